@@ -111,7 +111,8 @@ void aco_compile_shader(unsigned shader_count,
    }
 
    /* Register Allocation */
-   aco::register_allocation(program.get(), live_vars.live_out);
+   /* RA consumes the live-out sets, and nothing needs them afterwards */
+   aco::register_allocation(program.get(), std::move(live_vars.live_out));
    if (args->options->dump_shader) {
       std::cerr << "After RA:\n";
       aco_print_program(program.get(), stderr);
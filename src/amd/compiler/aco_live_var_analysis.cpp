@@ -38,8 +38,52 @@
 namespace aco {
 namespace {
 
+/* Set of temporaries indexed by their id, with constant-time insertion,
+ * removal and lookup and iteration over only the members. Clearing it is
+ * proportional to the number of members, so the same set can be reused for
+ * every block without touching memory for all temporaries of the program. */
+struct temp_set {
+   std::vector<Temp> dense;
+   std::vector<uint32_t> sparse;
+
+   temp_set(uint32_t num_ids) : sparse(num_ids) {}
+
+   bool count(Temp temp) const
+   {
+      uint32_t idx = sparse[temp.id()];
+      return idx < dense.size() && dense[idx].id() == temp.id();
+   }
+
+   bool insert(Temp temp)
+   {
+      if (count(temp))
+         return false;
+      sparse[temp.id()] = dense.size();
+      dense.push_back(temp);
+      return true;
+   }
+
+   size_t erase(Temp temp)
+   {
+      if (!count(temp))
+         return 0;
+      uint32_t idx = sparse[temp.id()];
+      Temp last = dense.back();
+      dense[idx] = last;
+      sparse[last.id()] = idx;
+      dense.pop_back();
+      return 1;
+   }
+
+   bool empty() const { return dense.empty(); }
+   void clear() { dense.clear(); }
+   std::vector<Temp>::const_iterator begin() const { return dense.begin(); }
+   std::vector<Temp>::const_iterator end() const { return dense.end(); }
+};
+
 void process_live_temps_per_block(Program *program, live& lives, Block* block,
-                                  std::set<unsigned>& worklist, std::vector<uint16_t>& phi_sgpr_ops)
+                                  std::set<unsigned>& worklist, std::vector<uint16_t>& phi_sgpr_ops,
+                                  temp_set& live_sgprs, temp_set& live_vgprs)
 {
    std::vector<RegisterDemand>& register_demand = lives.register_demand[block->index];
    RegisterDemand new_demand;
@@ -47,8 +91,8 @@ void process_live_temps_per_block(Program *program, live& lives, Block* block,
    register_demand.resize(block->instructions.size());
    block->register_demand = RegisterDemand();
 
-   std::set<Temp> live_sgprs;
-   std::set<Temp> live_vgprs;
+   live_sgprs.clear();
+   live_vgprs.clear();
 
    /* add the live_out_exec to live */
    bool exec_live = false;
@@ -62,8 +106,8 @@ void process_live_temps_per_block(Program *program, live& lives, Block* block,
    std::vector<std::set<Temp>>& live_temps = lives.live_out;
    for (const Temp temp : live_temps[block->index]) {
       const bool inserted = temp.is_linear()
-                          ? live_sgprs.insert(temp).second
-                          : live_vgprs.insert(temp).second;
+                          ? live_sgprs.insert(temp)
+                          : live_vgprs.insert(temp);
       if (inserted) {
          new_demand += temp;
       }
@@ -119,8 +163,8 @@ void process_live_temps_per_block(Program *program, live& lives, Block* block,
             }
             const Temp temp = operand.getTemp();
             const bool inserted = temp.is_linear()
-                                ? live_sgprs.insert(temp).second
-                                : live_vgprs.insert(temp).second;
+                                ? live_sgprs.insert(temp)
+                                : live_vgprs.insert(temp);
             if (inserted) {
                operand.setFirstKill(true);
                for (unsigned j = i + 1; j < insn->operands.size(); ++j) {
@@ -358,6 +402,8 @@ live live_var_analysis(Program* program,
    std::set<unsigned> worklist;
    std::vector<uint16_t> phi_sgpr_ops(program->blocks.size());
    RegisterDemand new_demand;
+   temp_set live_sgprs(program->peekAllocationId());
+   temp_set live_vgprs(program->peekAllocationId());
 
    /* this implementation assumes that the block idx corresponds to the block's position in program->blocks vector */
    for (Block& block : program->blocks)
@@ -366,7 +412,8 @@ live live_var_analysis(Program* program,
       std::set<unsigned>::reverse_iterator b_it = worklist.rbegin();
       unsigned block_idx = *b_it;
       worklist.erase(block_idx);
-      process_live_temps_per_block(program, result, &program->blocks[block_idx], worklist, phi_sgpr_ops);
+      process_live_temps_per_block(program, result, &program->blocks[block_idx], worklist, phi_sgpr_ops,
+                                   live_sgprs, live_vgprs);
       new_demand.update(program->blocks[block_idx].register_demand);
    }
 
@@ -469,6 +469,153 @@ void radv_DestroyPipelineLayout(
 
 #define EMPTY 1
 
+static unsigned
+radv_descriptor_pool_bucket(uint32_t size)
+{
+	return MIN2(size / 32, RADV_DESCRIPTOR_POOL_BUCKETS - 1);
+}
+
+static void
+radv_descriptor_pool_clear_holes(struct radv_descriptor_pool *pool)
+{
+	memset(pool->hole_buckets, 0xff, sizeof(pool->hole_buckets));
+	pool->free_holes = RADV_DESCRIPTOR_POOL_NO_HOLE;
+	pool->hole_count = 0;
+}
+
+static void
+radv_descriptor_pool_add_hole(struct radv_descriptor_pool *pool,
+			      const struct radv_descriptor_pool_entry *entry)
+{
+	uint32_t index;
+
+	if (pool->free_holes != RADV_DESCRIPTOR_POOL_NO_HOLE) {
+		index = pool->free_holes;
+		pool->free_holes = pool->holes[index].next;
+	} else if (pool->hole_count < pool->max_entry_count) {
+		index = pool->hole_count++;
+	} else {
+		/* The range is found again by radv_descriptor_pool_compact(). */
+		return;
+	}
+
+	uint32_t *bucket = &pool->hole_buckets[radv_descriptor_pool_bucket(entry->size)];
+	pool->holes[index].entry = *entry;
+	pool->holes[index].next = *bucket;
+	*bucket = index;
+}
+
+static bool
+radv_descriptor_pool_take_hole(struct radv_descriptor_pool *pool,
+			       uint32_t size,
+			       struct radv_descriptor_pool_entry *entry)
+{
+	uint32_t *prev = &pool->hole_buckets[radv_descriptor_pool_bucket(size)];
+
+	for (uint32_t index = *prev; index != RADV_DESCRIPTOR_POOL_NO_HOLE;
+	     index = pool->holes[index].next) {
+		struct radv_descriptor_pool_hole *hole = &pool->holes[index];
+
+		if (hole->entry.size == size) {
+			*entry = hole->entry;
+			*prev = hole->next;
+			hole->next = pool->free_holes;
+			pool->free_holes = index;
+			return true;
+		}
+		prev = &hole->next;
+	}
+
+	return false;
+}
+
+static int
+radv_descriptor_pool_entry_compare(const void *a, const void *b)
+{
+	const struct radv_descriptor_pool_entry *entry_a = a;
+	const struct radv_descriptor_pool_entry *entry_b = b;
+
+	if (entry_a->offset != entry_b->offset)
+		return entry_a->offset < entry_b->offset ? -1 : 1;
+	return 0;
+}
+
+/* Works out the free ranges of the pool from its live sets. The holes are
+ * dropped, and the linear allocator restarts after the last live set.
+ */
+static void
+radv_descriptor_pool_compact(struct radv_descriptor_pool *pool)
+{
+	uint64_t end = 0;
+
+	qsort(pool->entries, pool->entry_count, sizeof(pool->entries[0]),
+	      radv_descriptor_pool_entry_compare);
+
+	for (uint32_t i = 0; i < pool->entry_count; ++i) {
+		pool->entries[i].set->pool_entry = i;
+		if (pool->entries[i].size)
+			end = MAX2(end, pool->entries[i].offset + pool->entries[i].size);
+	}
+
+	pool->current_offset = end;
+	radv_descriptor_pool_clear_holes(pool);
+}
+
+/* Finds descriptor memory for a set of a pool that allows freeing sets.
+ * Applications usually free and allocate sets of the same few layouts over
+ * and over, so the memory of a freed set of the same size is taken first,
+ * then the linear allocator is tried, and only when both fail is the pool
+ * searched for a gap between its sets.
+ */
+static bool
+radv_descriptor_pool_alloc_entry(struct radv_descriptor_pool *pool,
+				 uint32_t layout_size,
+				 struct radv_descriptor_pool_entry *entry)
+{
+	if (radv_descriptor_pool_take_hole(pool, layout_size, entry))
+		return true;
+
+	*entry = (struct radv_descriptor_pool_entry) {
+		.size = layout_size,
+	};
+
+	if (pool->current_offset + layout_size > pool->size)
+		radv_descriptor_pool_compact(pool);
+
+	if (pool->current_offset + layout_size <= pool->size) {
+		entry->offset = pool->current_offset;
+		pool->current_offset += layout_size;
+		return true;
+	}
+
+	uint64_t offset = 0;
+	for (uint32_t i = 0; i < pool->entry_count; ++i) {
+		if (!pool->entries[i].size)
+			continue;
+		if (pool->entries[i].offset - offset >= layout_size) {
+			entry->offset = offset;
+			return true;
+		}
+		offset = pool->entries[i].offset + pool->entries[i].size;
+	}
+
+	return false;
+}
+
+static void
+radv_descriptor_pool_free_heap_sets(struct radv_device *device,
+				    struct radv_descriptor_pool *pool)
+{
+	if (!pool->heap_set_count)
+		return;
+
+	for (uint32_t i = 0; i < pool->entry_count; ++i) {
+		if (!pool->entries[i].host_size)
+			vk_free2(&device->alloc, NULL, pool->entries[i].set);
+	}
+	pool->heap_set_count = 0;
+}
+
 static VkResult
 radv_descriptor_set_create(struct radv_device *device,
 			   struct radv_descriptor_pool *pool,
@@ -491,85 +638,75 @@ radv_descriptor_set_create(struct radv_device *device,
 	unsigned mem_size = range_offset +
 		sizeof(struct radv_descriptor_range) * layout->dynamic_offset_count;
 
-	if (pool->host_memory_base) {
-		if (pool->host_memory_end - pool->host_memory_ptr < mem_size)
+	uint32_t layout_size = layout->size;
+	if (variable_count) {
+		assert(layout->has_variable_descriptors);
+		uint32_t stride = layout->binding[layout->binding_count - 1].size;
+		if (layout->binding[layout->binding_count - 1].type == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT)
+			stride = 1;
+
+		layout_size = layout->binding[layout->binding_count - 1].offset +
+		              *variable_count * stride;
+	}
+	layout_size = align_u32(layout_size, 32);
+
+	uint64_t offset;
+	if (!pool->allow_free) {
+		if (pool->host_memory_end - pool->host_memory_ptr < mem_size ||
+		    pool->current_offset + layout_size > pool->size)
 			return vk_error(device->instance, VK_ERROR_OUT_OF_POOL_MEMORY);
 
 		set = (struct radv_descriptor_set*)pool->host_memory_ptr;
 		pool->host_memory_ptr += mem_size;
+		offset = pool->current_offset;
+		pool->current_offset += layout_size;
 	} else {
-		set = vk_alloc2(&device->alloc, NULL, mem_size, 8,
-		                VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+		struct radv_descriptor_pool_entry entry;
+
+		if (pool->entry_count == pool->max_entry_count ||
+		    !radv_descriptor_pool_alloc_entry(pool, layout_size, &entry))
+			return vk_error(device->instance, VK_ERROR_OUT_OF_POOL_MEMORY);
+
+		/* The host memory of a freed set comes along with its
+		 * descriptor memory, but it may be too small for this one.
+		 */
+		if (entry.host_size < mem_size) {
+			if (pool->host_memory_end - pool->host_memory_ptr >= mem_size) {
+				entry.set = (struct radv_descriptor_set*)pool->host_memory_ptr;
+				entry.host_size = mem_size;
+				pool->host_memory_ptr += mem_size;
+			} else {
+				entry.set = vk_alloc2(&device->alloc, NULL, mem_size, 8,
+						      VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+				entry.host_size = 0;
+				if (!entry.set) {
+					radv_descriptor_pool_add_hole(pool, &entry);
+					return vk_error(device->instance, VK_ERROR_OUT_OF_HOST_MEMORY);
+				}
+				pool->heap_set_count++;
+			}
+		}
 
-		if (!set)
-			return vk_error(device->instance, VK_ERROR_OUT_OF_HOST_MEMORY);
+		set = entry.set;
+		offset = entry.offset;
+		pool->entries[pool->entry_count] = entry;
 	}
 
 	memset(set, 0, mem_size);
 
+	if (pool->allow_free)
+		set->pool_entry = pool->entry_count++;
+
 	if (layout->dynamic_offset_count) {
 		set->dynamic_descriptors = (struct radv_descriptor_range*)((uint8_t*)set + range_offset);
 	}
 
 	set->layout = layout;
-	uint32_t layout_size = layout->size;
-	if (variable_count) {
-		assert(layout->has_variable_descriptors);
-		uint32_t stride = layout->binding[layout->binding_count - 1].size;
-		if (layout->binding[layout->binding_count - 1].type == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT)
-			stride = 1;
-
-		layout_size = layout->binding[layout->binding_count - 1].offset +
-		              *variable_count * stride;
-	}
-	layout_size = align_u32(layout_size, 32);
 	if (layout_size) {
 		set->size = layout_size;
-
-		if (!pool->host_memory_base && pool->entry_count == pool->max_entry_count) {
-			vk_free2(&device->alloc, NULL, set);
-			return vk_error(device->instance, VK_ERROR_OUT_OF_POOL_MEMORY);
-		}
-
-		/* try to allocate linearly first, so that we don't spend
-		 * time looking for gaps if the app only allocates &
-		 * resets via the pool. */
-		if (pool->current_offset + layout_size <= pool->size) {
-			set->bo = pool->bo;
-			set->mapped_ptr = (uint32_t*)(pool->mapped_ptr + pool->current_offset);
-			set->va = radv_buffer_get_va(set->bo) + pool->current_offset;
-			if (!pool->host_memory_base) {
-				pool->entries[pool->entry_count].offset = pool->current_offset;
-				pool->entries[pool->entry_count].size = layout_size;
-				pool->entries[pool->entry_count].set = set;
-				pool->entry_count++;
-			}
-			pool->current_offset += layout_size;
-		} else if (!pool->host_memory_base) {
-			uint64_t offset = 0;
-			int index;
-
-			for (index = 0; index < pool->entry_count; ++index) {
-				if (pool->entries[index].offset - offset >= layout_size)
-					break;
-				offset = pool->entries[index].offset + pool->entries[index].size;
-			}
-
-			if (pool->size - offset < layout_size) {
-				vk_free2(&device->alloc, NULL, set);
-				return vk_error(device->instance, VK_ERROR_OUT_OF_POOL_MEMORY);
-			}
-			set->bo = pool->bo;
-			set->mapped_ptr = (uint32_t*)(pool->mapped_ptr + offset);
-			set->va = radv_buffer_get_va(set->bo) + offset;
-			memmove(&pool->entries[index + 1], &pool->entries[index],
-				sizeof(pool->entries[0]) * (pool->entry_count - index));
-			pool->entries[index].offset = offset;
-			pool->entries[index].size = layout_size;
-			pool->entries[index].set = set;
-			pool->entry_count++;
-		} else
-			return vk_error(device->instance, VK_ERROR_OUT_OF_POOL_MEMORY);
+		set->bo = pool->bo;
+		set->mapped_ptr = (uint32_t*)(pool->mapped_ptr + offset);
+		set->va = radv_buffer_get_va(set->bo) + offset;
 	}
 
 	if (layout->has_immutable_samplers) {
@@ -597,23 +734,22 @@ radv_descriptor_set_create(struct radv_device *device,
 static void
 radv_descriptor_set_destroy(struct radv_device *device,
 			    struct radv_descriptor_pool *pool,
-			    struct radv_descriptor_set *set,
-			    bool free_bo)
+			    struct radv_descriptor_set *set)
 {
-	assert(!pool->host_memory_base);
-
-	if (free_bo && set->size && !pool->host_memory_base) {
-		uint32_t offset = (uint8_t*)set->mapped_ptr - pool->mapped_ptr;
-		for (int i = 0; i < pool->entry_count; ++i) {
-			if (pool->entries[i].offset == offset) {
-				memmove(&pool->entries[i], &pool->entries[i+1],
-					sizeof(pool->entries[i]) * (pool->entry_count - i - 1));
-				--pool->entry_count;
-				break;
-			}
-		}
+	assert(pool->allow_free);
+
+	const uint32_t index = set->pool_entry;
+	struct radv_descriptor_pool_entry entry = pool->entries[index];
+
+	pool->entries[index] = pool->entries[--pool->entry_count];
+	pool->entries[index].set->pool_entry = index;
+
+	if (!entry.host_size) {
+		vk_free2(&device->alloc, NULL, set);
+		pool->heap_set_count--;
 	}
-	vk_free2(&device->alloc, NULL, set);
+
+	radv_descriptor_pool_add_hole(pool, &entry);
 }
 
 VkResult radv_CreateDescriptorPool(
@@ -677,14 +813,20 @@ VkResult radv_CreateDescriptorPool(
 		}
 	}
 
-	if (!(pCreateInfo->flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)) {
-		uint64_t host_size = pCreateInfo->maxSets * sizeof(struct radv_descriptor_set);
-		host_size += sizeof(struct radeon_winsys_bo*) * bo_count;
-		host_size += sizeof(struct radv_descriptor_range) * range_count;
-		size += host_size;
-	} else {
-		size += sizeof(struct radv_descriptor_pool_entry) * pCreateInfo->maxSets;
+	/* Sets are carved out of the pool in both cases, the sets of pools that
+	 * allow freeing them fall back to the heap when the memory of freed
+	 * sets can't be reused.
+	 */
+	uint64_t host_size = pCreateInfo->maxSets * sizeof(struct radv_descriptor_set);
+	host_size += sizeof(struct radeon_winsys_bo*) * bo_count;
+	host_size += sizeof(struct radv_descriptor_range) * range_count;
+
+	uint64_t tracking_size = 0;
+	if (pCreateInfo->flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT) {
+		tracking_size = (sizeof(struct radv_descriptor_pool_entry) +
+				 sizeof(struct radv_descriptor_pool_hole)) * pCreateInfo->maxSets;
 	}
+	size += tracking_size + host_size;
 
 	pool = vk_alloc2(&device->alloc, pAllocator, size, 8,
 	                 VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
@@ -693,12 +835,17 @@ VkResult radv_CreateDescriptorPool(
 
 	memset(pool, 0, sizeof(*pool));
 
-	if (!(pCreateInfo->flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)) {
-		pool->host_memory_base = (uint8_t*)pool + sizeof(struct radv_descriptor_pool);
-		pool->host_memory_ptr = pool->host_memory_base;
-		pool->host_memory_end = (uint8_t*)pool + size;
+	if (pCreateInfo->flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT) {
+		pool->allow_free = true;
+		pool->holes = (struct radv_descriptor_pool_hole*)
+			(pool->entries + pCreateInfo->maxSets);
+		radv_descriptor_pool_clear_holes(pool);
 	}
 
+	pool->host_memory_base = (uint8_t*)pool + sizeof(struct radv_descriptor_pool) + tracking_size;
+	pool->host_memory_ptr = pool->host_memory_base;
+	pool->host_memory_end = (uint8_t*)pool + size;
+
 	if (bo_size) {
 		pool->bo = device->ws->buffer_create(device->ws, bo_size, 32,
 						     RADEON_DOMAIN_VRAM,
@@ -726,11 +873,7 @@ void radv_DestroyDescriptorPool(
 	if (!pool)
 		return;
 
-	if (!pool->host_memory_base) {
-		for(int i = 0; i < pool->entry_count; ++i) {
-			radv_descriptor_set_destroy(device, pool, pool->entries[i].set, false);
-		}
-	}
+	radv_descriptor_pool_free_heap_sets(device, pool);
 
 	if (pool->bo)
 		device->ws->buffer_destroy(pool->bo);
@@ -745,10 +888,12 @@ VkResult radv_ResetDescriptorPool(
 	RADV_FROM_HANDLE(radv_device, device, _device);
 	RADV_FROM_HANDLE(radv_descriptor_pool, pool, descriptorPool);
 
-	if (!pool->host_memory_base) {
-		for(int i = 0; i < pool->entry_count; ++i) {
-			radv_descriptor_set_destroy(device, pool, pool->entries[i].set, false);
-		}
+	/* Only the sets that didn't fit in the pool need to be freed one by
+	 * one, and there are usually none.
+	 */
+	if (pool->allow_free) {
+		radv_descriptor_pool_free_heap_sets(device, pool);
+		radv_descriptor_pool_clear_holes(pool);
 		pool->entry_count = 0;
 	}
 
@@ -818,8 +963,8 @@ VkResult radv_FreeDescriptorSets(
 	for (uint32_t i = 0; i < count; i++) {
 		RADV_FROM_HANDLE(radv_descriptor_set, set, pDescriptorSets[i]);
 
-		if (set && !pool->host_memory_base)
-			radv_descriptor_set_destroy(device, pool, set, true);
+		if (set && pool->allow_free)
+			radv_descriptor_set_destroy(device, pool, set);
 	}
 	return VK_SUCCESS;
 }
@@ -962,6 +1107,160 @@ write_sampler_descriptor(struct radv_device *device,
 	memcpy(dst, sampler->state, 16);
 }
 
+/* Works out where the descriptors of a template entry go. Immutable samplers
+ * are only written for push descriptors, sets get them when they are
+ * allocated.
+ */
+static struct radv_descriptor_update_template_entry
+radv_descriptor_update_entry(const struct radv_descriptor_set_layout *set_layout,
+			     uint32_t binding, uint32_t array_element,
+			     VkDescriptorType descriptor_type,
+			     uint32_t descriptor_count,
+			     size_t src_offset, size_t src_stride,
+			     bool push)
+{
+	const struct radv_descriptor_set_binding_layout *binding_layout =
+		set_layout->binding + binding;
+	const uint32_t buffer_offset = binding_layout->buffer_offset + array_element;
+	const uint32_t *immutable_samplers = NULL;
+	uint32_t dst_offset;
+	uint32_t dst_stride;
+
+	/* dst_offset is an offset into dynamic_descriptors when the descriptor
+	   is dynamic, and an offset into mapped_ptr otherwise */
+	switch (descriptor_type) {
+	case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+	case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+		assert(!push);
+		dst_offset = binding_layout->dynamic_offset_offset + array_element;
+		dst_stride = 0; /* Not used */
+		break;
+	default:
+		switch (descriptor_type) {
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+			/* Immutable samplers are copied into push descriptors when they are pushed */
+			if (push && binding_layout->immutable_samplers_offset &&
+			    !binding_layout->immutable_samplers_equal) {
+				immutable_samplers = radv_immutable_samplers(set_layout, binding_layout) + array_element * 4;
+			}
+			break;
+		default:
+			break;
+		}
+		dst_offset = binding_layout->offset / 4;
+		if (descriptor_type == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT)
+			dst_offset += array_element / 4;
+		else
+			dst_offset += binding_layout->size * array_element / 4;
+
+		dst_stride = binding_layout->size / 4;
+		break;
+	}
+
+	return (struct radv_descriptor_update_template_entry) {
+		.descriptor_type = descriptor_type,
+		.descriptor_count = descriptor_count,
+		.src_offset = src_offset,
+		.src_stride = src_stride,
+		.dst_offset = dst_offset,
+		.dst_stride = dst_stride,
+		.buffer_offset = buffer_offset,
+		.has_sampler = !binding_layout->immutable_samplers_offset,
+		.sampler_offset = radv_combined_image_descriptor_sampler_offset(binding_layout),
+		.immutable_samplers = immutable_samplers
+	};
+}
+
+/* Samplers whose binding has immutable samplers are already in place. */
+static bool
+radv_descriptor_update_entry_is_noop(const struct radv_descriptor_update_template_entry *entry)
+{
+	return !entry->descriptor_count ||
+	       (entry->descriptor_type == VK_DESCRIPTOR_TYPE_SAMPLER &&
+		!entry->has_sampler && !entry->immutable_samplers);
+}
+
+/* The type is the same for all the descriptors of an entry, so it is only
+ * switched on once, and each type gets a loop of its own. For images, texel
+ * buffers and samplers that loop only copies the descriptors prepared when
+ * their views and samplers were created.
+ */
+static void
+radv_write_descriptor_update_entry(struct radv_device *device,
+				   struct radv_cmd_buffer *cmd_buffer,
+				   struct radv_descriptor_set *set,
+				   const struct radv_descriptor_update_template_entry *entry,
+				   const uint8_t *pSrc)
+{
+	struct radeon_winsys_bo **buffer_list = set->descriptors + entry->buffer_offset;
+	uint32_t *pDst = set->mapped_ptr + entry->dst_offset;
+	const uint32_t count = entry->descriptor_count;
+	const size_t src_stride = entry->src_stride;
+	const uint32_t dst_stride = entry->dst_stride;
+	uint32_t j;
+
+	switch (entry->descriptor_type) {
+	case VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT:
+		memcpy((uint8_t*)pDst, pSrc, count);
+		break;
+	case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+	case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+		assert(!(set->layout->flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR));
+		for (j = 0; j < count; ++j, pSrc += src_stride) {
+			write_dynamic_buffer_descriptor(device, set->dynamic_descriptors + entry->dst_offset + j,
+							buffer_list + j, (const VkDescriptorBufferInfo *) pSrc);
+		}
+		break;
+	case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+	case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+		for (j = 0; j < count; ++j, pSrc += src_stride, pDst += dst_stride) {
+			write_buffer_descriptor(device, cmd_buffer, pDst, buffer_list + j,
+						(const VkDescriptorBufferInfo *) pSrc);
+		}
+		break;
+	case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+	case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+		for (j = 0; j < count; ++j, pSrc += src_stride, pDst += dst_stride) {
+			write_texel_buffer_descriptor(device, cmd_buffer, pDst, buffer_list + j,
+						      *(const VkBufferView *) pSrc);
+		}
+		break;
+	case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+	case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+	case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+		for (j = 0; j < count; ++j, pSrc += src_stride, pDst += dst_stride) {
+			write_image_descriptor(device, cmd_buffer, 64, pDst, buffer_list + j,
+					       entry->descriptor_type,
+					       (const VkDescriptorImageInfo *) pSrc);
+		}
+		break;
+	case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+		for (j = 0; j < count; ++j, pSrc += src_stride, pDst += dst_stride) {
+			write_combined_image_sampler_descriptor(device, cmd_buffer, entry->sampler_offset,
+								pDst, buffer_list + j, entry->descriptor_type,
+								(const VkDescriptorImageInfo *) pSrc,
+								entry->has_sampler);
+			if (entry->immutable_samplers) {
+				memcpy((char*)pDst + entry->sampler_offset, entry->immutable_samplers + 4 * j, 16);
+			}
+		}
+		break;
+	case VK_DESCRIPTOR_TYPE_SAMPLER:
+		if (entry->has_sampler) {
+			for (j = 0; j < count; ++j, pSrc += src_stride, pDst += dst_stride)
+				write_sampler_descriptor(device, pDst, (const VkDescriptorImageInfo *) pSrc);
+		} else if (entry->immutable_samplers) {
+			for (j = 0; j < count; ++j, pDst += dst_stride)
+				memcpy(pDst, entry->immutable_samplers + 4 * j, 16);
+		}
+		break;
+	default:
+		unreachable("unimplemented descriptor type");
+		break;
+	}
+}
+
 void radv_update_descriptor_sets(
 	struct radv_device*                         device,
 	struct radv_cmd_buffer*                     cmd_buffer,
@@ -1152,8 +1451,6 @@ VkResult radv_CreateDescriptorUpdateTemplate(VkDevice _device,
 	if (!templ)
 		return vk_error(device->instance, VK_ERROR_OUT_OF_HOST_MEMORY);
 
-	templ->entry_count = entry_count;
-
 	if (pCreateInfo->templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR) {
 		RADV_FROM_HANDLE(radv_pipeline_layout, pipeline_layout, pCreateInfo->pipelineLayout);
 
@@ -1166,59 +1463,22 @@ VkResult radv_CreateDescriptorUpdateTemplate(VkDevice _device,
 		templ->bind_point = pCreateInfo->pipelineBindPoint;
 	}
 
+	/* Entries that wouldn't write anything are left out. */
+	templ->entry_count = 0;
 	for (i = 0; i < entry_count; i++) {
 		const VkDescriptorUpdateTemplateEntry *entry = &pCreateInfo->pDescriptorUpdateEntries[i];
-		const struct radv_descriptor_set_binding_layout *binding_layout =
-			set_layout->binding + entry->dstBinding;
-		const uint32_t buffer_offset = binding_layout->buffer_offset + entry->dstArrayElement;
-		const uint32_t *immutable_samplers = NULL;
-		uint32_t dst_offset;
-		uint32_t dst_stride;
-
-		/* dst_offset is an offset into dynamic_descriptors when the descriptor
-		   is dynamic, and an offset into mapped_ptr otherwise */
-		switch (entry->descriptorType) {
-		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
-			assert(pCreateInfo->templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET);
-			dst_offset = binding_layout->dynamic_offset_offset + entry->dstArrayElement;
-			dst_stride = 0; /* Not used */
-			break;
-		default:
-			switch (entry->descriptorType) {
-			case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-			case VK_DESCRIPTOR_TYPE_SAMPLER:
-				/* Immutable samplers are copied into push descriptors when they are pushed */
-				if (pCreateInfo->templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR &&
-				    binding_layout->immutable_samplers_offset && !binding_layout->immutable_samplers_equal) {
-					immutable_samplers = radv_immutable_samplers(set_layout, binding_layout) + entry->dstArrayElement * 4;
-				}
-				break;
-			default:
-				break;
-			}
-			dst_offset = binding_layout->offset / 4;
-			if (entry->descriptorType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT)
-				dst_offset += entry->dstArrayElement / 4;
-			else
-				dst_offset += binding_layout->size * entry->dstArrayElement / 4;
-
-			dst_stride = binding_layout->size / 4;
-			break;
-		}
-
-		templ->entry[i] = (struct radv_descriptor_update_template_entry) {
-			.descriptor_type = entry->descriptorType,
-			.descriptor_count = entry->descriptorCount,
-			.src_offset = entry->offset,
-			.src_stride = entry->stride,
-			.dst_offset = dst_offset,
-			.dst_stride = dst_stride,
-			.buffer_offset = buffer_offset,
-			.has_sampler = !binding_layout->immutable_samplers_offset,
-			.sampler_offset = radv_combined_image_descriptor_sampler_offset(binding_layout),
-			.immutable_samplers = immutable_samplers
-		};
+		const bool push =
+			pCreateInfo->templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR;
+
+		templ->entry[templ->entry_count] =
+			radv_descriptor_update_entry(set_layout, entry->dstBinding,
+						     entry->dstArrayElement,
+						     entry->descriptorType,
+						     entry->descriptorCount,
+						     entry->offset, entry->stride, push);
+
+		if (!radv_descriptor_update_entry_is_noop(&templ->entry[templ->entry_count]))
+			templ->entry_count++;
 	}
 
 	*pDescriptorUpdateTemplate = radv_descriptor_update_template_to_handle(templ);
@@ -1248,67 +1508,8 @@ void radv_update_descriptor_set_with_template(struct radv_device *device,
 	uint32_t i;
 
 	for (i = 0; i < templ->entry_count; ++i) {
-		struct radeon_winsys_bo **buffer_list = set->descriptors + templ->entry[i].buffer_offset;
-		uint32_t *pDst = set->mapped_ptr + templ->entry[i].dst_offset;
-		const uint8_t *pSrc = ((const uint8_t *) pData) + templ->entry[i].src_offset;
-		uint32_t j;
-
-		if (templ->entry[i].descriptor_type == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT) {
-			memcpy((uint8_t*)pDst, pSrc, templ->entry[i].descriptor_count);
-			continue;
-		}
-
-		for (j = 0; j < templ->entry[i].descriptor_count; ++j) {
-			switch (templ->entry[i].descriptor_type) {
-			case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-			case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: {
-				const unsigned idx = templ->entry[i].dst_offset + j;
-				assert(!(set->layout->flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR));
-				write_dynamic_buffer_descriptor(device, set->dynamic_descriptors + idx,
-								buffer_list, (struct VkDescriptorBufferInfo *) pSrc);
-				break;
-			}
-			case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-			case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-				write_buffer_descriptor(device, cmd_buffer, pDst, buffer_list,
-				                        (struct VkDescriptorBufferInfo *) pSrc);
-				break;
-			case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-			case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
-				write_texel_buffer_descriptor(device, cmd_buffer, pDst, buffer_list,
-						              *(VkBufferView *) pSrc);
-				break;
-			case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-			case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-			case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-				write_image_descriptor(device, cmd_buffer, 64, pDst, buffer_list,
-						       templ->entry[i].descriptor_type,
-					               (struct VkDescriptorImageInfo *) pSrc);
-				break;
-			case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-				write_combined_image_sampler_descriptor(device, cmd_buffer, templ->entry[i].sampler_offset,
-									pDst, buffer_list, templ->entry[i].descriptor_type,
-									(struct VkDescriptorImageInfo *) pSrc,
-									templ->entry[i].has_sampler);
-				if (templ->entry[i].immutable_samplers) {
-					memcpy((char*)pDst + templ->entry[i].sampler_offset, templ->entry[i].immutable_samplers + 4 * j, 16);
-				}
-				break;
-			case VK_DESCRIPTOR_TYPE_SAMPLER:
-				if (templ->entry[i].has_sampler)
-					write_sampler_descriptor(device, pDst,
-					                         (struct VkDescriptorImageInfo *) pSrc);
-				else if (templ->entry[i].immutable_samplers)
-					memcpy(pDst, templ->entry[i].immutable_samplers + 4 * j, 16);
-				break;
-			default:
-				unreachable("unimplemented descriptor type");
-				break;
-			}
-		        pSrc += templ->entry[i].src_stride;
-			pDst += templ->entry[i].dst_stride;
-			++buffer_list;
-		}
+		radv_write_descriptor_update_entry(device, cmd_buffer, set, &templ->entry[i],
+						   (const uint8_t *) pData + templ->entry[i].src_offset);
 	}
 }
 
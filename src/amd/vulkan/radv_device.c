@@ -535,6 +535,18 @@ static const VkAllocationCallbacks default_alloc = {
 	.pfnFree = default_free_func,
 };
 
+/* Application allocators may only be called from the thread the command was
+ * called on, so work may only be handed off to other threads if this
+ * returns true.
+ */
+bool
+radv_device_alloc_is_default(const struct radv_device *device,
+			     const VkAllocationCallbacks *pAllocator)
+{
+	return pAllocator == NULL &&
+	       device->alloc.pfnAllocation == default_alloc_func;
+}
+
 static const struct debug_control radv_debug_options[] = {
 	{"nofastclears", RADV_DEBUG_NO_FAST_CLEARS},
 	{"nodcc", RADV_DEBUG_NO_DCC},
@@ -3065,6 +3077,8 @@ VkResult radv_CreateDevice(
 			goto fail_meta;
 	}
 
+	mtx_init(&device->queue_mutex, mtx_plain);
+
 	*pDevice = radv_device_to_handle(device);
 	return VK_SUCCESS;
 
@@ -3117,6 +3131,14 @@ void radv_DestroyDevice(
 	}
 	radv_device_finish_meta(device);
 
+	if (device->pipeline_queue_attempted &&
+	    util_queue_is_initialized(&device->pipeline_queue))
+		util_queue_destroy(&device->pipeline_queue);
+	if (device->compile_queue_attempted &&
+	    util_queue_is_initialized(&device->compile_queue))
+		util_queue_destroy(&device->compile_queue);
+	mtx_destroy(&device->queue_mutex);
+
 	VkPipelineCache pc = radv_pipeline_cache_to_handle(device->mem_cache);
 	radv_DestroyPipelineCache(radv_device_to_handle(device), pc, NULL);
 
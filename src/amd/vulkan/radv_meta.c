@@ -273,9 +273,7 @@ static bool
 radv_load_meta_pipeline(struct radv_device *device)
 {
 	char path[PATH_MAX + 1];
-	struct stat st;
-	void *data = NULL;
-	bool ret = false;
+	bool ret;
 
 	if (!radv_builtin_cache_path(path))
 		return false;
@@ -283,17 +281,8 @@ radv_load_meta_pipeline(struct radv_device *device)
 	int fd = open(path, O_RDONLY);
 	if (fd < 0)
 		return false;
-	if (fstat(fd, &st))
-		goto fail;
-	data = malloc(st.st_size);
-	if (!data)
-		goto fail;
-	if(read(fd, data, st.st_size) == -1)
-		goto fail;
 
-	ret = radv_pipeline_cache_load(&device->meta_state.cache, data, st.st_size);
-fail:
-	free(data);
+	ret = radv_pipeline_cache_load_file(&device->meta_state.cache, fd);
 	close(fd);
 	return ret;
 }
@@ -28,6 +28,7 @@
 #include "util/disk_cache.h"
 #include "util/mesa-sha1.h"
 #include "util/u_atomic.h"
+#include "util/u_cpu_detect.h"
 #include "radv_debug.h"
 #include "radv_private.h"
 #include "radv_cs.h"
@@ -2722,6 +2723,58 @@ bool radv_aco_supported_stage(gl_shader_stage stage, bool has_gs, bool has_ts)
 	       stage == MESA_SHADER_COMPUTE;
 }
 
+/* Creates the device's compile queue if it hasn't been yet.  Returns false
+ * if the queue couldn't be created.
+ */
+static bool
+radv_device_init_compile_queue(struct radv_device *device)
+{
+	mtx_lock(&device->queue_mutex);
+	if (!device->compile_queue_attempted) {
+		device->compile_queue_attempted = true;
+		util_cpu_detect();
+		util_queue_init(&device->compile_queue, "radv_sh", 8,
+				util_cpu_caps.nr_cpus,
+				UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+	}
+	mtx_unlock(&device->queue_mutex);
+
+	return util_queue_is_initialized(&device->compile_queue);
+}
+
+/* The backend compile of one stage, run on the device's compile queue. */
+struct radv_shader_stage_job {
+	struct util_queue_fence fence;
+
+	struct radv_device *device;
+	struct radv_pipeline *pipeline;
+	struct radv_shader_module *module;
+	nir_shader **nir;
+	const struct radv_shader_variant_key *key;
+	struct radv_shader_info *info;
+	bool keep_executable_info;
+	bool use_aco;
+	struct radv_shader_binary **binary;
+	VkPipelineCreationFeedbackEXT *feedback;
+};
+
+static void
+radv_shader_stage_job_compile(void *data, int thread_index)
+{
+	struct radv_shader_stage_job *job = data;
+	gl_shader_stage stage = (*job->nir)->info.stage;
+
+	radv_start_feedback(job->feedback);
+
+	job->pipeline->shaders[stage] =
+		radv_shader_variant_compile(job->device, job->module, job->nir, 1,
+					    job->pipeline->layout, job->key,
+					    job->info, job->keep_executable_info,
+					    job->use_aco, job->binary);
+
+	radv_stop_feedback(job->feedback, false);
+}
+
 void radv_create_shaders(struct radv_pipeline *pipeline,
                          struct radv_device *device,
                          struct radv_pipeline_cache *cache,
@@ -2863,19 +2916,48 @@ void radv_create_shaders(struct radv_pipeline *pipeline,
 		gfx9_get_gs_info(key, pipeline, nir, infos, gs_info);
 	}
 
+	/* Nothing the other stages are compiled with depends on the fragment
+	 * shader, so it is compiled on the compile queue while they are
+	 * compiled here.  It stays on this thread if shaders are dumped, to
+	 * keep the output apart, and with secure compile, whose processes
+	 * can't start threads.
+	 */
+	struct radv_shader_stage_job fs_job;
+	bool fs_job_queued = false;
 	if (nir[MESA_SHADER_FRAGMENT]) {
 		if (!pipeline->shaders[MESA_SHADER_FRAGMENT]) {
-			radv_start_feedback(stage_feedbacks[MESA_SHADER_FRAGMENT]);
-
-			bool aco = use_aco && radv_aco_supported_stage(MESA_SHADER_FRAGMENT, has_gs, has_ts);
-			pipeline->shaders[MESA_SHADER_FRAGMENT] =
-			       radv_shader_variant_compile(device, modules[MESA_SHADER_FRAGMENT], &nir[MESA_SHADER_FRAGMENT], 1,
-			                                  pipeline->layout, keys + MESA_SHADER_FRAGMENT,
-							  infos + MESA_SHADER_FRAGMENT,
-			                                  keep_executable_info, aco,
-			                                  &binaries[MESA_SHADER_FRAGMENT]);
+			fs_job = (struct radv_shader_stage_job) {
+				.device = device,
+				.pipeline = pipeline,
+				.module = modules[MESA_SHADER_FRAGMENT],
+				.nir = &nir[MESA_SHADER_FRAGMENT],
+				.key = &keys[MESA_SHADER_FRAGMENT],
+				.info = &infos[MESA_SHADER_FRAGMENT],
+				.keep_executable_info = keep_executable_info,
+				.use_aco = use_aco && radv_aco_supported_stage(MESA_SHADER_FRAGMENT, has_gs, has_ts),
+				.binary = &binaries[MESA_SHADER_FRAGMENT],
+				.feedback = stage_feedbacks[MESA_SHADER_FRAGMENT],
+			};
+
+			bool other_stages = false;
+			for (unsigned i = 0; i < MESA_SHADER_FRAGMENT; ++i) {
+				if (modules[i] && !pipeline->shaders[i])
+					other_stages = true;
+			}
 
-			radv_stop_feedback(stage_feedbacks[MESA_SHADER_FRAGMENT], false);
+			if (other_stages &&
+			    !radv_can_dump_shader(device, modules[MESA_SHADER_FRAGMENT], false) &&
+			    !radv_device_use_secure_compile(device->instance) &&
+			    radv_device_init_compile_queue(device)) {
+				util_queue_fence_init(&fs_job.fence);
+				util_queue_add_job(&device->compile_queue, &fs_job,
+						   &fs_job.fence,
+						   radv_shader_stage_job_compile,
+						   NULL, 0);
+				fs_job_queued = true;
+			} else {
+				radv_shader_stage_job_compile(&fs_job, 0);
+			}
 		}
 	}
 
@@ -2917,6 +2999,9 @@ void radv_create_shaders(struct radv_pipeline *pipeline,
 	}
 
 	for (int i = 0; i < MESA_SHADER_STAGES; ++i) {
+		if (i == MESA_SHADER_FRAGMENT && fs_job_queued)
+			continue;
+
 		if(modules[i] && !pipeline->shaders[i]) {
 			if (i == MESA_SHADER_TESS_CTRL) {
 				keys[MESA_SHADER_TESS_CTRL].tcs.num_inputs = util_last_bit64(pipeline->shaders[MESA_SHADER_VERTEX]->info.vs.ls_outputs_written);
@@ -2938,6 +3023,11 @@ void radv_create_shaders(struct radv_pipeline *pipeline,
 		}
 	}
 
+	if (fs_job_queued) {
+		util_queue_fence_wait(&fs_job.fence);
+		util_queue_fence_destroy(&fs_job.fence);
+	}
+
 	if(modules[MESA_SHADER_GEOMETRY]) {
 		struct radv_shader_binary *gs_copy_binary = NULL;
 		if (!pipeline->gs_copy_shader &&
@@ -5153,6 +5243,120 @@ radv_graphics_pipeline_create(
 	return VK_SUCCESS;
 }
 
+/* Creation of one pipeline out of a vkCreate*Pipelines batch. */
+struct radv_pipeline_create_job {
+	struct util_queue_fence fence;
+
+	VkDevice device;
+	VkPipelineCache cache;
+	const void *create_info;
+	const VkAllocationCallbacks *alloc;
+	VkPipeline *pipeline;
+
+	VkResult result;
+};
+
+/* Creates the device's pipeline queue if it hasn't been yet, so that devices
+ * which never create pipelines in batches don't start a thread per CPU.
+ * This is never called with secure compile enabled, whose processes are
+ * forked at device creation and only need the calling thread.  Returns false
+ * if the queue couldn't be created.
+ */
+static bool
+radv_device_init_pipeline_queue(struct radv_device *device)
+{
+	mtx_lock(&device->queue_mutex);
+	if (!device->pipeline_queue_attempted) {
+		device->pipeline_queue_attempted = true;
+		util_cpu_detect();
+		util_queue_init(&device->pipeline_queue, "radv_pipe", 64,
+				util_cpu_caps.nr_cpus,
+				UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+	}
+	mtx_unlock(&device->queue_mutex);
+
+	return util_queue_is_initialized(&device->pipeline_queue);
+}
+
+/* Creates count pipelines by running create on a radv_pipeline_create_job
+ * for each of them, spread over the device's pipeline queue.
+ *
+ * Like before, every pipeline is attempted, failed entries are set to
+ * VK_NULL_HANDLE and an error is returned if any of them failed.  Batches
+ * stay on the calling thread if the application provided its own allocator
+ * or secure compile is enabled, since both are tied to that thread.
+ */
+static VkResult
+radv_pipeline_create_batch(VkDevice _device,
+			   VkPipelineCache cache,
+			   uint32_t count,
+			   const void *create_infos,
+			   size_t create_info_size,
+			   const VkAllocationCallbacks *pAllocator,
+			   VkPipeline *pPipelines,
+			   util_queue_execute_func create)
+{
+	RADV_FROM_HANDLE(radv_device, device, _device);
+	const bool threaded = count > 1 &&
+		radv_device_alloc_is_default(device, pAllocator) &&
+		!radv_device_use_secure_compile(device->instance) &&
+		radv_device_init_pipeline_queue(device);
+
+	struct radv_pipeline_create_job *jobs =
+		vk_alloc2(&device->alloc, pAllocator, count * sizeof(*jobs), 8,
+			  VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+	if (!jobs) {
+		for (uint32_t i = 0; i < count; i++)
+			pPipelines[i] = VK_NULL_HANDLE;
+		return vk_error(device->instance, VK_ERROR_OUT_OF_HOST_MEMORY);
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		jobs[i] = (struct radv_pipeline_create_job) {
+			.device = _device,
+			.cache = cache,
+			.create_info = (const char *)create_infos +
+				       i * create_info_size,
+			.alloc = pAllocator,
+			.pipeline = &pPipelines[i],
+		};
+
+		if (threaded) {
+			util_queue_fence_init(&jobs[i].fence);
+			util_queue_add_job(&device->pipeline_queue, &jobs[i],
+					   &jobs[i].fence, create, NULL, 0);
+		} else {
+			create(&jobs[i], 0);
+		}
+	}
+
+	VkResult result = VK_SUCCESS;
+	for (uint32_t i = 0; i < count; i++) {
+		if (threaded) {
+			util_queue_fence_wait(&jobs[i].fence);
+			util_queue_fence_destroy(&jobs[i].fence);
+		}
+
+		if (jobs[i].result != VK_SUCCESS) {
+			result = jobs[i].result;
+			pPipelines[i] = VK_NULL_HANDLE;
+		}
+	}
+
+	vk_free2(&device->alloc, pAllocator, jobs);
+	return result;
+}
+
+static void
+radv_graphics_pipeline_create_job(void *data, int thread_index)
+{
+	struct radv_pipeline_create_job *job = data;
+
+	job->result = radv_graphics_pipeline_create(job->device, job->cache,
+						    job->create_info, NULL,
+						    job->alloc, job->pipeline);
+}
+
 VkResult radv_CreateGraphicsPipelines(
 	VkDevice                                    _device,
 	VkPipelineCache                             pipelineCache,
@@ -5161,22 +5365,10 @@ VkResult radv_CreateGraphicsPipelines(
 	const VkAllocationCallbacks*                pAllocator,
 	VkPipeline*                                 pPipelines)
 {
-	VkResult result = VK_SUCCESS;
-	unsigned i = 0;
-
-	for (; i < count; i++) {
-		VkResult r;
-		r = radv_graphics_pipeline_create(_device,
-						  pipelineCache,
-						  &pCreateInfos[i],
-						  NULL, pAllocator, &pPipelines[i]);
-		if (r != VK_SUCCESS) {
-			result = r;
-			pPipelines[i] = VK_NULL_HANDLE;
-		}
-	}
-
-	return result;
+	return radv_pipeline_create_batch(_device, pipelineCache, count,
+					  pCreateInfos, sizeof(*pCreateInfos),
+					  pAllocator, pPipelines,
+					  radv_graphics_pipeline_create_job);
 }
 
 
@@ -5320,6 +5512,16 @@ static VkResult radv_compute_pipeline_create(
 	return VK_SUCCESS;
 }
 
+static void
+radv_compute_pipeline_create_job(void *data, int thread_index)
+{
+	struct radv_pipeline_create_job *job = data;
+
+	job->result = radv_compute_pipeline_create(job->device, job->cache,
+						   job->create_info,
+						   job->alloc, job->pipeline);
+}
+
 VkResult radv_CreateComputePipelines(
 	VkDevice                                    _device,
 	VkPipelineCache                             pipelineCache,
@@ -5328,21 +5530,10 @@ VkResult radv_CreateComputePipelines(
 	const VkAllocationCallbacks*                pAllocator,
 	VkPipeline*                                 pPipelines)
 {
-	VkResult result = VK_SUCCESS;
-
-	unsigned i = 0;
-	for (; i < count; i++) {
-		VkResult r;
-		r = radv_compute_pipeline_create(_device, pipelineCache,
-						 &pCreateInfos[i],
-						 pAllocator, &pPipelines[i]);
-		if (r != VK_SUCCESS) {
-			result = r;
-			pPipelines[i] = VK_NULL_HANDLE;
-		}
-	}
-
-	return result;
+	return radv_pipeline_create_batch(_device, pipelineCache, count,
+					  pCreateInfos, sizeof(*pCreateInfos),
+					  pAllocator, pPipelines,
+					  radv_compute_pipeline_create_job);
 }
 
 
@@ -21,6 +21,9 @@
  * IN THE SOFTWARE.
  */
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "util/mesa-sha1.h"
 #include "util/debug.h"
 #include "util/disk_cache.h"
@@ -49,6 +52,9 @@ radv_pipeline_cache_init(struct radv_pipeline_cache *cache,
 	pthread_mutex_init(&cache->mutex, NULL);
 
 	cache->modified = false;
+	cache->data = NULL;
+	cache->data_size = 0;
+	cache->data_mapped = false;
 	cache->kernel_count = 0;
 	cache->total_size = 0;
 	cache->table_size = 1024;
@@ -65,6 +71,19 @@ radv_pipeline_cache_init(struct radv_pipeline_cache *cache,
 		memset(cache->hash_table, 0, byte_size);
 }
 
+/* Whether the entry points into the serialized data the cache was loaded
+ * from, rather than being allocated on its own.
+ */
+static bool
+radv_pipeline_cache_entry_in_data(const struct radv_pipeline_cache *cache,
+				  const struct cache_entry *entry)
+{
+	const char *p = (const char *)entry;
+	const char *data = cache->data;
+
+	return data && p >= data && p < data + cache->data_size;
+}
+
 void
 radv_pipeline_cache_finish(struct radv_pipeline_cache *cache)
 {
@@ -75,10 +94,16 @@ radv_pipeline_cache_finish(struct radv_pipeline_cache *cache)
 					radv_shader_variant_destroy(cache->device,
 								    cache->hash_table[i]->variants[j]);
 			}
-			vk_free(&cache->alloc, cache->hash_table[i]);
+			if (!radv_pipeline_cache_entry_in_data(cache, cache->hash_table[i]))
+				vk_free(&cache->alloc, cache->hash_table[i]);
 		}
 	pthread_mutex_destroy(&cache->mutex);
 	free(cache->hash_table);
+
+	if (cache->data_mapped)
+		munmap(cache->data, cache->data_size);
+	else
+		vk_free(&cache->alloc, cache->data);
 }
 
 static uint32_t
@@ -183,7 +208,7 @@ radv_pipeline_cache_set_entry(struct radv_pipeline_cache *cache,
 		}
 	}
 
-	cache->total_size += entry_size(entry);
+	cache->total_size += align(entry_size(entry), 8);
 	cache->kernel_count++;
 }
 
@@ -515,12 +540,26 @@ struct cache_header {
 	uint8_t  uuid[VK_UUID_SIZE];
 };
 
-bool
-radv_pipeline_cache_load(struct radv_pipeline_cache *cache,
-			 const void *data, size_t size)
+/* After the header required by the Vulkan spec, the serialized cache has a
+ * format version and the number of entries, followed by the entries
+ * themselves, each one 8 byte aligned.  This lets the entries be used
+ * straight from the serialized data, their shader variants only get
+ * created on first use.
+ */
+#define RADV_PIPELINE_CACHE_FORMAT_VERSION 1
+
+struct cache_index_header {
+	uint32_t version;
+	uint32_t count;
+};
+
+static bool
+radv_pipeline_cache_check_header(struct radv_pipeline_cache *cache,
+				 const void *data, size_t size)
 {
 	struct radv_device *device = cache->device;
 	struct cache_header header;
+	struct cache_index_header index;
 
 	if (size < sizeof(header))
 		return false;
@@ -536,27 +575,98 @@ radv_pipeline_cache_load(struct radv_pipeline_cache *cache,
 	if (memcmp(header.uuid, device->physical_device->cache_uuid, VK_UUID_SIZE) != 0)
 		return false;
 
-	char *end = (void *) data + size;
-	char *p = (void *) data + header.header_size;
+	if (header.header_size > size ||
+	    size - header.header_size < sizeof(index))
+		return false;
+	memcpy(&index, (const char *)data + header.header_size, sizeof(index));
+	if (index.version != RADV_PIPELINE_CACHE_FORMAT_VERSION)
+		return false;
+
+	return true;
+}
+
+/* Adds the entries of the serialized data owned by the cache, in place. */
+static void
+radv_pipeline_cache_add_data_entries(struct radv_pipeline_cache *cache)
+{
+	const struct cache_header *header = cache->data;
+	const struct cache_index_header *index =
+		(const void *)((char *)cache->data + header->header_size);
+	char *end = (char *)cache->data + cache->data_size;
+	char *p = (char *)cache->data +
+		  align(header->header_size + sizeof(*index), 8);
+
+	for (uint32_t i = 0; i < index->count; i++) {
+		if (p > end || end - p < sizeof(struct cache_entry))
+			break;
 
-	while (end - p >= sizeof(struct cache_entry)) {
 		struct cache_entry *entry = (struct cache_entry*)p;
-		struct cache_entry *dest_entry;
 		size_t size = entry_size(entry);
-		if(end - p < size)
+		if (end - p < size)
 			break;
 
-		dest_entry = vk_alloc(&cache->alloc, size,
-					8, VK_SYSTEM_ALLOCATION_SCOPE_CACHE);
-		if (dest_entry) {
-			memcpy(dest_entry, entry, size);
-			for (int i = 0; i < MESA_SHADER_STAGES; ++i)
-				dest_entry->variants[i] = NULL;
-			radv_pipeline_cache_add_entry(cache, dest_entry);
-		}
-		p += size;
+		for (int j = 0; j < MESA_SHADER_STAGES; ++j)
+			entry->variants[j] = NULL;
+		radv_pipeline_cache_add_entry(cache, entry);
+
+		p += align(size, 8);
+	}
+}
+
+bool
+radv_pipeline_cache_load(struct radv_pipeline_cache *cache,
+			 const void *data, size_t size)
+{
+	assert(!cache->data);
+
+	if (!radv_pipeline_cache_check_header(cache, data, size))
+		return false;
+
+	/* The initial data doesn't outlive vkCreatePipelineCache(), so make
+	 * a single copy for all the entries to live in instead of allocating
+	 * and copying them one by one.
+	 */
+	cache->data = vk_alloc(&cache->alloc, size, 8,
+			       VK_SYSTEM_ALLOCATION_SCOPE_CACHE);
+	if (!cache->data)
+		return false;
+	memcpy(cache->data, data, size);
+	cache->data_size = size;
+
+	radv_pipeline_cache_add_data_entries(cache);
+
+	return true;
+}
+
+/* Loads a cache file by mapping it privately, so that the pages of entries
+ * which are never used are never read in.
+ */
+bool
+radv_pipeline_cache_load_file(struct radv_pipeline_cache *cache, int fd)
+{
+	struct stat st;
+
+	assert(!cache->data);
+
+	if (fstat(fd, &st) || st.st_size <= 0)
+		return false;
+
+	void *data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+			  MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED)
+		return false;
+
+	if (!radv_pipeline_cache_check_header(cache, data, st.st_size)) {
+		munmap(data, st.st_size);
+		return false;
 	}
 
+	cache->data = data;
+	cache->data_size = st.st_size;
+	cache->data_mapped = true;
+
+	radv_pipeline_cache_add_data_entries(cache);
+
 	return true;
 }
 
@@ -624,13 +734,14 @@ VkResult radv_GetPipelineCacheData(
 
 	pthread_mutex_lock(&cache->mutex);
 
-	const size_t size = sizeof(*header) + cache->total_size;
+	const size_t size = sizeof(*header) + sizeof(struct cache_index_header) +
+			    cache->total_size;
 	if (pData == NULL) {
 		pthread_mutex_unlock(&cache->mutex);
 		*pDataSize = size;
 		return VK_SUCCESS;
 	}
-	if (*pDataSize < sizeof(*header)) {
+	if (*pDataSize < sizeof(*header) + sizeof(struct cache_index_header)) {
 		pthread_mutex_unlock(&cache->mutex);
 		*pDataSize = 0;
 		return VK_INCOMPLETE;
@@ -644,21 +755,29 @@ VkResult radv_GetPipelineCacheData(
 	memcpy(header->uuid, device->physical_device->cache_uuid, VK_UUID_SIZE);
 	p += header->header_size;
 
+	struct cache_index_header *index = p;
+	index->version = RADV_PIPELINE_CACHE_FORMAT_VERSION;
+	index->count = 0;
+	p += sizeof(*index);
+
 	struct cache_entry *entry;
 	for (uint32_t i = 0; i < cache->table_size; i++) {
 		if (!cache->hash_table[i])
 			continue;
 		entry = cache->hash_table[i];
 		const uint32_t size = entry_size(entry);
-		if (end < p + size) {
+		const uint32_t aligned_size = align(size, 8);
+		if (end < p + aligned_size) {
 			result = VK_INCOMPLETE;
 			break;
 		}
 
 		memcpy(p, entry, size);
+		memset(p + size, 0, aligned_size - size);
 		for(int j = 0; j < MESA_SHADER_STAGES; ++j)
 			((struct cache_entry*)p)->variants[j] = NULL;
-		p += size;
+		p += aligned_size;
+		index->count++;
 	}
 	*pDataSize = p - pData;
 
@@ -675,6 +794,21 @@ radv_pipeline_cache_merge(struct radv_pipeline_cache *dst,
 		if (!entry || radv_pipeline_cache_search(dst, entry->sha1))
 			continue;
 
+		/* Entries living in the source's serialized data go away
+		 * with it, so give the destination its own copy.
+		 */
+		if (radv_pipeline_cache_entry_in_data(src, entry)) {
+			size_t size = entry_size(entry);
+			struct cache_entry *new_entry =
+				vk_alloc(&dst->alloc, size, 8,
+					 VK_SYSTEM_ALLOCATION_SCOPE_CACHE);
+			if (!new_entry)
+				continue;
+
+			memcpy(new_entry, entry, size);
+			entry = new_entry;
+		}
+
 		radv_pipeline_cache_add_entry(dst, entry);
 
 		src->hash_table[i] = NULL;
@@ -48,6 +48,7 @@
 #include "compiler/shader_enums.h"
 #include "util/macros.h"
 #include "util/list.h"
+#include "util/u_queue.h"
 #include "util/xmlconfig.h"
 #include "main/macros.h"
 #include "vk_alloc.h"
@@ -395,6 +396,13 @@ struct radv_pipeline_cache {
 	struct cache_entry **                        hash_table;
 	bool                                         modified;
 
+	/* Serialized cache the loaded entries point into, either a copy of
+	 * the initial data or a private mapping of the built-in cache file.
+	 */
+	void *                                       data;
+	size_t                                       data_size;
+	bool                                         data_mapped;
+
 	VkAllocationCallbacks                        alloc;
 };
 
@@ -434,6 +442,8 @@ radv_pipeline_cache_finish(struct radv_pipeline_cache *cache);
 bool
 radv_pipeline_cache_load(struct radv_pipeline_cache *cache,
 			 const void *data, size_t size);
+bool
+radv_pipeline_cache_load_file(struct radv_pipeline_cache *cache, int fd);
 
 bool
 radv_create_shader_variants_from_pipeline_cache(struct radv_device *device,
@@ -821,6 +831,22 @@ struct radv_device {
 	/* Backup in-memory cache to be used if the app doesn't provide one */
 	struct radv_pipeline_cache *                mem_cache;
 
+	/* Protects creation of the two thread pools below. */
+	mtx_t                                       queue_mutex;
+
+	/* Thread pool the fragment shader of a graphics pipeline is compiled
+	 * on while the other stages are compiled, created by the first
+	 * pipeline which can use it.
+	 */
+	bool                                        compile_queue_attempted;
+	struct util_queue                           compile_queue;
+
+	/* Thread pool batches of vkCreate*Pipelines are spread over, created
+	 * by the first batch which can use it.
+	 */
+	bool                                        pipeline_queue_attempted;
+	struct util_queue                           pipeline_queue;
+
 	/*
 	 * use different counters so MSAA MRTs get consecutive surface indices,
 	 * even if MASK is allocated in between.
@@ -883,6 +909,9 @@ struct radv_descriptor_set {
 	uint32_t *mapped_ptr;
 	struct radv_descriptor_range *dynamic_descriptors;
 
+	/* Index into the entries of the pool, for pools that allow freeing sets */
+	uint32_t pool_entry;
+
 	struct radeon_winsys_bo *descriptors[0];
 };
 
@@ -895,9 +924,22 @@ struct radv_push_descriptor_set
 struct radv_descriptor_pool_entry {
 	uint32_t offset;
 	uint32_t size;
+	/* Size of the host memory of the set in the pool, 0 if it was
+	 * allocated on the heap instead.
+	 */
+	uint32_t host_size;
 	struct radv_descriptor_set *set;
 };
 
+/* The memory of a freed set, kept for the next set of the same size */
+struct radv_descriptor_pool_hole {
+	struct radv_descriptor_pool_entry entry;
+	uint32_t next;
+};
+
+#define RADV_DESCRIPTOR_POOL_BUCKETS 64
+#define RADV_DESCRIPTOR_POOL_NO_HOLE UINT32_MAX
+
 struct radv_descriptor_pool {
 	struct radeon_winsys_bo *bo;
 	uint8_t *mapped_ptr;
@@ -908,8 +950,22 @@ struct radv_descriptor_pool {
 	uint8_t *host_memory_ptr;
 	uint8_t *host_memory_end;
 
+	/* Only used with VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+	 * the entries are in no particular order.
+	 */
+	bool allow_free;
 	uint32_t entry_count;
 	uint32_t max_entry_count;
+	uint32_t heap_set_count;
+
+	/* Holes are filed by size in units of 32 bytes, the last bucket takes
+	 * all the larger ones.
+	 */
+	struct radv_descriptor_pool_hole *holes;
+	uint32_t hole_count;
+	uint32_t free_holes;
+	uint32_t hole_buckets[RADV_DESCRIPTOR_POOL_BUCKETS];
+
 	struct radv_descriptor_pool_entry entries[0];
 };
 
@@ -1431,6 +1487,9 @@ void radv_emit_default_sample_locations(struct radeon_cmdbuf *cs, int nr_samples
 unsigned radv_get_default_max_sample_dist(int log_samples);
 void radv_device_init_msaa(struct radv_device *device);
 
+bool radv_device_alloc_is_default(const struct radv_device *device,
+				  const VkAllocationCallbacks *pAllocator);
+
 void radv_update_ds_clear_metadata(struct radv_cmd_buffer *cmd_buffer,
 				   const struct radv_image_view *iview,
 				   VkClearDepthStencilValue ds_clear_value,
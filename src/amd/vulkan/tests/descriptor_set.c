@@ -0,0 +1,600 @@
+/*
+ * Copyright © 2019 Valve Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Allocates, frees and updates descriptor sets against a winsys whose
+ * buffers live in host memory, checking that the sets of a pool never
+ * overlap and that update templates write the same descriptors as
+ * vkUpdateDescriptorSets().
+ *
+ * Run with --bench to time allocating and updating a frame worth of sets.
+ */
+
+#undef NDEBUG
+
+#include <stdio.h>
+
+#include "radv_private.h"
+#include "util/os_time.h"
+
+struct test_bo {
+	struct radeon_winsys_bo base;
+	void *map;
+};
+
+static struct radeon_winsys_bo *
+test_buffer_create(struct radeon_winsys *ws, uint64_t size, unsigned alignment,
+		   enum radeon_bo_domain domain, enum radeon_bo_flag flags,
+		   unsigned priority)
+{
+	struct test_bo *bo = calloc(1, sizeof(*bo));
+	bo->map = calloc(1, size);
+	bo->base.va = 0x100000000ull;
+	return &bo->base;
+}
+
+static void
+test_buffer_destroy(struct radeon_winsys_bo *_bo)
+{
+	struct test_bo *bo = (struct test_bo *)_bo;
+	free(bo->map);
+	free(bo);
+}
+
+static void *
+test_buffer_map(struct radeon_winsys_bo *_bo)
+{
+	return ((struct test_bo *)_bo)->map;
+}
+
+static void *
+test_alloc(void *user_data, size_t size, size_t align,
+	   VkSystemAllocationScope scope)
+{
+	return malloc(size);
+}
+
+static void *
+test_realloc(void *user_data, void *mem, size_t size, size_t align,
+	     VkSystemAllocationScope scope)
+{
+	return realloc(mem, size);
+}
+
+static void
+test_free(void *user_data, void *mem)
+{
+	free(mem);
+}
+
+static VkDescriptorSetLayout
+create_layout(struct radv_device *device,
+	      const VkDescriptorSetLayoutBinding *bindings, uint32_t count)
+{
+	const VkDescriptorSetLayoutCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = count,
+		.pBindings = bindings,
+	};
+	VkDescriptorSetLayout layout;
+
+	VkResult result = radv_CreateDescriptorSetLayout(radv_device_to_handle(device),
+							 &info, NULL, &layout);
+	assert(result == VK_SUCCESS);
+	return layout;
+}
+
+static struct radv_descriptor_pool *
+create_pool(struct radv_device *device, VkDescriptorPoolCreateFlags flags,
+	    uint32_t max_sets, const VkDescriptorPoolSize *sizes, uint32_t count)
+{
+	const VkDescriptorPoolCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		.flags = flags,
+		.maxSets = max_sets,
+		.poolSizeCount = count,
+		.pPoolSizes = sizes,
+	};
+	VkDescriptorPool pool;
+
+	VkResult result = radv_CreateDescriptorPool(radv_device_to_handle(device),
+						    &info, NULL, &pool);
+	assert(result == VK_SUCCESS);
+	return radv_descriptor_pool_from_handle(pool);
+}
+
+static void
+destroy_pool(struct radv_device *device, struct radv_descriptor_pool *pool)
+{
+	radv_DestroyDescriptorPool(radv_device_to_handle(device),
+				   radv_descriptor_pool_to_handle(pool), NULL);
+}
+
+static VkResult
+alloc_set(struct radv_device *device, struct radv_descriptor_pool *pool,
+	  VkDescriptorSetLayout layout, VkDescriptorSet *set)
+{
+	const VkDescriptorSetAllocateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+		.descriptorPool = radv_descriptor_pool_to_handle(pool),
+		.descriptorSetCount = 1,
+		.pSetLayouts = &layout,
+	};
+
+	return radv_AllocateDescriptorSets(radv_device_to_handle(device), &info, set);
+}
+
+static void
+free_set(struct radv_device *device, struct radv_descriptor_pool *pool,
+	 VkDescriptorSet set)
+{
+	radv_FreeDescriptorSets(radv_device_to_handle(device),
+				radv_descriptor_pool_to_handle(pool), 1, &set);
+}
+
+/* Every live set has to be tracked, and their descriptors must not overlap. */
+static void
+check_pool(struct radv_descriptor_pool *pool)
+{
+	for (uint32_t i = 0; i < pool->entry_count; i++) {
+		const struct radv_descriptor_pool_entry *a = &pool->entries[i];
+
+		assert(a->set->pool_entry == i);
+		assert(a->offset + a->size <= pool->size);
+		if (a->size)
+			assert(a->set->mapped_ptr == (uint32_t *)(pool->mapped_ptr + a->offset));
+
+		for (uint32_t j = i + 1; j < pool->entry_count; j++) {
+			const struct radv_descriptor_pool_entry *b = &pool->entries[j];
+			assert(a->set != b->set);
+			if (a->size && b->size)
+				assert(a->offset + a->size <= b->offset ||
+				       b->offset + b->size <= a->offset);
+		}
+	}
+}
+
+static void
+test_pool(struct radv_device *device)
+{
+	const uint32_t n = 64;
+	const VkDescriptorSetLayoutBinding image_binding = {
+		.binding = 0,
+		.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		.descriptorCount = 1,
+	};
+	const VkDescriptorSetLayoutBinding images_binding = {
+		.binding = 0,
+		.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		.descriptorCount = 2,
+	};
+	const VkDescriptorSetLayoutBinding buffer_binding = {
+		.binding = 0,
+		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+		.descriptorCount = 1,
+	};
+	VkDescriptorSetLayout image_layout = create_layout(device, &image_binding, 1);
+	VkDescriptorSetLayout images_layout = create_layout(device, &images_binding, 1);
+	VkDescriptorSetLayout buffer_layout = create_layout(device, &buffer_binding, 1);
+	const VkDescriptorPoolSize size = {
+		.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		.descriptorCount = n,
+	};
+	struct radv_descriptor_pool *pool =
+		create_pool(device, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+			    n, &size, 1);
+	VkDescriptorSet sets[64], extra;
+	VkResult result;
+
+	/* Fill the pool, it has room for exactly n image sets. */
+	for (uint32_t i = 0; i < n; i++) {
+		result = alloc_set(device, pool, image_layout, &sets[i]);
+		assert(result == VK_SUCCESS);
+	}
+	check_pool(pool);
+	result = alloc_set(device, pool, buffer_layout, &extra);
+	assert(result == VK_ERROR_OUT_OF_POOL_MEMORY);
+
+	/* Freed sets are handed out again to sets of the same size. */
+	for (uint32_t i = 0; i < n; i += 2) {
+		uint32_t *mapped_ptr = radv_descriptor_set_from_handle(sets[i])->mapped_ptr;
+		free_set(device, pool, sets[i]);
+		result = alloc_set(device, pool, image_layout, &sets[i]);
+		assert(result == VK_SUCCESS);
+		assert(radv_descriptor_set_from_handle(sets[i])->mapped_ptr == mapped_ptr);
+	}
+	check_pool(pool);
+
+	/* Smaller sets have to go through the gaps between the live ones. */
+	for (uint32_t i = 0; i < n; i += 2)
+		free_set(device, pool, sets[i]);
+	for (uint32_t i = 0; i < n; i += 2) {
+		result = alloc_set(device, pool, buffer_layout, &sets[i]);
+		assert(result == VK_SUCCESS);
+	}
+	check_pool(pool);
+
+	/* Larger sets only fit once their neighbours are gone, and they don't
+	 * fit in the host memory of the sets they replace.
+	 */
+	for (uint32_t i = 0; i < n; i++)
+		free_set(device, pool, sets[i]);
+	assert(pool->entry_count == 0);
+	for (uint32_t i = 0; i < n / 2; i++) {
+		result = alloc_set(device, pool, images_layout, &sets[i]);
+		assert(result == VK_SUCCESS);
+	}
+	assert(pool->heap_set_count > 0);
+	check_pool(pool);
+
+	radv_ResetDescriptorPool(radv_device_to_handle(device),
+				 radv_descriptor_pool_to_handle(pool), 0);
+	assert(pool->entry_count == 0 && pool->heap_set_count == 0);
+	for (uint32_t i = 0; i < n; i++) {
+		result = alloc_set(device, pool, image_layout, &sets[i]);
+		assert(result == VK_SUCCESS);
+	}
+	check_pool(pool);
+
+	/* maxSets applies whatever the size of the sets. */
+	free_set(device, pool, sets[0]);
+	result = alloc_set(device, pool, buffer_layout, &sets[0]);
+	assert(result == VK_SUCCESS);
+	result = alloc_set(device, pool, buffer_layout, &extra);
+	assert(result == VK_ERROR_OUT_OF_POOL_MEMORY);
+
+	/* The sets that are still allocated go away with the pool. */
+	destroy_pool(device, pool);
+
+	VkDevice _device = radv_device_to_handle(device);
+	radv_DestroyDescriptorSetLayout(_device, image_layout, NULL);
+	radv_DestroyDescriptorSetLayout(_device, images_layout, NULL);
+	radv_DestroyDescriptorSetLayout(_device, buffer_layout, NULL);
+}
+
+/* The objects the descriptors are written from */
+struct test_objects {
+	struct radeon_winsys_bo bo;
+	struct radv_buffer buffers[2];
+	struct radv_buffer_view buffer_view;
+	struct radv_image_view image_views[2];
+	struct radv_sampler samplers[2];
+};
+
+/* The data of the update template, also pointed at by the writes */
+struct test_update {
+	VkDescriptorBufferInfo buffers[2];
+	VkDescriptorImageInfo images[2];
+	VkDescriptorImageInfo sampler;
+	VkBufferView buffer_view;
+	VkDescriptorBufferInfo dynamic_buffer;
+	VkDescriptorImageInfo storage_image;
+};
+
+static const VkDescriptorSetLayoutBinding test_bindings[] = {
+	{ 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2, VK_SHADER_STAGE_ALL, NULL },
+	{ 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2, VK_SHADER_STAGE_ALL, NULL },
+	{ 2, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_ALL, NULL },
+	{ 3, VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1, VK_SHADER_STAGE_ALL, NULL },
+	{ 4, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_ALL, NULL },
+	{ 5, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_ALL, NULL },
+};
+
+static const VkDescriptorPoolSize test_pool_sizes[] = {
+	{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 },
+	{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 },
+	{ VK_DESCRIPTOR_TYPE_SAMPLER, 1 },
+	{ VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1 },
+	{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 },
+	{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 },
+};
+
+static struct radv_descriptor_pool *
+create_test_pool(struct radv_device *device, VkDescriptorPoolCreateFlags flags,
+		 uint32_t n_sets)
+{
+	VkDescriptorPoolSize sizes[ARRAY_SIZE(test_pool_sizes)];
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(sizes); i++) {
+		sizes[i] = test_pool_sizes[i];
+		sizes[i].descriptorCount *= n_sets;
+	}
+
+	return create_pool(device, flags, n_sets, sizes, ARRAY_SIZE(sizes));
+}
+
+static void
+init_objects(struct test_objects *objects, struct test_update *update)
+{
+	memset(objects, 0, sizeof(*objects));
+	objects->bo.va = 0x200000000ull;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		objects->buffers[i].bo = &objects->bo;
+		objects->buffers[i].size = 4096;
+		objects->buffers[i].offset = 256 * i;
+
+		objects->image_views[i].bo = &objects->bo;
+		for (uint32_t j = 0; j < 8; j++) {
+			objects->image_views[i].descriptor.plane0_descriptor[j] = 0x1000 * i + j;
+			objects->image_views[i].descriptor.fmask_descriptor[j] = 0x1100 * i + j;
+			objects->image_views[i].storage_descriptor.plane0_descriptor[j] = 0x1200 * i + j;
+		}
+
+		for (uint32_t j = 0; j < 4; j++)
+			objects->samplers[i].state[j] = 0x2000 * i + j;
+	}
+
+	objects->buffer_view.bo = &objects->bo;
+	for (uint32_t j = 0; j < 4; j++)
+		objects->buffer_view.state[j] = 0x3000 + j;
+
+	*update = (struct test_update) {
+		.buffers = {
+			{ radv_buffer_to_handle(&objects->buffers[0]), 16, 64 },
+			{ radv_buffer_to_handle(&objects->buffers[1]), 0, VK_WHOLE_SIZE },
+		},
+		.images = {
+			{ radv_sampler_to_handle(&objects->samplers[0]),
+			  radv_image_view_to_handle(&objects->image_views[0]),
+			  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+			{ radv_sampler_to_handle(&objects->samplers[1]),
+			  radv_image_view_to_handle(&objects->image_views[1]),
+			  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+		},
+		.sampler = { radv_sampler_to_handle(&objects->samplers[1]) },
+		.buffer_view = radv_buffer_view_to_handle(&objects->buffer_view),
+		.dynamic_buffer = { radv_buffer_to_handle(&objects->buffers[1]), 32, 128 },
+		.storage_image = { VK_NULL_HANDLE,
+				   radv_image_view_to_handle(&objects->image_views[1]),
+				   VK_IMAGE_LAYOUT_GENERAL },
+	};
+}
+
+static void
+write_set(struct radv_device *device, VkDescriptorSet set,
+	  const struct test_update *update)
+{
+	const VkWriteDescriptorSet writes[] = {
+		{ .dstBinding = 0, .descriptorCount = 2,
+		  .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+		  .pBufferInfo = update->buffers },
+		{ .dstBinding = 1, .descriptorCount = 2,
+		  .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		  .pImageInfo = update->images },
+		{ .dstBinding = 2, .descriptorCount = 1,
+		  .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+		  .pImageInfo = &update->sampler },
+		{ .dstBinding = 3, .descriptorCount = 1,
+		  .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,
+		  .pTexelBufferView = &update->buffer_view },
+		{ .dstBinding = 4, .descriptorCount = 1,
+		  .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+		  .pBufferInfo = &update->dynamic_buffer },
+		{ .dstBinding = 5, .descriptorCount = 1,
+		  .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+		  .pImageInfo = &update->storage_image },
+	};
+	VkWriteDescriptorSet sets[ARRAY_SIZE(writes)];
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(writes); i++) {
+		sets[i] = writes[i];
+		sets[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		sets[i].dstSet = set;
+	}
+
+	radv_UpdateDescriptorSets(radv_device_to_handle(device),
+				  ARRAY_SIZE(sets), sets, 0, NULL);
+}
+
+static VkDescriptorUpdateTemplate
+create_template(struct radv_device *device, VkDescriptorSetLayout layout)
+{
+	const VkDescriptorUpdateTemplateEntry entries[] = {
+		{ 0, 0, 2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+		  offsetof(struct test_update, buffers), sizeof(VkDescriptorBufferInfo) },
+		{ 1, 0, 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		  offsetof(struct test_update, images), sizeof(VkDescriptorImageInfo) },
+		{ 2, 0, 1, VK_DESCRIPTOR_TYPE_SAMPLER,
+		  offsetof(struct test_update, sampler), 0 },
+		{ 3, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,
+		  offsetof(struct test_update, buffer_view), 0 },
+		{ 4, 0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+		  offsetof(struct test_update, dynamic_buffer), 0 },
+		{ 5, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+		  offsetof(struct test_update, storage_image), 0 },
+	};
+	const VkDescriptorUpdateTemplateCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+		.descriptorUpdateEntryCount = ARRAY_SIZE(entries),
+		.pDescriptorUpdateEntries = entries,
+		.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+		.descriptorSetLayout = layout,
+	};
+	VkDescriptorUpdateTemplate templ;
+
+	VkResult result = radv_CreateDescriptorUpdateTemplate(radv_device_to_handle(device),
+							      &info, NULL, &templ);
+	assert(result == VK_SUCCESS);
+	return templ;
+}
+
+static void
+test_update(struct radv_device *device)
+{
+	VkDevice _device = radv_device_to_handle(device);
+	VkDescriptorSetLayout layout =
+		create_layout(device, test_bindings, ARRAY_SIZE(test_bindings));
+	struct radv_descriptor_pool *pool = create_test_pool(device, 0, 2);
+	VkDescriptorUpdateTemplate templ = create_template(device, layout);
+	struct test_objects objects;
+	struct test_update update;
+	VkDescriptorSet sets[2];
+
+	init_objects(&objects, &update);
+
+	for (uint32_t i = 0; i < 2; i++) {
+		VkResult result = alloc_set(device, pool, layout, &sets[i]);
+		assert(result == VK_SUCCESS);
+	}
+
+	write_set(device, sets[0], &update);
+	radv_UpdateDescriptorSetWithTemplate(_device, sets[1], templ, &update);
+
+	struct radv_descriptor_set *a = radv_descriptor_set_from_handle(sets[0]);
+	struct radv_descriptor_set *b = radv_descriptor_set_from_handle(sets[1]);
+	const struct radv_descriptor_set_layout *set_layout = a->layout;
+
+	assert(a->size == b->size && a->size > 0);
+	assert(memcmp(a->mapped_ptr, b->mapped_ptr, a->size) == 0);
+	assert(memcmp(a->descriptors, b->descriptors,
+		      set_layout->buffer_count * sizeof(a->descriptors[0])) == 0);
+	assert(memcmp(a->dynamic_descriptors, b->dynamic_descriptors,
+		      set_layout->dynamic_offset_count * sizeof(a->dynamic_descriptors[0])) == 0);
+
+	/* Spot check what was written. */
+	const uint32_t *image = a->mapped_ptr + set_layout->binding[1].offset / 4;
+	assert(image[0] == objects.image_views[0].descriptor.plane0_descriptor[0]);
+	assert(image[set_layout->binding[1].size / 4] ==
+	       objects.image_views[1].descriptor.plane0_descriptor[0]);
+	assert(a->dynamic_descriptors[0].va == objects.bo.va + 256 + 32);
+	assert(a->dynamic_descriptors[0].size == 128);
+	assert(a->descriptors[set_layout->binding[3].buffer_offset] == &objects.bo);
+
+	radv_DestroyDescriptorUpdateTemplate(_device, templ, NULL);
+	destroy_pool(device, pool);
+	radv_DestroyDescriptorSetLayout(_device, layout, NULL);
+}
+
+static double
+elapsed_ns(int64_t start, uint32_t n)
+{
+	return (double)(os_time_get_nano() - start) / n;
+}
+
+static void
+bench(struct radv_device *device)
+{
+	const uint32_t n_sets = 32768, n_frames = 16;
+	VkDevice _device = radv_device_to_handle(device);
+	VkDescriptorSetLayout layout =
+		create_layout(device, test_bindings, ARRAY_SIZE(test_bindings));
+	VkDescriptorSet *sets = malloc(n_sets * sizeof(*sets));
+	struct test_objects objects;
+	struct test_update update;
+	int64_t start;
+
+	init_objects(&objects, &update);
+
+	for (uint32_t f = 0; f < 2; f++) {
+		const VkDescriptorPoolCreateFlags flags =
+			f ? VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT : 0;
+		struct radv_descriptor_pool *pool =
+			create_test_pool(device, flags, n_sets);
+		VkDescriptorPool _pool = radv_descriptor_pool_to_handle(pool);
+
+		start = os_time_get_nano();
+		for (uint32_t frame = 0; frame < n_frames; frame++) {
+			for (uint32_t i = 0; i < n_sets; i++)
+				alloc_set(device, pool, layout, &sets[i]);
+			radv_ResetDescriptorPool(_device, _pool, 0);
+		}
+		printf("%s pool, allocate and reset: %.1f ns/set\n",
+		       f ? "free" : "linear", elapsed_ns(start, n_frames * n_sets));
+
+		if (f) {
+			for (uint32_t i = 0; i < n_sets; i++)
+				alloc_set(device, pool, layout, &sets[i]);
+
+			/* Free and reallocate sets all over the pool. */
+			start = os_time_get_nano();
+			for (uint32_t frame = 0; frame < n_frames; frame++) {
+				for (uint32_t i = frame % 4; i < n_sets; i += 4)
+					free_set(device, pool, sets[i]);
+				for (uint32_t i = frame % 4; i < n_sets; i += 4)
+					alloc_set(device, pool, layout, &sets[i]);
+			}
+			printf("free pool, free and reallocate: %.1f ns/set\n",
+			       elapsed_ns(start, n_frames * n_sets / 4));
+		}
+
+		destroy_pool(device, pool);
+	}
+
+	struct radv_descriptor_pool *pool = create_test_pool(device, 0, n_sets);
+	VkDescriptorUpdateTemplate templ = create_template(device, layout);
+
+	for (uint32_t i = 0; i < n_sets; i++)
+		alloc_set(device, pool, layout, &sets[i]);
+
+	start = os_time_get_nano();
+	for (uint32_t frame = 0; frame < n_frames; frame++) {
+		for (uint32_t i = 0; i < n_sets; i++)
+			write_set(device, sets[i], &update);
+	}
+	printf("vkUpdateDescriptorSets: %.1f ns/set\n",
+	       elapsed_ns(start, n_frames * n_sets));
+
+	start = os_time_get_nano();
+	for (uint32_t frame = 0; frame < n_frames; frame++) {
+		for (uint32_t i = 0; i < n_sets; i++)
+			radv_UpdateDescriptorSetWithTemplate(_device, sets[i], templ, &update);
+	}
+	printf("vkUpdateDescriptorSetWithTemplate: %.1f ns/set\n",
+	       elapsed_ns(start, n_frames * n_sets));
+
+	radv_DestroyDescriptorUpdateTemplate(_device, templ, NULL);
+	destroy_pool(device, pool);
+	radv_DestroyDescriptorSetLayout(_device, layout, NULL);
+	free(sets);
+}
+
+int main(int argc, char **argv)
+{
+	struct radv_instance instance = { 0 };
+	struct radv_physical_device physical_device = { 0 };
+	struct radeon_winsys ws = {
+		.buffer_create = test_buffer_create,
+		.buffer_destroy = test_buffer_destroy,
+		.buffer_map = test_buffer_map,
+	};
+	struct radv_device device = {
+		.alloc = {
+			.pfnAllocation = test_alloc,
+			.pfnReallocation = test_realloc,
+			.pfnFree = test_free,
+		},
+		.instance = &instance,
+		.ws = &ws,
+		.physical_device = &physical_device,
+	};
+
+	physical_device.rad_info.chip_class = GFX9;
+
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+		bench(&device);
+	} else {
+		test_pool(&device);
+		test_update(&device);
+	}
+}
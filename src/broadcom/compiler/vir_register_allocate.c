@@ -424,6 +424,46 @@ node_to_temp_priority(const void *in_a, const void *in_b)
                                          CLASS_BIT_ACC | \
                                          CLASS_BIT_R5)
 
+/**
+ * Returns the maximum number of simultaneously live temps that can't be
+ * rematerialized by spilling them as uniforms.
+ *
+ * This is a lower bound on the number of registers needed for allocation to
+ * succeed without TMU spilling, since the live ranges overlapping at a
+ * single point all interfere with each other.
+ */
+static int
+v3d_max_unspillable_pressure(struct v3d_compile *c)
+{
+        int num_ips = 0;
+        for (uint32_t i = 0; i < c->num_temps; i++)
+                num_ips = MAX2(num_ips, c->temp_end[i] + 1);
+
+        int *delta = calloc(num_ips + 1, sizeof(*delta));
+        if (!delta)
+                return 0;
+
+        for (uint32_t i = 0; i < c->num_temps; i++) {
+                if (c->temp_start[i] >= c->temp_end[i] ||
+                    vir_is_mov_uniform(c, i)) {
+                        continue;
+                }
+
+                delta[c->temp_start[i]]++;
+                delta[c->temp_end[i]]--;
+        }
+
+        int pressure = 0, max_pressure = 0;
+        for (int ip = 0; ip < num_ips; ip++) {
+                pressure += delta[ip];
+                max_pressure = MAX2(max_pressure, pressure);
+        }
+
+        free(delta);
+
+        return max_pressure;
+}
+
 /**
  * Returns a mapping from QFILE_TEMP indices to struct qpu_regs.
  *
@@ -459,6 +499,29 @@ v3d_register_allocate(struct v3d_compile *c, bool *spilled)
                         thread_index--;
         }
 
+        /* At thread counts where we don't TMU spill, only uniform loads can
+         * be spilled, so if the other values' pressure alone exceeds the
+         * register file, skip building and coloring a graph that can't be
+         * colored and let the caller drop the thread count right away.
+         */
+        if (thread_index > 0) {
+                int pressure = v3d_max_unspillable_pressure(c);
+                int num_regs = (PHYS_COUNT >> thread_index) + ACC_COUNT;
+
+                if (pressure > num_regs) {
+                        if (V3D_DEBUG & (V3D_DEBUG_VIR |
+                                         v3d_debug_flag_for_shader_stage(c->s->info.stage))) {
+                                fprintf(stderr, "%s prog %d/%d: register "
+                                        "pressure %d exceeds %d registers at "
+                                        "%d threads\n",
+                                        vir_get_stage_name(c),
+                                        c->program_id, c->variant_id,
+                                        pressure, num_regs, c->threads);
+                        }
+                        return NULL;
+                }
+        }
+
         struct ra_graph *g = ra_alloc_interference_graph(c->compiler->regs,
                                                          c->num_temps +
                                                          ARRAY_SIZE(acc_nodes));
@@ -218,6 +218,8 @@ struct ir3_instruction {
 		 */
 		IR3_INSTR_MARK  = 0x1000,
 		IR3_INSTR_UNUSED= 0x2000,
+		/* scratch flag used by ir3_sched to de-duplicate candidates: */
+		IR3_INSTR_SCHED_CANDIDATE = 0x4000,
 	} flags;
 	uint8_t repeat;
 	uint8_t nop;
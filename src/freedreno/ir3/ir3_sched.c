@@ -71,6 +71,15 @@ struct ir3_sched_ctx {
 	struct ir3_instruction *addr;      /* current a0.x user, if any */
 	struct ir3_instruction *pred;      /* current p0.x user, if any */
 	int live_values;                   /* estimate of current live values */
+
+	/* unique eligible instructions found by collect_candidates(), in
+	 * the order they were first reached walking the depth_list from
+	 * the end, and the depth of the deepest one:
+	 */
+	struct ir3_instruction **candidates;
+	unsigned candidates_count, candidates_size;
+	unsigned candidates_depth;
+
 	bool error;
 };
 
@@ -588,14 +597,23 @@ live_effect(struct ir3_instruction *instr)
 	return new_live - old_live;
 }
 
-/* find instruction to schedule: */
+/* Gather the eligible instructions for the next scheduling decision.
+ *
+ * Many entries in the depth_list resolve (via find_instr_recursive()) to
+ * the same eligible instruction, so the candidates are de-duplicated
+ * here, which lets find_eligible_instr() rank each one only once and
+ * avoids re-walking the depth_list for the soft and hard delay passes.
+ *
+ * Returns a meta instruction if one is eligible, since those are always
+ * scheduled right away.
+ */
 static struct ir3_instruction *
-find_eligible_instr(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes,
-		bool soft)
+collect_candidates(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes)
 {
-	struct ir3_instruction *best_instr = NULL;
-	int best_rank = INT_MAX;      /* lower is better */
-	unsigned deepest = 0;
+	struct ir3_instruction *meta = NULL;
+
+	ctx->candidates_count = 0;
+	ctx->candidates_depth = 0;
 
 	/* TODO we'd really rather use the list/array of block outputs.  But we
 	 * don't have such a thing.  Recursing *every* instruction in the list
@@ -610,21 +628,45 @@ find_eligible_instr(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes,
 		if (!candidate)
 			continue;
 
-		if (is_meta(candidate))
-			return candidate;
+		if (is_meta(candidate)) {
+			meta = candidate;
+			break;
+		}
+
+		if (candidate->flags & IR3_INSTR_SCHED_CANDIDATE)
+			continue;
+
+		candidate->flags |= IR3_INSTR_SCHED_CANDIDATE;
+
+		if (ctx->candidates_count == ctx->candidates_size) {
+			ctx->candidates_size = MAX2(64, ctx->candidates_size * 2);
+			ctx->candidates = reralloc(ctx->block->shader, ctx->candidates,
+					struct ir3_instruction *, ctx->candidates_size);
+		}
 
-		deepest = MAX2(deepest, candidate->depth);
+		ctx->candidates[ctx->candidates_count++] = candidate;
+		ctx->candidates_depth = MAX2(ctx->candidates_depth, candidate->depth);
 	}
 
-	/* traverse the list a second time.. but since we cache the result of
-	 * find_instr_recursive() it isn't as bad as it looks.
-	 */
-	foreach_instr_rev (instr, &ctx->depth_list) {
-		struct ir3_instruction *candidate;
+	for (unsigned i = 0; i < ctx->candidates_count; i++)
+		ctx->candidates[i]->flags &= ~IR3_INSTR_SCHED_CANDIDATE;
 
-		candidate = find_instr_recursive(ctx, notes, instr);
-		if (!candidate)
-			continue;
+	if (meta)
+		ctx->candidates_count = 0;
+
+	return meta;
+}
+
+/* find instruction to schedule among the collected candidates: */
+static struct ir3_instruction *
+find_eligible_instr(struct ir3_sched_ctx *ctx, bool soft)
+{
+	struct ir3_instruction *best_instr = NULL;
+	int best_rank = INT_MAX;      /* lower is better */
+	unsigned deepest = ctx->candidates_depth;
+
+	for (unsigned i = 0; i < ctx->candidates_count; i++) {
+		struct ir3_instruction *candidate = ctx->candidates[i];
 
 		/* determine net change to # of live values: */
 		int le = live_effect(candidate);
@@ -822,9 +864,11 @@ sched_block(struct ir3_sched_ctx *ctx, struct ir3_block *block)
 		struct ir3_sched_notes notes = {0};
 		struct ir3_instruction *instr;
 
-		instr = find_eligible_instr(ctx, &notes, true);
+		instr = collect_candidates(ctx, &notes);
 		if (!instr)
-			instr = find_eligible_instr(ctx, &notes, false);
+			instr = find_eligible_instr(ctx, true);
+		if (!instr)
+			instr = find_eligible_instr(ctx, false);
 
 		if (instr) {
 			unsigned delay = delay_calc(ctx->block, instr, false, false);
@@ -980,6 +1024,8 @@ int ir3_sched(struct ir3 *ir)
 		sched_intra_block(&ctx, block);
 	}
 
+	ralloc_free(ctx.candidates);
+
 	if (ctx.error)
 		return -1;
 
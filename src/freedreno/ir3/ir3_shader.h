@@ -644,6 +644,11 @@ struct ir3_shader {
 	struct ir3_shader_variant *variants;
 	mtx_t variants_lock;
 
+	/* variant being compiled in the background by the gallium driver,
+	 * if any (see ir3_shader_predict_variant()):
+	 */
+	struct ir3_shader_prediction *prediction;
+
 	uint32_t output_size; /* Size in dwords of all outputs for VS, size of entire patch for HS. */
 
 	/* Map from driver_location to byte offset in per-primitive storage */
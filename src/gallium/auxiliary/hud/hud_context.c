@@ -1273,6 +1273,12 @@ hud_parse_env_var(struct hud_context *hud, struct pipe_screen *screen,
       else if (strcmp(name, "main-thread-busy") == 0) {
          hud_thread_busy_install(pane, name, true);
       }
+      else if (strcmp(name, "upload-bytes") == 0) {
+         hud_upload_counter_install(pane, name, HUD_COUNTER_UPLOAD_BYTES);
+      }
+      else if (strcmp(name, "upload-buffer-allocs") == 0) {
+         hud_upload_counter_install(pane, name, HUD_COUNTER_UPLOAD_BUFFERS);
+      }
 #ifdef HAVE_GALLIUM_EXTRA_HUD
       else if (sscanf(name, "nic-rx-%s", arg_name) == 1) {
          hud_nic_graph_install(pane, arg_name, NIC_DIRECTION_RX);
@@ -1569,6 +1575,9 @@ print_help(struct pipe_screen *screen)
    for (i = 0; i < num_cpus; i++)
       printf("    cpu%i\n", i);
 
+   puts("    upload-bytes");
+   puts("    upload-buffer-allocs");
+
    if (has_occlusion_query(screen))
       puts("    samples-passed");
    if (has_streamout(screen))
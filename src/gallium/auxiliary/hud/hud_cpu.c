@@ -33,6 +33,7 @@
 #include "os/os_thread.h"
 #include "util/u_memory.h"
 #include "util/u_queue.h"
+#include "util/u_upload_mgr.h"
 #include <stdio.h>
 #include <inttypes.h>
 #ifdef PIPE_OS_WINDOWS
@@ -466,3 +467,88 @@ void hud_thread_counter_install(struct hud_pane *pane, const char *name,
    hud_pane_add_graph(pane, gr);
    hud_pane_set_max_value(pane, 100);
 }
+
+struct upload_counter_info {
+   enum hud_counter counter;
+   uint64_t last_value;    /* Counter value at the previous frame. */
+   uint64_t period_total;  /* Sum of the per-frame deltas this period. */
+   unsigned num_frames;    /* Frames seen this period. */
+   int64_t last_time;
+};
+
+static uint64_t get_upload_counter(struct pipe_context *pipe,
+                                   enum hud_counter counter)
+{
+   struct u_upload_stats stats;
+
+   if (!pipe->stream_uploader)
+      return 0;
+
+   u_upload_get_stats(pipe->stream_uploader, &stats);
+
+   switch (counter) {
+   case HUD_COUNTER_UPLOAD_BYTES:
+      return stats.bytes_uploaded;
+   case HUD_COUNTER_UPLOAD_BUFFERS:
+      return stats.num_buffers_allocated;
+   default:
+      assert(0);
+      return 0;
+   }
+}
+
+/* Called once per frame.  The upload manager counters only ever grow, so
+ * the value for this frame is the difference to the previous frame, and
+ * the graph shows the average of those over the HUD period.
+ */
+static void
+query_upload_counter(struct hud_graph *gr, struct pipe_context *pipe)
+{
+   struct upload_counter_info *info = gr->query_data;
+   uint64_t current_value = get_upload_counter(pipe, info->counter);
+   int64_t now = os_time_get_nano();
+
+   if (info->last_time) {
+      info->period_total += current_value - info->last_value;
+      info->num_frames++;
+
+      if (info->last_time + gr->pane->period*1000 <= now) {
+         hud_graph_add_value(gr, (double)info->period_total /
+                                 info->num_frames);
+         info->period_total = 0;
+         info->num_frames = 0;
+         info->last_time = now;
+      }
+   } else {
+      /* initialize */
+      info->last_time = now;
+   }
+   info->last_value = current_value;
+}
+
+void hud_upload_counter_install(struct hud_pane *pane, const char *name,
+                                enum hud_counter counter)
+{
+   struct hud_graph *gr = CALLOC_STRUCT(hud_graph);
+   if (!gr)
+      return;
+
+   strcpy(gr->name, name);
+
+   gr->query_data = CALLOC_STRUCT(upload_counter_info);
+   if (!gr->query_data) {
+      FREE(gr);
+      return;
+   }
+
+   ((struct upload_counter_info*)gr->query_data)->counter = counter;
+   gr->query_new_value = query_upload_counter;
+
+   /* Don't use free() as our callback as that messes up Gallium's
+    * memory debugger.  Use simple free_query_data() wrapper.
+    */
+   gr->free_query_data = free_query_data;
+
+   hud_pane_add_graph(pane, gr);
+   hud_pane_set_max_value(pane, 100);
+}
@@ -986,6 +986,9 @@ static const struct {
    { TEMP_PRIMITIVE_S3_I, TEMP_PRIMITIVE_S3_C },
 };
 
+/** All TGSI_QUAD_SIZE lanes enabled */
+#define TGSI_EXEC_FULL_MASK ((1 << TGSI_QUAD_SIZE) - 1)
+
 /** The execution mask depends on the conditional mask and the loop mask */
 #define UPDATE_EXEC_MASK(MACH) \
       MACH->ExecMask = MACH->CondMask & MACH->LoopMask & MACH->ContMask & MACH->Switch.mask & MACH->FuncMask
@@ -1957,6 +1960,22 @@ store_dest(struct tgsi_exec_machine *mach,
    if (!dst)
       return;
 
+   /* Fast path: with all lanes live (the common case outside of divergent
+    * control flow) the per-lane mask tests can be dropped, which lets the
+    * compiler emit these as straight vector loads/stores.
+    */
+   if ((execmask & TGSI_EXEC_FULL_MASK) == TGSI_EXEC_FULL_MASK) {
+      if (!inst->Instruction.Saturate) {
+         *dst = *chan;
+      }
+      else {
+         for (i = 0; i < TGSI_QUAD_SIZE; i++)
+            dst->f[i] = chan->f[i] < 0.0f ? 0.0f :
+                        chan->f[i] > 1.0f ? 1.0f : chan->f[i];
+      }
+      return;
+   }
+
    if (!inst->Instruction.Saturate) {
       for (i = 0; i < TGSI_QUAD_SIZE; i++)
          if (execmask & (1 << i))
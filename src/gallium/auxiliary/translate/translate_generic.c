@@ -707,6 +707,75 @@ generic_run_elts8(struct translate *translate,
    }
 }
 
+/**
+ * Fast path for generic_run() over a contiguous, in-bounds vertex range
+ * where every element is a regular vertex attribute.  The per-vertex
+ * index clamping and stride multiplication of generic_run_one() are
+ * replaced by a running source pointer per attribute.
+ * \return FALSE if the range/elements don't qualify.
+ */
+static boolean
+generic_run_linear(struct translate_generic *tg,
+                   unsigned start,
+                   unsigned count,
+                   unsigned start_instance,
+                   unsigned instance_id,
+                   void *output_buffer)
+{
+   const uint8_t *src[TRANSLATE_MAX_ATTRIBS];
+   unsigned src_stride[TRANSLATE_MAX_ATTRIBS];
+   unsigned nr_attrs = tg->nr_attrib;
+   unsigned output_stride = tg->translate.key.output_stride;
+   uint8_t *vert = output_buffer;
+   unsigned attr, i;
+
+   for (attr = 0; attr < nr_attrs; attr++) {
+      unsigned index;
+
+      if (tg->attrib[attr].type != TRANSLATE_ELEMENT_NORMAL)
+         return FALSE;
+
+      if (tg->attrib[attr].instance_divisor) {
+         /* constant across the whole run */
+         index = start_instance +
+                 instance_id / tg->attrib[attr].instance_divisor;
+         src_stride[attr] = 0;
+      }
+      else {
+         /* no clamping needed if the whole range is in bounds */
+         if (start > tg->attrib[attr].max_index ||
+             count - 1 > tg->attrib[attr].max_index - start)
+            return FALSE;
+         index = start;
+         src_stride[attr] = tg->attrib[attr].input_stride;
+      }
+
+      src[attr] = tg->attrib[attr].input_ptr +
+                  (ptrdiff_t)tg->attrib[attr].input_stride * index;
+   }
+
+   for (i = 0; i < count; i++) {
+      for (attr = 0; attr < nr_attrs; attr++) {
+         uint8_t *dst = vert + tg->attrib[attr].output_offset;
+         int copy_size = tg->attrib[attr].copy_size;
+
+         if (likely(copy_size >= 0)) {
+            memcpy(dst, src[attr], copy_size);
+         } else {
+            float data[4];
+
+            tg->attrib[attr].fetch(data, src[attr], 0, 0);
+            tg->attrib[attr].emit(data, dst);
+         }
+
+         src[attr] += src_stride[attr];
+      }
+      vert += output_stride;
+   }
+
+   return TRUE;
+}
+
 static void PIPE_CDECL
 generic_run(struct translate *translate,
             unsigned start,
@@ -719,6 +788,11 @@ generic_run(struct translate *translate,
    char *vert = output_buffer;
    unsigned i;
 
+   if (count &&
+       generic_run_linear(tg, start, count, start_instance, instance_id,
+                          output_buffer))
+      return;
+
    for (i = 0; i < count; i++) {
       generic_run_one(tg, start + i, start_instance, instance_id, vert);
       vert += tg->translate.key.output_stride;
@@ -38,6 +38,8 @@
 #include "util/u_gen_mipmap.h"
 #include "util/format/u_format.h"
 #include "util/u_inlines.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
 
 
 /**
@@ -126,3 +128,152 @@ util_gen_mipmap(struct pipe_context *pipe, struct pipe_resource *pt,
    }
    return TRUE;
 }
+
+
+/**
+ * Box-filter one row of a mipmap level from 2 (or 4 for 3D textures)
+ * unpacked source rows.
+ */
+static void
+gen_mipmap_row(float *dst, float * const *src, unsigned num_src,
+               unsigned src_width, unsigned dst_width)
+{
+   const float scale = 1.0f / (2 * num_src);
+   unsigned x, c, i;
+
+   for (x = 0; x < dst_width; x++) {
+      unsigned x0 = 2 * x * 4;
+      unsigned x1 = MIN2(2 * x + 1, src_width - 1) * 4;
+
+      for (c = 0; c < 4; c++) {
+         float sum = 0.0f;
+
+         for (i = 0; i < num_src; i++)
+            sum += src[i][x0 + c] + src[i][x1 + c];
+
+         dst[x * 4 + c] = sum * scale;
+      }
+   }
+}
+
+
+/**
+ * Generate mipmap images on the CPU, for software drivers.
+ *
+ * Unlike util_gen_mipmap(), this doesn't go through pipe->blit, so the
+ * whole chain is built without a draw and flush per level.  Texels are
+ * unpacked to float and repacked with the util_format helpers, so sRGB
+ * formats are filtered in linear space.  Source rows are streamed
+ * through a small scratch buffer rather than holding entire levels.
+ *
+ * Matches the pipe_context::generate_mipmap interface.
+ * \return FALSE if the format isn't supported, in which case the caller
+ *         should fall back to util_gen_mipmap().
+ */
+bool
+util_gen_mipmap_cpu(struct pipe_context *pipe, struct pipe_resource *pt,
+                    enum pipe_format format, unsigned base_level,
+                    unsigned last_level, unsigned first_layer,
+                    unsigned last_layer)
+{
+   const struct util_format_description *desc =
+      util_format_description(format);
+   const boolean is_3d = pt->target == PIPE_TEXTURE_3D;
+   unsigned max_width, level;
+   float *rows;
+
+   if (!desc ||
+       desc->block.width != 1 || desc->block.height != 1 ||
+       desc->block.depth != 1 ||
+       !desc->unpack_rgba_float || !desc->pack_rgba_float ||
+       util_format_is_depth_or_stencil(format) ||
+       util_format_is_pure_integer(format) ||
+       pt->nr_samples > 1)
+      return false;
+
+   assert(last_level <= pt->last_level);
+   assert(last_level > base_level);
+
+   /* 4 source rows + 1 destination row */
+   max_width = u_minify(pt->width0, base_level);
+   rows = MALLOC(max_width * 4 * sizeof(float) * 5);
+   if (!rows)
+      return false;
+
+   for (level = base_level + 1; level <= last_level; level++) {
+      const unsigned src_level = level - 1;
+      const unsigned sw = u_minify(pt->width0, src_level);
+      const unsigned sh = u_minify(pt->height0, src_level);
+      const unsigned dw = u_minify(pt->width0, level);
+      const unsigned dh = u_minify(pt->height0, level);
+      unsigned z_first, src_depth, dst_depth, z, y;
+      struct pipe_transfer *src_xfer, *dst_xfer;
+      const uint8_t *src_map;
+      uint8_t *dst_map;
+
+      if (is_3d) {
+         z_first = 0;
+         src_depth = u_minify(pt->depth0, src_level);
+         dst_depth = u_minify(pt->depth0, level);
+      }
+      else {
+         z_first = first_layer;
+         src_depth = dst_depth = last_layer + 1 - first_layer;
+      }
+
+      src_map = pipe_transfer_map_3d(pipe, pt, src_level, PIPE_TRANSFER_READ,
+                                     0, 0, z_first, sw, sh, src_depth,
+                                     &src_xfer);
+      if (!src_map)
+         goto fail;
+
+      dst_map = pipe_transfer_map_3d(pipe, pt, level,
+                                     PIPE_TRANSFER_WRITE |
+                                     PIPE_TRANSFER_DISCARD_RANGE,
+                                     0, 0, z_first, dw, dh, dst_depth,
+                                     &dst_xfer);
+      if (!dst_map) {
+         pipe->transfer_unmap(pipe, src_xfer);
+         goto fail;
+      }
+
+      for (z = 0; z < dst_depth; z++) {
+         const unsigned z0 = is_3d ? MIN2(2 * z, src_depth - 1) : z;
+         const unsigned z1 = is_3d ? MIN2(2 * z + 1, src_depth - 1) : z;
+         const unsigned num_src = z0 != z1 ? 4 : 2;
+
+         for (y = 0; y < dh; y++) {
+            const unsigned ys[2] = { 2 * y, MIN2(2 * y + 1, sh - 1) };
+            const unsigned zs[2] = { z0, z1 };
+            float *src_rows[4];
+            float *dst_row = rows + 4 * max_width * 4;
+            unsigned i;
+
+            for (i = 0; i < num_src; i++) {
+               src_rows[i] = rows + i * max_width * 4;
+               desc->unpack_rgba_float(src_rows[i], 0,
+                                       src_map +
+                                       zs[i / 2] * src_xfer->layer_stride +
+                                       ys[i % 2] * src_xfer->stride,
+                                       0, sw, 1);
+            }
+
+            gen_mipmap_row(dst_row, src_rows, num_src, sw, dw);
+
+            desc->pack_rgba_float(dst_map + z * dst_xfer->layer_stride +
+                                  y * dst_xfer->stride, 0,
+                                  dst_row, 0, dw, 1);
+         }
+      }
+
+      pipe->transfer_unmap(pipe, dst_xfer);
+      pipe->transfer_unmap(pipe, src_xfer);
+   }
+
+   FREE(rows);
+   return true;
+
+fail:
+   FREE(rows);
+   return false;
+}
@@ -43,6 +43,12 @@ util_gen_mipmap(struct pipe_context *pipe, struct pipe_resource *pt,
                 enum pipe_format format, uint base_level, uint last_level,
                 uint first_layer, uint last_layer, uint filter);
 
+extern bool
+util_gen_mipmap_cpu(struct pipe_context *pipe, struct pipe_resource *pt,
+                    enum pipe_format format, unsigned base_level,
+                    unsigned last_level, unsigned first_layer,
+                    unsigned last_layer);
+
 
 #ifdef __cplusplus
 }
@@ -54,6 +54,13 @@ struct u_upload_mgr {
    unsigned offset; /* Aligned offset to the upload buffer, pointing
                      * at the first unused byte. */
    unsigned flushed_size; /* Size we have flushed by transfer_flush_region. */
+
+   boolean recycle;        /* Whether to reuse idle buffers, see
+                            * u_upload_enable_recycling. */
+   unsigned max_size;      /* Upper bound for buffer size growth. */
+   unsigned cur_size;      /* Size of the next buffer allocation. */
+
+   struct u_upload_stats stats;
 };
 
 
@@ -70,6 +77,7 @@ u_upload_create(struct pipe_context *pipe, unsigned default_size,
    upload->bind = bind;
    upload->usage = usage;
    upload->flags = flags;
+   upload->cur_size = default_size;
 
    upload->map_persistent =
       pipe->screen->get_param(pipe->screen,
@@ -111,6 +119,8 @@ u_upload_clone(struct pipe_context *pipe, struct u_upload_mgr *upload)
    else if (upload->map_persistent &&
             upload->map_flags & PIPE_TRANSFER_FLUSH_EXPLICIT)
       u_upload_enable_flush_explicit(result);
+   if (upload->recycle)
+      u_upload_enable_recycling(result, upload->max_size);
 
    return result;
 }
@@ -131,6 +141,20 @@ u_upload_disable_persistent(struct u_upload_mgr *upload)
    upload->map_flags |= PIPE_TRANSFER_FLUSH_EXPLICIT;
 }
 
+void
+u_upload_enable_recycling(struct u_upload_mgr *upload, unsigned max_size)
+{
+   upload->recycle = TRUE;
+   upload->max_size = MAX2(max_size, upload->default_size);
+}
+
+void
+u_upload_get_stats(const struct u_upload_mgr *upload,
+                   struct u_upload_stats *stats)
+{
+   *stats = upload->stats;
+}
+
 static void
 upload_unmap_internal(struct u_upload_mgr *upload, boolean destroying)
 {
@@ -182,6 +206,47 @@ u_upload_destroy(struct u_upload_mgr *upload)
 }
 
 
+/**
+ * Try to restart suballocation at the beginning of the current buffer.
+ *
+ * This is only possible if nobody but us holds a reference to it (so no
+ * earlier suballocation is still waiting to be used) and the driver can
+ * map it without waiting (so no earlier suballocation is still in flight).
+ */
+static boolean
+u_upload_recycle_buffer(struct u_upload_mgr *upload, unsigned min_size)
+{
+   struct pipe_resource *buf = upload->buffer;
+   unsigned size;
+
+   if (!buf || buf->width0 < min_size)
+      return FALSE;
+
+   /* Drivers may hold a reference to the buffer in our transfer, so unmap
+    * it before looking at the reference count.  If the buffer can't be
+    * recycled, it is released right after anyway.
+    */
+   upload_unmap_internal(upload, TRUE);
+   if (p_atomic_read(&buf->reference.count) != 1)
+      return FALSE;
+
+   size = buf->width0;
+
+   upload->map = pipe_buffer_map_range(upload->pipe, buf, 0, size,
+                                       (upload->map_flags &
+                                        ~PIPE_TRANSFER_UNSYNCHRONIZED) |
+                                       PIPE_TRANSFER_DONTBLOCK,
+                                       &upload->transfer);
+   if (!upload->map) {
+      upload->transfer = NULL;
+      return FALSE;
+   }
+
+   upload->offset = 0;
+   upload->stats.num_buffers_recycled++;
+   return TRUE;
+}
+
 static void
 u_upload_alloc_buffer(struct u_upload_mgr *upload, unsigned min_size)
 {
@@ -189,13 +254,25 @@ u_upload_alloc_buffer(struct u_upload_mgr *upload, unsigned min_size)
    struct pipe_resource buffer;
    unsigned size;
 
+   if (upload->recycle) {
+      if (u_upload_recycle_buffer(upload, min_size))
+         return;
+
+      /* The old buffer is still busy, so we are cycling through buffers
+       * faster than they retire.  Grow the next one to cut down on the
+       * number of resource creations.
+       */
+      if (upload->buffer)
+         upload->cur_size = MIN2(upload->cur_size * 2, upload->max_size);
+   }
+
    /* Release the old buffer, if present:
     */
    u_upload_release_buffer(upload);
 
    /* Allocate a new one:
     */
-   size = align(MAX2(upload->default_size, min_size), 4096);
+   size = align(MAX2(upload->cur_size, min_size), 4096);
 
    memset(&buffer, 0, sizeof buffer);
    buffer.target = PIPE_BUFFER;
@@ -228,6 +305,7 @@ u_upload_alloc_buffer(struct u_upload_mgr *upload, unsigned min_size)
    }
 
    upload->offset = 0;
+   upload->stats.num_buffers_allocated++;
 }
 
 void
@@ -291,6 +369,7 @@ u_upload_alloc(struct u_upload_mgr *upload,
    *out_offset = offset;
 
    upload->offset = offset + size;
+   upload->stats.bytes_uploaded += size;
 }
 
 void
@@ -38,6 +38,16 @@
 struct pipe_context;
 struct pipe_resource;
 
+/**
+ * Cumulative upload manager statistics, e.g. for the HUD.
+ */
+struct u_upload_stats {
+   uint64_t bytes_uploaded;         /* Total size of all suballocations. */
+   unsigned num_buffers_allocated;  /* Number of buffers created. */
+   unsigned num_buffers_recycled;   /* Number of times a full buffer
+                                     * was reused from the start. */
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -77,6 +87,22 @@ u_upload_enable_flush_explicit(struct u_upload_mgr *upload);
 void
 u_upload_disable_persistent(struct u_upload_mgr *upload);
 
+/**
+ * Reuse the upload buffer from the start once the driver reports it idle,
+ * instead of always allocating a new one when it is full.  While buffers
+ * are still busy when they fill up, the size of newly allocated buffers
+ * doubles up to max_size.
+ *
+ * This relies on the driver honouring PIPE_TRANSFER_DONTBLOCK for buffers.
+ */
+void
+u_upload_enable_recycling(struct u_upload_mgr *upload, unsigned max_size);
+
+/** Return the cumulative statistics of the upload manager. */
+void
+u_upload_get_stats(const struct u_upload_mgr *upload,
+                   struct u_upload_stats *stats);
+
 /**
  * Destroy the upload manager.
  */
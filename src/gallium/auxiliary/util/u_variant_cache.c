@@ -0,0 +1,141 @@
+/*
+ * Copyright © 2019 Broadcom
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "compiler/nir/nir.h"
+#include "compiler/nir/nir_serialize.h"
+#include "util/blob.h"
+#include "util/mesa-sha1.h"
+#include "util/ralloc.h"
+#include "util/u_variant_cache.h"
+
+/**
+ * Hashes the NIR of an uncompiled shader, without its names and other debug
+ * information so that isomorphic shaders share their cache entries.
+ */
+void
+u_variant_cache_hash_nir(struct nir_shader *nir, unsigned char sha1[20])
+{
+   struct blob blob;
+
+   blob_init(&blob);
+   nir_serialize(&blob, nir, true);
+   _mesa_sha1_compute(blob.data, blob.size, sha1);
+   blob_finish(&blob);
+}
+
+/**
+ * Computes the cache key of a variant.
+ *
+ * The variant key is hashed as raw bytes, so any pointers in it have to be
+ * cleared by the caller first.
+ */
+void
+u_variant_cache_compute_key(struct disk_cache *cache,
+                            const unsigned char shader_sha1[20],
+                            const void *variant_key, size_t key_size,
+                            cache_key out_key)
+{
+   struct blob blob;
+
+   blob_init(&blob);
+   blob_write_bytes(&blob, shader_sha1, 20);
+   blob_write_bytes(&blob, variant_key, key_size);
+   disk_cache_compute_key(cache, blob.data, blob.size, out_key);
+   blob_finish(&blob);
+}
+
+void
+u_variant_cache_put(struct disk_cache *cache, const cache_key key,
+                    const struct u_variant_cache_part *parts,
+                    unsigned num_parts)
+{
+   struct blob blob;
+
+   blob_init(&blob);
+   blob_write_uint32(&blob, num_parts);
+   for (unsigned i = 0; i < num_parts; i++) {
+      blob_write_uint32(&blob, parts[i].size);
+      blob_write_bytes(&blob, parts[i].data, parts[i].size);
+   }
+
+   if (!blob.out_of_memory)
+      disk_cache_put(cache, key, blob.data, blob.size, NULL);
+   blob_finish(&blob);
+}
+
+/**
+ * Looks up a variant stored with u_variant_cache_put().
+ *
+ * On a hit, fills in parts with ralloc()ed copies of the stored parts,
+ * children of mem_ctx.  Returns false on a miss, or if the entry doesn't
+ * hold exactly num_parts parts.
+ */
+bool
+u_variant_cache_get(struct disk_cache *cache, const cache_key key,
+                    void *mem_ctx, struct u_variant_cache_part *parts,
+                    unsigned num_parts)
+{
+   size_t size;
+   void *buffer = disk_cache_get(cache, key, &size);
+   if (!buffer)
+      return false;
+
+   struct blob_reader blob;
+   blob_reader_init(&blob, buffer, size);
+
+   void *parts_ctx = ralloc_context(mem_ctx);
+   bool ok = blob_read_uint32(&blob) == num_parts;
+
+   for (unsigned i = 0; ok && i < num_parts; i++) {
+      parts[i].size = blob_read_uint32(&blob);
+      const void *data = blob_read_bytes(&blob, parts[i].size);
+      if (blob.overrun) {
+         ok = false;
+         break;
+      }
+
+      parts[i].data = ralloc_size(parts_ctx, MAX2(parts[i].size, 1));
+      if (!parts[i].data) {
+         ok = false;
+         break;
+      }
+      memcpy(parts[i].data, data, parts[i].size);
+   }
+
+   ok = ok && blob.current == blob.end;
+   free(buffer);
+
+   if (!ok) {
+      ralloc_free(parts_ctx);
+      return false;
+   }
+
+   for (unsigned i = 0; i < num_parts; i++)
+      ralloc_steal(mem_ctx, parts[i].data);
+   ralloc_free(parts_ctx);
+
+   return true;
+}
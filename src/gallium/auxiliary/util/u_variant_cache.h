@@ -0,0 +1,78 @@
+/*
+ * Copyright © 2019 Broadcom
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ *
+ * Helpers for drivers storing compiled shader variants in the on-disk
+ * shader cache.
+ *
+ * A variant is looked up by the hash of the uncompiled NIR and the driver's
+ * variant key.  Its cache entry holds a list of driver-defined parts (program
+ * data, instructions, ...), each stored with its size so that a truncated or
+ * mismatched entry is turned into a miss.
+ */
+
+#ifndef U_VARIANT_CACHE_H
+#define U_VARIANT_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "util/disk_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct nir_shader;
+
+struct u_variant_cache_part {
+   void *data;
+   size_t size;
+};
+
+void
+u_variant_cache_hash_nir(struct nir_shader *nir, unsigned char sha1[20]);
+
+void
+u_variant_cache_compute_key(struct disk_cache *cache,
+                            const unsigned char shader_sha1[20],
+                            const void *variant_key, size_t key_size,
+                            cache_key out_key);
+
+void
+u_variant_cache_put(struct disk_cache *cache, const cache_key key,
+                    const struct u_variant_cache_part *parts,
+                    unsigned num_parts);
+
+bool
+u_variant_cache_get(struct disk_cache *cache, const cache_key key,
+                    void *mem_ctx, struct u_variant_cache_part *parts,
+                    unsigned num_parts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_VARIANT_CACHE_H */
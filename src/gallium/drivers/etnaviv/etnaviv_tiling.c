@@ -26,59 +26,33 @@
 
 #include "etnaviv_tiling.h"
 
+#include "util/u_tiling.h"
+
 #include <stdint.h>
 #include <stdio.h>
 
 #define TEX_TILE_WIDTH (4)
 #define TEX_TILE_HEIGHT (4)
-#define TEX_TILE_WORDS (TEX_TILE_WIDTH * TEX_TILE_HEIGHT)
-
-#define DO_TILE(type)                                                   \
-   src_stride /= sizeof(type);                                          \
-   dst_stride = (dst_stride * TEX_TILE_HEIGHT) / sizeof(type);          \
-   for (unsigned srcy = 0; srcy < height; ++srcy) {                     \
-      unsigned dsty = basey + srcy;                                     \
-      unsigned ty = (dsty / TEX_TILE_HEIGHT) * dst_stride +             \
-                    (dsty % TEX_TILE_HEIGHT) * TEX_TILE_WIDTH;          \
-      for (unsigned srcx = 0; srcx < width; ++srcx) {                   \
-         unsigned dstx = basex + srcx;                                  \
-         ((type *)dest)[ty + (dstx / TEX_TILE_WIDTH) * TEX_TILE_WORDS + \
-                        (dstx % TEX_TILE_WIDTH)] =                      \
-            ((type *)src)[srcy * src_stride + srcx];                    \
-      }                                                                 \
-   }
-
-#define DO_UNTILE(type)                                                   \
-   src_stride = (src_stride * TEX_TILE_HEIGHT) / sizeof(type);            \
-   dst_stride /= sizeof(type);                                            \
-   for (unsigned dsty = 0; dsty < height; ++dsty) {                       \
-      unsigned srcy = basey + dsty;                                       \
-      unsigned sy = (srcy / TEX_TILE_HEIGHT) * src_stride +               \
-                    (srcy % TEX_TILE_HEIGHT) * TEX_TILE_WIDTH;            \
-      for (unsigned dstx = 0; dstx < width; ++dstx) {                     \
-         unsigned srcx = basex + dstx;                                    \
-         ((type *)dest)[dsty * dst_stride + dstx] =                       \
-            ((type *)src)[sy + (srcx / TEX_TILE_WIDTH) * TEX_TILE_WORDS + \
-                          (srcx % TEX_TILE_WIDTH)];                       \
-      }                                                                   \
-   }
 
 void
 etna_texture_tile(void *dest, void *src, unsigned basex, unsigned basey,
                   unsigned dst_stride, unsigned width, unsigned height,
                   unsigned src_stride, unsigned elmtsize)
 {
-   if (elmtsize == 8) {
-      DO_TILE(uint64_t)
-   } else if (elmtsize == 4) {
-      DO_TILE(uint32_t)
-   } else if (elmtsize == 2) {
-      DO_TILE(uint16_t)
-   } else if (elmtsize == 1) {
-      DO_TILE(uint8_t)
-   } else {
+   if (elmtsize != 8 && elmtsize != 4 && elmtsize != 2 && elmtsize != 1) {
       printf("etna_texture_tile: unhandled element size %i\n", elmtsize);
+      return;
    }
+
+   const struct util_tile_layout layout = {
+      .tile_w = TEX_TILE_WIDTH,
+      .tile_h = TEX_TILE_HEIGHT,
+      .cpp = elmtsize,
+      .tile_row_stride = dst_stride * TEX_TILE_HEIGHT,
+   };
+
+   util_tile_store(&layout, dest, src, src_stride,
+                   basex, basey, width, height);
 }
 
 void
@@ -86,15 +60,18 @@ etna_texture_untile(void *dest, void *src, unsigned basex, unsigned basey,
                     unsigned src_stride, unsigned width, unsigned height,
                     unsigned dst_stride, unsigned elmtsize)
 {
-   if (elmtsize == 8) {
-      DO_UNTILE(uint64_t)
-   } else if (elmtsize == 4) {
-      DO_UNTILE(uint32_t);
-   } else if (elmtsize == 2) {
-      DO_UNTILE(uint16_t);
-   } else if (elmtsize == 1) {
-      DO_UNTILE(uint8_t);
-   } else {
+   if (elmtsize != 8 && elmtsize != 4 && elmtsize != 2 && elmtsize != 1) {
       printf("etna_texture_tile: unhandled element size %i\n", elmtsize);
+      return;
    }
+
+   const struct util_tile_layout layout = {
+      .tile_w = TEX_TILE_WIDTH,
+      .tile_h = TEX_TILE_HEIGHT,
+      .cpp = elmtsize,
+      .tile_row_stride = src_stride * TEX_TILE_HEIGHT,
+   };
+
+   util_tile_load(&layout, dest, dst_stride, src,
+                  basex, basey, width, height);
 }
@@ -57,6 +57,7 @@ fd5_create_compute_state(struct pipe_context *pctx,
 	struct ir3_compiler *compiler = ctx->screen->compiler;
 	struct fd5_compute_stateobj *so = CALLOC_STRUCT(fd5_compute_stateobj);
 	so->shader = ir3_shader_create_compute(compiler, cso, &ctx->debug, pctx->screen);
+	ir3_shader_predict_variant(ctx, so->shader);
 	return so;
 }
 
@@ -64,6 +65,7 @@ static void
 fd5_delete_compute_state(struct pipe_context *pctx, void *hwcso)
 {
 	struct fd5_compute_stateobj *so = hwcso;
+	ir3_shader_drop_prediction(so->shader);
 	ir3_shader_destroy(so->shader);
 	free(so);
 }
@@ -1035,6 +1035,8 @@ fd6_shader_state_create(struct pipe_context *pctx, const struct pipe_shader_stat
 	unsigned sizedwords = (4 * packets) + size;
 	shader->ubo_state.cmdstream_size = sizedwords * 4;
 
+	ir3_shader_predict_variant(ctx, shader);
+
 	return shader;
 }
 
@@ -1044,6 +1046,7 @@ fd6_shader_state_delete(struct pipe_context *pctx, void *hwcso)
 	struct ir3_shader *so = hwcso;
 	struct fd_context *ctx = fd_context(pctx);
 	ir3_cache_invalidate(fd6_context(ctx)->shader_cache, hwcso);
+	ir3_shader_drop_prediction(so);
 	ir3_shader_destroy(so);
 }
 
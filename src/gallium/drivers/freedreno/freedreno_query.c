@@ -143,6 +143,8 @@ static const struct pipe_driver_query_info sw_query_list[] = {
 	FQ("shadow", SHADOW_UPLOADS, UINT64, AVERAGE),
 	FQ("vsregs", VS_REGS, FLOAT, AVERAGE),
 	FQ("fsregs", FS_REGS, FLOAT, AVERAGE),
+	FQ("shader-predicted-hits", PREDICTED_HITS, UINT64, AVERAGE),
+	FQ("shader-predicted-misses", PREDICTED_MISSES, UINT64, AVERAGE),
 };
 
 static int
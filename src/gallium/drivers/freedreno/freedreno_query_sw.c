@@ -25,6 +25,7 @@
  */
 
 #include "pipe/p_state.h"
+#include "util/u_atomic.h"
 #include "util/u_string.h"
 #include "util/u_memory.h"
 #include "util/u_inlines.h"
@@ -75,6 +76,10 @@ read_counter(struct fd_context *ctx, int type)
 		return ctx->stats.vs_regs;
 	case FD_QUERY_FS_REGS:
 		return ctx->stats.fs_regs;
+	case FD_QUERY_PREDICTED_HITS:
+		return p_atomic_read(&ctx->screen->predicted_hits);
+	case FD_QUERY_PREDICTED_MISSES:
+		return p_atomic_read(&ctx->screen->predicted_misses);
 	}
 	return 0;
 }
@@ -180,6 +185,8 @@ fd_sw_create_query(struct fd_context *ctx, unsigned query_type, unsigned index)
 	case FD_QUERY_SHADOW_UPLOADS:
 	case FD_QUERY_VS_REGS:
 	case FD_QUERY_FS_REGS:
+	case FD_QUERY_PREDICTED_HITS:
+	case FD_QUERY_PREDICTED_MISSES:
 		break;
 	default:
 		return NULL;
@@ -144,6 +144,11 @@ fd_screen_destroy(struct pipe_screen *pscreen)
 {
 	struct fd_screen *screen = fd_screen(pscreen);
 
+	if (screen->compile_queue_attempted &&
+			util_queue_is_initialized(&screen->compile_queue))
+		util_queue_destroy(&screen->compile_queue);
+	mtx_destroy(&screen->compile_queue_lock);
+
 	if (screen->pipe)
 		fd_pipe_del(screen->pipe);
 
@@ -958,6 +963,7 @@ fd_screen_create(struct fd_device *dev, struct renderonly *ro)
 	fd_bc_init(&screen->batch_cache);
 
 	(void) mtx_init(&screen->lock, mtx_plain);
+	(void) mtx_init(&screen->compile_queue_lock, mtx_plain);
 
 	pscreen->destroy = fd_screen_destroy;
 	pscreen->get_param = fd_screen_get_param;
@@ -34,6 +34,7 @@
 #include "pipe/p_screen.h"
 #include "util/u_memory.h"
 #include "util/slab.h"
+#include "util/u_queue.h"
 #include "os/os_thread.h"
 #include "renderonly/renderonly.h"
 
@@ -82,6 +83,19 @@ struct fd_screen {
 
 	void *compiler;          /* currently unused for a2xx */
 
+	/* compiles shader variants predicted at CSO creation time, created
+	 * by the first prediction.  Protected by compile_queue_lock:
+	 */
+	mtx_t compile_queue_lock;
+	bool compile_queue_attempted;
+	struct util_queue compile_queue;
+
+	/* predicted variants which were, or weren't, the variant that the
+	 * first draw with the shader needed:
+	 */
+	uint32_t predicted_hits;
+	uint32_t predicted_misses;
+
 	struct fd_device *dev;
 
 	/* NOTE: we still need a pipe associated with the screen in a few
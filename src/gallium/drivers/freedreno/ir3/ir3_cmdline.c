@@ -53,6 +53,7 @@
 #include "compiler/spirv/nir_spirv.h"
 
 #include "pipe/p_context.h"
+#include "util/os_time.h"
 
 static void dump_info(struct ir3_shader_variant *so, const char *str)
 {
@@ -64,6 +65,45 @@ static void dump_info(struct ir3_shader_variant *so, const char *str)
 	free(bin);
 }
 
+/* Compiles the optimized NIR down to ir3 over and over, for tracking the
+ * backend's (mostly the scheduler's) compile time.  Run it over each shader
+ * of a corpus and compare the totals before and after a change.
+ */
+static int
+bench_compile(struct ir3_shader *s, const struct ir3_shader_key *key,
+		unsigned iterations, const char *filename)
+{
+	int64_t total = 0, min = INT64_MAX;
+
+	for (unsigned i = 0; i < iterations; i++) {
+		struct ir3_shader_variant v;
+
+		memset(&v, 0, sizeof(v));
+		v.key = *key;
+		v.shader = s;
+		v.type = s->type;
+
+		int64_t start = os_time_get_nano();
+		int ret = ir3_compile_shader_nir(s->compiler, &v);
+		int64_t elapsed = os_time_get_nano() - start;
+
+		if (ret) {
+			fprintf(stderr, "compiler failed!\n");
+			return ret;
+		}
+
+		ir3_destroy(v.ir);
+
+		total += elapsed;
+		min = MIN2(min, elapsed);
+	}
+
+	printf("%s: %u compiles, min %.1f us, avg %.1f us\n", filename,
+			iterations, min / 1000.0, total / 1000.0 / iterations);
+
+	return 0;
+}
+
 static void
 insert_sorted(struct exec_list *var_list, nir_variable *new_var)
 {
@@ -272,6 +312,7 @@ static void print_usage(void)
 	printf("    --stream-out      - enable stream-out (aka transform feedback)\n");
 	printf("    --ucp MASK        - bitmask of enabled user-clip-planes\n");
 	printf("    --gpu GPU_ID      - specify gpu-id (default 320)\n");
+	printf("    --bench N         - time N backend compiles instead of dumping the shader\n");
 	printf("    --help            - show this message\n");
 }
 
@@ -290,6 +331,7 @@ int main(int argc, char **argv)
 	const char *entry;
 	void *ptr;
 	bool from_spirv = false;
+	unsigned bench_iterations = 0;
 	size_t size;
 
 	memset(&s, 0, sizeof(s));
@@ -390,6 +432,13 @@ int main(int argc, char **argv)
 			continue;
 		}
 
+		/* Not part of the shader key, so not spit out with the options: */
+		if (!strcmp(argv[n], "--bench")) {
+			bench_iterations = strtol(argv[n+1], NULL, 0);
+			n += 2;
+			continue;
+		}
+
 		if (!strcmp(argv[n], "--help")) {
 			print_usage();
 			return 0;
@@ -497,6 +546,9 @@ int main(int argc, char **argv)
 	v.shader = &s;
 	s.type = v.type = nir->info.stage;
 
+	if (bench_iterations)
+		return bench_compile(&s, &key, bench_iterations, filenames[0]);
+
 	info = "NIR compiler";
 	ret = ir3_compile_shader_nir(s.compiler, &v);
 	if (ret) {
@@ -26,6 +26,9 @@
 
 #include "pipe/p_state.h"
 #include "pipe/p_screen.h"
+#include "util/u_atomic.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
 #include "util/u_string.h"
 #include "util/u_memory.h"
 #include "util/u_inlines.h"
@@ -67,6 +70,50 @@ dump_shader_info(struct ir3_shader_variant *v, bool binning_pass,
 			v->max_sun, v->loops);
 }
 
+/* A variant compiled on the screen's compile queue when the shader is
+ * created, with a key guessed from the state bound at that point.
+ */
+struct ir3_shader_prediction {
+	struct util_queue_fence ready;
+	struct fd_screen *screen;
+	struct ir3_shader *shader;
+	struct ir3_shader_key key;
+
+	/* set once a draw-time lookup has waited for, or dropped, the job: */
+	uint32_t resolved;
+};
+
+/* Makes sure the shader's predicted variant, if any, isn't being compiled
+ * any longer.  Compiling a variant writes to state shared by all variants
+ * of the shader (const_state, output_loc, ...), which draws read without
+ * taking variants_lock, so that must be done before any variant of the
+ * shader is handed out.  The job is waited for if the draw needs the
+ * predicted variant, and dropped (or waited for, if it already started)
+ * otherwise.
+ */
+static void
+resolve_prediction(struct ir3_shader *shader, struct ir3_shader_key *key)
+{
+	struct ir3_shader_prediction *p = shader->prediction;
+
+	if (!p || p_atomic_read(&p->resolved))
+		return;
+
+	bool hit = ir3_shader_key_equal(&p->key, key);
+	if (hit)
+		util_queue_fence_wait(&p->ready);
+	else
+		util_queue_drop_job(&p->screen->compile_queue, &p->ready);
+
+	/* only the first lookup counts, if several contexts race for it: */
+	if (p_atomic_cmpxchg(&p->resolved, 0, 1) == 0) {
+		if (hit)
+			p_atomic_inc(&p->screen->predicted_hits);
+		else
+			p_atomic_inc(&p->screen->predicted_misses);
+	}
+}
+
 struct ir3_shader_variant *
 ir3_shader_variant(struct ir3_shader *shader, struct ir3_shader_key key,
 		bool binning_pass, struct pipe_debug_callback *debug)
@@ -80,6 +127,8 @@ ir3_shader_variant(struct ir3_shader *shader, struct ir3_shader_key key,
 	 */
 	ir3_normalize_key(&key, shader->type);
 
+	resolve_prediction(shader, &key);
+
 	v = ir3_shader_get_variant(shader, &key, binning_pass, &created);
 
 	if (created) {
@@ -146,6 +195,109 @@ ir3_shader_create(struct ir3_compiler *compiler,
 	return shader;
 }
 
+static bool
+init_compile_queue(struct fd_screen *screen)
+{
+	mtx_lock(&screen->compile_queue_lock);
+	if (!screen->compile_queue_attempted) {
+		screen->compile_queue_attempted = true;
+
+		/* leave a core free for the application's rendering thread: */
+		util_cpu_detect();
+		util_queue_init(&screen->compile_queue, "ir3_sh", 64,
+				MAX2(util_cpu_caps.nr_cpus - 1, 1),
+				UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+				UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY);
+	}
+	mtx_unlock(&screen->compile_queue_lock);
+
+	return util_queue_is_initialized(&screen->compile_queue);
+}
+
+static void
+compile_predicted_variant(void *job, int thread_index)
+{
+	struct ir3_shader_prediction *p = job;
+	bool created;
+
+	ir3_shader_get_variant(p->shader, &p->key, false, &created);
+
+	/* like the shader-db path, the binning pass variant is needed too: */
+	if (p->shader->type == MESA_SHADER_VERTEX)
+		ir3_shader_get_variant(p->shader, &p->key, true, &created);
+}
+
+/**
+ * Guesses the key that a new shader will first be drawn with, from the
+ * rasterizer and framebuffer state currently bound to ctx, and compiles
+ * that variant in the background.  The first draw-time lookup then either
+ * finds it (or waits for it to finish), or drops it.  Compute shaders are
+ * predicted with the empty key they are always dispatched with.
+ *
+ * Keys that depend on sampler views (the saturate and sample bitmasks) are
+ * assumed to be unset.  Nothing is predicted when shaders are being dumped,
+ * so that the output stays in draw order, or for shader-db runs, which
+ * already compile a variant up front.
+ */
+void
+ir3_shader_predict_variant(struct fd_context *ctx, struct ir3_shader *shader)
+{
+	struct fd_screen *screen = ctx->screen;
+
+	if (!shader || (fd_mesa_debug & FD_DBG_SHADERDB) ||
+			shader_debug_enabled(shader->type) ||
+			(ir3_shader_debug & IR3_DBG_OPTMSGS))
+		return;
+
+	if (!init_compile_queue(screen))
+		return;
+
+	struct ir3_shader_prediction *p = CALLOC_STRUCT(ir3_shader_prediction);
+	if (!p)
+		return;
+
+	if (shader->type != MESA_SHADER_COMPUTE) {
+		const struct pipe_rasterizer_state *rast = ctx->rasterizer;
+
+		if (rast) {
+			p->key.color_two_side = rast->light_twoside;
+			p->key.vclamp_color = rast->clamp_vertex_color;
+			p->key.fclamp_color = rast->clamp_fragment_color;
+			p->key.rasterflat = rast->flatshade;
+			p->key.ucp_enables = rast->clip_plane_enable;
+		}
+		p->key.sample_shading = ctx->min_samples > 1;
+		p->key.msaa = ctx->framebuffer.samples > 1;
+	}
+	ir3_normalize_key(&p->key, shader->type);
+
+	p->screen = screen;
+	p->shader = shader;
+	util_queue_fence_init(&p->ready);
+
+	shader->prediction = p;
+	util_queue_add_job(&screen->compile_queue, p, &p->ready,
+			compile_predicted_variant, NULL, 0);
+}
+
+/**
+ * Drops or waits for the shader's predicted variant, if any, before the
+ * shader is destroyed.
+ */
+void
+ir3_shader_drop_prediction(struct ir3_shader *shader)
+{
+	struct ir3_shader_prediction *p = shader->prediction;
+
+	if (!p)
+		return;
+
+	util_queue_drop_job(&p->screen->compile_queue, &p->ready);
+	util_queue_fence_destroy(&p->ready);
+	free(p);
+	shader->prediction = NULL;
+}
+
 /* a bit annoying that compute-shader and normal shader state objects
  * aren't a bit more aligned.
  */
@@ -762,13 +914,19 @@ ir3_shader_state_create(struct pipe_context *pctx, const struct pipe_shader_stat
 {
 	struct fd_context *ctx = fd_context(pctx);
 	struct ir3_compiler *compiler = ctx->screen->compiler;
-	return ir3_shader_create(compiler, cso, &ctx->debug, pctx->screen);
+	struct ir3_shader *shader =
+		ir3_shader_create(compiler, cso, &ctx->debug, pctx->screen);
+
+	ir3_shader_predict_variant(ctx, shader);
+
+	return shader;
 }
 
 static void
 ir3_shader_state_delete(struct pipe_context *pctx, void *hwcso)
 {
 	struct ir3_shader *so = hwcso;
+	ir3_shader_drop_prediction(so);
 	ir3_shader_destroy(so);
 }
 
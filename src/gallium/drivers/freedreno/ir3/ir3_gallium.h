@@ -46,6 +46,9 @@ struct ir3_shader_variant * ir3_shader_variant(struct ir3_shader *shader,
 
 struct fd_ringbuffer;
 struct fd_context;
+
+void ir3_shader_predict_variant(struct fd_context *ctx, struct ir3_shader *shader);
+void ir3_shader_drop_prediction(struct ir3_shader *shader);
 struct fd_screen;
 struct fd_constbuf_stateobj;
 struct fd_shaderbuf_stateobj;
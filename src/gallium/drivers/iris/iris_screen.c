@@ -520,6 +520,7 @@ iris_destroy_screen(struct pipe_screen *pscreen)
    u_transfer_helper_destroy(pscreen->transfer_helper);
    iris_bufmgr_destroy(screen->bufmgr);
    disk_cache_destroy(screen->disk_cache);
+   isl_surf_cache_destroy(screen->isl_dev.surf_cache);
    close(screen->fd);
    ralloc_free(screen);
 }
@@ -661,6 +662,7 @@ iris_screen_create(int fd, const struct pipe_screen_config *config)
    screen->precompile = env_var_as_boolean("shader_precompile", true);
 
    isl_device_init(&screen->isl_dev, &screen->devinfo, false);
+   screen->isl_dev.surf_cache = isl_surf_cache_create();
 
    screen->compiler = brw_compiler_create(screen, &screen->devinfo);
    screen->compiler->shader_debug_log = iris_shader_debug_log;
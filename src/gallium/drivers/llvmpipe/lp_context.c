@@ -210,6 +210,11 @@ llvmpipe_create_context(struct pipe_screen *screen, void *priv,
    llvmpipe->pipe.stream_uploader = u_upload_create_default(&llvmpipe->pipe);
    if (!llvmpipe->pipe.stream_uploader)
       goto fail;
+   /* Uploaded data is consumed (or copied into the scene) at draw time,
+    * so full upload buffers are usually idle and can be reused.
+    */
+   u_upload_enable_recycling(llvmpipe->pipe.stream_uploader,
+                             16 * 1024 * 1024);
    llvmpipe->pipe.const_uploader = llvmpipe->pipe.stream_uploader;
 
    llvmpipe->blitter = util_blitter_create(&llvmpipe->pipe);
@@ -26,6 +26,7 @@
 
 extern "C" {
 #include "nouveau_debug.h"
+#include "util/os_time.h"
 #include "nv50/nv50_program.h"
 }
 
@@ -1178,6 +1179,19 @@ void Program::releaseValue(Value *value)
 
 extern "C" {
 
+// Prints the time spent since *start in a compiler stage, and restarts the
+// clock for the next one.
+static void
+nv50_ir_report_time(const nv50_ir::Program *prog, const char *stage,
+                    int64_t *start)
+{
+   if (!(prog->dbgFlags & NV50_IR_DEBUG_TIMING))
+      return;
+   int64_t now = os_time_get_nano();
+   INFO("%-26s %8.3f ms\n", stage, (now - *start) / 1e6);
+   *start = now;
+}
+
 static void
 nv50_ir_init_prog_info(struct nv50_ir_prog_info *info)
 {
@@ -1242,6 +1256,9 @@ nv50_ir_generate_code(struct nv50_ir_prog_info *info)
    prog->dbgFlags = info->dbgFlags;
    prog->optLevel = info->optLevel;
 
+   int64_t start =
+      (prog->dbgFlags & NV50_IR_DEBUG_TIMING) ? os_time_get_nano() : 0;
+
    switch (info->bin.sourceRep) {
    case PIPE_SHADER_IR_NIR:
       ret = prog->makeFromNIR(info) ? 0 : -2;
@@ -1255,19 +1272,26 @@ nv50_ir_generate_code(struct nv50_ir_prog_info *info)
    }
    if (ret < 0)
       goto out;
+   nv50_ir_report_time(prog, "translation:", &start);
    if (prog->dbgFlags & NV50_IR_DEBUG_VERBOSE)
       prog->print();
 
    targ->parseDriverInfo(info);
    prog->getTarget()->runLegalizePass(prog, nv50_ir::CG_STAGE_PRE_SSA);
+   nv50_ir_report_time(prog, "legalize (pre-SSA):", &start);
 
    prog->convertToSSA();
+   nv50_ir_report_time(prog, "SSA construction:", &start);
 
    if (prog->dbgFlags & NV50_IR_DEBUG_VERBOSE)
       prog->print();
 
+   if (prog->dbgFlags & NV50_IR_DEBUG_TIMING)
+      INFO("SSA optimizations:\n");
    prog->optimizeSSA(info->optLevel);
+   nv50_ir_report_time(prog, "SSA optimizations total:", &start);
    prog->getTarget()->runLegalizePass(prog, nv50_ir::CG_STAGE_SSA);
+   nv50_ir_report_time(prog, "legalize (SSA):", &start);
 
    if (prog->dbgFlags & NV50_IR_DEBUG_BASIC)
       prog->print();
@@ -1276,14 +1300,20 @@ nv50_ir_generate_code(struct nv50_ir_prog_info *info)
       ret = -4;
       goto out;
    }
+   nv50_ir_report_time(prog, "register allocation:", &start);
    prog->getTarget()->runLegalizePass(prog, nv50_ir::CG_STAGE_POST_RA);
+   nv50_ir_report_time(prog, "legalize (post-RA):", &start);
 
+   if (prog->dbgFlags & NV50_IR_DEBUG_TIMING)
+      INFO("post-RA optimizations:\n");
    prog->optimizePostRA(info->optLevel);
+   nv50_ir_report_time(prog, "post-RA optimizations total:", &start);
 
    if (!prog->emitBinary(info)) {
       ret = -5;
       goto out;
    }
+   nv50_ir_report_time(prog, "emission:", &start);
 
 out:
    INFO_DBG(prog->dbgFlags, VERBOSE, "nv50_ir_generate_code: ret = %i\n", ret);
@@ -25,6 +25,7 @@
 #include "codegen/nv50_ir_build_util.h"
 
 extern "C" {
+#include "util/os_time.h"
 #include "util/u_math.h"
 }
 
@@ -4000,9 +4001,14 @@ DeadCodeElim::checkSplitLoad(Instruction *ld1)
    if (level >= (l)) {                          \
       if (dbgFlags & NV50_IR_DEBUG_VERBOSE)     \
          INFO("PEEPHOLE: %s\n", #n);            \
+      const bool timed = dbgFlags & NV50_IR_DEBUG_TIMING; \
+      int64_t start = timed ? os_time_get_nano() : 0; \
       n pass;                                   \
       if (!pass.f(this))                        \
          return false;                          \
+      if (timed)                                \
+         INFO("  %-24s %8.3f ms\n", #n,         \
+              (os_time_get_nano() - start) / 1e6); \
    }
 
 bool
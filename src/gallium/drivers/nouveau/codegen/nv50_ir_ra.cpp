@@ -752,6 +752,7 @@ private:
       int32_t reg;
 
       float weight;
+      float spillScore; // weight / degree, updated as the degree drops
 
       // list pointers for simplify() phase
       RIG_Node *next;
@@ -784,8 +785,8 @@ private:
 
    inline void checkInterference(const RIG_Node *, Graph::EdgeIterator&);
 
-   inline void insertOrderedTail(std::list<RIG_Node *>&, RIG_Node *);
-   void checkList(std::list<RIG_Node *>&);
+   static inline bool compareLiveStart(const RIG_Node *, const RIG_Node *);
+   void checkList(std::vector<RIG_Node *>&);
 
 private:
    std::stack<uint32_t> stack;
@@ -896,6 +897,7 @@ GCRA::RIG_Node::init(const RegisterSet& regs, LValue *lval)
       reg = regs.idToUnits(lval);
 
    weight = std::numeric_limits<float>::infinity();
+   spillScore = weight;
    degree = 0;
    maxReg = regs.getFileSize(f);
    // On nv50, we lose a bit of gpr encoding when there's an embedded
@@ -1176,11 +1178,11 @@ GCRA::~GCRA()
 }
 
 void
-GCRA::checkList(std::list<RIG_Node *>& lst)
+GCRA::checkList(std::vector<RIG_Node *>& lst)
 {
    GCRA::RIG_Node *prev = NULL;
 
-   for (std::list<RIG_Node *>::iterator it = lst.begin();
+   for (std::vector<RIG_Node *>::iterator it = lst.begin();
         it != lst.end();
         ++it) {
       assert((*it)->getValue()->join == (*it)->getValue());
@@ -1190,55 +1192,62 @@ GCRA::checkList(std::list<RIG_Node *>& lst)
    }
 }
 
-void
-GCRA::insertOrderedTail(std::list<RIG_Node *>& list, RIG_Node *node)
+bool
+GCRA::compareLiveStart(const RIG_Node *a, const RIG_Node *b)
 {
-   if (node->livei.isEmpty())
-      return;
-   // only the intervals of joined values don't necessarily arrive in order
-   std::list<RIG_Node *>::iterator prev, it;
-   for (it = list.end(); it != list.begin(); it = prev) {
-      prev = it;
-      --prev;
-      if ((*prev)->livei.begin() <= node->livei.begin())
-         break;
-   }
-   list.insert(it, node);
+   return a->livei.begin() < b->livei.begin();
 }
 
 void
 GCRA::buildRIG(ArrayList& insns)
 {
-   std::list<RIG_Node *> values, active;
+   std::vector<RIG_Node *> values, active;
+
+   values.reserve(nodeCount);
 
    for (std::deque<ValueDef>::iterator it = func->ins.begin();
-        it != func->ins.end(); ++it)
-      insertOrderedTail(values, getNode(it->get()->asLValue()));
+        it != func->ins.end(); ++it) {
+      RIG_Node *node = getNode(it->get()->asLValue());
+      if (!node->livei.isEmpty())
+         values.push_back(node);
+   }
 
    for (int i = 0; i < insns.getSize(); ++i) {
       Instruction *insn = reinterpret_cast<Instruction *>(insns.get(i));
-      for (int d = 0; insn->defExists(d); ++d)
-         if (insn->getDef(d)->rep() == insn->getDef(d))
-            insertOrderedTail(values, getNode(insn->getDef(d)->asLValue()));
+      for (int d = 0; insn->defExists(d); ++d) {
+         if (insn->getDef(d)->rep() != insn->getDef(d))
+            continue;
+         RIG_Node *node = getNode(insn->getDef(d)->asLValue());
+         if (!node->livei.isEmpty())
+            values.push_back(node);
+      }
    }
+
+   // Only the intervals of joined values don't necessarily arrive in order.
+   // A stable sort keeps the order of values starting at the same position,
+   // and avoids the quadratic cost of sorted insertion into a list.
+   std::stable_sort(values.begin(), values.end(), compareLiveStart);
    checkList(values);
 
-   while (!values.empty()) {
-      RIG_Node *cur = values.front();
+   // Sweep over the intervals in order of their start, keeping the ones that
+   // are still live in the active set. Only those can interfere with the
+   // current one.
+   for (std::vector<RIG_Node *>::iterator v = values.begin();
+        v != values.end(); ++v) {
+      RIG_Node *cur = *v;
+      const int start = cur->livei.begin();
+      size_t n = 0;
 
-      for (std::list<RIG_Node *>::iterator it = active.begin();
-           it != active.end();) {
-         RIG_Node *node = *it;
+      for (size_t i = 0; i < active.size(); ++i) {
+         RIG_Node *node = active[i];
 
-         if (node->livei.end() <= cur->livei.begin()) {
-            it = active.erase(it);
-         } else {
-            if (node->f == cur->f && node->livei.overlaps(cur->livei))
-               cur->addInterference(node);
-            ++it;
-         }
+         if (node->livei.end() <= start)
+            continue;
+         if (node->f == cur->f && node->livei.overlaps(cur->livei))
+            cur->addInterference(node);
+         active[n++] = node;
       }
-      values.pop_front();
+      active.resize(n);
       active.push_back(cur);
    }
 }
@@ -1267,6 +1276,7 @@ GCRA::calculateSpillWeights()
          nodes[i].weight =
             (float)rc * (float)rc / (float)nodes[i].livei.extent();
       }
+      nodes[i].spillScore = nodes[i].weight / (float)nodes[i].degree;
 
       if (nodes[i].degree < nodes[i].degreeLimit) {
          int l = 0;
@@ -1292,6 +1302,7 @@ GCRA::simplifyEdge(RIG_Node *a, RIG_Node *b)
             b->getValue()->id, b->degree, b->degreeLimit);
 
    b->degree -= relDegree[a->colors][b->colors];
+   b->spillScore = b->weight / (float)b->degree;
 
    move = move && b->degree < b->degreeLimit;
    if (move && !DLLIST_EMPTY(b)) {
@@ -1333,12 +1344,12 @@ GCRA::simplify()
       if (!DLLIST_EMPTY(&hi)) {
          RIG_Node *best = hi.next;
          unsigned bestMaxReg = best->maxReg;
-         float bestScore = best->weight / (float)best->degree;
+         float bestScore = best->spillScore;
          // Spill candidate. First go through the ones with the highest max
          // register, then the ones with lower. That way the ones with the
          // lowest requirement will be allocated first, since it's a stack.
          for (RIG_Node *it = best->next; it != &hi; it = it->next) {
-            float score = it->weight / (float)it->degree;
+            float score = it->spillScore;
             if (score < bestScore || it->maxReg > bestMaxReg) {
                best = it;
                bestScore = score;
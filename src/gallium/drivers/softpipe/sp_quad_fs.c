@@ -71,7 +71,6 @@ shade_quad(struct quad_stage *qs, struct quad_header *quad)
    }
 
    /* run shader */
-   machine->flatshade_color = softpipe->rasterizer->flatshade ? TRUE : FALSE;
    return softpipe->fs_variant->run( softpipe->fs_variant, machine, quad, softpipe->early_depth );
 }
 
@@ -115,6 +114,11 @@ shade_quads(struct quad_stage *qs,
 
    machine->InterpCoefs = quads[0]->coef;
 
+   /* Rasterizer state is constant across the batch, so set this once
+    * rather than for every quad.
+    */
+   machine->flatshade_color = softpipe->rasterizer->flatshade ? TRUE : FALSE;
+
    for (i = 0; i < nr; i++) {
       /* Only omit this quad from the output list if all the fragments
        * are killed _AND_ it's not the first quad in the list.
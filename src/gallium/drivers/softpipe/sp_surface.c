@@ -27,6 +27,7 @@
 
 #include "util/format/u_format.h"
 #include "util/u_surface.h"
+#include "util/u_gen_mipmap.h"
 #include "sp_context.h"
 #include "sp_surface.h"
 #include "sp_query.h"
@@ -139,4 +140,5 @@ sp_init_surface_functions(struct softpipe_context *sp)
    sp->pipe.clear_depth_stencil = softpipe_clear_depth_stencil;
    sp->pipe.blit = sp_blit;
    sp->pipe.flush_resource = sp_flush_resource;
+   sp->pipe.generate_mipmap = util_gen_mipmap_cpu;
 }
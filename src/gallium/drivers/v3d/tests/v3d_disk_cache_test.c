@@ -0,0 +1,292 @@
+/*
+ * Copyright © 2019 Broadcom
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Round-trips compiled variants through the on-disk shader cache.
+ *
+ * Each compile creates its own screen, the way separate runs of an
+ * application would, on the noop v3d drm-shim that the test is run with
+ * (LD_PRELOAD=libv3d_noop_drm_shim.so).  Whether the backend compiler ran
+ * is told by the shader-db message it sends to the debug callback.
+ */
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <xf86drm.h>
+
+#include "compiler/v3d_compiler.h"
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "tgsi/tgsi_text.h"
+#include "util/hash_table.h"
+#include "util/u_inlines.h"
+#include "util/xmlconfig.h"
+#include "util/xmlpool.h"
+#include "v3d/drm/v3d_drm_public.h"
+#include "v3d_context.h"
+
+#define t_assert(cond) \
+        do { \
+                if (!(cond)) { \
+                        fprintf(stderr, "%s:%d: assertion failed: %s\n", \
+                                __FILE__, __LINE__, #cond); \
+                        abort(); \
+                } \
+        } while (0)
+
+static const char *v3d_driinfo_xml =
+#include "v3d_driinfo.h"
+        ;
+
+/* Uses immediates, so that the variant has a uniform list. */
+static const char *fs_text =
+        "FRAG\n"
+        "DCL IN[0], GENERIC[0], PERSPECTIVE\n"
+        "DCL OUT[0], COLOR\n"
+        "DCL TEMP[0]\n"
+        "IMM[0] FLT32 { 0.5, 0.25, 0.0, 1.0 }\n"
+        "  0: MAD TEMP[0], IN[0], IMM[0].xxxx, IMM[0].yyyy\n"
+        "  1: MOV OUT[0], TEMP[0]\n"
+        "  2: END\n";
+
+static const char *other_fs_text =
+        "FRAG\n"
+        "DCL IN[0], GENERIC[0], PERSPECTIVE\n"
+        "DCL OUT[0], COLOR\n"
+        "  0: MOV OUT[0], IN[0]\n"
+        "  1: END\n";
+
+struct compile_result {
+        /* Number of variants that went through the backend compiler */
+        unsigned compiles;
+
+        /* The variant, with the uniform list pointers cleared */
+        struct v3d_fs_prog_data prog_data;
+        enum quniform_contents *uniform_contents;
+        uint32_t *uniform_data;
+
+        /* The rest of the shader's upload buffer, starting at the QPU
+         * instructions.
+         */
+        uint8_t *code;
+        size_t code_size;
+};
+
+static driOptionCache option_info, options;
+
+static void
+count_compiles(void *data, unsigned *id, enum pipe_debug_type type,
+               const char *fmt, va_list args)
+{
+        unsigned *compiles = data;
+
+        if (type == PIPE_DEBUG_TYPE_SHADER_INFO)
+                (*compiles)++;
+}
+
+static int
+open_v3d(void)
+{
+        /* The shim takes the first render node that doesn't exist on the
+         * system.
+         */
+        for (int minor = 128; minor < 138; minor++) {
+                char path[32];
+                snprintf(path, sizeof(path), "/dev/dri/renderD%d", minor);
+
+                int fd = open(path, O_RDWR | O_CLOEXEC);
+                if (fd < 0)
+                        continue;
+
+                drmVersionPtr version = drmGetVersion(fd);
+                bool is_v3d = version && strcmp(version->name, "v3d") == 0;
+                drmFreeVersion(version);
+
+                if (is_v3d)
+                        return fd;
+                close(fd);
+        }
+
+        return -1;
+}
+
+static void *
+memdup(const void *data, size_t size)
+{
+        void *copy = malloc(MAX2(size, 1));
+        t_assert(copy);
+        memcpy(copy, data, size);
+        return copy;
+}
+
+static void
+save_variant(struct pipe_context *pctx, struct v3d_compiled_shader *shader,
+             struct compile_result *result)
+{
+        const struct v3d_prog_data *prog_data = shader->prog_data.base;
+        uint32_t count = prog_data->uniforms.count;
+
+        memcpy(&result->prog_data, shader->prog_data.fs,
+               sizeof(result->prog_data));
+        result->prog_data.base.uniforms.contents = NULL;
+        result->prog_data.base.uniforms.data = NULL;
+        result->uniform_contents =
+                memdup(prog_data->uniforms.contents,
+                       count * sizeof(enum quniform_contents));
+        result->uniform_data = memdup(prog_data->uniforms.data,
+                                      count * sizeof(uint32_t));
+
+        struct pipe_transfer *transfer;
+        const uint8_t *map = pipe_buffer_map(pctx, shader->resource,
+                                             PIPE_TRANSFER_READ, &transfer);
+        t_assert(map);
+        result->code_size = shader->resource->width0 - shader->offset;
+        result->code = memdup(map + shader->offset, result->code_size);
+        pipe_buffer_unmap(pctx, transfer);
+}
+
+/* Compiles the default variant of a fragment shader on a new screen. */
+static void
+compile_fs(const char *text, struct compile_result *result)
+{
+        struct tgsi_token tokens[1024];
+        t_assert(tgsi_text_translate(text, tokens, ARRAY_SIZE(tokens)));
+
+        int fd = open_v3d();
+        t_assert(fd >= 0);
+
+        struct pipe_screen_config config = { .options = &options };
+        struct pipe_screen *pscreen = v3d_drm_screen_create(fd, &config);
+        t_assert(pscreen);
+        t_assert(v3d_screen(pscreen)->disk_cache);
+
+        struct pipe_context *pctx = pscreen->context_create(pscreen, NULL, 0);
+        t_assert(pctx);
+
+        memset(result, 0, sizeof(*result));
+        struct pipe_debug_callback debug = {
+                .debug_message = count_compiles,
+                .data = &result->compiles,
+        };
+        pctx->set_debug_callback(pctx, &debug);
+
+        /* V3D_DEBUG=precompile leaves the default variant in the context's
+         * variant cache.
+         */
+        struct pipe_shader_state state = {
+                .type = PIPE_SHADER_IR_TGSI,
+                .tokens = tokens,
+        };
+        void *fs = pctx->create_fs_state(pctx, &state);
+        t_assert(fs);
+
+        struct hash_table *ht =
+                v3d_context(pctx)->prog.cache[MESA_SHADER_FRAGMENT];
+        t_assert(_mesa_hash_table_num_entries(ht) == 1);
+        save_variant(pctx, _mesa_hash_table_next_entry(ht, NULL)->data,
+                     result);
+
+        pctx->delete_fs_state(pctx, fs);
+        pctx->destroy(pctx);
+
+        /* Waits for the cache writes to land. */
+        pscreen->destroy(pscreen);
+        close(fd);
+}
+
+static void
+check_same_variant(const struct compile_result *a,
+                   const struct compile_result *b)
+{
+        uint32_t count = a->prog_data.base.uniforms.count;
+
+        t_assert(memcmp(&a->prog_data, &b->prog_data,
+                        sizeof(a->prog_data)) == 0);
+        t_assert(memcmp(a->uniform_contents, b->uniform_contents,
+                        count * sizeof(enum quniform_contents)) == 0);
+        t_assert(memcmp(a->uniform_data, b->uniform_data,
+                        count * sizeof(uint32_t)) == 0);
+        t_assert(a->code_size == b->code_size);
+        t_assert(memcmp(a->code, b->code, a->code_size) == 0);
+}
+
+static void
+free_result(struct compile_result *result)
+{
+        free(result->uniform_contents);
+        free(result->uniform_data);
+        free(result->code);
+}
+
+static int
+remove_entry(const char *path, const struct stat *st, int flag,
+             struct FTW *ftw)
+{
+        return remove(path);
+}
+
+int
+main(int argc, char **argv)
+{
+        char cache_dir[] = "/tmp/v3d_disk_cache_test.XXXXXX";
+        t_assert(mkdtemp(cache_dir));
+
+        setenv("MESA_GLSL_CACHE_DIR", cache_dir, 1);
+        unsetenv("MESA_GLSL_CACHE_DISABLE");
+        setenv("V3D_DEBUG", "precompile", 1);
+
+        driParseOptionInfo(&option_info, v3d_driinfo_xml);
+        driParseConfigFiles(&options, &option_info, 0, "v3d", NULL, NULL, 0);
+
+        struct compile_result first, second, other;
+
+        /* An empty cache, so the variant is compiled and stored. */
+        compile_fs(fs_text, &first);
+        t_assert(first.compiles == 1);
+        t_assert(first.prog_data.base.uniforms.count > 0);
+
+        /* The same shader in a new screen is loaded from the cache, and
+         * comes out the same as it was compiled.
+         */
+        compile_fs(fs_text, &second);
+        t_assert(second.compiles == 0);
+        check_same_variant(&first, &second);
+
+        /* Another shader doesn't hit the first one's entry. */
+        compile_fs(other_fs_text, &other);
+        t_assert(other.compiles == 1);
+
+        free_result(&first);
+        free_result(&second);
+        free_result(&other);
+
+        driDestroyOptionCache(&options);
+        driDestroyOptionInfo(&option_info);
+        nftw(cache_dir, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+
+        return 0;
+}
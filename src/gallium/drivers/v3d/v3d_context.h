@@ -42,6 +42,7 @@
 
 struct v3d_job;
 struct v3d_bo;
+struct v3d_key;
 void v3d_job_add_bo(struct v3d_job *job, struct v3d_bo *bo);
 
 #include "v3d_bufmgr.h"
@@ -54,6 +55,9 @@ void v3d_job_add_bo(struct v3d_job *job, struct v3d_bo *bo);
 #define using_v3d_simulator false
 #endif
 
+#define V3D_QUERY_PREDICTED_HITS      (PIPE_QUERY_DRIVER_SPECIFIC + 0)
+#define V3D_QUERY_PREDICTED_MISSES    (PIPE_QUERY_DRIVER_SPECIFIC + 1)
+
 #define VC5_DIRTY_BLEND               (1ull <<  0)
 #define VC5_DIRTY_RASTERIZER          (1ull <<  1)
 #define VC5_DIRTY_ZSA                 (1ull <<  2)
@@ -202,8 +206,15 @@ struct v3d_uncompiled_shader {
         uint16_t tf_specs[16];
         uint16_t tf_specs_psiz[16];
         uint32_t num_tf_specs;
+
+        /** SHA1 of the final NIR, for the on-disk shader cache. */
+        unsigned char nir_sha1[20];
+
+        /** Variant being compiled in the background, if any. */
+        struct v3d_predicted_variant *predicted;
 };
 
+
 struct v3d_compiled_shader {
         struct pipe_resource *resource;
         uint32_t offset;
@@ -232,6 +243,12 @@ struct v3d_program_stateobj {
 
         struct v3d_bo *spill_bo;
         int spill_size_per_thread;
+
+        /* Variants taken from a matching prediction, and variants that
+         * had to be compiled at draw time.
+         */
+        uint32_t predicted_hits;
+        uint32_t predicted_misses;
 };
 
 struct v3d_constbuf_stateobj {
@@ -608,6 +625,8 @@ struct pipe_context *v3d_context_create(struct pipe_screen *pscreen,
 void v3d_program_init(struct pipe_context *pctx);
 void v3d_program_fini(struct pipe_context *pctx);
 void v3d_query_init(struct pipe_context *pctx);
+int v3d_get_driver_query_info(struct pipe_screen *pscreen, unsigned index,
+                              struct pipe_driver_query_info *info);
 
 void v3d_simulator_init(struct v3d_screen *screen);
 void v3d_simulator_destroy(struct v3d_screen *screen);
@@ -633,6 +652,15 @@ v3d_transform_feedback_enabled(struct v3d_context *v3d)
 }
 
 void v3d_set_shader_uniform_dirty_flags(struct v3d_compiled_shader *shader);
+void v3d_disk_cache_init(struct v3d_screen *screen);
+void v3d_disk_cache_store(struct v3d_screen *screen,
+                          const struct v3d_key *key, size_t key_size,
+                          const struct v3d_prog_data *prog_data,
+                          const uint64_t *qpu_insts, uint32_t qpu_size);
+uint64_t *v3d_disk_cache_retrieve(struct v3d_screen *screen,
+                                  const struct v3d_key *key, size_t key_size,
+                                  struct v3d_prog_data **prog_data,
+                                  uint32_t *qpu_size);
 struct v3d_cl_reloc v3d_write_uniforms(struct v3d_context *v3d,
                                        struct v3d_job *job,
                                        struct v3d_compiled_shader *shader,
@@ -0,0 +1,237 @@
+/*
+ * Copyright © 2019 Broadcom
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * @file v3d_disk_cache.c
+ *
+ * Stores compiled QPU programs in the on-disk shader cache, so that a
+ * variant seen in a previous run doesn't have to go through the backend
+ * compiler again.
+ */
+
+#include "compiler/nir/nir.h"
+#include "compiler/v3d_compiler.h"
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
+#include "util/ralloc.h"
+#include "util/u_variant_cache.h"
+#include "v3d_context.h"
+
+/**
+ * The parts of a cache entry: the stage's prog_data (with stale uniform list
+ * pointers), the uniform list contents and data arrays, and the QPU
+ * instructions.
+ */
+enum v3d_disk_cache_part {
+        V3D_DISK_CACHE_PROG_DATA,
+        V3D_DISK_CACHE_UNIFORM_CONTENTS,
+        V3D_DISK_CACHE_UNIFORM_DATA,
+        V3D_DISK_CACHE_QPU_INSTS,
+        V3D_DISK_CACHE_PART_COUNT,
+};
+
+/**
+ * Computes the disk cache key for a variant from the uncompiled shader's
+ * NIR hash and the (pointer-free) contents of the variant key.
+ */
+static void
+v3d_disk_cache_compute_key(struct disk_cache *cache,
+                           const struct v3d_key *orig_key,
+                           size_t key_size,
+                           cache_key cache_key)
+{
+        struct v3d_uncompiled_shader *uncompiled = orig_key->shader_state;
+        nir_shader *s = uncompiled->base.ir.nir;
+        gl_shader_stage stage = s->info.stage;
+
+        union {
+                struct v3d_key base;
+                struct v3d_vs_key vs;
+                struct v3d_gs_key gs;
+                struct v3d_fs_key fs;
+        } key;
+        assert(key_size <= sizeof(key));
+        memcpy(&key, orig_key, key_size);
+
+        /* Zero out the pointers so that only the state they stand for ends
+         * up in the hash.  The render target swizzles are derived from the
+         * format, which is already part of the key.
+         */
+        key.base.shader_state = NULL;
+        if (stage == MESA_SHADER_FRAGMENT) {
+                for (int i = 0; i < ARRAY_SIZE(key.fs.color_fmt); i++)
+                        key.fs.color_fmt[i].swizzle = NULL;
+        }
+
+        u_variant_cache_compute_key(cache, uncompiled->nir_sha1,
+                                    &key, key_size, cache_key);
+}
+
+/**
+ * Stores a newly compiled variant in the disk cache.
+ */
+void
+v3d_disk_cache_store(struct v3d_screen *screen,
+                     const struct v3d_key *key, size_t key_size,
+                     const struct v3d_prog_data *prog_data,
+                     const uint64_t *qpu_insts, uint32_t qpu_size)
+{
+        struct disk_cache *cache = screen->disk_cache;
+        if (!cache)
+                return;
+
+        struct v3d_uncompiled_shader *uncompiled = key->shader_state;
+        nir_shader *s = uncompiled->base.ir.nir;
+        gl_shader_stage stage = s->info.stage;
+
+        cache_key cache_key;
+        v3d_disk_cache_compute_key(cache, key, key_size, cache_key);
+
+        uint32_t ulist_count = prog_data->uniforms.count;
+        const struct u_variant_cache_part parts[] = {
+                [V3D_DISK_CACHE_PROG_DATA] = {
+                        (void *)prog_data, v3d_prog_data_size(stage)
+                },
+                [V3D_DISK_CACHE_UNIFORM_CONTENTS] = {
+                        prog_data->uniforms.contents,
+                        ulist_count * sizeof(enum quniform_contents)
+                },
+                [V3D_DISK_CACHE_UNIFORM_DATA] = {
+                        prog_data->uniforms.data,
+                        ulist_count * sizeof(uint32_t)
+                },
+                [V3D_DISK_CACHE_QPU_INSTS] = {
+                        (void *)qpu_insts, qpu_size
+                },
+        };
+
+        u_variant_cache_put(cache, cache_key, parts, ARRAY_SIZE(parts));
+}
+
+/**
+ * Looks up a variant in the disk cache.
+ *
+ * On a hit, returns a malloc()ed copy of the QPU instructions and a
+ * ralloc()ed prog_data, the same way v3d_compile() does.  Returns NULL on a
+ * miss.
+ */
+uint64_t *
+v3d_disk_cache_retrieve(struct v3d_screen *screen,
+                        const struct v3d_key *key, size_t key_size,
+                        struct v3d_prog_data **out_prog_data,
+                        uint32_t *out_qpu_size)
+{
+        struct disk_cache *cache = screen->disk_cache;
+        if (!cache)
+                return NULL;
+
+        struct v3d_uncompiled_shader *uncompiled = key->shader_state;
+        nir_shader *s = uncompiled->base.ir.nir;
+        gl_shader_stage stage = s->info.stage;
+
+        cache_key cache_key;
+        v3d_disk_cache_compute_key(cache, key, key_size, cache_key);
+
+        void *mem_ctx = ralloc_context(NULL);
+        struct u_variant_cache_part parts[V3D_DISK_CACHE_PART_COUNT];
+        if (!u_variant_cache_get(cache, cache_key, mem_ctx,
+                                 parts, ARRAY_SIZE(parts))) {
+                ralloc_free(mem_ctx);
+                return NULL;
+        }
+
+        /* Entries from a build with a different prog_data layout have a
+         * different key, so these only fail for a corrupted entry.
+         */
+        struct v3d_prog_data *prog_data =
+                parts[V3D_DISK_CACHE_PROG_DATA].data;
+        bool valid = (parts[V3D_DISK_CACHE_PROG_DATA].size ==
+                      v3d_prog_data_size(stage));
+        uint32_t ulist_count = valid ? prog_data->uniforms.count : 0;
+        valid = valid &&
+                parts[V3D_DISK_CACHE_UNIFORM_CONTENTS].size ==
+                ulist_count * sizeof(enum quniform_contents) &&
+                parts[V3D_DISK_CACHE_UNIFORM_DATA].size ==
+                ulist_count * sizeof(uint32_t);
+
+        uint32_t qpu_size = parts[V3D_DISK_CACHE_QPU_INSTS].size;
+        uint64_t *qpu_insts = valid ? malloc(qpu_size) : NULL;
+
+        if (!qpu_insts) {
+                ralloc_free(mem_ctx);
+                return NULL;
+        }
+
+        memcpy(qpu_insts, parts[V3D_DISK_CACHE_QPU_INSTS].data, qpu_size);
+
+        prog_data->uniforms.contents =
+                parts[V3D_DISK_CACHE_UNIFORM_CONTENTS].data;
+        prog_data->uniforms.data = parts[V3D_DISK_CACHE_UNIFORM_DATA].data;
+        ralloc_steal(NULL, prog_data);
+        ralloc_steal(prog_data, prog_data->uniforms.contents);
+        ralloc_steal(prog_data, prog_data->uniforms.data);
+        ralloc_free(mem_ctx);
+
+        *out_prog_data = prog_data;
+        *out_qpu_size = qpu_size;
+
+        return qpu_insts;
+}
+
+/**
+ * Creates the screen's disk cache, keyed on the driver build.
+ */
+void
+v3d_disk_cache_init(struct v3d_screen *screen)
+{
+#ifdef ENABLE_SHADER_CACHE
+        /* Shader dumps and shader-db stats come out of the backend compile,
+         * so don't let cache hits hide them.
+         */
+        if (V3D_DEBUG & (V3D_DEBUG_SHADERDB |
+                         V3D_DEBUG_NIR |
+                         V3D_DEBUG_VIR |
+                         V3D_DEBUG_QPU |
+                         V3D_DEBUG_FS |
+                         V3D_DEBUG_GS |
+                         V3D_DEBUG_VS |
+                         V3D_DEBUG_CS)) {
+                return;
+        }
+
+        struct mesa_sha1 ctx;
+        unsigned char sha1[20];
+        char cache_id[20 * 2 + 1];
+
+        _mesa_sha1_init(&ctx);
+        if (!disk_cache_get_function_identifier(v3d_disk_cache_init, &ctx))
+                return;
+        _mesa_sha1_final(&ctx, sha1);
+        disk_cache_format_hex_id(cache_id, sha1, 20 * 2);
+
+        char renderer[16];
+        snprintf(renderer, sizeof(renderer), "v3d_%d", screen->devinfo.ver);
+
+        screen->disk_cache = disk_cache_create(renderer, cache_id, 0);
+#endif
+}
@@ -23,11 +23,14 @@
 
 #include <inttypes.h>
 #include "util/format/u_format.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/ralloc.h"
 #include "util/hash_table.h"
 #include "util/u_upload_mgr.h"
+#include "util/u_framebuffer.h"
+#include "util/u_variant_cache.h"
 #include "tgsi/tgsi_dump.h"
 #include "tgsi/tgsi_parse.h"
 #include "compiler/nir/nir.h"
@@ -37,12 +40,38 @@
 #include "v3d_context.h"
 #include "broadcom/cle/v3d_packet_v33_pack.h"
 
+/**
+ * A variant compiled on the screen's compile queue from the key that the
+ * shader is predicted to be first drawn with.
+ */
+struct v3d_predicted_variant {
+        union {
+                struct v3d_key base;
+                struct v3d_vs_key vs;
+                struct v3d_fs_key fs;
+        } key;
+        size_t key_size;
+
+        struct v3d_screen *screen;
+        int program_id;
+
+        /** Signaled once prog_data and qpu_insts have been filled in. */
+        struct util_queue_fence ready;
+
+        struct v3d_prog_data *prog_data;
+        uint64_t *qpu_insts;
+        uint32_t qpu_size;
+};
+
 static struct v3d_compiled_shader *
 v3d_get_compiled_shader(struct v3d_context *v3d,
                         struct v3d_key *key, size_t key_size);
 static void
 v3d_setup_shared_precompile_key(struct v3d_uncompiled_shader *uncompiled,
                                 struct v3d_key *key);
+static void
+v3d_predict_variant(struct v3d_context *v3d,
+                    struct v3d_uncompiled_shader *so);
 
 static gl_varying_slot
 v3d_get_slot_for_driver_location(nir_shader *s, uint32_t driver_location)
@@ -330,6 +359,9 @@ v3d_uncompiled_shader_create(struct pipe_context *pctx,
         so->base.type = PIPE_SHADER_IR_NIR;
         so->base.ir.nir = s;
 
+        if (v3d->screen->disk_cache)
+                u_variant_cache_hash_nir(s, so->nir_sha1);
+
         if (V3D_DEBUG & (V3D_DEBUG_NIR |
                          v3d_debug_flag_for_shader_stage(s->info.stage))) {
                 fprintf(stderr, "%s prog %d NIR:\n",
@@ -366,9 +398,79 @@ v3d_shader_state_create(struct pipe_context *pctx,
 
         v3d_set_transform_feedback_outputs(so, &cso->stream_output);
 
+        v3d_predict_variant(v3d_context(pctx), so);
+
         return so;
 }
 
+/**
+ * Returns the compiled code for a variant, from the on-disk cache if
+ * possible.
+ */
+static uint64_t *
+v3d_compile_variant(struct v3d_screen *screen,
+                    struct v3d_key *key, size_t key_size,
+                    struct v3d_prog_data **prog_data,
+                    void (*debug_output)(const char *msg,
+                                         void *debug_output_data),
+                    void *debug_output_data,
+                    int program_id, int variant_id,
+                    uint32_t *qpu_size)
+{
+        struct v3d_uncompiled_shader *shader_state = key->shader_state;
+        uint64_t *qpu_insts;
+
+        qpu_insts = v3d_disk_cache_retrieve(screen, key, key_size,
+                                            prog_data, qpu_size);
+        if (qpu_insts)
+                return qpu_insts;
+
+        qpu_insts = v3d_compile(screen->compiler, key, prog_data,
+                                shader_state->base.ir.nir,
+                                debug_output, debug_output_data,
+                                program_id, variant_id, qpu_size);
+        if (qpu_insts) {
+                v3d_disk_cache_store(screen, key, key_size, *prog_data,
+                                     qpu_insts, *qpu_size);
+        }
+
+        return qpu_insts;
+}
+
+static void
+v3d_predicted_variant_debug_output(const char *message, void *data)
+{
+        /* Nothing to report: variants aren't predicted while the context
+         * has a debug callback.
+         */
+}
+
+static void
+v3d_compile_predicted_variant(void *job, int thread_index)
+{
+        struct v3d_predicted_variant *p = job;
+
+        p->qpu_insts = v3d_compile_variant(p->screen,
+                                           &p->key.base, p->key_size,
+                                           &p->prog_data,
+                                           v3d_predicted_variant_debug_output,
+                                           NULL,
+                                           p->program_id, 0,
+                                           &p->qpu_size);
+}
+
+static void
+v3d_free_predicted_variant(struct v3d_screen *screen,
+                           struct v3d_predicted_variant *p)
+{
+        util_queue_drop_job(&screen->compile_queue, &p->ready);
+        util_queue_fence_destroy(&p->ready);
+
+        free(p->qpu_insts);
+        ralloc_free(p->prog_data);
+        free(p);
+}
+
 struct v3d_compiled_shader *
 v3d_get_compiled_shader(struct v3d_context *v3d,
                         struct v3d_key *key,
@@ -385,17 +487,44 @@ v3d_get_compiled_shader(struct v3d_context *v3d,
         struct v3d_compiled_shader *shader =
                 rzalloc(NULL, struct v3d_compiled_shader);
 
-        int program_id = shader_state->program_id;
-        int variant_id =
-                p_atomic_inc_return(&shader_state->compiled_variant_count);
+        struct v3d_predicted_variant *predicted = shader_state->predicted;
         uint64_t *qpu_insts;
         uint32_t shader_size;
 
-        qpu_insts = v3d_compile(v3d->screen->compiler, key,
-                                &shader->prog_data.base, s,
-                                v3d_shader_debug_output,
-                                v3d,
-                                program_id, variant_id, &shader_size);
+        if (predicted && predicted->key_size == key_size &&
+            memcmp(&predicted->key, key, key_size) == 0) {
+                /* The background compile guessed right, so we only have to
+                 * wait for it to finish (if it hasn't already).
+                 */
+                util_queue_fence_wait(&predicted->ready);
+
+                shader->prog_data.base = predicted->prog_data;
+                qpu_insts = predicted->qpu_insts;
+                shader_size = predicted->qpu_size;
+
+                predicted->prog_data = NULL;
+                predicted->qpu_insts = NULL;
+                v3d_free_predicted_variant(v3d->screen, predicted);
+                shader_state->predicted = NULL;
+
+                /* Only variants that get used are counted. */
+                p_atomic_inc(&shader_state->compiled_variant_count);
+
+                v3d->prog.predicted_hits++;
+        } else {
+                int program_id = shader_state->program_id;
+                int variant_id =
+                        p_atomic_inc_return(&shader_state->compiled_variant_count);
+
+                qpu_insts = v3d_compile_variant(v3d->screen, key, key_size,
+                                                &shader->prog_data.base,
+                                                v3d_shader_debug_output,
+                                                v3d,
+                                                program_id, variant_id,
+                                                &shader_size);
+
+                v3d->prog.predicted_misses++;
+        }
         ralloc_steal(shader, shader->prog_data.base);
 
         v3d_set_shader_uniform_dirty_flags(shader);
@@ -518,27 +647,15 @@ v3d_setup_shared_precompile_key(struct v3d_uncompiled_shader *uncompiled,
 }
 
 static void
-v3d_update_compiled_fs(struct v3d_context *v3d, uint8_t prim_mode)
+v3d_setup_fs_key(struct v3d_context *v3d, struct v3d_fs_key *key,
+                 struct v3d_uncompiled_shader *uncompiled,
+                 uint8_t prim_mode, bool msaa)
 {
-        struct v3d_job *job = v3d->job;
-        struct v3d_fs_key local_key;
-        struct v3d_fs_key *key = &local_key;
-        nir_shader *s = v3d->prog.bind_fs->base.ir.nir;
-
-        if (!(v3d->dirty & (VC5_DIRTY_PRIM_MODE |
-                            VC5_DIRTY_BLEND |
-                            VC5_DIRTY_FRAMEBUFFER |
-                            VC5_DIRTY_ZSA |
-                            VC5_DIRTY_RASTERIZER |
-                            VC5_DIRTY_SAMPLE_STATE |
-                            VC5_DIRTY_FRAGTEX |
-                            VC5_DIRTY_UNCOMPILED_FS))) {
-                return;
-        }
+        nir_shader *s = uncompiled->base.ir.nir;
 
         memset(key, 0, sizeof(*key));
         v3d_setup_shared_key(v3d, &key->base, &v3d->tex[PIPE_SHADER_FRAGMENT]);
-        key->base.shader_state = v3d->prog.bind_fs;
+        key->base.shader_state = uncompiled;
         key->base.ucp_enables = v3d->rasterizer->base.clip_plane_enable;
         key->is_points = (prim_mode == PIPE_PRIM_POINTS);
         key->is_lines = (prim_mode >= PIPE_PRIM_LINES &&
@@ -549,7 +666,7 @@ v3d_update_compiled_fs(struct v3d_context *v3d, uint8_t prim_mode)
         } else {
                 key->logicop_func = PIPE_LOGICOP_COPY;
         }
-        if (job->msaa) {
+        if (msaa) {
                 key->msaa = v3d->rasterizer->base.multisample;
                 key->sample_coverage = (v3d->rasterizer->base.multisample &&
                                         v3d->sample_mask != (1 << V3D_MAX_SAMPLES) - 1);
@@ -614,6 +731,27 @@ v3d_update_compiled_fs(struct v3d_context *v3d, uint8_t prim_mode)
 
         key->light_twoside = v3d->rasterizer->base.light_twoside;
         key->shade_model_flat = v3d->rasterizer->base.flatshade;
+}
+
+static void
+v3d_update_compiled_fs(struct v3d_context *v3d, uint8_t prim_mode)
+{
+        struct v3d_job *job = v3d->job;
+        struct v3d_fs_key local_key;
+        struct v3d_fs_key *key = &local_key;
+
+        if (!(v3d->dirty & (VC5_DIRTY_PRIM_MODE |
+                            VC5_DIRTY_BLEND |
+                            VC5_DIRTY_FRAMEBUFFER |
+                            VC5_DIRTY_ZSA |
+                            VC5_DIRTY_RASTERIZER |
+                            VC5_DIRTY_SAMPLE_STATE |
+                            VC5_DIRTY_FRAGTEX |
+                            VC5_DIRTY_UNCOMPILED_FS))) {
+                return;
+        }
+
+        v3d_setup_fs_key(v3d, key, v3d->prog.bind_fs, prim_mode, job->msaa);
 
         struct v3d_compiled_shader *old_fs = v3d->prog.fs;
         v3d->prog.fs = v3d_get_compiled_shader(v3d, &key->base, sizeof(*key));
@@ -721,24 +859,12 @@ v3d_update_compiled_gs(struct v3d_context *v3d, uint8_t prim_mode)
 }
 
 static void
-v3d_update_compiled_vs(struct v3d_context *v3d, uint8_t prim_mode)
+v3d_setup_vs_key(struct v3d_context *v3d, struct v3d_vs_key *key,
+                 struct v3d_uncompiled_shader *uncompiled, uint8_t prim_mode)
 {
-        struct v3d_vs_key local_key;
-        struct v3d_vs_key *key = &local_key;
-
-        if (!(v3d->dirty & (VC5_DIRTY_VERTTEX |
-                            VC5_DIRTY_VTXSTATE |
-                            VC5_DIRTY_UNCOMPILED_VS |
-                            (v3d->prog.bind_gs ? 0 : VC5_DIRTY_RASTERIZER) |
-                            (v3d->prog.bind_gs ? 0 : VC5_DIRTY_PRIM_MODE) |
-                            (v3d->prog.bind_gs ? VC5_DIRTY_GS_INPUTS :
-                                                 VC5_DIRTY_FS_INPUTS)))) {
-                return;
-        }
-
         memset(key, 0, sizeof(*key));
         v3d_setup_shared_key(v3d, &key->base, &v3d->tex[PIPE_SHADER_VERTEX]);
-        key->base.shader_state = v3d->prog.bind_vs;
+        key->base.shader_state = uncompiled;
         key->base.ucp_enables = v3d->rasterizer->base.clip_plane_enable;
         key->base.is_last_geometry_stage = !v3d->prog.bind_gs;
 
@@ -761,6 +887,25 @@ v3d_update_compiled_vs(struct v3d_context *v3d, uint8_t prim_mode)
         key->per_vertex_point_size =
                 (prim_mode == PIPE_PRIM_POINTS &&
                  v3d->rasterizer->base.point_size_per_vertex);
+}
+
+static void
+v3d_update_compiled_vs(struct v3d_context *v3d, uint8_t prim_mode)
+{
+        struct v3d_vs_key local_key;
+        struct v3d_vs_key *key = &local_key;
+
+        if (!(v3d->dirty & (VC5_DIRTY_VERTTEX |
+                            VC5_DIRTY_VTXSTATE |
+                            VC5_DIRTY_UNCOMPILED_VS |
+                            (v3d->prog.bind_gs ? 0 : VC5_DIRTY_RASTERIZER) |
+                            (v3d->prog.bind_gs ? 0 : VC5_DIRTY_PRIM_MODE) |
+                            (v3d->prog.bind_gs ? VC5_DIRTY_GS_INPUTS :
+                                                 VC5_DIRTY_FS_INPUTS)))) {
+                return;
+        }
+
+        v3d_setup_vs_key(v3d, key, v3d->prog.bind_vs, prim_mode);
 
         struct v3d_compiled_shader *vs =
                 v3d_get_compiled_shader(v3d, &key->base, sizeof(*key));
@@ -810,6 +955,15 @@ v3d_update_compiled_shaders(struct v3d_context *v3d, uint8_t prim_mode)
         v3d_update_compiled_vs(v3d, prim_mode);
 }
 
+static void
+v3d_setup_cs_key(struct v3d_context *v3d, struct v3d_key *key,
+                 struct v3d_uncompiled_shader *uncompiled)
+{
+        memset(key, 0, sizeof(*key));
+        v3d_setup_shared_key(v3d, key, &v3d->tex[PIPE_SHADER_COMPUTE]);
+        key->shader_state = uncompiled;
+}
+
 void
 v3d_update_compiled_cs(struct v3d_context *v3d)
 {
@@ -821,9 +975,7 @@ v3d_update_compiled_cs(struct v3d_context *v3d)
                 return;
         }
 
-        memset(key, 0, sizeof(*key));
-        v3d_setup_shared_key(v3d, key, &v3d->tex[PIPE_SHADER_COMPUTE]);
-        key->shader_state = v3d->prog.bind_compute;
+        v3d_setup_cs_key(v3d, key, v3d->prog.bind_compute);
 
         struct v3d_compiled_shader *cs =
                 v3d_get_compiled_shader(v3d, key, sizeof(*key));
@@ -833,6 +985,110 @@ v3d_update_compiled_cs(struct v3d_context *v3d)
         }
 }
 
+/**
+ * Creates the screen's compile queue if it hasn't been yet, so that screens
+ * whose contexts never predict a variant don't start its threads.  Returns
+ * false if the queue couldn't be created.
+ */
+static bool
+v3d_screen_init_compile_queue(struct v3d_screen *screen)
+{
+        mtx_lock(&screen->compile_queue_mutex);
+        if (!screen->compile_queue_attempted) {
+                screen->compile_queue_attempted = true;
+
+                /* Leave a core free for the application's rendering thread
+                 * when compiling predicted shader variants in the
+                 * background.
+                 */
+                util_cpu_detect();
+                util_queue_init(&screen->compile_queue, "v3d_sh", 64,
+                                MAX2(util_cpu_caps.nr_cpus - 1, 1),
+                                UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                                UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY);
+        }
+        mtx_unlock(&screen->compile_queue_mutex);
+
+        return util_queue_is_initialized(&screen->compile_queue);
+}
+
+/**
+ * Guesses the key that a new shader will first be drawn with from the
+ * currently bound state, and compiles that variant on the screen's compile
+ * queue so that the draw only has to wait for it if it's still in flight.
+ *
+ * Draws are assumed to be triangles.  Vertex shaders are only predicted
+ * without a geometry shader, against the current compiled FS's inputs.
+ *
+ * Nothing is predicted while compiles are being reported, through the
+ * context's debug callback or V3D_DEBUG, since a prediction that is never
+ * used would show up as an extra variant with a made up variant id.
+ */
+static void
+v3d_predict_variant(struct v3d_context *v3d,
+                    struct v3d_uncompiled_shader *so)
+{
+        struct v3d_screen *screen = v3d->screen;
+
+        if (!so)
+                return;
+
+        if (v3d->debug.debug_message ||
+            (V3D_DEBUG & (V3D_DEBUG_SHADERDB | V3D_DEBUG_PERF |
+                          V3D_DEBUG_NIR | V3D_DEBUG_VIR | V3D_DEBUG_QPU |
+                          V3D_DEBUG_FS | V3D_DEBUG_GS | V3D_DEBUG_VS |
+                          V3D_DEBUG_CS)))
+                return;
+
+        nir_shader *s = so->base.ir.nir;
+
+        switch (s->info.stage) {
+        case MESA_SHADER_FRAGMENT:
+                if (!v3d->rasterizer || !v3d->blend || !v3d->zsa)
+                        return;
+                break;
+        case MESA_SHADER_VERTEX:
+                if (!v3d->rasterizer || !v3d->prog.fs || v3d->prog.bind_gs)
+                        return;
+                break;
+        case MESA_SHADER_COMPUTE:
+                break;
+        default:
+                return;
+        }
+
+        if (!v3d_screen_init_compile_queue(screen))
+                return;
+
+        struct v3d_predicted_variant *p = CALLOC_STRUCT(v3d_predicted_variant);
+        if (!p)
+                return;
+
+        switch (s->info.stage) {
+        case MESA_SHADER_FRAGMENT:
+                v3d_setup_fs_key(v3d, &p->key.fs, so, PIPE_PRIM_TRIANGLES,
+                                 util_framebuffer_get_num_samples(&v3d->framebuffer) > 1);
+                p->key_size = sizeof(p->key.fs);
+                break;
+        case MESA_SHADER_VERTEX:
+                v3d_setup_vs_key(v3d, &p->key.vs, so, PIPE_PRIM_TRIANGLES);
+                p->key_size = sizeof(p->key.vs);
+                break;
+        default:
+                v3d_setup_cs_key(v3d, &p->key.base, so);
+                p->key_size = sizeof(p->key.base);
+                break;
+        }
+
+        p->screen = screen;
+        p->program_id = so->program_id;
+        util_queue_fence_init(&p->ready);
+
+        so->predicted = p;
+        util_queue_add_job(&screen->compile_queue, p, &p->ready,
+                           v3d_compile_predicted_variant, NULL, 0);
+}
+
 static uint32_t
 fs_cache_hash(const void *key)
 {
@@ -908,6 +1164,9 @@ v3d_shader_state_delete(struct pipe_context *pctx, void *hwcso)
                 v3d_free_compiled_shader(shader);
         }
 
+        if (so->predicted)
+                v3d_free_predicted_variant(v3d->screen, so->predicted);
+
         ralloc_free(so->base.ir.nir);
         free(so);
 }
@@ -949,8 +1208,13 @@ static void *
 v3d_create_compute_state(struct pipe_context *pctx,
                          const struct pipe_compute_state *cso)
 {
-        return v3d_uncompiled_shader_create(pctx, cso->ir_type,
-                                            (void *)cso->prog);
+        struct v3d_uncompiled_shader *so =
+                v3d_uncompiled_shader_create(pctx, cso->ir_type,
+                                             (void *)cso->prog);
+
+        v3d_predict_variant(v3d_context(pctx), so);
+
+        return so;
 }
 
 void
@@ -38,12 +38,41 @@
 
 struct v3d_query
 {
-        enum pipe_query_type type;
+        unsigned type;
         struct v3d_bo *bo;
 
         uint32_t start, end;
 };
 
+static const struct pipe_driver_query_info v3d_driver_query_list[] = {
+        {
+                .name = "shader-predicted-hits",
+                .query_type = V3D_QUERY_PREDICTED_HITS,
+                .type = PIPE_DRIVER_QUERY_TYPE_UINT64,
+                .result_type = PIPE_DRIVER_QUERY_RESULT_TYPE_CUMULATIVE,
+        },
+        {
+                .name = "shader-predicted-misses",
+                .query_type = V3D_QUERY_PREDICTED_MISSES,
+                .type = PIPE_DRIVER_QUERY_TYPE_UINT64,
+                .result_type = PIPE_DRIVER_QUERY_RESULT_TYPE_CUMULATIVE,
+        },
+};
+
+int
+v3d_get_driver_query_info(struct pipe_screen *pscreen, unsigned index,
+                          struct pipe_driver_query_info *info)
+{
+        if (!info)
+                return ARRAY_SIZE(v3d_driver_query_list);
+
+        if (index >= ARRAY_SIZE(v3d_driver_query_list))
+                return 0;
+
+        *info = v3d_driver_query_list[index];
+        return 1;
+}
+
 static struct pipe_query *
 v3d_create_query(struct pipe_context *pctx, unsigned query_type, unsigned index)
 {
@@ -89,6 +118,12 @@ v3d_begin_query(struct pipe_context *pctx, struct pipe_query *query)
                         v3d_update_primitive_counters(v3d);
                 q->start = v3d->tf_prims_generated;
                 break;
+        case V3D_QUERY_PREDICTED_HITS:
+                q->start = v3d->prog.predicted_hits;
+                break;
+        case V3D_QUERY_PREDICTED_MISSES:
+                q->start = v3d->prog.predicted_misses;
+                break;
         case PIPE_QUERY_OCCLUSION_COUNTER:
         case PIPE_QUERY_OCCLUSION_PREDICATE:
         case PIPE_QUERY_OCCLUSION_PREDICATE_CONSERVATIVE:
@@ -131,6 +166,12 @@ v3d_end_query(struct pipe_context *pctx, struct pipe_query *query)
                         v3d_update_primitive_counters(v3d);
                 q->end = v3d->tf_prims_generated;
                 break;
+        case V3D_QUERY_PREDICTED_HITS:
+                q->end = v3d->prog.predicted_hits;
+                break;
+        case V3D_QUERY_PREDICTED_MISSES:
+                q->end = v3d->prog.predicted_misses;
+                break;
         case PIPE_QUERY_OCCLUSION_COUNTER:
         case PIPE_QUERY_OCCLUSION_PREDICATE:
         case PIPE_QUERY_OCCLUSION_PREDICATE_CONSERVATIVE:
@@ -180,6 +221,8 @@ v3d_get_query_result(struct pipe_context *pctx, struct pipe_query *query,
                 break;
         case PIPE_QUERY_PRIMITIVES_GENERATED:
         case PIPE_QUERY_PRIMITIVES_EMITTED:
+        case V3D_QUERY_PREDICTED_HITS:
+        case V3D_QUERY_PREDICTED_MISSES:
                 vresult->u64 = q->end - q->start;
                 break;
         default:
@@ -30,6 +30,7 @@
 #include "pipe/p_screen.h"
 #include "pipe/p_state.h"
 
+#include "util/disk_cache.h"
 #include "util/u_debug.h"
 #include "util/u_memory.h"
 #include "util/format/u_format.h"
@@ -80,7 +81,12 @@ v3d_screen_destroy(struct pipe_screen *pscreen)
         if (using_v3d_simulator)
                 v3d_simulator_destroy(screen);
 
+        if (screen->compile_queue_attempted &&
+            util_queue_is_initialized(&screen->compile_queue))
+                util_queue_destroy(&screen->compile_queue);
+        mtx_destroy(&screen->compile_queue_mutex);
         v3d_compiler_free(screen->compiler);
+        disk_cache_destroy(screen->disk_cache);
         u_transfer_helper_destroy(pscreen->transfer_helper);
 
         close(screen->fd);
@@ -669,6 +675,7 @@ v3d_screen_create(int fd, const struct pipe_screen_config *config,
         pscreen->get_paramf = v3d_screen_get_paramf;
         pscreen->get_shader_param = v3d_screen_get_shader_param;
         pscreen->get_compute_param = v3d_get_compute_param;
+        pscreen->get_driver_query_info = v3d_get_driver_query_info;
         pscreen->context_create = v3d_context_create;
         pscreen->is_format_supported = v3d_screen_is_format_supported;
 
@@ -713,6 +720,8 @@ v3d_screen_create(int fd, const struct pipe_screen_config *config,
         v3d_resource_screen_init(pscreen);
 
         screen->compiler = v3d_compiler_init(&screen->devinfo);
+        v3d_disk_cache_init(screen);
+        (void)mtx_init(&screen->compile_queue_mutex, mtx_plain);
 
         pscreen->get_name = v3d_screen_get_name;
         pscreen->get_vendor = v3d_screen_get_vendor;
@@ -30,6 +30,7 @@
 #include "state_tracker/drm_driver.h"
 #include "util/list.h"
 #include "util/slab.h"
+#include "util/u_queue.h"
 #include "broadcom/common/v3d_debug.h"
 #include "broadcom/common/v3d_device_info.h"
 
@@ -71,6 +72,16 @@ struct v3d_screen {
 
         const struct v3d_compiler *compiler;
 
+        struct disk_cache *disk_cache;
+
+        /**
+         * Compiles variants predicted at shader creation time, created by
+         * the first prediction.
+         */
+        mtx_t compile_queue_mutex;
+        bool compile_queue_attempted;
+        struct util_queue compile_queue;
+
         struct util_hash_table *bo_handles;
         mtx_t bo_handles_mutex;
 
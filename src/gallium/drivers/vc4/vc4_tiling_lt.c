@@ -35,6 +35,7 @@
 #include "pipe/p_state.h"
 #include "vc4_tiling.h"
 #include "broadcom/common/v3d_cpu_tiling.h"
+#include "util/u_tiling.h"
 
 #ifdef V3D_BUILD_NEON
 #define NEON_TAG(x) x ## _neon
@@ -64,67 +65,6 @@ vc4_utile_stride(int cpp)
         }
 }
 
-/**
- * Returns the X value into the address bits for LT tiling.
- *
- * The LT tile load/stores rely on the X bits not intersecting with the Y
- * bits.  Because of this, we have to choose to put the utile index within the
- * LT tile into one of the two values, and we do so in swizzle_lt_x() to make
- * NPOT handling easier.
- */
-static uint32_t
-swizzle_lt_x(int x, int cpp)
-{
-        switch (cpp) {
-        case 1:
-                /* 8x8 inside of 4x4 */
-                return ((x & 0x7) << (0 - 0) |
-                        (x & ~0x7) << (6 - 3));
-        case 2:
-                /* 8x4 inside of 4x4 */
-                return ((x & 0x7) << (1 - 0) |
-                        (x & ~0x7) << (6 - 3));
-        case 4:
-                /* 4x4 inside of 4x4 */
-                return ((x & 0x3) << (2 - 0) |
-                        (x & ~0x3) << (6 - 2));
-        case 8:
-                /* 2x4 inside of 4x4 */
-                return ((x & 0x1) << (3 - 0) |
-                        (x & ~0x1) << (6 - 1));
-        default:
-                unreachable("bad cpp");
-        }
-}
-
-/**
- * Returns the Y value into the address bits for LT tiling.
- *
- * The LT tile load/stores rely on the X bits not intersecting with the Y
- * bits.
- */
-static uint32_t
-swizzle_lt_y(int y, int cpp)
-{
-
-        switch (cpp) {
-        case 1:
-                /* 8x8 inside of 4x4 */
-                return ((y & 0x7) << 3);
-        case 2:
-                /* 8x4 inside of 4x4 */
-                return ((y & 0x3) << 4);
-        case 4:
-                /* 4x4 inside of 4x4 */
-                return ((y & 0x3) << 4);
-        case 8:
-                /* 2x4 inside of 4x4 */
-                return ((y & 0x3) << 4);
-        default:
-                unreachable("bad cpp");
-        }
-}
-
 /**
  * Helper for loading or storing to an LT image, where the box is aligned
  * to utiles.
@@ -168,61 +108,30 @@ vc4_lt_image_aligned(void *gpu, uint32_t gpu_stride,
  * Helper for loading or storing to an LT image, where the box is not aligned
  * to utiles.
  *
- * This walks through the raster-order data, copying to/from the corresponding
- * tiled pixel.  This means we don't get write-combining on stores, but the
- * loop is very few CPU instructions since the memcpy will be inlined.
+ * Within a utile the pixels are in raster order, so each row of the box is a
+ * run of whole utile rows plus partial ones at either end, which
+ * util_tile_load/util_tile_store copy with fixed-size moves.
  */
 static inline void
 vc4_lt_image_unaligned(void *gpu, uint32_t gpu_stride,
                        void *cpu, uint32_t cpu_stride,
                        int cpp, const struct pipe_box *box, bool to_cpu)
 {
-
-        /* These are the address bits for the start of the box, split out into
-         * x/y so that they can be incremented separately in their loops.
-         */
-        uint32_t offs_x0 = swizzle_lt_x(box->x, cpp);
-        uint32_t offs_y = swizzle_lt_y(box->y, cpp);
-        /* The *_mask values are "what bits of the address are from x or y" */
-        uint32_t x_mask = swizzle_lt_x(~0, cpp);
-        uint32_t y_mask = swizzle_lt_y(~0, cpp);
-        uint32_t incr_y = swizzle_lt_x(gpu_stride / cpp, cpp);
-
-        assert(!(x_mask & y_mask));
-
-        offs_x0 += incr_y * (box->y / vc4_utile_height(cpp));
-
-        for (uint32_t y = 0; y < box->height; y++) {
-                void *gpu_row = gpu + offs_y;
-
-                uint32_t offs_x = offs_x0;
-
-                for (uint32_t x = 0; x < box->width; x++) {
-                        /* Use a memcpy here to move a pixel's worth of data.
-                         * We're relying on this function to be inlined, so
-                         * this will get expanded into the appropriate 1, 2,
-                         * or 4-byte move.
-                         */
-                        if (to_cpu) {
-                                memcpy(cpu + x * cpp, gpu_row + offs_x, cpp);
-                        } else {
-                                memcpy(gpu_row + offs_x, cpu + x * cpp, cpp);
-                        }
-
-                        /* This math trick with x_mask increments offs_x by 1
-                         * in x.
-                         */
-                        offs_x = (offs_x - x_mask) & x_mask;
-                }
-
-                offs_y = (offs_y - y_mask) & y_mask;
-                /* When offs_y wraps (we hit the end of the utile), we
-                 * increment offs_x0 by effectively the utile stride.
-                 */
-                if (!offs_y)
-                        offs_x0 += incr_y;
-
-                cpu += cpu_stride;
+        const struct util_tile_layout layout = {
+                .tile_w = vc4_utile_width(cpp),
+                .tile_h = vc4_utile_height(cpp),
+                .cpp = cpp,
+                .tile_row_stride = gpu_stride * vc4_utile_height(cpp),
+        };
+
+        assert(layout.tile_w * cpp == vc4_utile_stride(cpp));
+
+        if (to_cpu) {
+                util_tile_load(&layout, cpu, cpu_stride, gpu,
+                               box->x, box->y, box->width, box->height);
+        } else {
+                util_tile_store(&layout, gpu, cpu, cpu_stride,
+                                box->x, box->y, box->width, box->height);
         }
 }
 
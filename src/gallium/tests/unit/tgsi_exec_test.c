@@ -0,0 +1,152 @@
+/*
+ * Copyright 2019 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Checks that the interpreter stores the same values whether all lanes of
+ * the quad are live, or only some are (inside divergent control flow), with
+ * and without saturation.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tgsi/tgsi_exec.h"
+#include "tgsi/tgsi_text.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+
+#define t_assert(cond) \
+   do { \
+      if (!(cond)) { \
+         fprintf(stderr, "%s:%d: assertion failed: %s\n", \
+                 __FILE__, __LINE__, #cond); \
+         abort(); \
+      } \
+   } while (0)
+
+/* OUT[0] and OUT[1] are written with all lanes live, OUT[2] and OUT[3] only
+ * by the lanes where IN[1].x is non-zero.
+ */
+static const char *shader_text =
+   "VERT\n"
+   "DCL IN[0]\n"
+   "DCL IN[1]\n"
+   "DCL OUT[0], GENERIC[0]\n"
+   "DCL OUT[1], GENERIC[1]\n"
+   "DCL OUT[2], GENERIC[2]\n"
+   "DCL OUT[3], GENERIC[3]\n"
+   "  0: MOV OUT[0], IN[0]\n"
+   "  1: MOV_SAT OUT[1], IN[0]\n"
+   "  2: UIF IN[1].xxxx\n"
+   "  3:   MOV OUT[2], IN[0]\n"
+   "  4:   MOV_SAT OUT[3], IN[0]\n"
+   "  5: ENDIF\n"
+   "  6: END\n";
+
+#define SENTINEL 0xdeadbeef
+
+static uint32_t
+saturate_bits(uint32_t bits)
+{
+   float f = uif(bits);
+
+   if (f < 0.0f)
+      return fui(0.0f);
+   if (f > 1.0f)
+      return fui(1.0f);
+   return bits;
+}
+
+static void
+run(struct tgsi_exec_machine *mach, const float values[16],
+    unsigned live_lanes)
+{
+   for (unsigned c = 0; c < 4; c++) {
+      for (unsigned lane = 0; lane < TGSI_QUAD_SIZE; lane++)
+         mach->Inputs[0].xyzw[c].f[lane] = values[c * 4 + lane];
+   }
+   for (unsigned lane = 0; lane < TGSI_QUAD_SIZE; lane++)
+      mach->Inputs[1].xyzw[0].u[lane] = (live_lanes >> lane) & 1;
+
+   for (unsigned i = 0; i < 4; i++) {
+      for (unsigned c = 0; c < 4; c++) {
+         for (unsigned lane = 0; lane < TGSI_QUAD_SIZE; lane++)
+            mach->Outputs[i].xyzw[c].u[lane] = SENTINEL;
+      }
+   }
+
+   mach->NonHelperMask = 0xf;
+   tgsi_exec_machine_run(mach, 0);
+}
+
+static void
+check(const struct tgsi_exec_machine *mach, const float values[16],
+      unsigned live_lanes)
+{
+   for (unsigned c = 0; c < 4; c++) {
+      for (unsigned lane = 0; lane < TGSI_QUAD_SIZE; lane++) {
+         uint32_t in = fui(values[c * 4 + lane]);
+         bool live = live_lanes & (1 << lane);
+
+         t_assert(mach->Outputs[0].xyzw[c].u[lane] == in);
+         t_assert(mach->Outputs[1].xyzw[c].u[lane] == saturate_bits(in));
+         t_assert(mach->Outputs[2].xyzw[c].u[lane] ==
+                  (live ? in : SENTINEL));
+         t_assert(mach->Outputs[3].xyzw[c].u[lane] ==
+                  (live ? saturate_bits(in) : SENTINEL));
+      }
+   }
+}
+
+int
+main(int argc, char **argv)
+{
+   struct tgsi_token tokens[1024];
+   t_assert(tgsi_text_translate(shader_text, tokens, ARRAY_SIZE(tokens)));
+
+   struct tgsi_exec_machine *mach =
+      tgsi_exec_machine_create(PIPE_SHADER_VERTEX);
+   t_assert(mach);
+   tgsi_exec_machine_bind_shader(mach, tokens, NULL, NULL, NULL);
+
+   /* Values on and around the saturation bounds, and ones the clamp must
+    * leave alone bit for bit.
+    */
+   const float values[16] = {
+      -2.0f, -0.0f, 0.0f, 0.5f,
+      1.0f, 1.0f + FLT_EPSILON, 3.0f, 1e-40f,
+      NAN, INFINITY, -INFINITY, -1e-40f,
+      0.25f, -0.5f, 0.75f, 100.0f,
+   };
+
+   for (unsigned live_lanes = 0; live_lanes <= 0xf; live_lanes++) {
+      run(mach, values, live_lanes);
+      check(mach, values, live_lanes);
+   }
+
+   tgsi_exec_machine_destroy(mach);
+
+   printf("Success!\n");
+   return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2019 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Checks that translate_generic's run() gives the same vertices as
+ * run_elts() with the indices of the same range, whether or not the range
+ * takes the linear fast path: in and out of bounds ranges, instanced
+ * attributes, format conversions and instance ID elements.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "translate/translate.h"
+#include "util/u_memory.h"
+
+#define t_assert(cond) \
+   do { \
+      if (!(cond)) { \
+         fprintf(stderr, "%s:%d: assertion failed: %s\n", \
+                 __FILE__, __LINE__, #cond); \
+         abort(); \
+      } \
+   } while (0)
+
+#define MAX_VERTICES 64
+#define BUFFER_SIZE 4096
+
+static uint8_t buffers[2][BUFFER_SIZE];
+
+static void
+add_element(struct translate_key *key, enum translate_element_type type,
+            enum pipe_format input_format, enum pipe_format output_format,
+            unsigned input_buffer, unsigned input_offset,
+            unsigned instance_divisor, unsigned output_size)
+{
+   struct translate_element *element = &key->element[key->nr_elements++];
+
+   element->type = type;
+   element->input_format = input_format;
+   element->output_format = output_format;
+   element->input_buffer = input_buffer;
+   element->input_offset = input_offset;
+   element->instance_divisor = instance_divisor;
+   element->output_offset = key->output_stride;
+   key->output_stride += output_size;
+}
+
+/* Runs the range both ways and compares the results byte for byte. */
+static void
+check_range(struct translate *translate, unsigned start, unsigned count,
+            unsigned start_instance, unsigned instance_id)
+{
+   const unsigned output_size = MAX_VERTICES * translate->key.output_stride;
+   uint8_t *linear = MALLOC(output_size);
+   uint8_t *indexed = MALLOC(output_size);
+   unsigned elts[MAX_VERTICES];
+
+   t_assert(count <= MAX_VERTICES);
+   for (unsigned i = 0; i < count; i++)
+      elts[i] = start + i;
+
+   memset(linear, 0xcd, output_size);
+   memset(indexed, 0xcd, output_size);
+
+   translate->run(translate, start, count, start_instance, instance_id,
+                  linear);
+   translate->run_elts(translate, elts, count, start_instance, instance_id,
+                       indexed);
+
+   t_assert(memcmp(linear, indexed, output_size) == 0);
+
+   FREE(linear);
+   FREE(indexed);
+}
+
+static void
+check_ranges(const struct translate_key *key, unsigned max_index)
+{
+   struct translate *translate = translate_generic_create(key);
+   t_assert(translate);
+
+   /* Interleaved vertices in buffer 0, packed per-instance data in 1. */
+   translate->set_buffer(translate, 0, buffers[0], 24, max_index);
+   translate->set_buffer(translate, 1, buffers[1], 8, max_index);
+
+   /* In bounds */
+   check_range(translate, 0, 1, 0, 0);
+   check_range(translate, 3, 10, 0, 0);
+   check_range(translate, 0, max_index + 1, 2, 5);
+
+   /* Clamped to max_index */
+   check_range(translate, max_index - 2, 8, 0, 3);
+   check_range(translate, max_index + 4, 4, 1, 0);
+
+   translate->release(translate);
+}
+
+int
+main(int argc, char **argv)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(buffers); i++) {
+      for (unsigned j = 0; j < BUFFER_SIZE; j++)
+         buffers[i][j] = (j * 37 + i * 11) & 0x7f;
+   }
+
+   struct translate_key key;
+
+   /* Straight copies */
+   memset(&key, 0, sizeof(key));
+   add_element(&key, TRANSLATE_ELEMENT_NORMAL,
+               PIPE_FORMAT_R32G32B32_FLOAT, PIPE_FORMAT_R32G32B32_FLOAT,
+               0, 0, 0, 12);
+   add_element(&key, TRANSLATE_ELEMENT_NORMAL,
+               PIPE_FORMAT_R32G32_FLOAT, PIPE_FORMAT_R32G32_FLOAT,
+               0, 12, 0, 8);
+   check_ranges(&key, 20);
+
+   /* Conversions, and instanced attributes */
+   memset(&key, 0, sizeof(key));
+   add_element(&key, TRANSLATE_ELEMENT_NORMAL,
+               PIPE_FORMAT_R32G32B32_FLOAT, PIPE_FORMAT_R32G32B32A32_FLOAT,
+               0, 0, 0, 16);
+   add_element(&key, TRANSLATE_ELEMENT_NORMAL,
+               PIPE_FORMAT_R8G8B8A8_UNORM, PIPE_FORMAT_R32G32B32A32_FLOAT,
+               0, 20, 0, 16);
+   add_element(&key, TRANSLATE_ELEMENT_NORMAL,
+               PIPE_FORMAT_R16G16_SNORM, PIPE_FORMAT_R32G32_FLOAT,
+               1, 0, 1, 8);
+   add_element(&key, TRANSLATE_ELEMENT_NORMAL,
+               PIPE_FORMAT_R8G8B8A8_UINT, PIPE_FORMAT_R32G32B32A32_UINT,
+               1, 4, 2, 16);
+   check_ranges(&key, 20);
+
+   /* An instance ID element, which doesn't take the fast path */
+   memset(&key, 0, sizeof(key));
+   add_element(&key, TRANSLATE_ELEMENT_NORMAL,
+               PIPE_FORMAT_R32G32B32_FLOAT, PIPE_FORMAT_R32G32B32_FLOAT,
+               0, 0, 0, 12);
+   add_element(&key, TRANSLATE_ELEMENT_INSTANCE_ID,
+               PIPE_FORMAT_R32_USCALED, PIPE_FORMAT_R32_USCALED,
+               0, 0, 0, 4);
+   check_ranges(&key, 20);
+
+   printf("Success!\n");
+   return 0;
+}
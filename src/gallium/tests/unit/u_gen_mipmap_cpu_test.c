@@ -0,0 +1,317 @@
+/*
+ * Copyright 2019 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Checks the mip levels util_gen_mipmap_cpu() builds, through a fake
+ * context whose textures live in malloc()ed memory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "util/format/u_format.h"
+#include "util/format_srgb.h"
+#include "util/u_gen_mipmap.h"
+#include "util/u_inlines.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+
+#define t_assert(cond) \
+   do { \
+      if (!(cond)) { \
+         fprintf(stderr, "%s:%d: assertion failed: %s\n", \
+                 __FILE__, __LINE__, #cond); \
+         abort(); \
+      } \
+   } while (0)
+
+#define MAX_LEVELS 4
+#define SENTINEL 0xcd
+
+struct fake_texture {
+   struct pipe_resource base;
+   uint8_t *levels[MAX_LEVELS];
+};
+
+static unsigned
+level_stride(const struct pipe_resource *pt, unsigned level)
+{
+   return u_minify(pt->width0, level) * util_format_get_blocksize(pt->format);
+}
+
+static unsigned
+level_layer_stride(const struct pipe_resource *pt, unsigned level)
+{
+   return level_stride(pt, level) * u_minify(pt->height0, level);
+}
+
+static unsigned
+level_depth(const struct pipe_resource *pt, unsigned level)
+{
+   return pt->target == PIPE_TEXTURE_3D ? u_minify(pt->depth0, level) :
+                                          pt->array_size;
+}
+
+static void *
+fake_transfer_map(struct pipe_context *pipe, struct pipe_resource *resource,
+                  unsigned level, unsigned usage, const struct pipe_box *box,
+                  struct pipe_transfer **out_transfer)
+{
+   struct fake_texture *tex = (struct fake_texture *)resource;
+   struct pipe_transfer *transfer = CALLOC_STRUCT(pipe_transfer);
+
+   t_assert(box->z + box->depth <= level_depth(resource, level));
+
+   transfer->resource = resource;
+   transfer->level = level;
+   transfer->usage = usage;
+   transfer->box = *box;
+   transfer->stride = level_stride(resource, level);
+   transfer->layer_stride = level_layer_stride(resource, level);
+   *out_transfer = transfer;
+
+   return tex->levels[level] + box->z * transfer->layer_stride +
+          box->y * transfer->stride +
+          box->x * util_format_get_blocksize(resource->format);
+}
+
+static void
+fake_transfer_unmap(struct pipe_context *pipe,
+                    struct pipe_transfer *transfer)
+{
+   FREE(transfer);
+}
+
+static struct pipe_context context = {
+   .transfer_map = fake_transfer_map,
+   .transfer_unmap = fake_transfer_unmap,
+};
+
+/* Creates a texture whose levels are all filled with SENTINEL. */
+static struct fake_texture *
+create_texture(enum pipe_texture_target target, enum pipe_format format,
+               unsigned width, unsigned height, unsigned depth,
+               unsigned array_size, unsigned last_level)
+{
+   struct fake_texture *tex = CALLOC_STRUCT(fake_texture);
+
+   t_assert(last_level < MAX_LEVELS);
+   tex->base.target = target;
+   tex->base.format = format;
+   tex->base.width0 = width;
+   tex->base.height0 = height;
+   tex->base.depth0 = depth;
+   tex->base.array_size = array_size;
+   tex->base.last_level = last_level;
+
+   for (unsigned level = 0; level <= last_level; level++) {
+      unsigned size = level_layer_stride(&tex->base, level) *
+                      level_depth(&tex->base, level);
+      tex->levels[level] = MALLOC(size);
+      memset(tex->levels[level], SENTINEL, size);
+   }
+
+   return tex;
+}
+
+static void
+destroy_texture(struct fake_texture *tex)
+{
+   for (unsigned level = 0; level <= tex->base.last_level; level++)
+      FREE(tex->levels[level]);
+   FREE(tex);
+}
+
+static const uint8_t *
+texel(struct fake_texture *tex, unsigned level, unsigned x, unsigned y,
+      unsigned z)
+{
+   return tex->levels[level] + z * level_layer_stride(&tex->base, level) +
+          y * level_stride(&tex->base, level) +
+          x * util_format_get_blocksize(tex->base.format);
+}
+
+static void
+check_texel(struct fake_texture *tex, unsigned level, unsigned x, unsigned y,
+            unsigned z, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+   const uint8_t *t = texel(tex, level, x, y, z);
+
+   t_assert(t[0] == r && t[1] == g && t[2] == b && t[3] == a);
+}
+
+static void
+test_2d(void)
+{
+   struct fake_texture *tex =
+      create_texture(PIPE_TEXTURE_2D, PIPE_FORMAT_R8G8B8A8_UNORM,
+                     4, 4, 1, 1, 2);
+
+   /* Channel values are multiples of 4, so that every average is exact. */
+   for (unsigned y = 0; y < 4; y++) {
+      for (unsigned x = 0; x < 4; x++) {
+         uint8_t *t = (uint8_t *)texel(tex, 0, x, y, 0);
+         t[0] = 16 * x;
+         t[1] = 16 * y;
+         t[2] = 4 * (x + 4 * y);
+         t[3] = 255;
+      }
+   }
+
+   t_assert(util_gen_mipmap_cpu(&context, &tex->base, tex->base.format,
+                                0, 2, 0, 0));
+
+   for (unsigned y = 0; y < 2; y++) {
+      for (unsigned x = 0; x < 2; x++) {
+         check_texel(tex, 1, x, y, 0, 16 * (2 * x) + 8, 16 * (2 * y) + 8,
+                     4 * (2 * x + 8 * y) + 10, 255);
+      }
+   }
+   check_texel(tex, 2, 0, 0, 0, 24, 24, 30, 255);
+
+   destroy_texture(tex);
+}
+
+static void
+test_srgb(void)
+{
+   struct fake_texture *tex =
+      create_texture(PIPE_TEXTURE_2D, PIPE_FORMAT_R8G8B8A8_SRGB,
+                     2, 1, 1, 1, 1);
+   uint8_t *t0 = (uint8_t *)texel(tex, 0, 0, 0, 0);
+   uint8_t *t1 = (uint8_t *)texel(tex, 0, 1, 0, 0);
+
+   memcpy(t0, (uint8_t[]) { 0, 0, 255, 0 }, 4);
+   memcpy(t1, (uint8_t[]) { 255, 0, 255, 255 }, 4);
+
+   t_assert(util_gen_mipmap_cpu(&context, &tex->base, tex->base.format,
+                                0, 1, 0, 0));
+
+   /* Averaged in linear space, while alpha is linear to begin with. */
+   check_texel(tex, 1, 0, 0, 0,
+               util_format_linear_float_to_srgb_8unorm(0.5f), 0, 255, 128);
+
+   destroy_texture(tex);
+}
+
+static void
+test_3d(void)
+{
+   struct fake_texture *tex =
+      create_texture(PIPE_TEXTURE_3D, PIPE_FORMAT_R8G8B8A8_UNORM,
+                     2, 2, 2, 1, 1);
+
+   for (unsigned z = 0; z < 2; z++) {
+      for (unsigned y = 0; y < 2; y++) {
+         for (unsigned x = 0; x < 2; x++) {
+            uint8_t *t = (uint8_t *)texel(tex, 0, x, y, z);
+            t[0] = 8 * (x + 2 * y + 4 * z);
+            t[1] = z ? 200 : 0;
+            t[2] = 0;
+            t[3] = 255;
+         }
+      }
+   }
+
+   t_assert(util_gen_mipmap_cpu(&context, &tex->base, tex->base.format,
+                                0, 1, 0, 0));
+
+   /* Both slices are filtered together. */
+   check_texel(tex, 1, 0, 0, 0, 28, 100, 0, 255);
+
+   destroy_texture(tex);
+}
+
+static void
+test_layers(void)
+{
+   struct fake_texture *tex =
+      create_texture(PIPE_TEXTURE_2D_ARRAY, PIPE_FORMAT_R8G8B8A8_UNORM,
+                     2, 2, 1, 3, 1);
+
+   for (unsigned z = 0; z < 3; z++) {
+      for (unsigned y = 0; y < 2; y++) {
+         for (unsigned x = 0; x < 2; x++) {
+            uint8_t *t = (uint8_t *)texel(tex, 0, x, y, z);
+            t[0] = 40 * z + 4 * x;
+            t[1] = 4 * y;
+            t[2] = 0;
+            t[3] = 255;
+         }
+      }
+   }
+
+   t_assert(util_gen_mipmap_cpu(&context, &tex->base, tex->base.format,
+                                0, 1, 1, 2));
+
+   /* Only the requested layers are written, each from its own source. */
+   check_texel(tex, 1, 0, 0, 0, SENTINEL, SENTINEL, SENTINEL, SENTINEL);
+   check_texel(tex, 1, 0, 0, 1, 42, 2, 0, 255);
+   check_texel(tex, 1, 0, 0, 2, 82, 2, 0, 255);
+
+   destroy_texture(tex);
+}
+
+static void
+test_unsupported(void)
+{
+   const enum pipe_format formats[] = {
+      PIPE_FORMAT_Z24_UNORM_S8_UINT,
+      PIPE_FORMAT_R8G8B8A8_UINT,
+      PIPE_FORMAT_DXT1_RGBA,
+   };
+
+   /* Left to util_gen_mipmap(), without touching the texture. */
+   for (unsigned i = 0; i < ARRAY_SIZE(formats); i++) {
+      struct pipe_resource pt = {
+         .target = PIPE_TEXTURE_2D,
+         .format = formats[i],
+         .width0 = 4, .height0 = 4, .depth0 = 1, .array_size = 1,
+         .last_level = 2,
+      };
+      t_assert(!util_gen_mipmap_cpu(&context, &pt, formats[i], 0, 2, 0, 0));
+   }
+
+   struct pipe_resource msaa = {
+      .target = PIPE_TEXTURE_2D,
+      .format = PIPE_FORMAT_R8G8B8A8_UNORM,
+      .width0 = 4, .height0 = 4, .depth0 = 1, .array_size = 1,
+      .last_level = 2,
+      .nr_samples = 4,
+   };
+   t_assert(!util_gen_mipmap_cpu(&context, &msaa, msaa.format, 0, 2, 0, 0));
+}
+
+int
+main(int argc, char **argv)
+{
+   test_2d();
+   test_srgb();
+   test_3d();
+   test_layers();
+   test_unsupported();
+
+   printf("Success!\n");
+   return 0;
+}
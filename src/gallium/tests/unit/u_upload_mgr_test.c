@@ -0,0 +1,316 @@
+/*
+ * Copyright 2019 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Checks that the upload manager only reuses a full buffer once the driver
+ * has retired it, using a fake driver whose buffers stay busy until the
+ * fence of the last draw using them signals.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_upload_mgr.h"
+
+#define BUFFER_SIZE 4096
+
+#define t_assert(cond) \
+   do { \
+      if (!(cond)) { \
+         fprintf(stderr, "%s:%d: assertion failed: %s\n", \
+                 __FILE__, __LINE__, #cond); \
+         abort(); \
+      } \
+   } while (0)
+
+struct fake_fence {
+   bool signalled;
+};
+
+struct fake_buffer {
+   struct pipe_resource base;
+   unsigned id;               /* Creation order, starting at 1. */
+   uint8_t *data;
+   struct fake_fence *fence;  /* Of the last draw reading the buffer. */
+};
+
+static unsigned num_buffers_created;
+
+static struct fake_buffer *
+fake_buffer(struct pipe_resource *resource)
+{
+   return (struct fake_buffer *)resource;
+}
+
+static bool
+fake_buffer_busy(struct fake_buffer *buf)
+{
+   return buf->fence && !buf->fence->signalled;
+}
+
+static int
+fake_get_param(struct pipe_screen *screen, enum pipe_cap param)
+{
+   /* No persistent mappings, so uploads are flushed explicitly. */
+   return 0;
+}
+
+static struct pipe_resource *
+fake_resource_create(struct pipe_screen *screen,
+                     const struct pipe_resource *templat)
+{
+   struct fake_buffer *buf = CALLOC_STRUCT(fake_buffer);
+
+   buf->base = *templat;
+   buf->base.screen = screen;
+   pipe_reference_init(&buf->base.reference, 1);
+   buf->id = ++num_buffers_created;
+   buf->data = CALLOC(templat->width0, 1);
+
+   return &buf->base;
+}
+
+static void
+fake_resource_destroy(struct pipe_screen *screen,
+                      struct pipe_resource *resource)
+{
+   struct fake_buffer *buf = fake_buffer(resource);
+
+   FREE(buf->data);
+   FREE(buf);
+}
+
+static void *
+fake_transfer_map(struct pipe_context *pipe, struct pipe_resource *resource,
+                  unsigned level, unsigned usage, const struct pipe_box *box,
+                  struct pipe_transfer **out_transfer)
+{
+   struct fake_buffer *buf = fake_buffer(resource);
+
+   if (!(usage & PIPE_TRANSFER_UNSYNCHRONIZED) && fake_buffer_busy(buf)) {
+      /* A real driver would wait for the fence here, which never signals
+       * on its own in this test.
+       */
+      t_assert(usage & PIPE_TRANSFER_DONTBLOCK);
+      return NULL;
+   }
+
+   struct pipe_transfer *transfer = CALLOC_STRUCT(pipe_transfer);
+   pipe_resource_reference(&transfer->resource, resource);
+   transfer->usage = usage;
+   transfer->box = *box;
+   *out_transfer = transfer;
+
+   return buf->data + box->x;
+}
+
+static void
+fake_transfer_flush_region(struct pipe_context *pipe,
+                           struct pipe_transfer *transfer,
+                           const struct pipe_box *box)
+{
+}
+
+static void
+fake_transfer_unmap(struct pipe_context *pipe,
+                    struct pipe_transfer *transfer)
+{
+   pipe_resource_reference(&transfer->resource, NULL);
+   FREE(transfer);
+}
+
+static struct pipe_screen screen = {
+   .get_param = fake_get_param,
+   .resource_create = fake_resource_create,
+   .resource_destroy = fake_resource_destroy,
+};
+
+static struct pipe_context context = {
+   .screen = &screen,
+   .transfer_map = fake_transfer_map,
+   .transfer_flush_region = fake_transfer_flush_region,
+   .transfer_unmap = fake_transfer_unmap,
+};
+
+struct upload {
+   unsigned buffer_id;
+   unsigned offset;
+   unsigned width0;
+};
+
+/* Uploads size bytes for a draw, which keeps the buffer busy until fence
+ * signals.  If hold is non-NULL, the caller keeps a reference to the
+ * buffer there, like a state tracker that hasn't consumed the upload yet.
+ */
+static struct upload
+upload_for_draw(struct u_upload_mgr *upload, unsigned size,
+                struct fake_fence *fence, struct pipe_resource **hold)
+{
+   struct pipe_resource *resource = NULL;
+   struct upload result;
+   void *ptr;
+
+   u_upload_alloc(upload, 0, size, 4, &result.offset, &resource, &ptr);
+   t_assert(resource && ptr);
+
+   result.buffer_id = fake_buffer(resource)->id;
+   result.width0 = resource->width0;
+   fence->signalled = false;
+   fake_buffer(resource)->fence = fence;
+
+   if (hold)
+      *hold = resource;
+   else
+      pipe_resource_reference(&resource, NULL);
+   return result;
+}
+
+static void
+check_stats(struct u_upload_mgr *upload, unsigned allocated,
+            unsigned recycled)
+{
+   struct u_upload_stats stats;
+
+   u_upload_get_stats(upload, &stats);
+   t_assert(stats.num_buffers_allocated == allocated);
+   t_assert(stats.num_buffers_recycled == recycled);
+}
+
+static struct u_upload_mgr *
+create_upload(bool recycle, unsigned max_size)
+{
+   struct u_upload_mgr *upload =
+      u_upload_create(&context, BUFFER_SIZE, PIPE_BIND_VERTEX_BUFFER,
+                      PIPE_USAGE_STREAM, 0);
+   t_assert(upload);
+
+   if (recycle)
+      u_upload_enable_recycling(upload, max_size);
+   return upload;
+}
+
+static void
+test_reuse_after_fence(void)
+{
+   struct u_upload_mgr *upload = create_upload(true, 4 * BUFFER_SIZE);
+   struct fake_fence fence_a, fence_b;
+   struct upload a, b, c;
+
+   /* Fill the first buffer, and keep it busy. */
+   a = upload_for_draw(upload, BUFFER_SIZE, &fence_a, NULL);
+   t_assert(a.offset == 0 && a.width0 == BUFFER_SIZE);
+
+   /* Its fence hasn't signalled, so it can't be reused: a new, larger
+    * buffer is allocated instead.
+    */
+   b = upload_for_draw(upload, BUFFER_SIZE, &fence_b, NULL);
+   t_assert(b.buffer_id != a.buffer_id);
+   t_assert(b.offset == 0 && b.width0 == 2 * BUFFER_SIZE);
+   check_stats(upload, 2, 0);
+
+   /* Fill up the rest of the second buffer. */
+   c = upload_for_draw(upload, BUFFER_SIZE, &fence_b, NULL);
+   t_assert(c.buffer_id == b.buffer_id && c.offset == BUFFER_SIZE);
+
+   /* Once the draws reading it are done, it is reused from the start. */
+   fence_b.signalled = true;
+   c = upload_for_draw(upload, BUFFER_SIZE, &fence_b, NULL);
+   t_assert(c.buffer_id == b.buffer_id && c.offset == 0);
+   check_stats(upload, 2, 1);
+
+   u_upload_destroy(upload);
+}
+
+static void
+test_no_reuse_while_referenced(void)
+{
+   struct u_upload_mgr *upload = create_upload(true, 4 * BUFFER_SIZE);
+   struct pipe_resource *held = NULL;
+   struct fake_fence fence;
+   struct upload a, b;
+
+   /* The buffer is idle, but its contents haven't been consumed yet. */
+   a = upload_for_draw(upload, BUFFER_SIZE, &fence, &held);
+   fence.signalled = true;
+
+   b = upload_for_draw(upload, 16, &fence, NULL);
+   t_assert(b.buffer_id != a.buffer_id);
+   check_stats(upload, 2, 0);
+
+   pipe_resource_reference(&held, NULL);
+   u_upload_destroy(upload);
+}
+
+static void
+test_growth_limit(void)
+{
+   struct u_upload_mgr *upload = create_upload(true, 3 * BUFFER_SIZE);
+   struct fake_fence fences[4];
+   const unsigned expected_sizes[] = {
+      BUFFER_SIZE, 2 * BUFFER_SIZE, 3 * BUFFER_SIZE, 3 * BUFFER_SIZE,
+   };
+
+   /* Nothing ever retires, so every full buffer is replaced by one that is
+    * twice as big, up to the limit.
+    */
+   for (unsigned i = 0; i < ARRAY_SIZE(expected_sizes); i++) {
+      struct upload u = upload_for_draw(upload, expected_sizes[i],
+                                        &fences[i], NULL);
+      t_assert(u.offset == 0 && u.width0 == expected_sizes[i]);
+   }
+   check_stats(upload, 4, 0);
+
+   u_upload_destroy(upload);
+}
+
+static void
+test_no_recycling(void)
+{
+   struct u_upload_mgr *upload = create_upload(false, 0);
+   struct fake_fence fence;
+   struct upload a, b;
+
+   /* Without recycling, even an idle buffer is replaced. */
+   a = upload_for_draw(upload, BUFFER_SIZE, &fence, NULL);
+   fence.signalled = true;
+   b = upload_for_draw(upload, BUFFER_SIZE, &fence, NULL);
+   t_assert(b.buffer_id != a.buffer_id && b.width0 == BUFFER_SIZE);
+   check_stats(upload, 2, 0);
+
+   u_upload_destroy(upload);
+}
+
+int
+main(int argc, char **argv)
+{
+   test_reuse_after_fence();
+   test_no_reuse_while_referenced();
+   test_growth_limit();
+   test_no_recycling();
+
+   printf("Success!\n");
+   return 0;
+}
@@ -28,6 +28,9 @@
 #include "blorp_priv.h"
 #include "compiler/brw_compiler.h"
 #include "compiler/brw_nir.h"
+#include "util/blob.h"
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
 
 void
 blorp_init(struct blorp_context *blorp, void *driver_ctx,
@@ -35,6 +38,7 @@ blorp_init(struct blorp_context *blorp, void *driver_ctx,
 {
    blorp->driver_ctx = driver_ctx;
    blorp->isl_dev = isl_dev;
+   blorp->disk_cache = NULL;
 }
 
 void
@@ -51,14 +55,129 @@ blorp_batch_init(struct blorp_context *blorp,
    batch->blorp = blorp;
    batch->driver_batch = driver_batch;
    batch->flags = flags;
+   batch->rect_batch = NULL;
 }
 
 void
 blorp_batch_finish(struct blorp_batch *batch)
 {
+   assert(batch->rect_batch == NULL);
    batch->blorp = NULL;
 }
 
+/**
+ * Starts collecting the rectangles passed to blorp_batch_exec() into
+ * rect_batch, until blorp_rect_batch_end().
+ */
+void
+blorp_rect_batch_begin(struct blorp_batch *batch,
+                       struct blorp_rect_batch *rect_batch)
+{
+   assert(batch->rect_batch == NULL);
+   rect_batch->num_rects = 0;
+   batch->rect_batch = rect_batch;
+}
+
+static void
+blorp_rect_batch_flush(struct blorp_batch *batch)
+{
+   struct blorp_rect_batch *rb = batch->rect_batch;
+
+   if (rb->num_rects == 0)
+      return;
+
+   struct blorp_params params = rb->params;
+   const struct blorp_batch_rect *first = &rb->rects[0];
+
+   params.x0 = first->x0;
+   params.y0 = first->y0;
+   params.x1 = first->x1;
+   params.y1 = first->y1;
+   params.wm_inputs = first->wm_inputs;
+
+   if (rb->num_rects > 1) {
+      for (uint32_t i = 1; i < rb->num_rects; i++) {
+         params.x0 = MIN2(params.x0, rb->rects[i].x0);
+         params.y0 = MIN2(params.y0, rb->rects[i].y0);
+         params.x1 = MAX2(params.x1, rb->rects[i].x1);
+         params.y1 = MAX2(params.y1, rb->rects[i].y1);
+      }
+      params.num_rects = rb->num_rects;
+      params.rects = rb->rects;
+   }
+
+   /* Straight to the driver: going through blorp_batch_exec() would queue
+    * a lone rectangle again.
+    */
+   rb->num_rects = 0;
+   batch->blorp->exec(batch, &params);
+}
+
+void
+blorp_rect_batch_end(struct blorp_batch *batch)
+{
+   blorp_rect_batch_flush(batch);
+   batch->rect_batch = NULL;
+}
+
+/* Only plain draws can share a primitive.  HiZ ops and fast clears have
+ * requirements on the rectangle, and an indirect clear color is copied into
+ * the vertex data.
+ */
+static bool
+blorp_params_can_batch(const struct blorp_params *params)
+{
+   return params->hiz_op == ISL_AUX_OP_NONE &&
+          params->fast_clear_op == ISL_AUX_OP_NONE &&
+          !params->dst_clear_color_as_input &&
+          params->num_rects == 0;
+}
+
+/**
+ * Draws the given params, or queues them up to be drawn with the rectangles
+ * of other params which only differ in their geometry and WM inputs if a
+ * rect batch is active.
+ */
+void
+blorp_batch_exec(struct blorp_batch *batch, const struct blorp_params *params)
+{
+   struct blorp_rect_batch *rb = batch->rect_batch;
+
+   if (rb == NULL) {
+      batch->blorp->exec(batch, params);
+      return;
+   }
+
+   if (!blorp_params_can_batch(params)) {
+      blorp_rect_batch_flush(batch);
+      batch->blorp->exec(batch, params);
+      return;
+   }
+
+   /* The params were all set up from a blorp_params_init()ed struct, so
+    * they can be compared as a whole once the per-rectangle fields are
+    * cleared.
+    */
+   struct blorp_params state = *params;
+   state.x0 = state.y0 = state.x1 = state.y1 = 0;
+   memset(&state.wm_inputs, 0, sizeof(state.wm_inputs));
+
+   if (rb->num_rects == BLORP_MAX_BATCH_RECTS ||
+       (rb->num_rects > 0 && memcmp(&rb->params, &state, sizeof(state)) != 0))
+      blorp_rect_batch_flush(batch);
+
+   if (rb->num_rects == 0)
+      memcpy(&rb->params, &state, sizeof(state));
+
+   rb->rects[rb->num_rects++] = (struct blorp_batch_rect) {
+      .x0 = params->x0,
+      .y0 = params->y0,
+      .x1 = params->x1,
+      .y1 = params->y1,
+      .wm_inputs = params->wm_inputs,
+   };
+}
+
 void
 brw_blorp_surface_info_init(struct blorp_context *blorp,
                             struct brw_blorp_surface_info *info,
@@ -238,6 +357,125 @@ blorp_compile_vs(struct blorp_context *blorp, void *mem_ctx,
    return program;
 }
 
+/* The driver's cache may well be shared with its own shaders, so keep blorp
+ * entries apart by hashing the key along with a prefix.
+ */
+static void
+blorp_disk_cache_compute_key(struct disk_cache *cache,
+                             const void *key, uint32_t key_size,
+                             cache_key cache_key)
+{
+   struct mesa_sha1 ctx;
+   unsigned char sha1[20];
+
+   _mesa_sha1_init(&ctx);
+   _mesa_sha1_update(&ctx, "blorp", 5);
+   _mesa_sha1_update(&ctx, key, key_size);
+   _mesa_sha1_final(&ctx, sha1);
+
+   disk_cache_compute_key(cache, sha1, sizeof(sha1), cache_key);
+}
+
+/**
+ * Wraps blorp_context::lookup_shader, falling back to the disk cache.  A
+ * shader found there is handed to upload_shader like a freshly compiled one.
+ */
+bool
+blorp_lookup_shader(struct blorp_batch *batch,
+                    const void *key, uint32_t key_size,
+                    uint32_t *kernel_out, void *prog_data_out)
+{
+   struct blorp_context *blorp = batch->blorp;
+
+   if (blorp->lookup_shader(batch, key, key_size, kernel_out, prog_data_out))
+      return true;
+
+   if (blorp->disk_cache == NULL)
+      return false;
+
+   cache_key cache_key;
+   blorp_disk_cache_compute_key(blorp->disk_cache, key, key_size, cache_key);
+
+   size_t size;
+   void *buffer = disk_cache_get(blorp->disk_cache, cache_key, &size);
+   if (buffer == NULL)
+      return false;
+
+   struct blob_reader blob;
+   blob_reader_init(&blob, buffer, size);
+   const uint32_t prog_data_size = blob_read_uint32(&blob);
+   const uint32_t kernel_size = blob_read_uint32(&blob);
+   const void *prog_data = blob_read_bytes(&blob, prog_data_size);
+   const void *kernel = blob_read_bytes(&blob, kernel_size);
+
+   bool result = !blob.overrun &&
+      blorp->upload_shader(batch, key, key_size, kernel, kernel_size,
+                           prog_data, prog_data_size,
+                           kernel_out, prog_data_out);
+
+   free(buffer);
+
+   return result;
+}
+
+/**
+ * Wraps blorp_context::upload_shader, also storing the shader in the disk
+ * cache.
+ */
+bool
+blorp_upload_shader(struct blorp_batch *batch,
+                    const void *key, uint32_t key_size,
+                    const void *kernel, uint32_t kernel_size,
+                    const struct brw_stage_prog_data *prog_data,
+                    uint32_t prog_data_size,
+                    uint32_t *kernel_out, void *prog_data_out)
+{
+   struct blorp_context *blorp = batch->blorp;
+
+   if (!blorp->upload_shader(batch, key, key_size, kernel, kernel_size,
+                             prog_data, prog_data_size,
+                             kernel_out, prog_data_out))
+      return false;
+
+   if (blorp->disk_cache == NULL)
+      return true;
+
+   /* All blorp keys start with the shader type.  Apart from the gen4 SF
+    * program, the prog data is a brw_stage_prog_data, whose param arrays
+    * can't be stored.  Blorp shaders don't have any though.
+    */
+   const enum blorp_shader_type shader_type =
+      *(const enum blorp_shader_type *)key;
+   struct brw_stage_prog_data *stored_prog_data = malloc(prog_data_size);
+   if (stored_prog_data == NULL)
+      return true;
+
+   memcpy(stored_prog_data, prog_data, prog_data_size);
+   if (shader_type != BLORP_SHADER_TYPE_GEN4_SF) {
+      assert(prog_data->nr_params == 0 && prog_data->nr_pull_params == 0);
+      stored_prog_data->param = NULL;
+      stored_prog_data->pull_param = NULL;
+   }
+
+   cache_key cache_key;
+   blorp_disk_cache_compute_key(blorp->disk_cache, key, key_size, cache_key);
+
+   struct blob blob;
+   blob_init(&blob);
+   blob_write_uint32(&blob, prog_data_size);
+   blob_write_uint32(&blob, kernel_size);
+   blob_write_bytes(&blob, stored_prog_data, prog_data_size);
+   blob_write_bytes(&blob, kernel, kernel_size);
+
+   if (!blob.out_of_memory)
+      disk_cache_put(blorp->disk_cache, cache_key, blob.data, blob.size, NULL);
+
+   blob_finish(&blob);
+   free(stored_prog_data);
+
+   return true;
+}
+
 struct blorp_sf_key {
    enum blorp_shader_type shader_type; /* Must be BLORP_SHADER_TYPE_GEN4_SF */
 
@@ -275,8 +513,8 @@ blorp_ensure_sf_program(struct blorp_batch *batch,
    memcpy(key.key.interp_mode, wm_prog_data->interp_mode,
           sizeof(key.key.interp_mode));
 
-   if (blorp->lookup_shader(batch, &key, sizeof(key),
-                            &params->sf_prog_kernel, &params->sf_prog_data))
+   if (blorp_lookup_shader(batch, &key, sizeof(key),
+                           &params->sf_prog_kernel, &params->sf_prog_data))
       return true;
 
    void *mem_ctx = ralloc_context(NULL);
@@ -292,9 +530,9 @@ blorp_ensure_sf_program(struct blorp_batch *batch,
                             &prog_data_tmp, &vue_map, &program_size);
 
    bool result =
-      blorp->upload_shader(batch, &key, sizeof(key), program, program_size,
-                           (void *)&prog_data_tmp, sizeof(prog_data_tmp),
-                           &params->sf_prog_kernel, &params->sf_prog_data);
+      blorp_upload_shader(batch, &key, sizeof(key), program, program_size,
+                          (void *)&prog_data_tmp, sizeof(prog_data_tmp),
+                          &params->sf_prog_kernel, &params->sf_prog_data);
 
    ralloc_free(mem_ctx);
 
@@ -363,7 +601,7 @@ blorp_hiz_op(struct blorp_batch *batch, struct blorp_surf *surf,
          isl_format_get_depth_format(surf->surf->format, false);
       params.num_samples = params.depth.surf.samples;
 
-      batch->blorp->exec(batch, &params);
+      blorp_batch_exec(batch, &params);
    }
 }
 
@@ -393,6 +631,6 @@ blorp_hiz_stencil_op(struct blorp_batch *batch, struct blorp_surf *stencil,
          params.dst.view = params.stencil.view;
          params.num_samples = params.stencil.surf.samples;
 
-         batch->blorp->exec(batch, &params);
+         blorp_batch_exec(batch, &params);
    }
 }
@@ -30,6 +30,7 @@
 #include "isl/isl.h"
 
 struct brw_stage_prog_data;
+struct disk_cache;
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,6 +38,7 @@ extern "C" {
 
 struct blorp_batch;
 struct blorp_params;
+struct blorp_rect_batch;
 
 struct blorp_context {
    void *driver_ctx;
@@ -55,6 +57,13 @@ struct blorp_context {
                          uint32_t prog_data_size,
                          uint32_t *kernel_out, void *prog_data_out);
    void (*exec)(struct blorp_batch *batch, const struct blorp_params *params);
+
+   /**
+    * Optional cache where shaders compiled by blorp are stored, and looked
+    * up when lookup_shader() misses, so that they persist across runs.  It
+    * must only be shared with devices which produce the same binaries.
+    */
+   struct disk_cache *disk_cache;
 };
 
 void blorp_init(struct blorp_context *blorp, void *driver_ctx,
@@ -83,6 +92,9 @@ struct blorp_batch {
    struct blorp_context *blorp;
    void *driver_batch;
    enum blorp_batch_flags flags;
+
+   /* Rectangles waiting to be drawn together, see blorp_copy_rects() */
+   struct blorp_rect_batch *rect_batch;
 };
 
 void blorp_batch_init(struct blorp_context *blorp, struct blorp_batch *batch,
@@ -154,6 +166,24 @@ blorp_copy(struct blorp_batch *batch,
            uint32_t dst_x, uint32_t dst_y,
            uint32_t src_width, uint32_t src_height);
 
+struct blorp_copy_rect {
+   uint32_t src_x, src_y;
+   uint32_t dst_x, dst_y;
+   uint32_t width, height;
+};
+
+/**
+ * Same as calling blorp_copy() for each of the rectangles, except that the
+ * copies which share all of their state are done with a single primitive.
+ */
+void
+blorp_copy_rects(struct blorp_batch *batch,
+                 const struct blorp_surf *src_surf,
+                 unsigned src_level, unsigned src_layer,
+                 const struct blorp_surf *dst_surf,
+                 unsigned dst_level, unsigned dst_layer,
+                 const struct blorp_copy_rect *rects, uint32_t num_rects);
+
 void
 blorp_buffer_copy(struct blorp_batch *batch,
                   struct blorp_address src,
@@ -178,6 +208,11 @@ blorp_clear(struct blorp_batch *batch,
             union isl_color_value clear_color,
             const bool color_write_disable[4]);
 
+struct blorp_rect {
+   uint32_t x0, y0;
+   uint32_t x1, y1;
+};
+
 void
 blorp_clear_depth_stencil(struct blorp_batch *batch,
                           const struct blorp_surf *depth,
@@ -223,6 +258,29 @@ blorp_clear_attachments(struct blorp_batch *batch,
                         bool clear_depth, float depth_value,
                         uint8_t stencil_mask, uint8_t stencil_value);
 
+struct blorp_layered_rect {
+   struct blorp_rect rect;
+   uint32_t start_layer;
+   uint32_t num_layers;
+};
+
+/**
+ * Same as calling blorp_clear_attachments() for each of the rectangles,
+ * except that consecutive rectangles with the same layers are cleared with a
+ * single primitive.
+ */
+void
+blorp_clear_attachments_rects(struct blorp_batch *batch,
+                              uint32_t binding_table_offset,
+                              enum isl_format depth_format,
+                              uint32_t num_samples,
+                              const struct blorp_layered_rect *rects,
+                              uint32_t num_rects,
+                              bool clear_color,
+                              union isl_color_value color_value,
+                              bool clear_depth, float depth_value,
+                              uint8_t stencil_mask, uint8_t stencil_value);
+
 void
 blorp_ccs_resolve(struct blorp_batch *batch,
                   struct blorp_surf *surf, uint32_t level,
@@ -1475,8 +1475,8 @@ brw_blorp_get_blit_kernel(struct blorp_batch *batch,
 {
    struct blorp_context *blorp = batch->blorp;
 
-   if (blorp->lookup_shader(batch, prog_key, sizeof(*prog_key),
-                            &params->wm_prog_kernel, &params->wm_prog_data))
+   if (blorp_lookup_shader(batch, prog_key, sizeof(*prog_key),
+                           &params->wm_prog_kernel, &params->wm_prog_data))
       return true;
 
    void *mem_ctx = ralloc_context(NULL);
@@ -1498,10 +1498,10 @@ brw_blorp_get_blit_kernel(struct blorp_batch *batch,
                               &prog_data);
 
    bool result =
-      blorp->upload_shader(batch, prog_key, sizeof(*prog_key),
-                           program, prog_data.base.program_size,
-                           &prog_data.base, sizeof(prog_data),
-                           &params->wm_prog_kernel, &params->wm_prog_data);
+      blorp_upload_shader(batch, prog_key, sizeof(*prog_key),
+                          program, prog_data.base.program_size,
+                          &prog_data.base, sizeof(prog_data),
+                          &params->wm_prog_kernel, &params->wm_prog_data);
 
    ralloc_free(mem_ctx);
    return result;
@@ -2099,7 +2099,7 @@ try_blorp_blit(struct blorp_batch *batch,
       result |= BLIT_HEIGHT_SHRINK;
 
    if (result == 0) {
-      batch->blorp->exec(batch, params);
+      blorp_batch_exec(batch, params);
    }
 
    return result;
@@ -2723,6 +2723,28 @@ blorp_copy(struct blorp_batch *batch,
    do_blorp_blit(batch, &params, &wm_prog_key, &coords);
 }
 
+void
+blorp_copy_rects(struct blorp_batch *batch,
+                 const struct blorp_surf *src_surf,
+                 unsigned src_level, unsigned src_layer,
+                 const struct blorp_surf *dst_surf,
+                 unsigned dst_level, unsigned dst_layer,
+                 const struct blorp_copy_rect *rects, uint32_t num_rects)
+{
+   struct blorp_rect_batch rect_batch;
+   blorp_rect_batch_begin(batch, &rect_batch);
+
+   for (uint32_t i = 0; i < num_rects; i++) {
+      blorp_copy(batch, src_surf, src_level, src_layer,
+                 dst_surf, dst_level, dst_layer,
+                 rects[i].src_x, rects[i].src_y,
+                 rects[i].dst_x, rects[i].dst_y,
+                 rects[i].width, rects[i].height);
+   }
+
+   blorp_rect_batch_end(batch);
+}
+
 static enum isl_format
 isl_format_for_size(unsigned size_B)
 {
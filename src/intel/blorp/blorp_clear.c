@@ -57,8 +57,8 @@ blorp_params_get_clear_kernel(struct blorp_batch *batch,
       .clear_rgb_as_red = clear_rgb_as_red,
    };
 
-   if (blorp->lookup_shader(batch, &blorp_key, sizeof(blorp_key),
-                            &params->wm_prog_kernel, &params->wm_prog_data))
+   if (blorp_lookup_shader(batch, &blorp_key, sizeof(blorp_key),
+                           &params->wm_prog_kernel, &params->wm_prog_data))
       return true;
 
    void *mem_ctx = ralloc_context(NULL);
@@ -100,10 +100,10 @@ blorp_params_get_clear_kernel(struct blorp_batch *batch,
                        &prog_data);
 
    bool result =
-      blorp->upload_shader(batch, &blorp_key, sizeof(blorp_key),
-                           program, prog_data.base.program_size,
-                           &prog_data.base, sizeof(prog_data),
-                           &params->wm_prog_kernel, &params->wm_prog_data);
+      blorp_upload_shader(batch, &blorp_key, sizeof(blorp_key),
+                          program, prog_data.base.program_size,
+                          &prog_data.base, sizeof(prog_data),
+                          &params->wm_prog_kernel, &params->wm_prog_data);
 
    ralloc_free(mem_ctx);
    return result;
@@ -135,8 +135,8 @@ blorp_params_get_layer_offset_vs(struct blorp_batch *batch,
    if (params->wm_prog_data)
       blorp_key.num_inputs = params->wm_prog_data->num_varying_inputs;
 
-   if (blorp->lookup_shader(batch, &blorp_key, sizeof(blorp_key),
-                            &params->vs_prog_kernel, &params->vs_prog_data))
+   if (blorp_lookup_shader(batch, &blorp_key, sizeof(blorp_key),
+                           &params->vs_prog_kernel, &params->vs_prog_data))
       return true;
 
    void *mem_ctx = ralloc_context(NULL);
@@ -192,10 +192,10 @@ blorp_params_get_layer_offset_vs(struct blorp_batch *batch,
       blorp_compile_vs(blorp, mem_ctx, b.shader, &vs_prog_data);
 
    bool result =
-      blorp->upload_shader(batch, &blorp_key, sizeof(blorp_key),
-                           program, vs_prog_data.base.base.program_size,
-                           &vs_prog_data.base.base, sizeof(vs_prog_data),
-                           &params->vs_prog_kernel, &params->vs_prog_data);
+      blorp_upload_shader(batch, &blorp_key, sizeof(blorp_key),
+                          program, vs_prog_data.base.base.program_size,
+                          &vs_prog_data.base.base, sizeof(vs_prog_data),
+                          &params->vs_prog_kernel, &params->vs_prog_data);
 
    ralloc_free(mem_ctx);
    return result;
@@ -358,7 +358,7 @@ blorp_fast_clear(struct blorp_batch *batch,
                                start_layer, format, true);
    params.num_samples = params.dst.surf.samples;
 
-   batch->blorp->exec(batch, &params);
+   blorp_batch_exec(batch, &params);
 }
 
 union isl_color_value
@@ -554,10 +554,10 @@ blorp_clear(struct blorp_batch *batch,
             params.x0 = 0;
             params.x1 = MIN2(orig_x1 - x, max_image_width);
 
-            batch->blorp->exec(batch, &params);
+            blorp_batch_exec(batch, &params);
          }
       } else {
-         batch->blorp->exec(batch, &params);
+         blorp_batch_exec(batch, &params);
       }
 
       start_layer += params.num_layers;
@@ -660,7 +660,7 @@ blorp_clear_stencil_as_rgba(struct blorp_batch *batch,
       params.x1 = params.dst.tile_x_sa + x1 / (wide_Bpp / 2);
       params.y1 = params.dst.tile_y_sa + y1 / 2;
 
-      batch->blorp->exec(batch, &params);
+      blorp_batch_exec(batch, &params);
    }
 
    return true;
@@ -749,7 +749,7 @@ blorp_clear_depth_stencil(struct blorp_batch *batch,
             params.num_layers = params.depth.view.array_len;
       }
 
-      batch->blorp->exec(batch, &params);
+      blorp_batch_exec(batch, &params);
 
       start_layer += params.num_layers;
       num_layers -= params.num_layers;
@@ -906,7 +906,7 @@ blorp_hiz_clear_depth_stencil(struct blorp_batch *batch,
          params.num_samples = params.depth.surf.samples;
       }
 
-      batch->blorp->exec(batch, &params);
+      blorp_batch_exec(batch, &params);
    }
 }
 
@@ -937,7 +937,7 @@ blorp_gen8_hiz_clear_attachments(struct blorp_batch *batch,
    params.depth.enabled = clear_depth;
    params.stencil.enabled = clear_stencil;
    params.stencil_ref = stencil_value;
-   batch->blorp->exec(batch, &params);
+   blorp_batch_exec(batch, &params);
 }
 
 /** Clear active color/depth/stencili attachments
@@ -1010,7 +1010,36 @@ blorp_clear_attachments(struct blorp_batch *batch,
 
    params.vs_inputs.base_layer = start_layer;
 
-   batch->blorp->exec(batch, &params);
+   blorp_batch_exec(batch, &params);
+}
+
+void
+blorp_clear_attachments_rects(struct blorp_batch *batch,
+                              uint32_t binding_table_offset,
+                              enum isl_format depth_format,
+                              uint32_t num_samples,
+                              const struct blorp_layered_rect *rects,
+                              uint32_t num_rects,
+                              bool clear_color,
+                              union isl_color_value color_value,
+                              bool clear_depth, float depth_value,
+                              uint8_t stencil_mask, uint8_t stencil_value)
+{
+   struct blorp_rect_batch rect_batch;
+   blorp_rect_batch_begin(batch, &rect_batch);
+
+   for (uint32_t i = 0; i < num_rects; i++) {
+      const struct blorp_rect *rect = &rects[i].rect;
+      blorp_clear_attachments(batch, binding_table_offset, depth_format,
+                              num_samples,
+                              rects[i].start_layer, rects[i].num_layers,
+                              rect->x0, rect->y0, rect->x1, rect->y1,
+                              clear_color, color_value,
+                              clear_depth, depth_value,
+                              stencil_mask, stencil_value);
+   }
+
+   blorp_rect_batch_end(batch);
 }
 
 void
@@ -1082,7 +1111,7 @@ blorp_ccs_resolve(struct blorp_batch *batch,
    if (!blorp_params_get_clear_kernel(batch, &params, true, false))
       return;
 
-   batch->blorp->exec(batch, &params);
+   blorp_batch_exec(batch, &params);
 }
 
 static nir_ssa_def *
@@ -1114,8 +1143,8 @@ blorp_params_get_mcs_partial_resolve_kernel(struct blorp_batch *batch,
       .num_samples = params->num_samples,
    };
 
-   if (blorp->lookup_shader(batch, &blorp_key, sizeof(blorp_key),
-                            &params->wm_prog_kernel, &params->wm_prog_data))
+   if (blorp_lookup_shader(batch, &blorp_key, sizeof(blorp_key),
+                           &params->wm_prog_kernel, &params->wm_prog_data))
       return true;
 
    void *mem_ctx = ralloc_context(NULL);
@@ -1170,10 +1199,10 @@ blorp_params_get_mcs_partial_resolve_kernel(struct blorp_batch *batch,
                        &prog_data);
 
    bool result =
-      blorp->upload_shader(batch, &blorp_key, sizeof(blorp_key),
-                           program, prog_data.base.program_size,
-                           &prog_data.base, sizeof(prog_data),
-                           &params->wm_prog_kernel, &params->wm_prog_data);
+      blorp_upload_shader(batch, &blorp_key, sizeof(blorp_key),
+                          program, prog_data.base.program_size,
+                          &prog_data.base, sizeof(prog_data),
+                          &params->wm_prog_kernel, &params->wm_prog_data);
 
    ralloc_free(mem_ctx);
    return result;
@@ -1210,7 +1239,7 @@ blorp_mcs_partial_resolve(struct blorp_batch *batch,
    if (!blorp_params_get_mcs_partial_resolve_kernel(batch, &params))
       return;
 
-   batch->blorp->exec(batch, &params);
+   blorp_batch_exec(batch, &params);
 }
 
 /** Clear a CCS to the "uncompressed" state
@@ -1369,5 +1398,5 @@ blorp_ccs_ambiguate(struct blorp_batch *batch,
    if (!blorp_params_get_clear_kernel(batch, &params, true, false))
       return;
 
-   batch->blorp->exec(batch, &params);
+   blorp_batch_exec(batch, &params);
 }
@@ -224,6 +224,23 @@ blorp_emit_vertex_data(struct blorp_batch *batch,
                        struct blorp_address *addr,
                        uint32_t *size)
 {
+   if (params->num_rects > 0) {
+      *size = params->num_rects * 9 * sizeof(float);
+      float *vertices = blorp_alloc_vertex_buffer(batch, *size, addr);
+
+      for (uint32_t i = 0; i < params->num_rects; i++) {
+         const struct blorp_batch_rect *rect = &params->rects[i];
+         float *v = vertices + i * 9;
+
+         v[0] = rect->x1; v[1] = rect->y1; v[2] = params->z;
+         v[3] = rect->x0; v[4] = rect->y1; v[5] = params->z;
+         v[6] = rect->x0; v[7] = rect->y0; v[8] = params->z;
+      }
+
+      blorp_flush_range(batch, vertices, *size);
+      return;
+   }
+
    const float vertices[] = {
       /* v0 */ (float)params->x1, (float)params->y1, params->z,
       /* v1 */ (float)params->x0, (float)params->y1, params->z,
@@ -236,23 +253,15 @@ blorp_emit_vertex_data(struct blorp_batch *batch,
    blorp_flush_range(batch, data, *size);
 }
 
-static void
-blorp_emit_input_varying_data(struct blorp_batch *batch,
-                              const struct blorp_params *params,
-                              struct blorp_address *addr,
-                              uint32_t *size)
+static uint32_t *
+blorp_copy_input_varying_data(const struct blorp_params *params,
+                              const struct brw_blorp_wm_inputs *wm_inputs,
+                              uint32_t *inputs)
 {
    const unsigned vec4_size_in_bytes = 4 * sizeof(float);
    const unsigned max_num_varyings =
-      DIV_ROUND_UP(sizeof(params->wm_inputs), vec4_size_in_bytes);
-   const unsigned num_varyings =
-      params->wm_prog_data ? params->wm_prog_data->num_varying_inputs : 0;
-
-   *size = 16 + num_varyings * vec4_size_in_bytes;
-
-   const uint32_t *const inputs_src = (const uint32_t *)&params->wm_inputs;
-   void *data = blorp_alloc_vertex_buffer(batch, *size, addr);
-   uint32_t *inputs = data;
+      DIV_ROUND_UP(sizeof(*wm_inputs), vec4_size_in_bytes);
+   const uint32_t *const inputs_src = (const uint32_t *)wm_inputs;
 
    /* Copy in the VS inputs */
    assert(sizeof(params->vs_inputs) == 16);
@@ -277,6 +286,50 @@ blorp_emit_input_varying_data(struct blorp_batch *batch,
       }
    }
 
+   return inputs;
+}
+
+/* The inputs are constant across the primitive, so they are normally read
+ * with a stride of 0.  When the primitive is made of several rectangles,
+ * each of their vertices gets a copy of the inputs of its rectangle.
+ */
+static void
+blorp_emit_input_varying_data(struct blorp_batch *batch,
+                              const struct blorp_params *params,
+                              struct blorp_address *addr,
+                              uint32_t *size, uint32_t *stride)
+{
+   const unsigned vec4_size_in_bytes = 4 * sizeof(float);
+   const unsigned num_varyings =
+      params->wm_prog_data ? params->wm_prog_data->num_varying_inputs : 0;
+   const uint32_t vertex_size = 16 + num_varyings * vec4_size_in_bytes;
+
+   if (params->num_rects > 0) {
+      *size = params->num_rects * 3 * vertex_size;
+      *stride = vertex_size;
+
+      uint32_t *inputs = blorp_alloc_vertex_buffer(batch, *size, addr);
+      void *data = inputs;
+
+      for (uint32_t i = 0; i < params->num_rects; i++) {
+         for (unsigned v = 0; v < 3; v++) {
+            inputs = blorp_copy_input_varying_data(params,
+                                                   &params->rects[i].wm_inputs,
+                                                   inputs);
+         }
+      }
+
+      assert(!params->dst_clear_color_as_input);
+      blorp_flush_range(batch, data, *size);
+      return;
+   }
+
+   *size = vertex_size;
+   *stride = 0;
+
+   void *data = blorp_alloc_vertex_buffer(batch, *size, addr);
+   blorp_copy_input_varying_data(params, &params->wm_inputs, data);
+
    blorp_flush_range(batch, data, *size);
 
    if (params->dst_clear_color_as_input) {
@@ -345,13 +398,15 @@ blorp_emit_vertex_buffers(struct blorp_batch *batch,
    memset(vb, 0, sizeof(vb));
 
    struct blorp_address addrs[2] = {};
-   uint32_t sizes[2];
+   uint32_t sizes[2], input_stride;
    blorp_emit_vertex_data(batch, params, &addrs[0], &sizes[0]);
    blorp_fill_vertex_buffer_state(batch, vb, 0, addrs[0], sizes[0],
                                   3 * sizeof(float));
 
-   blorp_emit_input_varying_data(batch, params, &addrs[1], &sizes[1]);
-   blorp_fill_vertex_buffer_state(batch, vb, 1, addrs[1], sizes[1], 0);
+   blorp_emit_input_varying_data(batch, params, &addrs[1], &sizes[1],
+                                 &input_stride);
+   blorp_fill_vertex_buffer_state(batch, vb, 1, addrs[1], sizes[1],
+                                  input_stride);
 
    blorp_vf_invalidate_for_vb_48b_transitions(batch, addrs, sizes, num_vbs);
 
@@ -1931,7 +1986,7 @@ blorp_exec(struct blorp_batch *batch, const struct blorp_params *params)
 #if GEN_GEN >= 7
       prim.PredicateEnable = batch->flags & BLORP_BATCH_PREDICATE_ENABLE;
 #endif
-      prim.VertexCountPerInstance = 3;
+      prim.VertexCountPerInstance = 3 * MAX2(params->num_rects, 1);
       prim.InstanceCount = params->num_layers;
    }
 }
@@ -185,6 +185,19 @@ brw_blorp_get_urb_length(const struct brw_wm_prog_data *prog_data)
    return MAX2((prog_data->num_varying_inputs + 1) / 2, 1);
 }
 
+/**
+ * One rectangle of a primitive made of several, along with the WM inputs
+ * which go with it.
+ */
+struct blorp_batch_rect
+{
+   uint32_t x0;
+   uint32_t y0;
+   uint32_t x1;
+   uint32_t y1;
+   struct brw_blorp_wm_inputs wm_inputs;
+};
+
 struct blorp_params
 {
    uint32_t x0;
@@ -218,10 +231,40 @@ struct blorp_params
 
    bool use_pre_baked_binding_table;
    uint32_t pre_baked_binding_table_offset;
+
+   /**
+    * If non-zero, the primitive is made of these rectangles rather than the
+    * one given by x0, y0, x1 and y1, which hold their bounding box instead.
+    * Each rectangle comes with its own WM inputs.
+    */
+   uint32_t num_rects;
+   const struct blorp_batch_rect *rects;
 };
 
 void blorp_params_init(struct blorp_params *params);
 
+/* Bounds the size of the vertex data of a single primitive */
+#define BLORP_MAX_BATCH_RECTS 32
+
+/**
+ * Rectangles which have been submitted through blorp_batch_exec() and not
+ * drawn yet.  They all share the same params, apart from their geometry and
+ * their WM inputs.
+ */
+struct blorp_rect_batch
+{
+   struct blorp_params params;
+   uint32_t num_rects;
+   struct blorp_batch_rect rects[BLORP_MAX_BATCH_RECTS];
+};
+
+void blorp_rect_batch_begin(struct blorp_batch *batch,
+                            struct blorp_rect_batch *rect_batch);
+void blorp_rect_batch_end(struct blorp_batch *batch);
+
+void blorp_batch_exec(struct blorp_batch *batch,
+                      const struct blorp_params *params);
+
 enum blorp_shader_type {
    BLORP_SHADER_TYPE_BLIT,
    BLORP_SHADER_TYPE_CLEAR,
@@ -375,6 +418,19 @@ bool
 blorp_ensure_sf_program(struct blorp_batch *batch,
                         struct blorp_params *params);
 
+bool
+blorp_lookup_shader(struct blorp_batch *batch,
+                    const void *key, uint32_t key_size,
+                    uint32_t *kernel_out, void *prog_data_out);
+
+bool
+blorp_upload_shader(struct blorp_batch *batch,
+                    const void *key, uint32_t key_size,
+                    const void *kernel, uint32_t kernel_size,
+                    const struct brw_stage_prog_data *prog_data,
+                    uint32_t prog_data_size,
+                    uint32_t *kernel_out, void *prog_data_out);
+
 /** \} */
 
 #ifdef __cplusplus
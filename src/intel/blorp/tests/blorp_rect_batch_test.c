@@ -0,0 +1,268 @@
+/*
+ * Copyright © 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "blorp/blorp_priv.h"
+
+#define t_assert(cond) \
+   do { \
+      if (!(cond)) { \
+         fprintf(stderr, "%s:%d: assertion failed: %s\n", \
+                 __FILE__, __LINE__, #cond); \
+         abort(); \
+      } \
+   } while (0)
+
+#define MAX_EXECS 8
+
+/* What blorp_context::exec was called with.  The rectangles of a batched
+ * draw live in the rect batch, which is reused right after exec returns, so
+ * they are copied out.
+ */
+static struct {
+   struct blorp_params params;
+   struct blorp_batch_rect rects[BLORP_MAX_BATCH_RECTS];
+} execs[MAX_EXECS];
+static unsigned num_execs;
+
+static void
+test_exec(struct blorp_batch *batch, const struct blorp_params *params)
+{
+   t_assert(num_execs < MAX_EXECS);
+   t_assert(params->num_rects <= BLORP_MAX_BATCH_RECTS);
+
+   execs[num_execs].params = *params;
+   if (params->num_rects > 0) {
+      memcpy(execs[num_execs].rects, params->rects,
+             params->num_rects * sizeof(params->rects[0]));
+   }
+   num_execs++;
+}
+
+static struct blorp_context blorp;
+static struct blorp_batch batch;
+
+static void
+setup(void)
+{
+   memset(&blorp, 0, sizeof(blorp));
+   blorp.exec = test_exec;
+   blorp_batch_init(&blorp, &batch, NULL, 0);
+   num_execs = 0;
+}
+
+/* A copy of rectangle i, with WM inputs telling it apart from the others */
+static struct blorp_params
+make_params(uint32_t i, uint32_t dst_level)
+{
+   struct blorp_params params;
+   blorp_params_init(&params);
+
+   params.dst.view.base_level = dst_level;
+   params.x0 = 10 * i;
+   params.y0 = 20 * i;
+   params.x1 = 10 * i + 5;
+   params.y1 = 20 * i + 7;
+   params.wm_inputs.coord_transform[0].offset = i;
+   params.wm_inputs.src_z = i;
+
+   return params;
+}
+
+static void
+check_rect(const struct blorp_batch_rect *rect, uint32_t i)
+{
+   t_assert(rect->x0 == 10 * i && rect->y0 == 20 * i);
+   t_assert(rect->x1 == 10 * i + 5 && rect->y1 == 20 * i + 7);
+   t_assert(rect->wm_inputs.coord_transform[0].offset == i);
+   t_assert(rect->wm_inputs.src_z == i);
+}
+
+static void
+test_no_batch(void)
+{
+   setup();
+
+   struct blorp_params params = make_params(1, 0);
+   blorp_batch_exec(&batch, &params);
+
+   t_assert(num_execs == 1);
+   t_assert(execs[0].params.num_rects == 0);
+   t_assert(execs[0].params.x0 == 10 && execs[0].params.x1 == 15);
+
+   blorp_batch_finish(&batch);
+}
+
+static void
+test_single_rect(void)
+{
+   setup();
+
+   struct blorp_rect_batch rect_batch;
+   blorp_rect_batch_begin(&batch, &rect_batch);
+
+   struct blorp_params params = make_params(2, 0);
+   blorp_batch_exec(&batch, &params);
+   t_assert(num_execs == 0);
+
+   blorp_rect_batch_end(&batch);
+
+   /* A lone rectangle is drawn the usual way */
+   t_assert(num_execs == 1);
+   t_assert(execs[0].params.num_rects == 0);
+   t_assert(execs[0].params.x0 == 20 && execs[0].params.y0 == 40);
+   t_assert(execs[0].params.wm_inputs.src_z == 2);
+
+   blorp_batch_finish(&batch);
+}
+
+static void
+test_multi_rect(void)
+{
+   setup();
+
+   struct blorp_rect_batch rect_batch;
+   blorp_rect_batch_begin(&batch, &rect_batch);
+
+   for (uint32_t i = 1; i <= 3; i++) {
+      struct blorp_params params = make_params(i, 0);
+      blorp_batch_exec(&batch, &params);
+   }
+   t_assert(num_execs == 0);
+
+   blorp_rect_batch_end(&batch);
+
+   t_assert(num_execs == 1);
+   const struct blorp_params *params = &execs[0].params;
+   t_assert(params->num_rects == 3);
+   for (uint32_t i = 0; i < 3; i++)
+      check_rect(&execs[0].rects[i], i + 1);
+
+   /* x0/y0/x1/y1 hold the bounding box */
+   t_assert(params->x0 == 10 && params->y0 == 20);
+   t_assert(params->x1 == 35 && params->y1 == 67);
+
+   blorp_batch_finish(&batch);
+}
+
+static void
+test_state_change(void)
+{
+   setup();
+
+   struct blorp_rect_batch rect_batch;
+   blorp_rect_batch_begin(&batch, &rect_batch);
+
+   const uint32_t levels[] = { 0, 0, 1, 0 };
+   for (uint32_t i = 0; i < ARRAY_SIZE(levels); i++) {
+      struct blorp_params params = make_params(i, levels[i]);
+      blorp_batch_exec(&batch, &params);
+   }
+
+   blorp_rect_batch_end(&batch);
+
+   t_assert(num_execs == 3);
+   t_assert(execs[0].params.num_rects == 2);
+   check_rect(&execs[0].rects[0], 0);
+   check_rect(&execs[0].rects[1], 1);
+   t_assert(execs[1].params.num_rects == 0);
+   t_assert(execs[1].params.dst.view.base_level == 1);
+   t_assert(execs[1].params.wm_inputs.src_z == 2);
+   t_assert(execs[2].params.num_rects == 0);
+   t_assert(execs[2].params.wm_inputs.src_z == 3);
+
+   blorp_batch_finish(&batch);
+}
+
+static void
+test_unbatchable(void)
+{
+   setup();
+
+   struct blorp_rect_batch rect_batch;
+   blorp_rect_batch_begin(&batch, &rect_batch);
+
+   for (uint32_t i = 0; i < 2; i++) {
+      struct blorp_params params = make_params(i, 0);
+      blorp_batch_exec(&batch, &params);
+   }
+
+   /* A fast clear is drawn right away, after what was queued before it */
+   struct blorp_params fast_clear = make_params(5, 0);
+   fast_clear.fast_clear_op = ISL_AUX_OP_FAST_CLEAR;
+   blorp_batch_exec(&batch, &fast_clear);
+
+   t_assert(num_execs == 2);
+   t_assert(execs[0].params.num_rects == 2);
+   t_assert(execs[1].params.fast_clear_op == ISL_AUX_OP_FAST_CLEAR);
+   t_assert(execs[1].params.num_rects == 0);
+
+   blorp_rect_batch_end(&batch);
+   t_assert(num_execs == 2);
+
+   blorp_batch_finish(&batch);
+}
+
+static void
+test_full_batch(void)
+{
+   setup();
+
+   struct blorp_rect_batch rect_batch;
+   blorp_rect_batch_begin(&batch, &rect_batch);
+
+   const uint32_t count = BLORP_MAX_BATCH_RECTS + 3;
+   for (uint32_t i = 0; i < count; i++) {
+      struct blorp_params params = make_params(i, 0);
+      blorp_batch_exec(&batch, &params);
+   }
+
+   blorp_rect_batch_end(&batch);
+
+   t_assert(num_execs == 2);
+   t_assert(execs[0].params.num_rects == BLORP_MAX_BATCH_RECTS);
+   t_assert(execs[1].params.num_rects == 3);
+   for (uint32_t i = 0; i < BLORP_MAX_BATCH_RECTS; i++)
+      check_rect(&execs[0].rects[i], i);
+   for (uint32_t i = 0; i < 3; i++)
+      check_rect(&execs[1].rects[i], BLORP_MAX_BATCH_RECTS + i);
+
+   blorp_batch_finish(&batch);
+}
+
+int
+main(void)
+{
+   test_no_batch();
+   test_single_rect();
+   test_multi_rect();
+   test_state_change();
+   test_unbatchable();
+   test_full_batch();
+
+   return 0;
+}
@@ -28,7 +28,6 @@
 #include <string.h>
 #include <expat.h>
 #include <inttypes.h>
-#include <zlib.h>
 
 #include <util/macros.h>
 #include <util/ralloc.h>
@@ -36,7 +35,7 @@
 #include "gen_decoder.h"
 
 #include "isl/isl.h"
-#include "genxml/genX_xml.h"
+#include "genxml/genX_spec_tables.h"
 
 #define XML_BUFFER_SIZE 4096
 #define MAX_VALUE_ITEMS 128
@@ -517,54 +516,6 @@ devinfo_to_gen(const struct gen_device_info *devinfo, bool x10)
    return x10 ? devinfo->gen * 10 : devinfo->gen;
 }
 
-static uint32_t zlib_inflate(const void *compressed_data,
-                             uint32_t compressed_len,
-                             void **out_ptr)
-{
-   struct z_stream_s zstream;
-   void *out;
-
-   memset(&zstream, 0, sizeof(zstream));
-
-   zstream.next_in = (unsigned char *)compressed_data;
-   zstream.avail_in = compressed_len;
-
-   if (inflateInit(&zstream) != Z_OK)
-      return 0;
-
-   out = malloc(4096);
-   zstream.next_out = out;
-   zstream.avail_out = 4096;
-
-   do {
-      switch (inflate(&zstream, Z_SYNC_FLUSH)) {
-      case Z_STREAM_END:
-         goto end;
-      case Z_OK:
-         break;
-      default:
-         inflateEnd(&zstream);
-         return 0;
-      }
-
-      if (zstream.avail_out)
-         break;
-
-      out = realloc(out, 2*zstream.total_out);
-      if (out == NULL) {
-         inflateEnd(&zstream);
-         return 0;
-      }
-
-      zstream.next_out = (unsigned char *)out + zstream.total_out;
-      zstream.avail_out = zstream.total_out;
-   } while (1);
- end:
-   inflateEnd(&zstream);
-   *out_ptr = out;
-   return zstream.total_out;
-}
-
 static uint32_t _hash_uint32(const void *key)
 {
    return (uint32_t) (uintptr_t) key;
@@ -594,70 +545,222 @@ gen_spec_init(void)
    return spec;
 }
 
-struct gen_spec *
-gen_spec_load(const struct gen_device_info *devinfo)
+static int
+compare_opcode_entries(const void *_a, const void *_b)
 {
-   struct parser_context ctx;
-   void *buf;
-   uint8_t *text_data = NULL;
-   uint32_t text_offset = 0, text_length = 0;
-   ASSERTED uint32_t total_length;
-   uint32_t gen_10 = devinfo_to_gen(devinfo, true);
+   const struct gen_opcode_entry *a = _a, *b = _b;
 
-   for (int i = 0; i < ARRAY_SIZE(genxml_files_table); i++) {
-      if (genxml_files_table[i].gen_10 == gen_10) {
-         text_offset = genxml_files_table[i].offset;
-         text_length = genxml_files_table[i].length;
-         break;
+   if (a->group->opcode_mask != b->group->opcode_mask)
+      return a->group->opcode_mask < b->group->opcode_mask ? -1 : 1;
+   if (a->group->opcode != b->group->opcode)
+      return a->group->opcode < b->group->opcode ? -1 : 1;
+   return a->order < b->order ? -1 : a->order > b->order;
+}
+
+/**
+ * Sorts the instructions by opcode mask and opcode, so that
+ * gen_spec_find_instruction() only does a binary search per distinct mask
+ * (there are only a few) rather than walk every instruction.
+ *
+ * Instructions with the same mask and opcode stay in the order they come out
+ * of spec->commands, so the first match is the same as with a linear walk.
+ */
+static bool
+gen_spec_build_opcode_index(struct gen_spec *spec)
+{
+   uint32_t n = _mesa_hash_table_num_entries(spec->commands);
+   struct gen_opcode_entry *entries =
+      ralloc_array(spec, struct gen_opcode_entry, n);
+   if (entries == NULL && n > 0)
+      return false;
+
+   uint32_t i = 0;
+   hash_table_foreach(spec->commands, entry) {
+      entries[i].group = entry->data;
+      entries[i].order = i;
+      i++;
+   }
+
+   qsort(entries, n, sizeof(*entries), compare_opcode_entries);
+
+   spec->opcode_entries = entries;
+   spec->n_opcode_entries = n;
+   spec->n_opcode_ranges = 0;
+   for (i = 0; i < n; i++) {
+      if (i > 0 &&
+          entries[i].group->opcode_mask == entries[i - 1].group->opcode_mask)
+         continue;
+
+      if (spec->n_opcode_ranges == ARRAY_SIZE(spec->opcode_ranges)) {
+         /* Too many different masks, look through everything. */
+         spec->n_opcode_ranges = 0;
+         return true;
       }
+      spec->opcode_ranges[spec->n_opcode_ranges].mask =
+         entries[i].group->opcode_mask;
+      spec->opcode_ranges[spec->n_opcode_ranges].start = i;
+      spec->n_opcode_ranges++;
    }
 
-   if (text_length == 0) {
-      fprintf(stderr, "unable to find gen (%u) data\n", gen_10);
+   return true;
+}
+
+static inline const char *
+genxml_string(uint32_t offset)
+{
+   return offset == GENXML_NO_STRING ? NULL : &genxml_strings[offset];
+}
+
+/**
+ * Builds a gen_spec out of the tables generated from the genxml files at
+ * build time.  This produces the same result as parsing the gen's XML with
+ * start_element()/end_element(), but only has to hook up pointers.
+ */
+static struct gen_spec *
+gen_spec_load_tables(const struct genxml_spec *tables)
+{
+   struct gen_spec *spec = gen_spec_init();
+   if (spec == NULL) {
+      fprintf(stderr, "Failed to create gen_spec\n");
       return NULL;
    }
 
-   memset(&ctx, 0, sizeof ctx);
-   ctx.parser = XML_ParserCreate(NULL);
-   XML_SetUserData(ctx.parser, &ctx);
-   if (ctx.parser == NULL) {
-      fprintf(stderr, "failed to create parser\n");
+   spec->gen = tables->gen;
+
+   struct gen_group *groups =
+      rzalloc_array(spec, struct gen_group, tables->n_groups);
+   struct gen_field *fields =
+      rzalloc_array(spec, struct gen_field, tables->n_fields);
+   struct gen_enum *enums =
+      rzalloc_array(spec, struct gen_enum, tables->n_enums);
+   struct gen_value *values =
+      ralloc_array(spec, struct gen_value, tables->n_values);
+   struct gen_value **value_ptrs =
+      ralloc_array(spec, struct gen_value *, tables->n_values);
+   if ((groups == NULL && tables->n_groups > 0) ||
+       (fields == NULL && tables->n_fields > 0) ||
+       (enums == NULL && tables->n_enums > 0) ||
+       ((values == NULL || value_ptrs == NULL) && tables->n_values > 0)) {
+      fprintf(stderr, "Failed to create gen_spec\n");
+      gen_spec_destroy(spec);
       return NULL;
    }
 
-   XML_SetElementHandler(ctx.parser, start_element, end_element);
-   XML_SetCharacterDataHandler(ctx.parser, character_data);
+   for (uint32_t i = 0; i < tables->n_values; i++) {
+      values[i].name = (char *) genxml_string(tables->values[i].name);
+      values[i].value = tables->values[i].value;
+      value_ptrs[i] = &values[i];
+   }
 
-   ctx.spec = gen_spec_init();
-   if (ctx.spec == NULL) {
-      fprintf(stderr, "Failed to create gen_spec\n");
-      return NULL;
+   for (uint32_t i = 0; i < tables->n_enums; i++) {
+      const struct genxml_enum *t = &tables->enums[i];
+      struct gen_enum *e = &enums[i];
+
+      e->name = (char *) genxml_string(t->name);
+      e->nvalues = t->n_values;
+      e->values = &value_ptrs[t->value_start];
+      _mesa_hash_table_insert(spec->enums, e->name, e);
    }
 
-   total_length = zlib_inflate(compress_genxmls,
-                               sizeof(compress_genxmls),
-                               (void **) &text_data);
-   assert(text_offset + text_length <= total_length);
+   for (uint32_t i = 0; i < tables->n_fields; i++) {
+      const struct genxml_field *t = &tables->fields[i];
+      struct gen_field *field = &fields[i];
+
+      field->name = (char *) genxml_string(t->name);
+      field->start = t->start;
+      field->end = t->end;
+      field->has_default = t->has_default;
+      field->default_value = t->default_value;
+      field->array = t->array >= 0 ? &groups[t->array] : NULL;
+      field->inline_enum.nvalues = t->n_values;
+      field->inline_enum.values = &value_ptrs[t->value_start];
+
+      field->type.kind = t->type;
+      switch (field->type.kind) {
+      case GEN_TYPE_STRUCT:
+         field->type.gen_struct = &groups[t->type_ref];
+         break;
+      case GEN_TYPE_ENUM:
+         field->type.gen_enum = &enums[t->type_ref];
+         break;
+      case GEN_TYPE_UFIXED:
+      case GEN_TYPE_SFIXED:
+         field->type.i = t->type_ref;
+         field->type.f = t->type_frac;
+         break;
+      default:
+         break;
+      }
+   }
 
-   buf = XML_GetBuffer(ctx.parser, text_length);
-   memcpy(buf, &text_data[text_offset], text_length);
+   for (uint32_t i = 0; i < tables->n_groups; i++) {
+      const struct genxml_group *t = &tables->groups[i];
+      struct gen_group *group = &groups[i];
+
+      group->spec = spec;
+      group->name = (char *) genxml_string(t->name);
+      group->parent = t->parent >= 0 ? &groups[t->parent] : NULL;
+      group->dword_length_field =
+         t->dword_length_field >= 0 ? &fields[t->dword_length_field] : NULL;
+      group->dw_length = t->dw_length;
+      group->engine_mask = t->engine_mask;
+      group->bias = t->bias;
+      group->array_offset = t->array_offset;
+      group->array_count = t->array_count;
+      group->array_item_size = t->array_item_size;
+      group->variable = t->variable;
+      group->fixed_length = t->fixed_length;
+      group->opcode_mask = t->opcode_mask;
+      group->opcode = t->opcode;
+      group->register_offset = t->register_offset;
+
+      /* A group's fields are contiguous and already in list order. */
+      if (t->n_fields > 0)
+         group->fields = &fields[t->field_start];
+      for (int f = 0; f < t->n_fields; f++) {
+         struct gen_field *field = &fields[t->field_start + f];
+         field->parent = group;
+         field->next = f + 1 < t->n_fields ? field + 1 : NULL;
+      }
 
-   if (XML_ParseBuffer(ctx.parser, text_length, true) == 0) {
-      fprintf(stderr,
-              "Error parsing XML at line %ld col %ld byte %ld/%u: %s\n",
-              XML_GetCurrentLineNumber(ctx.parser),
-              XML_GetCurrentColumnNumber(ctx.parser),
-              XML_GetCurrentByteIndex(ctx.parser), text_length,
-              XML_ErrorString(XML_GetErrorCode(ctx.parser)));
-      XML_ParserFree(ctx.parser);
-      free(text_data);
+      switch (t->kind) {
+      case GENXML_INSTRUCTION:
+         _mesa_hash_table_insert(spec->commands, group->name, group);
+         break;
+      case GENXML_STRUCT:
+         _mesa_hash_table_insert(spec->structs, group->name, group);
+         break;
+      case GENXML_REGISTER:
+         _mesa_hash_table_insert(spec->registers_by_name, group->name, group);
+         _mesa_hash_table_insert(spec->registers_by_offset,
+                                 (void *) (uintptr_t) group->register_offset,
+                                 group);
+         break;
+      default:
+         break;
+      }
+   }
+
+   if (!gen_spec_build_opcode_index(spec)) {
+      gen_spec_destroy(spec);
       return NULL;
    }
 
-   XML_ParserFree(ctx.parser);
-   free(text_data);
+   return spec;
+}
 
-   return ctx.spec;
+struct gen_spec *
+gen_spec_load(const struct gen_device_info *devinfo)
+{
+   uint32_t gen_10 = devinfo_to_gen(devinfo, true);
+
+   for (int i = 0; i < ARRAY_SIZE(genxml_specs); i++) {
+      if (genxml_specs[i].gen_10 == gen_10)
+         return gen_spec_load_tables(&genxml_specs[i]);
+   }
+
+   fprintf(stderr, "unable to find gen (%u) data\n", gen_10);
+   return NULL;
 }
 
 struct gen_spec *
@@ -731,6 +834,11 @@ gen_spec_load_filename(const char *filename)
       return NULL;
    }
 
+   if (ctx.spec && !gen_spec_build_opcode_index(ctx.spec)) {
+      gen_spec_destroy(ctx.spec);
+      return NULL;
+   }
+
    return ctx.spec;
 }
 
@@ -761,12 +869,41 @@ gen_spec_find_instruction(struct gen_spec *spec,
                           enum drm_i915_gem_engine_class engine,
                           const uint32_t *p)
 {
-   hash_table_foreach(spec->commands, entry) {
-      struct gen_group *command = entry->data;
-      uint32_t opcode = *p & command->opcode_mask;
-      if ((command->engine_mask & I915_ENGINE_CLASS_TO_MASK(engine)) &&
-           opcode == command->opcode)
-         return command;
+   const struct gen_opcode_entry *entries = spec->opcode_entries;
+   const uint32_t engine_mask = I915_ENGINE_CLASS_TO_MASK(engine);
+
+   if (spec->n_opcode_ranges == 0) {
+      for (uint32_t i = 0; i < spec->n_opcode_entries; i++) {
+         struct gen_group *command = entries[i].group;
+         if ((command->engine_mask & engine_mask) &&
+             (*p & command->opcode_mask) == command->opcode)
+            return command;
+      }
+      return NULL;
+   }
+
+   for (uint32_t r = 0; r < spec->n_opcode_ranges; r++) {
+      const uint32_t mask = spec->opcode_ranges[r].mask;
+      const uint32_t opcode = *p & mask;
+      uint32_t lo = spec->opcode_ranges[r].start;
+      uint32_t hi = r + 1 < spec->n_opcode_ranges ?
+                    spec->opcode_ranges[r + 1].start : spec->n_opcode_entries;
+
+      /* Find the first entry in the range with this opcode. */
+      while (lo < hi) {
+         uint32_t mid = lo + (hi - lo) / 2;
+         if (entries[mid].group->opcode < opcode)
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+
+      for (; lo < spec->n_opcode_entries &&
+             entries[lo].group->opcode_mask == mask &&
+             entries[lo].group->opcode == opcode; lo++) {
+         if (entries[lo].group->engine_mask & engine_mask)
+            return entries[lo].group;
+      }
    }
 
    return NULL;
@@ -97,6 +97,11 @@ struct gen_field_iterator {
    bool print_colors;
 };
 
+struct gen_opcode_entry {
+   struct gen_group *group;
+   uint32_t order;
+};
+
 struct gen_spec {
    uint32_t gen;
 
@@ -107,6 +112,17 @@ struct gen_spec {
    struct hash_table *enums;
 
    struct hash_table *access_cache;
+
+   /* Instructions sorted by opcode mask and opcode, and where each mask's
+    * run starts.  n_opcode_ranges is 0 if there were too many masks to index.
+    */
+   struct gen_opcode_entry *opcode_entries;
+   uint32_t n_opcode_entries;
+   struct {
+      uint32_t mask;
+      uint32_t start;
+   } opcode_ranges[8];
+   uint32_t n_opcode_ranges;
 };
 
 struct gen_group {
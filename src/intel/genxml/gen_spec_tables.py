@@ -0,0 +1,558 @@
+#encoding=utf-8
+#
+# Copyright © 2019 Intel Corporation
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice (including the next
+# paragraph) shall be included in all copies or substantial portions of the
+# Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+# IN THE SOFTWARE.
+#
+
+
+"""Generates genX_spec_tables.h, which holds every genxml file flattened into
+index-based C tables.  gen_spec_load() builds a gen_spec from these directly,
+instead of inflating and parsing the XML at runtime.
+
+The parse below has to stay in sync with start_element()/end_element() in
+src/intel/common/gen_decoder.c, which still handles XML loaded from disk.
+"""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+
+import argparse
+import io
+import re
+import sys
+import xml.parsers.expat
+
+ENGINE_CLASS_RENDER = 1 << 0
+ENGINE_CLASS_COPY = 1 << 1
+ENGINE_CLASS_VIDEO = 1 << 2
+ALL_ENGINES = ENGINE_CLASS_RENDER | ENGINE_CLASS_VIDEO | ENGINE_CLASS_COPY
+
+NO_STRING = 0xffffffff
+NO_INDEX = -1
+
+def strtoul(s):
+    """Mimics strtoul(s, NULL, 0) on a 64-bit unsigned long."""
+    m = re.match(r'\s*([+-]?)(0[xX][0-9a-fA-F]+|0[0-7]*|[1-9][0-9]*)', s)
+    if m is None:
+        return 0
+    digits = m.group(2)
+    if digits[:2] in ('0x', '0X'):
+        v = int(digits[2:], 16)
+    elif digits.startswith('0'):
+        v = int(digits, 8)
+    else:
+        v = int(digits, 10)
+    if m.group(1) == '-':
+        v = -v
+    return v & 0xffffffffffffffff
+
+def mask(start, end):
+    return ((0xffffffffffffffff >> (63 - end + start)) << start) & \
+        0xffffffffffffffff
+
+
+class Value(object):
+    def __init__(self, attrs):
+        self.name = attrs.get('name')
+        self.value = strtoul(attrs['value']) if 'value' in attrs else 0
+
+
+class Enum(object):
+    def __init__(self, index, name):
+        self.index = index
+        self.name = name
+        self.values = []
+
+
+class Group(object):
+    def __init__(self, index, kind, name, attrs, parent, fixed_length):
+        self.index = index
+        self.kind = kind
+        self.name = name
+        self.parent = parent
+        self.fixed_length = fixed_length
+        self.fields = []
+        self.dword_length_field = None
+        self.dw_length = 0
+        self.engine_mask = ALL_ENGINES
+        self.bias = 1
+        self.array_offset = 0
+        self.array_count = 0
+        self.array_item_size = 0
+        self.variable = False
+        self.opcode_mask = 0
+        self.opcode = 0
+        self.register_offset = 0
+
+        if 'length' in attrs:
+            self.dw_length = strtoul(attrs['length']) & 0xffffffff
+        if 'bias' in attrs:
+            self.bias = strtoul(attrs['bias']) & 0xffffffff
+        if 'engine' in attrs:
+            self.engine_mask = 0
+            for tok in attrs['engine'].split('|'):
+                if tok == 'render':
+                    self.engine_mask |= ENGINE_CLASS_RENDER
+                elif tok == 'video':
+                    self.engine_mask |= ENGINE_CLASS_VIDEO
+                elif tok == 'blitter':
+                    self.engine_mask |= ENGINE_CLASS_COPY
+                elif tok:
+                    print('unknown engine class defined for instruction '
+                          '"%s": %s' % (name, attrs['engine']),
+                          file=sys.stderr)
+
+        if parent is not None:
+            if 'count' in attrs:
+                self.array_count = strtoul(attrs['count']) & 0xffffffff
+                if self.array_count == 0:
+                    self.variable = True
+            if 'start' in attrs:
+                self.array_offset = strtoul(attrs['start']) & 0xffffffff
+            if 'size' in attrs:
+                self.array_item_size = strtoul(attrs['size']) & 0xffffffff
+
+        if kind == 'REGISTER' and 'num' in attrs:
+            self.register_offset = strtoul(attrs['num']) & 0xffffffff
+
+    def append_field(self, field):
+        # Fields are kept sorted by start bit, with a new field going in
+        # front of existing ones with the same start, as in
+        # create_and_append_field().
+        i = 0
+        while i < len(self.fields) and field.start > self.fields[i].start:
+            i += 1
+        self.fields.insert(i, field)
+
+
+class Field(object):
+    def __init__(self):
+        self.name = None
+        self.start = 0
+        self.end = 0
+        self.type = ('GEN_TYPE_UNKNOWN', NO_INDEX, 0)
+        self.has_default = False
+        self.default_value = 0
+        self.array = None
+        self.values = []
+
+
+class Spec(object):
+    def __init__(self, filename):
+        self.filename = filename
+        self.gen = 0
+        self.gen_10 = 0
+        self.groups = []
+        self.enums = []
+
+        self.structs = {}
+        self.enums_by_name = {}
+
+        self.parser = None
+        self.group = None
+        self.enoom = None
+        self.values = []
+        self.last_field = None
+
+    def fail(self, msg):
+        sys.exit('%s:%d: error: %s' %
+                 (self.filename, self.parser.CurrentLineNumber, msg))
+
+    def string_to_type(self, s):
+        if s == 'int':
+            return ('GEN_TYPE_INT', NO_INDEX, 0)
+        elif s == 'uint':
+            return ('GEN_TYPE_UINT', NO_INDEX, 0)
+        elif s == 'bool':
+            return ('GEN_TYPE_BOOL', NO_INDEX, 0)
+        elif s == 'float':
+            return ('GEN_TYPE_FLOAT', NO_INDEX, 0)
+        elif s == 'address':
+            return ('GEN_TYPE_ADDRESS', NO_INDEX, 0)
+        elif s == 'offset':
+            return ('GEN_TYPE_OFFSET', NO_INDEX, 0)
+
+        m = re.match(r'([us])([+-]?\d+)\.([+-]?\d+)', s)
+        if m:
+            kind = 'GEN_TYPE_UFIXED' if m.group(1) == 'u' else 'GEN_TYPE_SFIXED'
+            return (kind, int(m.group(2)), int(m.group(3)))
+
+        if s in self.structs:
+            return ('GEN_TYPE_STRUCT', self.structs[s].index, 0)
+        elif s in self.enums_by_name:
+            return ('GEN_TYPE_ENUM', self.enums_by_name[s].index, 0)
+        elif s == 'mbo':
+            return ('GEN_TYPE_MBO', NO_INDEX, 0)
+
+        self.fail('invalid type: %s' % s)
+
+    def create_group(self, kind, name, attrs, parent, fixed_length):
+        group = Group(len(self.groups), kind, name, attrs, parent,
+                      fixed_length)
+        self.groups.append(group)
+        return group
+
+    def create_field(self, attrs):
+        field = Field()
+        for key, value in attrs:
+            if key == 'name':
+                field.name = value
+                if value == 'DWord Length':
+                    self.group.dword_length_field = field
+            elif key == 'start':
+                field.start = strtoul(value) & 0xffffffff
+            elif key == 'end':
+                field.end = strtoul(value) & 0xffffffff
+            elif key == 'type':
+                field.type = self.string_to_type(value)
+            elif key == 'default' and field.start >= 16 and field.end <= 31:
+                field.has_default = True
+                field.default_value = strtoul(value) & 0xffffffff
+        return field
+
+    def create_and_append_field(self, attrs, array):
+        if array is not None:
+            field = Field()
+            field.array = array
+            field.start = array.array_offset
+        else:
+            field = self.create_field(attrs)
+        self.group.append_field(field)
+        return field
+
+    def start_element(self, element_name, attr_list):
+        attrs = dict(zip(attr_list[0::2], attr_list[1::2]))
+        attr_pairs = list(zip(attr_list[0::2], attr_list[1::2]))
+        name = attrs.get('name')
+
+        if element_name == 'genxml':
+            if name is None:
+                self.fail('no platform name given')
+            gen = attrs.get('gen')
+            if gen is None:
+                self.fail('no gen given')
+            m = re.match(r'(\d+)(?:\.(\d+))?', gen)
+            if m is None:
+                self.fail('invalid gen given: %s' % gen)
+            major = int(m.group(1))
+            minor = int(m.group(2)) if m.group(2) else 0
+            self.gen = (major << 8) | minor
+            self.gen_10 = int(float(gen) * 10)
+        elif element_name == 'instruction':
+            self.group = self.create_group('INSTRUCTION', name, attrs,
+                                           None, False)
+        elif element_name == 'struct':
+            self.group = self.create_group('STRUCT', name, attrs, None, True)
+        elif element_name == 'register':
+            self.group = self.create_group('REGISTER', name, attrs,
+                                           None, True)
+        elif element_name == 'group':
+            group = self.create_group('GROUP', '', attrs, self.group, False)
+            self.last_field = self.create_and_append_field(None, group)
+            self.group = group
+        elif element_name == 'field':
+            self.last_field = self.create_and_append_field(attr_pairs, None)
+        elif element_name == 'enum':
+            self.enoom = Enum(len(self.enums), name)
+            self.enums.append(self.enoom)
+        elif element_name == 'value':
+            self.values.append(Value(attrs))
+
+    def end_element(self, name):
+        if name in ('instruction', 'struct', 'register'):
+            group = self.group
+            self.group = group.parent
+
+            for field in group.fields:
+                if field.end > 31:
+                    break
+                if field.start >= 16 and field.has_default:
+                    group.opcode_mask |= mask(field.start % 32,
+                                              field.end % 32)
+                    group.opcode |= field.default_value << field.start
+            group.opcode_mask &= 0xffffffff
+            group.opcode &= 0xffffffff
+
+            if name == 'struct':
+                self.structs[group.name] = group
+        elif name == 'group':
+            self.group = self.group.parent
+        elif name == 'field':
+            self.last_field.values = self.values
+            self.last_field = None
+            self.values = []
+        elif name == 'enum':
+            self.enoom.values = self.values
+            self.enums_by_name[self.enoom.name] = self.enoom
+            self.enoom = None
+            self.values = []
+
+    def parse(self):
+        self.parser = xml.parsers.expat.ParserCreate()
+        self.parser.ordered_attributes = True
+        self.parser.StartElementHandler = self.start_element
+        self.parser.EndElementHandler = self.end_element
+        with open(self.filename, 'rb') as f:
+            self.parser.ParseFile(f)
+        self.parser = None
+
+
+class StringTable(object):
+    def __init__(self):
+        self.offsets = {}
+        self.strings = []
+        self.size = 0
+
+    def add(self, s):
+        if s is None:
+            return NO_STRING
+        if s not in self.offsets:
+            self.offsets[s] = self.size
+            self.strings.append(s)
+            self.size += len(s.encode('utf-8')) + 1
+        return self.offsets[s]
+
+
+def c_string(s):
+    out = ''
+    for c in bytearray(s.encode('utf-8')):
+        if c in (ord('"'), ord('\\')):
+            out += '\\' + chr(c)
+        elif 32 <= c < 127 and c != ord('?'):
+            out += chr(c)
+        else:
+            out += '\\%03o' % c
+    return out
+
+
+def emit_spec(out, spec, strings):
+    prefix = 'gen%d' % spec.gen_10
+
+    # Lay the fields and values out so that each group's fields and each
+    # field's or enum's values are contiguous.
+    fields = []
+    values = []
+    for group in spec.groups:
+        group.field_start = len(fields)
+        for field in group.fields:
+            field.index = len(fields)
+            fields.append(field)
+    for field in fields:
+        field.value_start = len(values)
+        values += field.values
+    for enum in spec.enums:
+        enum.value_start = len(values)
+        values += enum.values
+
+    for n in (len(spec.groups), len(fields), len(spec.enums), len(values)):
+        assert n < 0x8000
+
+    print('static const struct genxml_group %s_groups[] = {' % prefix,
+          file=out)
+    for g in spec.groups:
+        print('   { %uu, GENXML_%s, %d, %d, %d, %d, %uu, %uu, %uu, '
+              '%uu, %uu, %uu, %s, %s, 0x%08xu, 0x%08xu, 0x%08xu },' %
+              (strings.add(g.name), g.kind,
+               g.parent.index if g.parent is not None else NO_INDEX,
+               g.field_start, len(g.fields),
+               g.dword_length_field.index
+               if g.dword_length_field is not None else NO_INDEX,
+               g.dw_length, g.engine_mask, g.bias,
+               g.array_offset, g.array_count, g.array_item_size,
+               'true' if g.variable else 'false',
+               'true' if g.fixed_length else 'false',
+               g.opcode_mask, g.opcode, g.register_offset), file=out)
+    print('};\n', file=out)
+
+    print('static const struct genxml_field %s_fields[] = {' % prefix,
+          file=out)
+    for f in fields:
+        kind, ref, frac = f.type
+        print('   { %uu, %uu, %uu, %s, %d, %d, %d, %d, %d, %s, 0x%xu },' %
+              (strings.add(f.name), f.start, f.end, kind, ref, frac,
+               f.array.index if f.array is not None else NO_INDEX,
+               f.value_start, len(f.values),
+               'true' if f.has_default else 'false', f.default_value),
+              file=out)
+    print('};\n', file=out)
+
+    print('static const struct genxml_enum %s_enums[] = {' % prefix,
+          file=out)
+    for e in spec.enums:
+        print('   { %uu, %d, %d },' %
+              (strings.add(e.name), e.value_start, len(e.values)), file=out)
+    print('};\n', file=out)
+
+    print('static const struct genxml_value %s_values[] = {' % prefix,
+          file=out)
+    for v in values:
+        print('   { %uu, 0x%xull },' % (strings.add(v.name), v.value),
+              file=out)
+    print('};\n', file=out)
+
+
+HEADER = '''\
+/*
+ * Copyright © 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* THIS FILE HAS BEEN GENERATED, DO NOT HAND EDIT.
+ *
+ * The genxml files flattened into tables for gen_spec_load().  Strings are
+ * offsets into genxml_strings, and references to other groups, fields, enums
+ * and values are indices into the same gen's arrays.
+ */
+
+#ifndef GENX_SPEC_TABLES_H
+#define GENX_SPEC_TABLES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GENXML_NO_STRING 0xffffffffu
+
+enum genxml_group_kind {
+   GENXML_INSTRUCTION,
+   GENXML_STRUCT,
+   GENXML_REGISTER,
+   GENXML_GROUP,
+};
+
+struct genxml_group {
+   uint32_t name;
+   uint8_t kind;
+   int16_t parent;
+   int16_t field_start;
+   int16_t n_fields;
+   int16_t dword_length_field;
+   uint32_t dw_length;
+   uint32_t engine_mask;
+   uint32_t bias;
+   uint32_t array_offset;
+   uint32_t array_count;
+   uint32_t array_item_size;
+   bool variable;
+   bool fixed_length;
+   uint32_t opcode_mask;
+   uint32_t opcode;
+   uint32_t register_offset;
+};
+
+struct genxml_field {
+   uint32_t name;
+   uint32_t start, end;
+   uint8_t type;
+   /* Struct or enum index, or the integer bits of a fixed-point type */
+   int16_t type_ref;
+   int16_t type_frac;
+   int16_t array;
+   int16_t value_start;
+   int16_t n_values;
+   bool has_default;
+   uint32_t default_value;
+};
+
+struct genxml_enum {
+   uint32_t name;
+   int16_t value_start;
+   int16_t n_values;
+};
+
+struct genxml_value {
+   uint32_t name;
+   uint64_t value;
+};
+
+struct genxml_spec {
+   uint32_t gen_10;
+   uint32_t gen;
+   const struct genxml_group *groups;
+   uint32_t n_groups;
+   const struct genxml_field *fields;
+   uint32_t n_fields;
+   const struct genxml_enum *enums;
+   uint32_t n_enums;
+   const struct genxml_value *values;
+   uint32_t n_values;
+};
+'''
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('xml_sources', metavar='XML_SOURCE', nargs='+')
+    parser.add_argument('-o', '--output', type=str,
+                        help='Output file name')
+    args = parser.parse_args()
+
+    specs = []
+    for filename in args.xml_sources:
+        spec = Spec(filename)
+        spec.parse()
+        specs.append(spec)
+
+    strings = StringTable()
+    with io.open(args.output, 'w', encoding='utf-8') as out:
+        print(HEADER, file=out)
+
+        for spec in specs:
+            emit_spec(out, spec, strings)
+
+        print('static const char genxml_strings[] =', file=out)
+        for s in strings.strings:
+            print('   "%s\\0"' % c_string(s), file=out)
+        print('   ;\n', file=out)
+
+        print('static const struct genxml_spec genxml_specs[] = {', file=out)
+        for spec in specs:
+            prefix = 'gen%d' % spec.gen_10
+            print('   { %d, 0x%x, %s_groups, ARRAY_SIZE(%s_groups), '
+                  '%s_fields, ARRAY_SIZE(%s_fields), '
+                  '%s_enums, ARRAY_SIZE(%s_enums), '
+                  '%s_values, ARRAY_SIZE(%s_values) },' %
+                  ((spec.gen_10, spec.gen) + (prefix,) * 8), file=out)
+        print('};\n', file=out)
+
+        print('#endif /* GENX_SPEC_TABLES_H */', file=out)
+
+
+if __name__ == '__main__':
+    main()
@@ -156,6 +156,7 @@ isl_device_init(struct isl_device *dev,
    dev->info = info;
    dev->use_separate_stencil = ISL_DEV_GEN(dev) >= 6;
    dev->has_bit6_swizzling = has_bit6_swizzling;
+   dev->surf_cache = NULL;
 
    /* The ISL_DEV macros may be defined in the CFLAGS, thus hardcoding some
     * device properties at buildtime. Verify that the macros with the device
@@ -1536,10 +1537,10 @@ isl_calc_row_pitch(const struct isl_device *dev,
    return true;
 }
 
-bool
-isl_surf_init_s(const struct isl_device *dev,
-                struct isl_surf *surf,
-                const struct isl_surf_init_info *restrict info)
+static bool
+isl_surf_calc_layout(const struct isl_device *dev,
+                     struct isl_surf *surf,
+                     const struct isl_surf_init_info *restrict info)
 {
    const struct isl_format_layout *fmtl = isl_format_get_layout(info->format);
 
@@ -1699,6 +1700,23 @@ isl_surf_init_s(const struct isl_device *dev,
    return true;
 }
 
+bool
+isl_surf_init_s(const struct isl_device *dev,
+                struct isl_surf *surf,
+                const struct isl_surf_init_info *restrict info)
+{
+   if (dev->surf_cache && isl_surf_cache_search(dev->surf_cache, info, surf))
+      return true;
+
+   if (!isl_surf_calc_layout(dev, surf, info))
+      return false;
+
+   if (dev->surf_cache)
+      isl_surf_cache_insert(dev->surf_cache, info, surf);
+
+   return true;
+}
+
 void
 isl_surf_get_tile_info(const struct isl_surf *surf,
                        struct isl_tile_info *tile_info)
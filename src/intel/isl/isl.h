@@ -50,6 +50,7 @@ extern "C" {
 #endif
 
 struct gen_device_info;
+struct isl_surf_cache;
 struct brw_image_param;
 
 #ifndef ISL_DEV_GEN
@@ -1020,6 +1021,12 @@ struct isl_device {
       uint32_t internal;
       uint32_t external;
    } mocs;
+
+   /**
+    * Optional cache of surface layouts, see isl_surf_cache_create().  NULL
+    * unless the driver sets one up.
+    */
+   struct isl_surf_cache *surf_cache;
 };
 
 struct isl_extent2d {
@@ -1467,6 +1474,30 @@ isl_device_init(struct isl_device *dev,
 isl_sample_count_mask_t ATTRIBUTE_CONST
 isl_device_get_sample_counts(struct isl_device *dev);
 
+struct isl_surf_cache_stats {
+   uint64_t hits;
+   uint64_t misses;
+};
+
+/**
+ * Creates a cache for the results of isl_surf_init(), to be stored in
+ * isl_device::surf_cache.
+ *
+ * Drivers which create many surfaces with the same description can use
+ * this to skip the layout computation on repeated descriptions.  The cache
+ * is thread-safe and bounded in size, but must not be shared between
+ * devices.
+ */
+struct isl_surf_cache *
+isl_surf_cache_create(void);
+
+void
+isl_surf_cache_destroy(struct isl_surf_cache *cache);
+
+void
+isl_surf_cache_get_stats(struct isl_surf_cache *cache,
+                         struct isl_surf_cache_stats *stats);
+
 static inline const struct isl_format_layout * ATTRIBUTE_CONST
 isl_format_get_layout(enum isl_format fmt)
 {
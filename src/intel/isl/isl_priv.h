@@ -50,6 +50,16 @@ __isl_finishme(const char *file, int line, const char *fmt, ...);
 
 typedef void *(*isl_mem_copy_fn)(void *dest, const void *src, size_t n);
 
+bool
+isl_surf_cache_search(struct isl_surf_cache *cache,
+                      const struct isl_surf_init_info *restrict info,
+                      struct isl_surf *surf);
+
+void
+isl_surf_cache_insert(struct isl_surf_cache *cache,
+                      const struct isl_surf_init_info *restrict info,
+                      const struct isl_surf *surf);
+
 static inline bool
 isl_is_pow2(uintmax_t n)
 {
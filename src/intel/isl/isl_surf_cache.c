@@ -0,0 +1,193 @@
+/*
+ * Copyright 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "isl.h"
+#include "isl_priv.h"
+
+#include "util/simple_mtx.h"
+
+/* The cache is a 4-way set associative table: each description hashes to a
+ * set of four slots, and a miss replaces them in turn.  Applications creating
+ * lots of images tend to cycle through a small number of descriptions, which
+ * this handles well while keeping lookups to a few compares.
+ */
+#define ISL_SURF_CACHE_SETS 64
+#define ISL_SURF_CACHE_WAYS 4
+
+/* isl_surf_init_info may have uninitialized padding, so the key is built
+ * field by field.  The device isn't part of the key since each isl_device
+ * has a cache of its own.
+ */
+struct isl_surf_cache_key {
+   uint32_t dim;
+   uint32_t format;
+   uint32_t width;
+   uint32_t height;
+   uint32_t depth;
+   uint32_t levels;
+   uint32_t array_len;
+   uint32_t samples;
+   uint32_t min_alignment_B;
+   uint32_t row_pitch_B;
+   uint32_t tiling_flags;
+   uint32_t pad;
+   uint64_t usage;
+};
+
+struct isl_surf_cache_entry {
+   bool valid;
+   struct isl_surf_cache_key key;
+   struct isl_surf surf;
+};
+
+struct isl_surf_cache_set {
+   struct isl_surf_cache_entry entries[ISL_SURF_CACHE_WAYS];
+   /** Next entry to replace */
+   unsigned next;
+};
+
+struct isl_surf_cache {
+   simple_mtx_t mutex;
+   uint64_t hits;
+   uint64_t misses;
+   struct isl_surf_cache_set sets[ISL_SURF_CACHE_SETS];
+};
+
+struct isl_surf_cache *
+isl_surf_cache_create(void)
+{
+   struct isl_surf_cache *cache = calloc(1, sizeof(*cache));
+   if (!cache)
+      return NULL;
+
+   simple_mtx_init(&cache->mutex, mtx_plain);
+
+   return cache;
+}
+
+void
+isl_surf_cache_destroy(struct isl_surf_cache *cache)
+{
+   if (!cache)
+      return;
+
+   simple_mtx_destroy(&cache->mutex);
+   free(cache);
+}
+
+void
+isl_surf_cache_get_stats(struct isl_surf_cache *cache,
+                         struct isl_surf_cache_stats *stats)
+{
+   simple_mtx_lock(&cache->mutex);
+   stats->hits = cache->hits;
+   stats->misses = cache->misses;
+   simple_mtx_unlock(&cache->mutex);
+}
+
+static struct isl_surf_cache_set *
+isl_surf_cache_get_set(struct isl_surf_cache *cache,
+                         const struct isl_surf_init_info *restrict info,
+                         struct isl_surf_cache_key *key)
+{
+   *key = (struct isl_surf_cache_key) {
+      .dim = info->dim,
+      .format = info->format,
+      .width = info->width,
+      .height = info->height,
+      .depth = info->depth,
+      .levels = info->levels,
+      .array_len = info->array_len,
+      .samples = info->samples,
+      .min_alignment_B = info->min_alignment_B,
+      .row_pitch_B = info->row_pitch_B,
+      .tiling_flags = info->tiling_flags,
+      .usage = info->usage,
+   };
+
+   /* _mesa_hash_data() works a byte at a time, which costs about as much as
+    * the layout computation for simple surfaces.  Mix whole words instead,
+    * with independent multiplies so that they can run in parallel.
+    */
+   const uint32_t *words = (const uint32_t *)key;
+   uint32_t hash = 0;
+   for (unsigned i = 0; i < sizeof(*key) / 4; i++)
+      hash += words[i] * (0x9e3779b1 + 2 * i);
+   hash ^= hash >> 15;
+   hash *= 0x85ebca6b;
+
+   return &cache->sets[(hash >> 24) % ISL_SURF_CACHE_SETS];
+}
+
+bool
+isl_surf_cache_search(struct isl_surf_cache *cache,
+                      const struct isl_surf_init_info *restrict info,
+                      struct isl_surf *surf)
+{
+   struct isl_surf_cache_key key;
+   struct isl_surf_cache_set *set = isl_surf_cache_get_set(cache, info, &key);
+   bool found = false;
+
+   simple_mtx_lock(&cache->mutex);
+
+   for (unsigned i = 0; i < ISL_SURF_CACHE_WAYS; i++) {
+      struct isl_surf_cache_entry *entry = &set->entries[i];
+      if (entry->valid && memcmp(&entry->key, &key, sizeof(key)) == 0) {
+         *surf = entry->surf;
+         found = true;
+         break;
+      }
+   }
+
+   if (found)
+      cache->hits++;
+   else
+      cache->misses++;
+
+   simple_mtx_unlock(&cache->mutex);
+
+   return found;
+}
+
+void
+isl_surf_cache_insert(struct isl_surf_cache *cache,
+                      const struct isl_surf_init_info *restrict info,
+                      const struct isl_surf *surf)
+{
+   struct isl_surf_cache_key key;
+   struct isl_surf_cache_set *set = isl_surf_cache_get_set(cache, info, &key);
+
+   simple_mtx_lock(&cache->mutex);
+
+   struct isl_surf_cache_entry *entry = &set->entries[set->next];
+   set->next = (set->next + 1) % ISL_SURF_CACHE_WAYS;
+
+   entry->valid = true;
+   entry->key = key;
+   entry->surf = *surf;
+
+   simple_mtx_unlock(&cache->mutex);
+}
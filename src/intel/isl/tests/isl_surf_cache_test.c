@@ -0,0 +1,190 @@
+/*
+ * Copyright 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks that surfaces served from isl_device::surf_cache are identical to
+ * freshly computed ones, across a set of descriptions large enough to cause
+ * evictions.
+ *
+ * Run with --bench to compare the time taken by isl_surf_init() with and
+ * without the cache and print the hit rate.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dev/gen_device_info.h"
+#include "isl/isl.h"
+#include "isl/isl_priv.h"
+#include "util/os_time.h"
+#include "util/u_math.h"
+
+#define BDW_GT2_DEVID 0x161a
+
+// An asssert that works regardless of NDEBUG.
+#define t_assert(cond) \
+   do { \
+      if (!(cond)) { \
+         fprintf(stderr, "%s:%d: assertion failed\n", __FILE__, __LINE__); \
+         abort(); \
+      } \
+   } while (0)
+
+static const enum isl_format formats[] = {
+   ISL_FORMAT_R8G8B8A8_UNORM,
+   ISL_FORMAT_B8G8R8A8_UNORM_SRGB,
+   ISL_FORMAT_R16G16B16A16_FLOAT,
+   ISL_FORMAT_R32_FLOAT,
+   ISL_FORMAT_R8_UNORM,
+   ISL_FORMAT_BC1_UNORM,
+};
+
+/* Generates the i-th of a series of distinct descriptions, spread over
+ * formats, sizes and array lengths, with either one or a full chain of mip
+ * levels.
+ */
+static struct isl_surf_init_info
+make_info(uint32_t i, bool mipmapped)
+{
+   const uint32_t size = 16 << (i % 7);
+
+   return (struct isl_surf_init_info) {
+      .dim = ISL_SURF_DIM_2D,
+      .format = formats[i % ARRAY_SIZE(formats)],
+      .width = size + (i / 7) % 5,
+      .height = size + i / 210,
+      .depth = 1,
+      .levels = mipmapped ? util_logbase2(size) + 1 : 1,
+      .array_len = 1 + (i / 35) % 6,
+      .samples = 1,
+      .usage = ISL_SURF_USAGE_TEXTURE_BIT |
+               ISL_SURF_USAGE_DISABLE_AUX_BIT,
+      .tiling_flags = ISL_TILING_ANY_MASK,
+   };
+}
+
+static void
+test_cached_matches_uncached(const struct gen_device_info *devinfo)
+{
+   const uint32_t n_infos = 420;
+
+   struct isl_device dev, cached_dev;
+   isl_device_init(&dev, devinfo, /*bit6_swizzle*/ false);
+   isl_device_init(&cached_dev, devinfo, /*bit6_swizzle*/ false);
+   cached_dev.surf_cache = isl_surf_cache_create();
+   t_assert(cached_dev.surf_cache);
+
+   for (int pass = 0; pass < 3; pass++) {
+      for (uint32_t i = 0; i < n_infos; i++) {
+         const struct isl_surf_init_info info = make_info(i / 2, i % 2);
+         struct isl_surf surf, cached_surf;
+
+         bool ok = isl_surf_init_s(&dev, &surf, &info);
+         bool cached_ok = isl_surf_init_s(&cached_dev, &cached_surf, &info);
+         t_assert(ok == cached_ok);
+         if (ok)
+            t_assert(memcmp(&surf, &cached_surf, sizeof(surf)) == 0);
+      }
+   }
+
+   /* Repeating the same description must always hit. */
+   struct isl_surf_cache_stats before, after;
+   isl_surf_cache_get_stats(cached_dev.surf_cache, &before);
+   for (int i = 0; i < 10; i++) {
+      const struct isl_surf_init_info info = make_info(0, true);
+      struct isl_surf surf;
+      t_assert(isl_surf_init_s(&cached_dev, &surf, &info));
+   }
+   isl_surf_cache_get_stats(cached_dev.surf_cache, &after);
+   t_assert(after.hits - before.hits >= 9);
+   t_assert(after.hits + after.misses == 3 * n_infos + 10);
+
+   isl_surf_cache_destroy(cached_dev.surf_cache);
+}
+
+static int64_t
+time_surf_init(const struct isl_device *dev, uint32_t n_infos,
+               bool mipmapped, uint32_t iterations)
+{
+   int64_t start = os_time_get_nano();
+
+   for (uint32_t it = 0; it < iterations; it++) {
+      for (uint32_t i = 0; i < n_infos; i++) {
+         const struct isl_surf_init_info info = make_info(i, mipmapped);
+         struct isl_surf surf;
+         isl_surf_init_s(dev, &surf, &info);
+      }
+   }
+
+   return os_time_get_nano() - start;
+}
+
+static void
+bench(const struct gen_device_info *devinfo)
+{
+   const uint32_t iterations = 2000;
+   const uint32_t set_sizes[] = { 16, 128, 1024 };
+
+   for (int mipmapped = 0; mipmapped <= 1; mipmapped++) {
+      for (unsigned s = 0; s < ARRAY_SIZE(set_sizes); s++) {
+         const uint32_t n_infos = set_sizes[s];
+         const double n = (double)n_infos * iterations;
+
+         struct isl_device dev;
+         isl_device_init(&dev, devinfo, /*bit6_swizzle*/ false);
+         int64_t uncached_ns =
+            time_surf_init(&dev, n_infos, mipmapped, iterations);
+
+         dev.surf_cache = isl_surf_cache_create();
+         int64_t cached_ns =
+            time_surf_init(&dev, n_infos, mipmapped, iterations);
+
+         struct isl_surf_cache_stats stats;
+         isl_surf_cache_get_stats(dev.surf_cache, &stats);
+         isl_surf_cache_destroy(dev.surf_cache);
+
+         printf("%4u %s descriptions: uncached %.1f ns, cached %.1f ns, "
+                "hit rate %.1f%%\n", n_infos,
+                mipmapped ? "mipmapped" : "single level",
+                uncached_ns / n, cached_ns / n,
+                100.0 * stats.hits / (stats.hits + stats.misses));
+      }
+   }
+}
+
+int main(int argc, char **argv)
+{
+   struct gen_device_info devinfo;
+   t_assert(gen_get_device_info_from_pci_id(BDW_GT2_DEVID, &devinfo));
+
+   if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+      bench(&devinfo);
+      return 0;
+   }
+
+   test_cached_matches_uncached(&devinfo);
+   return 0;
+}
@@ -29,6 +29,10 @@
 #include <unistd.h>
 #include <errno.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <drm-uapi/i915_drm.h>
 
 #include "common/gen_gem.h"
@@ -1050,36 +1054,92 @@ gen_perf_store_configuration(struct gen_perf_config *perf_cfg, int fd,
    return i915_add_config(perf_cfg, fd, config, generated_guid);
 }
 
-/* Accumulate 32bits OA counters */
+/* Accumulate n consecutive 32bits OA counters
+ *
+ * The counters of the same type sit next to each other in both the report
+ * and the accumulator, so each run is handled as one array operation. With
+ * SSE2 (which this library is always built with on x86) 4 deltas are
+ * computed and widened at once.
+ */
 static inline void
-accumulate_uint32(const uint32_t *report0,
-                  const uint32_t *report1,
-                  uint64_t *accumulator)
+accumulate_uint32(const uint32_t *restrict report0,
+                  const uint32_t *restrict report1,
+                  uint64_t *restrict accumulator,
+                  int n)
 {
-   *accumulator += (uint32_t)(*report1 - *report0);
+   int i = 0;
+
+#ifdef __SSE2__
+   const __m128i zero = _mm_setzero_si128();
+
+   for (; i + 4 <= n; i += 4) {
+      __m128i v0 = _mm_loadu_si128((const __m128i *)(report0 + i));
+      __m128i v1 = _mm_loadu_si128((const __m128i *)(report1 + i));
+      __m128i delta = _mm_sub_epi32(v1, v0);
+      __m128i *acc = (__m128i *)(accumulator + i);
+
+      _mm_storeu_si128(acc, _mm_add_epi64(_mm_loadu_si128(acc),
+                                          _mm_unpacklo_epi32(delta, zero)));
+      _mm_storeu_si128(acc + 1, _mm_add_epi64(_mm_loadu_si128(acc + 1),
+                                              _mm_unpackhi_epi32(delta, zero)));
+   }
+#endif
+
+   for (; i < n; i++)
+      accumulator[i] += (uint32_t)(report1[i] - report0[i]);
 }
 
-/* Accumulate 40bits OA counters */
+/* Accumulate the 32 40bits A counters
+ *
+ * The low 32bits of A counter i are at dword 4 + i of the report, and the
+ * high 8bits are in byte i of the dwords starting at 40. The counters wrap
+ * at 40bits, so the delta is the 64bit difference masked down to 40bits.
+ */
 static inline void
-accumulate_uint40(int a_index,
-                  const uint32_t *report0,
-                  const uint32_t *report1,
-                  uint64_t *accumulator)
-{
-   const uint8_t *high_bytes0 = (uint8_t *)(report0 + 40);
-   const uint8_t *high_bytes1 = (uint8_t *)(report1 + 40);
-   uint64_t high0 = (uint64_t)(high_bytes0[a_index]) << 32;
-   uint64_t high1 = (uint64_t)(high_bytes1[a_index]) << 32;
-   uint64_t value0 = report0[a_index + 4] | high0;
-   uint64_t value1 = report1[a_index + 4] | high1;
-   uint64_t delta;
-
-   if (value0 > value1)
-      delta = (1ULL << 40) + value1 - value0;
-   else
-      delta = value1 - value0;
+accumulate_uint40(const uint32_t *restrict report0,
+                  const uint32_t *restrict report1,
+                  uint64_t *restrict accumulator)
+{
+   const uint8_t *high_bytes0 = (const uint8_t *)(report0 + 40);
+   const uint8_t *high_bytes1 = (const uint8_t *)(report1 + 40);
+   const uint64_t mask = (1ULL << 40) - 1;
+   int i = 0;
+
+#ifdef __SSE2__
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i mask128 = _mm_set1_epi64x(mask);
+
+   for (; i < 32; i += 4) {
+      __m128i lo0 = _mm_loadu_si128((const __m128i *)(report0 + 4 + i));
+      __m128i lo1 = _mm_loadu_si128((const __m128i *)(report1 + 4 + i));
+      __m128i hi0 = _mm_cvtsi32_si128(*(const uint32_t *)(high_bytes0 + i));
+      __m128i hi1 = _mm_cvtsi32_si128(*(const uint32_t *)(high_bytes1 + i));
+
+      /* Zero extend the 4 high bytes to 4 dwords. */
+      hi0 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(hi0, zero), zero);
+      hi1 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(hi1, zero), zero);
+
+      /* Interleaving the low and high dwords gives the 40bits values. */
+      __m128i delta_lo = _mm_and_si128(
+         _mm_sub_epi64(_mm_unpacklo_epi32(lo1, hi1),
+                       _mm_unpacklo_epi32(lo0, hi0)), mask128);
+      __m128i delta_hi = _mm_and_si128(
+         _mm_sub_epi64(_mm_unpackhi_epi32(lo1, hi1),
+                       _mm_unpackhi_epi32(lo0, hi0)), mask128);
+      __m128i *acc = (__m128i *)(accumulator + i);
+
+      _mm_storeu_si128(acc, _mm_add_epi64(_mm_loadu_si128(acc), delta_lo));
+      _mm_storeu_si128(acc + 1, _mm_add_epi64(_mm_loadu_si128(acc + 1),
+                                              delta_hi));
+   }
+#endif
+
+   for (; i < 32; i++) {
+      uint64_t value0 = report0[4 + i] | ((uint64_t)high_bytes0[i] << 32);
+      uint64_t value1 = report1[4 + i] | ((uint64_t)high_bytes1[i] << 32);
 
-   *accumulator += delta;
+      accumulator[i] += (value1 - value0) & mask;
+   }
 }
 
 static void
@@ -1142,8 +1202,6 @@ gen_perf_query_result_accumulate(struct gen_perf_query_result *result,
                                  const uint32_t *start,
                                  const uint32_t *end)
 {
-   int i, idx = 0;
-
    if (result->hw_id == OA_REPORT_INVALID_CTX_ID &&
        start[2] != OA_REPORT_INVALID_CTX_ID)
       result->hw_id = start[2];
@@ -1153,27 +1211,24 @@ gen_perf_query_result_accumulate(struct gen_perf_query_result *result,
 
    switch (query->oa_format) {
    case I915_OA_FORMAT_A32u40_A4u32_B8_C8:
-      accumulate_uint32(start + 1, end + 1, result->accumulator + idx++); /* timestamp */
-      accumulate_uint32(start + 3, end + 3, result->accumulator + idx++); /* clock */
+      accumulate_uint32(start + 1, end + 1, result->accumulator + 0, 1); /* timestamp */
+      accumulate_uint32(start + 3, end + 3, result->accumulator + 1, 1); /* clock */
 
       /* 32x 40bit A counters... */
-      for (i = 0; i < 32; i++)
-         accumulate_uint40(i, start, end, result->accumulator + idx++);
+      accumulate_uint40(start, end, result->accumulator + 2);
 
       /* 4x 32bit A counters... */
-      for (i = 0; i < 4; i++)
-         accumulate_uint32(start + 36 + i, end + 36 + i, result->accumulator + idx++);
+      accumulate_uint32(start + 36, end + 36, result->accumulator + 34, 4);
 
       /* 8x 32bit B counters + 8x 32bit C counters... */
-      for (i = 0; i < 16; i++)
-         accumulate_uint32(start + 48 + i, end + 48 + i, result->accumulator + idx++);
+      accumulate_uint32(start + 48, end + 48, result->accumulator + 38, 16);
       break;
 
    case I915_OA_FORMAT_A45_B8_C8:
-      accumulate_uint32(start + 1, end + 1, result->accumulator); /* timestamp */
+      accumulate_uint32(start + 1, end + 1, result->accumulator, 1); /* timestamp */
 
-      for (i = 0; i < 61; i++)
-         accumulate_uint32(start + 3 + i, end + 3 + i, result->accumulator + 1 + i);
+      /* 45x 32bit A counters + 8x 32bit B counters + 8x 32bit C counters... */
+      accumulate_uint32(start + 3, end + 3, result->accumulator + 1, 61);
       break;
 
    default:
@@ -1182,6 +1237,24 @@ gen_perf_query_result_accumulate(struct gen_perf_query_result *result,
 
 }
 
+void
+gen_perf_query_result_accumulate_reports(struct gen_perf_query_result *result,
+                                         const struct gen_perf_query_info *query,
+                                         const uint32_t *reports,
+                                         size_t report_stride,
+                                         uint32_t n_reports)
+{
+   const uint32_t *last = reports;
+
+   for (uint32_t i = 1; i < n_reports; i++) {
+      const uint32_t *report =
+         (const uint32_t *)((const uint8_t *)last + report_stride);
+
+      gen_perf_query_result_accumulate(result, query, last, report);
+      last = report;
+   }
+}
+
 void
 gen_perf_query_result_clear(struct gen_perf_query_result *result)
 {
@@ -2493,46 +2566,60 @@ read_gt_frequency(struct gen_perf_context *perf_ctx,
    obj->oa.gt_frequency[1] *= 1000000ULL;
 }
 
+void
+gen_perf_query_result_read_counters(struct gen_perf_config *perf,
+                                    const struct gen_perf_query_info *query,
+                                    const struct gen_perf_query_result *results,
+                                    uint32_t n_results,
+                                    void *data)
+{
+   /* Walk the counters in the outer loop, so that each generated equation
+    * is called back to back over all the results rather than bouncing
+    * between all the equations of the set for every result.
+    */
+   for (int i = 0; i < query->n_counters; i++) {
+      const struct gen_perf_query_counter *counter = &query->counters[i];
+      uint8_t *out = (uint8_t *)data + counter->offset;
+
+      if (!gen_perf_query_counter_get_size(counter))
+         continue;
+
+      switch (counter->data_type) {
+      case GEN_PERF_COUNTER_DATA_TYPE_UINT64:
+         for (uint32_t r = 0; r < n_results; r++) {
+            *(uint64_t *)out =
+               counter->oa_counter_read_uint64(perf, query,
+                                               results[r].accumulator);
+            out += query->data_size;
+         }
+         break;
+      case GEN_PERF_COUNTER_DATA_TYPE_FLOAT:
+         for (uint32_t r = 0; r < n_results; r++) {
+            *(float *)out =
+               counter->oa_counter_read_float(perf, query,
+                                              results[r].accumulator);
+            out += query->data_size;
+         }
+         break;
+      default:
+         /* So far we aren't using uint32, double or bool32... */
+         unreachable("unexpected counter data type");
+      }
+   }
+}
+
 static int
 get_oa_counter_data(struct gen_perf_context *perf_ctx,
                     struct gen_perf_query_object *query,
                     size_t data_size,
                     uint8_t *data)
 {
-   struct gen_perf_config *perf_cfg = perf_ctx->perf;
    const struct gen_perf_query_info *queryinfo = query->queryinfo;
-   int n_counters = queryinfo->n_counters;
-   int written = 0;
 
-   for (int i = 0; i < n_counters; i++) {
-      const struct gen_perf_query_counter *counter = &queryinfo->counters[i];
-      uint64_t *out_uint64;
-      float *out_float;
-      size_t counter_size = gen_perf_query_counter_get_size(counter);
-
-      if (counter_size) {
-         switch (counter->data_type) {
-         case GEN_PERF_COUNTER_DATA_TYPE_UINT64:
-            out_uint64 = (uint64_t *)(data + counter->offset);
-            *out_uint64 =
-               counter->oa_counter_read_uint64(perf_cfg, queryinfo,
-                                               query->oa.result.accumulator);
-            break;
-         case GEN_PERF_COUNTER_DATA_TYPE_FLOAT:
-            out_float = (float *)(data + counter->offset);
-            *out_float =
-               counter->oa_counter_read_float(perf_cfg, queryinfo,
-                                              query->oa.result.accumulator);
-            break;
-         default:
-            /* So far we aren't using uint32, double or bool32... */
-            unreachable("unexpected counter data type");
-         }
-         written = counter->offset + counter_size;
-      }
-   }
+   gen_perf_query_result_read_counters(perf_ctx->perf, queryinfo,
+                                       &query->oa.result, 1, data);
 
-   return written;
+   return queryinfo->data_size;
 }
 
 static int
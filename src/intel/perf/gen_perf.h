@@ -281,6 +281,30 @@ void gen_perf_query_result_accumulate(struct gen_perf_query_result *result,
                                       const struct gen_perf_query_info *query,
                                       const uint32_t *start,
                                       const uint32_t *end);
+
+/** Accumulate the deltas between each pair of consecutive OA reports of a
+ *  stream into result for a given query.
+ *
+ *  The reports are report_stride bytes apart, which allows walking either
+ *  packed reports or the records of an i915 perf stream.
+ */
+void gen_perf_query_result_accumulate_reports(struct gen_perf_query_result *result,
+                                              const struct gen_perf_query_info *query,
+                                              const uint32_t *reports,
+                                              size_t report_stride,
+                                              uint32_t n_reports);
+
+/** Evaluate the counters of a query for n_results accumulated results.
+ *
+ *  data receives n_results consecutive blocks of query->data_size bytes,
+ *  laid out as described by the offsets of the query's counters.
+ */
+void gen_perf_query_result_read_counters(struct gen_perf_config *perf,
+                                         const struct gen_perf_query_info *query,
+                                         const struct gen_perf_query_result *results,
+                                         uint32_t n_results,
+                                         void *data);
+
 void gen_perf_query_result_clear(struct gen_perf_query_result *result);
 
 struct gen_perf_context;
@@ -0,0 +1,339 @@
+/*
+ * Copyright © 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Checks the OA report accumulation and the batched counter evaluation
+ * against a stream of reports whose counter deltas are known, without
+ * needing a GPU.  The stream starts every counter close to its wrapping
+ * point so that the wrap handling is exercised.
+ *
+ * Run with --bench to time both steps over a longer stream.
+ */
+
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <drm-uapi/i915_drm.h>
+
+#include "perf/gen_perf.h"
+#include "perf/gen_perf_metrics.h"
+#include "util/hash_table.h"
+#include "util/macros.h"
+#include "util/os_time.h"
+
+#define REPORT_DWORDS 64
+#define CTX_ID 0x42
+
+struct stream {
+   uint32_t (*reports)[REPORT_DWORDS];
+   uint32_t n_reports;
+   /* Sum of the deltas fed into each accumulator slot */
+   uint64_t expected[MAX_OA_REPORT_COUNTERS];
+};
+
+static uint32_t rand_state = 0x12345678;
+
+static uint32_t
+next_rand(void)
+{
+   /* xorshift32, deterministic across runs */
+   rand_state ^= rand_state << 13;
+   rand_state ^= rand_state >> 17;
+   rand_state ^= rand_state << 5;
+   return rand_state;
+}
+
+static void
+set_uint40(uint32_t *report, int i, uint64_t value)
+{
+   report[4 + i] = (uint32_t)value;
+   ((uint8_t *)(report + 40))[i] = (uint8_t)(value >> 32);
+}
+
+/* Fills in a stream of reports in the given OA format.  Each report adds a
+ * random delta to every counter and stores the counters truncated to their
+ * hardware width, the way the OA unit writes them.
+ */
+static void
+generate_stream(struct stream *s, int oa_format, uint32_t n_reports)
+{
+   uint64_t values[MAX_OA_REPORT_COUNTERS];
+
+   s->reports = calloc(n_reports, sizeof(*s->reports));
+   s->n_reports = n_reports;
+   memset(s->expected, 0, sizeof(s->expected));
+
+   for (int i = 0; i < MAX_OA_REPORT_COUNTERS; i++)
+      values[i] = (1ull << 40) - 1 - (next_rand() & 0xffff);
+
+   for (uint32_t r = 0; r < n_reports; r++) {
+      uint32_t *report = s->reports[r];
+
+      if (r > 0) {
+         for (int i = 0; i < MAX_OA_REPORT_COUNTERS; i++) {
+            uint64_t delta = next_rand() & 0x3ffff;
+            values[i] += delta;
+            s->expected[i] += delta;
+         }
+      }
+
+      report[2] = CTX_ID;
+
+      switch (oa_format) {
+      case I915_OA_FORMAT_A32u40_A4u32_B8_C8:
+         report[1] = values[0];
+         report[3] = values[1];
+         for (int i = 0; i < 32; i++)
+            set_uint40(report, i, values[2 + i] & ((1ull << 40) - 1));
+         for (int i = 0; i < 4; i++)
+            report[36 + i] = values[34 + i];
+         for (int i = 0; i < 16; i++)
+            report[48 + i] = values[38 + i];
+         break;
+
+      case I915_OA_FORMAT_A45_B8_C8:
+         report[1] = values[0];
+         for (int i = 0; i < 61; i++)
+            report[3 + i] = values[1 + i];
+         break;
+
+      default:
+         unreachable("unknown OA format");
+      }
+   }
+}
+
+static int
+format_n_counters(int oa_format)
+{
+   return oa_format == I915_OA_FORMAT_A45_B8_C8 ? 62 : 54;
+}
+
+static void
+test_accumulate(int oa_format)
+{
+   struct gen_perf_query_info query = { .oa_format = oa_format };
+   struct gen_perf_query_result result;
+   struct stream s;
+
+   generate_stream(&s, oa_format, 1000);
+
+   gen_perf_query_result_clear(&result);
+   gen_perf_query_result_accumulate_reports(&result, &query, s.reports[0],
+                                            sizeof(s.reports[0]),
+                                            s.n_reports);
+
+   assert(result.reports_accumulated == s.n_reports - 1);
+   assert(result.hw_id == CTX_ID);
+   assert(result.begin_timestamp == s.reports[0][1]);
+   for (int i = 0; i < format_n_counters(oa_format); i++) {
+      if (result.accumulator[i] != s.expected[i]) {
+         fprintf(stderr, "format %d, counter %d: got %llu, expected %llu\n",
+                 oa_format, i, (unsigned long long)result.accumulator[i],
+                 (unsigned long long)s.expected[i]);
+         abort();
+      }
+   }
+
+   /* Accumulating pair by pair must give the same result. */
+   struct gen_perf_query_result pairwise;
+   gen_perf_query_result_clear(&pairwise);
+   for (uint32_t r = 1; r < s.n_reports; r++) {
+      gen_perf_query_result_accumulate(&pairwise, &query,
+                                       s.reports[r - 1], s.reports[r]);
+   }
+   assert(memcmp(&pairwise, &result, sizeof(result)) == 0);
+
+   free(s.reports);
+}
+
+static struct gen_perf_config *
+create_perf(void)
+{
+   struct gen_perf_config *perf = rzalloc(NULL, struct gen_perf_config);
+
+   perf->sys_vars.timestamp_frequency = 12000000;
+   perf->sys_vars.n_eus = 24;
+   perf->sys_vars.n_eu_slices = 1;
+   perf->sys_vars.n_eu_sub_slices = 3;
+   perf->sys_vars.eu_threads_count = 7;
+   perf->sys_vars.slice_mask = 0x1;
+   perf->sys_vars.subslice_mask = 0x7;
+   perf->sys_vars.gt_min_freq = 300000000;
+   perf->sys_vars.gt_max_freq = 1150000000;
+
+   perf->oa_metrics_table =
+      _mesa_hash_table_create(perf, _mesa_key_hash_string,
+                              _mesa_key_string_equal);
+
+   return perf;
+}
+
+/* Builds one result per interval of the stream, the way a profiler looking
+ * at a sampled OA stream would.
+ */
+static struct gen_perf_query_result *
+interval_results(const struct gen_perf_query_info *query,
+                 const struct stream *s)
+{
+   struct gen_perf_query_result *results =
+      calloc(s->n_reports - 1, sizeof(*results));
+
+   for (uint32_t r = 1; r < s->n_reports; r++) {
+      gen_perf_query_result_clear(&results[r - 1]);
+      gen_perf_query_result_accumulate(&results[r - 1], query,
+                                       s->reports[r - 1], s->reports[r]);
+   }
+
+   return results;
+}
+
+static void
+test_read_counters(struct gen_perf_config *perf,
+                   const struct gen_perf_query_info *query)
+{
+   struct stream s;
+   generate_stream(&s, query->oa_format, 64);
+
+   uint32_t n_results = s.n_reports - 1;
+   struct gen_perf_query_result *results = interval_results(query, &s);
+   uint8_t *data = calloc(n_results, query->data_size);
+   gen_perf_query_result_read_counters(perf, query, results, n_results, data);
+
+   uint8_t *expected = calloc(1, query->data_size);
+   for (uint32_t r = 0; r < n_results; r++) {
+      memset(expected, 0, query->data_size);
+
+      for (int i = 0; i < query->n_counters; i++) {
+         const struct gen_perf_query_counter *counter = &query->counters[i];
+
+         switch (counter->data_type) {
+         case GEN_PERF_COUNTER_DATA_TYPE_UINT64:
+            *(uint64_t *)(expected + counter->offset) =
+               counter->oa_counter_read_uint64(perf, query,
+                                               results[r].accumulator);
+            break;
+         case GEN_PERF_COUNTER_DATA_TYPE_FLOAT:
+            *(float *)(expected + counter->offset) =
+               counter->oa_counter_read_float(perf, query,
+                                              results[r].accumulator);
+            break;
+         default:
+            break;
+         }
+      }
+
+      if (memcmp(expected, data + r * query->data_size, query->data_size)) {
+         fprintf(stderr, "%s: result %u differs\n", query->name, r);
+         abort();
+      }
+   }
+
+   free(expected);
+   free(data);
+   free(results);
+   free(s.reports);
+}
+
+static void
+test_metric_sets(void (*oa_register)(struct gen_perf_config *perf))
+{
+   struct gen_perf_config *perf = create_perf();
+
+   oa_register(perf);
+   hash_table_foreach(perf->oa_metrics_table, entry)
+      test_read_counters(perf, entry->data);
+
+   ralloc_free(perf);
+}
+
+static void
+bench(void)
+{
+   const uint32_t n_reports = 1 << 16;
+   const int iterations = 32;
+   struct gen_perf_config *perf = create_perf();
+   struct stream s;
+
+   gen_oa_register_queries_sklgt2(perf);
+   const struct gen_perf_query_info *query = NULL;
+   hash_table_foreach(perf->oa_metrics_table, entry) {
+      query = entry->data;
+      if (strcmp(query->name, "Render Metrics Basic Gen9") == 0)
+         break;
+   }
+
+   generate_stream(&s, query->oa_format, n_reports);
+
+   struct gen_perf_query_result result;
+   int64_t start = os_time_get_nano();
+   for (int i = 0; i < iterations; i++) {
+      gen_perf_query_result_clear(&result);
+      gen_perf_query_result_accumulate_reports(&result, query, s.reports[0],
+                                               sizeof(s.reports[0]),
+                                               s.n_reports);
+   }
+   int64_t accumulate_ns = os_time_get_nano() - start;
+
+   uint32_t n_results = n_reports - 1;
+   struct gen_perf_query_result *results = interval_results(query, &s);
+   uint8_t *data = malloc((size_t)n_results * query->data_size);
+
+   start = os_time_get_nano();
+   for (int i = 0; i < iterations; i++)
+      gen_perf_query_result_read_counters(perf, query, results, n_results, data);
+   int64_t read_ns = os_time_get_nano() - start;
+
+   double n = (double)iterations * n_results;
+   printf("accumulate: %.1f Mreports/s\n", n * 1000.0 / accumulate_ns);
+   printf("%s (%d counters): %.1f Mresults/s\n", query->name,
+          query->n_counters, n * 1000.0 / read_ns);
+
+   free(data);
+   free(results);
+   free(s.reports);
+   ralloc_free(perf);
+}
+
+int
+main(int argc, char **argv)
+{
+   if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+      bench();
+      return 0;
+   }
+
+   test_accumulate(I915_OA_FORMAT_A32u40_A4u32_B8_C8);
+   test_accumulate(I915_OA_FORMAT_A45_B8_C8);
+
+   test_metric_sets(gen_oa_register_queries_hsw);
+   test_metric_sets(gen_oa_register_queries_sklgt2);
+   test_metric_sets(gen_oa_register_queries_icl);
+
+   return 0;
+}
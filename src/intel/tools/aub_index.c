@@ -0,0 +1,418 @@
+/*
+ * Copyright © 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "util/macros.h"
+#include "util/u_dynarray.h"
+
+#include "aub_index.h"
+
+#define AUB_INDEX_MAGIC "AUBINDEX"
+#define AUB_INDEX_VERSION 2
+
+/* Followed by the execs, then the writes */
+struct aub_index_header {
+   char magic[8];
+   uint32_t version;
+   uint32_t n_execs;
+   uint64_t n_writes;
+   uint64_t aub_size;
+   int64_t aub_mtime_sec;
+   int64_t aub_mtime_nsec;
+   int32_t pci_id;
+   char app_name[64];
+   uint32_t pad;
+};
+
+struct index_builder {
+   struct aub_index *index;
+   const uint8_t *map;
+   struct util_dynarray writes;
+   struct util_dynarray execs;
+   bool has_info;
+};
+
+static void
+handle_error(void *user_data, const void *aub_data, const char *msg)
+{
+   fprintf(stderr, "%s", msg);
+}
+
+static void
+handle_info(void *user_data, int pci_id, const char *app_name)
+{
+   struct index_builder *builder = user_data;
+
+   if (builder->has_info)
+      return;
+
+   builder->has_info = true;
+   builder->index->pci_id = pci_id;
+   snprintf(builder->index->app_name, sizeof(builder->index->app_name),
+            "%s", app_name);
+}
+
+static void
+add_write(struct index_builder *builder, enum aub_index_write_type type,
+          uint64_t address, const void *data, uint32_t size)
+{
+   struct aub_index_write write = {
+      .offset = (const uint8_t *)data - builder->map,
+      .address = address,
+      .size = size,
+      .type = type,
+   };
+   util_dynarray_append(&builder->writes, struct aub_index_write, write);
+}
+
+static void
+handle_local_write(void *user_data, uint64_t address,
+                   const void *data, uint32_t size)
+{
+   add_write(user_data, AUB_INDEX_LOCAL_WRITE, address, data, size);
+}
+
+static void
+handle_phys_write(void *user_data, uint64_t address,
+                  const void *data, uint32_t size)
+{
+   add_write(user_data, AUB_INDEX_PHYS_WRITE, address, data, size);
+}
+
+static void
+handle_ggtt_write(void *user_data, uint64_t address,
+                  const void *data, uint32_t size)
+{
+   add_write(user_data, AUB_INDEX_GGTT_WRITE, address, data, size);
+}
+
+static void
+handle_ggtt_entry_write(void *user_data, uint64_t address,
+                        const void *data, uint32_t size)
+{
+   add_write(user_data, AUB_INDEX_GGTT_ENTRY_WRITE, address, data, size);
+}
+
+static void
+add_exec(struct index_builder *builder, enum aub_index_exec_type type,
+         enum drm_i915_gem_engine_class engine, uint64_t value, uint32_t size)
+{
+   struct aub_index_exec exec = {
+      .n_writes_before = util_dynarray_num_elements(&builder->writes,
+                                                    struct aub_index_write),
+      .value = value,
+      .size = size,
+      .engine = engine,
+      .type = type,
+   };
+   util_dynarray_append(&builder->execs, struct aub_index_exec, exec);
+}
+
+static void
+handle_ring_write(void *user_data, enum drm_i915_gem_engine_class engine,
+                  const void *data, uint32_t data_len)
+{
+   struct index_builder *builder = user_data;
+
+   add_exec(builder, AUB_INDEX_RING_WRITE, engine,
+            (const uint8_t *)data - builder->map, data_len);
+}
+
+static void
+handle_execlist_write(void *user_data, enum drm_i915_gem_engine_class engine,
+                      uint64_t context_descriptor)
+{
+   add_exec(user_data, AUB_INDEX_EXECLIST_WRITE, engine,
+            context_descriptor, 0);
+}
+
+static bool
+aub_index_build(struct aub_index *index, const void *map, uint64_t size)
+{
+   struct index_builder builder = {
+      .index = index,
+      .map = map,
+   };
+   struct aub_read read = {
+      .user_data = &builder,
+      .error = handle_error,
+      .info = handle_info,
+      .local_write = handle_local_write,
+      .phys_write = handle_phys_write,
+      .ggtt_write = handle_ggtt_write,
+      .ggtt_entry_write = handle_ggtt_entry_write,
+      .ring_write = handle_ring_write,
+      .execlist_write = handle_execlist_write,
+   };
+
+   util_dynarray_init(&builder.writes, NULL);
+   util_dynarray_init(&builder.execs, NULL);
+
+   uint64_t offset = 0;
+   int consumed;
+   while (offset < size &&
+          (consumed = aub_read_command(&read, builder.map + offset,
+                                       MIN2(size - offset, UINT32_MAX))) > 0)
+      offset += consumed;
+
+   if (!builder.has_info) {
+      util_dynarray_fini(&builder.writes);
+      util_dynarray_fini(&builder.execs);
+      return false;
+   }
+
+   index->writes_storage = builder.writes.data;
+   index->writes = builder.writes.data;
+   index->n_writes = util_dynarray_num_elements(&builder.writes,
+                                                struct aub_index_write);
+   index->execs_storage = builder.execs.data;
+   index->execs = builder.execs.data;
+   index->n_execs = util_dynarray_num_elements(&builder.execs,
+                                               struct aub_index_exec);
+   return true;
+}
+
+static bool
+aub_index_load(struct aub_index *index, const char *path,
+               const struct aub_index_header *expected)
+{
+   int fd = open(path, O_RDONLY);
+   if (fd == -1)
+      return false;
+
+   struct stat sb;
+   if (fstat(fd, &sb) == -1 || sb.st_size < (off_t)sizeof(*expected)) {
+      close(fd);
+      return false;
+   }
+
+   void *map = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (map == MAP_FAILED)
+      return false;
+
+   const struct aub_index_header *header = map;
+   if (memcmp(header->magic, expected->magic, sizeof(header->magic)) != 0 ||
+       header->version != expected->version ||
+       header->aub_size != expected->aub_size ||
+       header->aub_mtime_sec != expected->aub_mtime_sec ||
+       header->aub_mtime_nsec != expected->aub_mtime_nsec ||
+       sb.st_size != sizeof(*header) +
+                     header->n_execs * sizeof(struct aub_index_exec) +
+                     header->n_writes * sizeof(struct aub_index_write)) {
+      munmap(map, sb.st_size);
+      return false;
+   }
+
+   index->map = map;
+   index->map_size = sb.st_size;
+   index->pci_id = header->pci_id;
+   memcpy(index->app_name, header->app_name, sizeof(index->app_name));
+   index->app_name[sizeof(index->app_name) - 1] = '\0';
+   index->execs = (const void *)(header + 1);
+   index->n_execs = header->n_execs;
+   index->writes = (const void *)(index->execs + index->n_execs);
+   index->n_writes = header->n_writes;
+
+   return true;
+}
+
+/* Written to a temporary file first, so that a concurrent reader never
+ * sees a partial index.
+ */
+static void
+aub_index_save(const struct aub_index *index, const char *path,
+               const struct aub_index_header *header)
+{
+   char *tmp_path = malloc(strlen(path) + 8);
+   if (!tmp_path)
+      return;
+   sprintf(tmp_path, "%s.XXXXXX", path);
+
+   int fd = mkstemp(tmp_path);
+   if (fd == -1) {
+      free(tmp_path);
+      return;
+   }
+
+   /* mkstemp() ignores the umask, unlike creating the file normally */
+   mode_t mask = umask(0);
+   umask(mask);
+   fchmod(fd, 0666 & ~mask);
+
+   FILE *f = fdopen(fd, "wb");
+   if (!f) {
+      close(fd);
+      unlink(tmp_path);
+      free(tmp_path);
+      return;
+   }
+
+   bool ok =
+      fwrite(header, sizeof(*header), 1, f) == 1 &&
+      fwrite(index->execs, sizeof(*index->execs), index->n_execs, f) ==
+      index->n_execs &&
+      fwrite(index->writes, sizeof(*index->writes), index->n_writes, f) ==
+      index->n_writes;
+
+   if (fclose(f) != 0 || !ok || rename(tmp_path, path) != 0)
+      unlink(tmp_path);
+   free(tmp_path);
+}
+
+/**
+ * Fills in the index for the AUB file FILENAME, mapped at MAP.  Fails if
+ * the file can't be stat'ed or doesn't say what device it was recorded on;
+ * not being able to read or write the saved index just means it gets
+ * rebuilt.
+ */
+bool
+aub_index_init(struct aub_index *index, const char *filename,
+               const void *map, uint64_t size)
+{
+   memset(index, 0, sizeof(*index));
+
+   struct stat sb;
+   if (stat(filename, &sb) == -1)
+      return false;
+
+   struct aub_index_header header = {
+      .magic = AUB_INDEX_MAGIC,
+      .version = AUB_INDEX_VERSION,
+      .aub_size = size,
+      .aub_mtime_sec = sb.st_mtim.tv_sec,
+      .aub_mtime_nsec = sb.st_mtim.tv_nsec,
+   };
+
+   char *path = malloc(strlen(filename) + 5);
+   if (!path)
+      return false;
+   sprintf(path, "%s.idx", filename);
+
+   bool ok = aub_index_load(index, path, &header);
+   if (!ok) {
+      ok = aub_index_build(index, map, size);
+      if (ok) {
+         header.n_execs = index->n_execs;
+         header.n_writes = index->n_writes;
+         header.pci_id = index->pci_id;
+         memcpy(header.app_name, index->app_name, sizeof(header.app_name));
+         aub_index_save(index, path, &header);
+      }
+   }
+
+   free(path);
+   return ok;
+}
+
+void
+aub_index_finish(struct aub_index *index)
+{
+   if (index->map)
+      munmap(index->map, index->map_size);
+   free(index->writes_storage);
+   free(index->execs_storage);
+   memset(index, 0, sizeof(*index));
+}
+
+static void
+replay_writes(const struct aub_index *index, const uint8_t *map,
+              struct aub_read *read, uint64_t begin, uint64_t end,
+              uint64_t first_local_write)
+{
+   for (uint64_t i = begin; i < end; i++) {
+      const struct aub_index_write *w = &index->writes[i];
+      void (*write)(void *user_data, uint64_t address,
+                    const void *data, uint32_t size) = NULL;
+
+      switch (w->type) {
+      case AUB_INDEX_LOCAL_WRITE:
+         if (i >= first_local_write)
+            write = read->local_write;
+         break;
+      case AUB_INDEX_PHYS_WRITE:
+         write = read->phys_write;
+         break;
+      case AUB_INDEX_GGTT_WRITE:
+         write = read->ggtt_write;
+         break;
+      case AUB_INDEX_GGTT_ENTRY_WRITE:
+         write = read->ggtt_entry_write;
+         break;
+      }
+
+      if (write)
+         write(read->user_data, w->address, map + w->offset, w->size);
+   }
+}
+
+/**
+ * Calls READ's callbacks the way aub_read_command() would for the whole
+ * file, except that only batches FIRST to LAST are submitted.  The memory
+ * writes in front of FIRST are replayed from the index, so none of the
+ * commands before it are read.
+ *
+ * Legacy local writes only last until the next batch (aub_mem drops them
+ * in aub_mem_clear_bo_maps()), so those before the batch preceding FIRST
+ * are left out.
+ */
+void
+aub_index_replay(const struct aub_index *index, const void *map,
+                 struct aub_read *read, uint32_t first, uint32_t last)
+{
+   if (read->info)
+      read->info(read->user_data, index->pci_id, index->app_name);
+
+   uint64_t n_writes = 0;
+   uint64_t first_local_write =
+      first > 0 && first <= index->n_execs ?
+      index->execs[first - 1].n_writes_before : 0;
+
+   for (uint32_t i = first; i <= last && i < index->n_execs; i++) {
+      const struct aub_index_exec *exec = &index->execs[i];
+
+      replay_writes(index, map, read, n_writes, exec->n_writes_before,
+                    first_local_write);
+      n_writes = exec->n_writes_before;
+
+      switch (exec->type) {
+      case AUB_INDEX_RING_WRITE:
+         if (read->ring_write)
+            read->ring_write(read->user_data, exec->engine,
+                             (const uint8_t *)map + exec->value, exec->size);
+         break;
+      case AUB_INDEX_EXECLIST_WRITE:
+         if (read->execlist_write)
+            read->execlist_write(read->user_data, exec->engine, exec->value);
+         break;
+      }
+   }
+}
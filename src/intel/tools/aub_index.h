@@ -0,0 +1,106 @@
+/*
+ * Copyright © 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#ifndef INTEL_AUB_INDEX
+#define INTEL_AUB_INDEX
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aub_read.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum aub_index_write_type {
+   AUB_INDEX_LOCAL_WRITE,
+   AUB_INDEX_PHYS_WRITE,
+   AUB_INDEX_GGTT_WRITE,
+   AUB_INDEX_GGTT_ENTRY_WRITE,
+};
+
+struct aub_index_write {
+   /* Offset of the written data in the AUB file */
+   uint64_t offset;
+   uint64_t address;
+   uint32_t size;
+   uint32_t type;
+};
+
+enum aub_index_exec_type {
+   AUB_INDEX_RING_WRITE,
+   AUB_INDEX_EXECLIST_WRITE,
+};
+
+struct aub_index_exec {
+   /* Number of memory writes before this batch is submitted */
+   uint64_t n_writes_before;
+   /* Offset of the ring data in the AUB file, or the context descriptor */
+   uint64_t value;
+   /* Size of the ring data, 0 for execlist submissions */
+   uint32_t size;
+   uint32_t engine;
+   uint32_t type;
+   uint32_t pad;
+};
+
+/**
+ * The memory writes and batch submissions of an AUB file, in file order,
+ * along with where their data is in the file.
+ *
+ * This is enough to get the memory contents at any batch without reading
+ * the commands in front of it.  Building it needs a pass over the whole
+ * file though, so the result is saved next to it as FILENAME.idx, and
+ * mapped from there for as long as the AUB file's size and modification
+ * time don't change.
+ */
+struct aub_index {
+   int pci_id;
+   char app_name[64];
+
+   const struct aub_index_write *writes;
+   uint64_t n_writes;
+   const struct aub_index_exec *execs;
+   uint32_t n_execs;
+
+   /* Private */
+   void *map;
+   size_t map_size;
+   void *writes_storage;
+   void *execs_storage;
+};
+
+bool aub_index_init(struct aub_index *index, const char *filename,
+                    const void *map, uint64_t size);
+void aub_index_finish(struct aub_index *index);
+
+void aub_index_replay(const struct aub_index *index, const void *map,
+                      struct aub_read *read, uint32_t first, uint32_t last);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INTEL_AUB_INDEX */
@@ -28,6 +28,7 @@
 
 #include "aub_mem.h"
 #include "util/anon_file.h"
+#include "util/u_dynarray.h"
 
 struct bo_map {
    struct list_head link;
@@ -42,12 +43,21 @@ struct ggtt_entry {
    uint64_t phys_addr;
 };
 
+struct phys_mem_write {
+   const uint8_t *data;
+   uint16_t offset;
+   uint16_t size;
+};
+
 struct phys_mem {
    struct rb_node node;
    uint64_t fd_offset;
    uint64_t phys_addr;
+   /* Backing page in mem_fd, only allocated when the page is first read */
    uint8_t *data;
    const uint8_t *aub_data;
+   /* Writes that haven't been applied to data yet, oldest first */
+   struct util_dynarray pending;
 };
 
 static void
@@ -144,20 +154,38 @@ ensure_phys_mem(struct aub_mem *mem, uint64_t phys_addr)
    if (!node || (cmp = cmp_phys_mem(node, &phys_addr))) {
       struct phys_mem *new_mem = calloc(1, sizeof(*new_mem));
       new_mem->phys_addr = phys_addr;
-      new_mem->fd_offset = mem->mem_fd_len;
+      util_dynarray_init(&new_mem->pending, NULL);
+      rb_tree_insert_at(&mem->mem, node, &new_mem->node, cmp < 0);
+      node = &new_mem->node;
+   }
+
+   return rb_node_data(struct phys_mem, node, node);
+}
+
+/**
+ * Brings a page up to date before it gets read.
+ *
+ * Page contents are only copied out of the AUB file on first use, so that
+ * the large buffer uploads of a trace that the decoder never looks at don't
+ * end up duplicated in mem_fd.
+ */
+static void
+phys_mem_flush(struct aub_mem *mem, struct phys_mem *pmem)
+{
+   if (!pmem->data) {
+      pmem->fd_offset = mem->mem_fd_len;
 
       ASSERTED int ftruncate_res = ftruncate(mem->mem_fd, mem->mem_fd_len += 4096);
       assert(ftruncate_res == 0);
 
-      new_mem->data = mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_SHARED,
-                           mem->mem_fd, new_mem->fd_offset);
-      assert(new_mem->data != MAP_FAILED);
-
-      rb_tree_insert_at(&mem->mem, node, &new_mem->node, cmp < 0);
-      node = &new_mem->node;
+      pmem->data = mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        mem->mem_fd, pmem->fd_offset);
+      assert(pmem->data != MAP_FAILED);
    }
 
-   return rb_node_data(struct phys_mem, node, node);
+   util_dynarray_foreach(&pmem->pending, struct phys_mem_write, w)
+      memcpy(pmem->data + w->offset, w->data, w->size);
+   util_dynarray_clear(&pmem->pending);
 }
 
 static struct phys_mem *
@@ -170,7 +198,10 @@ search_phys_mem(struct aub_mem *mem, uint64_t phys_addr)
    if (!node)
       return NULL;
 
-   return rb_node_data(struct phys_mem, node, node);
+   struct phys_mem *pmem = rb_node_data(struct phys_mem, node, node);
+   phys_mem_flush(mem, pmem);
+
+   return pmem;
 }
 
 void
@@ -213,7 +244,16 @@ aub_mem_phys_write(void *_mem, uint64_t phys_address,
       uint64_t offset = MAX2(page, phys_address) - page;
       uint32_t size_this_page = MIN2(to_write, 4096 - offset);
       to_write -= size_this_page;
-      memcpy(pmem->data + offset, data, size_this_page);
+
+      /* A write of the whole page makes the earlier ones irrelevant. */
+      if (size_this_page == 4096)
+         util_dynarray_clear(&pmem->pending);
+      struct phys_mem_write w = {
+         .data = data,
+         .offset = offset,
+         .size = size_this_page,
+      };
+      util_dynarray_append(&pmem->pending, struct phys_mem_write, w);
       pmem->aub_data = data - offset;
       data = (const uint8_t *)data + size_this_page;
    }
@@ -384,6 +424,7 @@ aub_mem_fini(struct aub_mem *mem)
    }
    rb_tree_foreach_safe(struct phys_mem, entry, &mem->mem, node) {
       rb_tree_remove(&mem->mem, &entry->node);
+      util_dynarray_fini(&entry->pending);
       free(entry);
    }
 
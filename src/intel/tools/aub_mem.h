@@ -48,6 +48,10 @@ struct aub_mem {
    struct rb_tree mem;
 };
 
+/* The write functions keep pointers to the data they are given rather than
+ * copying it, so it has to stay valid (normally, the AUB file has to stay
+ * mapped) for as long as the aub_mem is in use.
+ */
 bool aub_mem_init(struct aub_mem *mem);
 void aub_mem_fini(struct aub_mem *mem);
 
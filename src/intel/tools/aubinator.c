@@ -40,6 +40,7 @@
 
 #include "util/macros.h"
 
+#include "aub_index.h"
 #include "aub_read.h"
 #include "aub_mem.h"
 
@@ -53,6 +54,8 @@
 static int option_full_decode = true;
 static int option_print_offsets = true;
 static int max_vbo_lines = -1;
+static bool option_range = false;
+static uint32_t option_range_first = 0, option_range_last = UINT32_MAX;
 static enum { COLOR_AUTO, COLOR_ALWAYS, COLOR_NEVER } option_color;
 
 /* state */
@@ -268,6 +271,34 @@ setup_pager(void)
    close(fds[1]);
 }
 
+static bool
+parse_range(const char *arg)
+{
+   char *end;
+
+   option_range = true;
+   option_range_first = strtoul(arg, &end, 0);
+   if (end == arg)
+      return false;
+
+   if (*end == '\0') {
+      option_range_last = option_range_first;
+      return true;
+   }
+   if (*end != ':')
+      return false;
+
+   arg = end + 1;
+   if (*arg == '\0') {
+      option_range_last = UINT32_MAX;
+      return true;
+   }
+
+   option_range_last = strtoul(arg, &end, 0);
+   return end != arg && *end == '\0' &&
+          option_range_first <= option_range_last;
+}
+
 static void
 print_help(const char *progname, FILE *file)
 {
@@ -282,6 +313,12 @@ print_help(const char *progname, FILE *file)
            "      --max-vbo-lines=N  limit the number of decoded VBO lines\n"
            "      --no-pager         don't launch pager\n"
            "      --no-offsets       don't print instruction offsets\n"
+           "      --range=FIRST[:LAST]\n"
+           "                         only decode batches FIRST to LAST (counting\n"
+           "                         from 0, LAST defaults to FIRST, \"FIRST:\" runs\n"
+           "                         to the end), without reading the commands in\n"
+           "                         between; this uses an index of FILE, which is\n"
+           "                         saved as FILE.idx when possible\n"
            "      --xml=DIR          load hardware xml description from directory DIR\n",
            progname);
 }
@@ -300,6 +337,7 @@ int main(int argc, char *argv[])
       { "color",         required_argument, NULL,                          'c' },
       { "xml",           required_argument, NULL,                          'x' },
       { "max-vbo-lines", required_argument, NULL,                          'v' },
+      { "range",         required_argument, NULL,                          'r' },
       { NULL,            0,                 NULL,                          0 }
    };
 
@@ -338,6 +376,12 @@ int main(int argc, char *argv[])
       case 'v':
          max_vbo_lines = atoi(optarg);
          break;
+      case 'r':
+         if (!parse_range(optarg)) {
+            fprintf(stderr, "invalid value for --range: %s\n", optarg);
+            exit(EXIT_FAILURE);
+         }
+         break;
       default:
          break;
       }
@@ -383,11 +427,31 @@ int main(int argc, char *argv[])
       .execlist_write = handle_execlist_write,
       .ring_write = handle_ring_write,
    };
-   int consumed;
-   while (aub_file_more_stuff(file) &&
-          (consumed = aub_read_command(&aub_read, file->cursor,
-                                       file->end - file->cursor)) > 0) {
-      file->cursor += consumed;
+
+   if (option_range) {
+      struct aub_index index;
+      if (!aub_index_init(&index, input_file, file->map,
+                          (uint8_t *)file->end - (uint8_t *)file->map)) {
+         fprintf(stderr, "Unable to index %s\n", input_file);
+         exit(EXIT_FAILURE);
+      }
+
+      if (option_range_first >= index.n_execs) {
+         fprintf(stderr, "--range starts at batch %u, but %s only has %u\n",
+                 option_range_first, input_file, index.n_execs);
+         exit(EXIT_FAILURE);
+      }
+
+      aub_index_replay(&index, file->map, &aub_read,
+                       option_range_first, option_range_last);
+      aub_index_finish(&index);
+   } else {
+      int consumed;
+      while (aub_file_more_stuff(file) &&
+             (consumed = aub_read_command(&aub_read, file->cursor,
+                                          file->end - file->cursor)) > 0) {
+         file->cursor += consumed;
+      }
    }
 
    aub_mem_fini(&mem);
@@ -0,0 +1,67 @@
+#!/bin/sh
+#
+# Checks that aubinator --range decodes batches exactly like a full decode
+# of the trace does, by splitting the trace into ranges and putting the
+# decoded ranges back together.
+
+AUBINATOR="$1"
+GEN_RANGE_AUB="$2"
+N_BATCHES=12
+
+tmpdir=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmpdir"' EXIT
+
+aub="$tmpdir/range.aub"
+"$GEN_RANGE_AUB" "$aub" || exit 1
+
+decode() {
+   "$AUBINATOR" --no-pager --color=never "$@" "$aub"
+}
+
+# Everything after the header and the blank line following it, which are
+# printed once per run
+batches() {
+   awk 'decoding { print } /^Decoding as:/ { getline; decoding = 1 }'
+}
+
+decode > "$tmpdir/full" || exit 1
+batches < "$tmpdir/full" > "$tmpdir/full.batches"
+
+status=0
+check() {
+   if cmp -s "$tmpdir/full" "$tmpdir/split"; then
+      echo "$1 : PASS"
+   else
+      echo "$1 : FAIL"
+      diff -u "$tmpdir/full" "$tmpdir/split" | head -n 40
+      status=1
+   fi
+}
+
+# Twice each, so that the second run goes through the saved index
+for pass in build saved; do
+   for first in 1 5 6 11; do
+      decode --range=0:$((first - 1)) > "$tmpdir/split" &&
+      decode --range=$first: | batches >> "$tmpdir/split"
+      check "--range split at $first ($pass index)"
+   done
+done
+
+# One batch at a time
+decode --range=0 > "$tmpdir/split"
+i=1
+while [ $i -lt $N_BATCHES ]; do
+   decode --range=$i | batches >> "$tmpdir/split"
+   i=$((i + 1))
+done
+check "--range one batch at a time"
+
+# Out of range
+if decode --range=$N_BATCHES > /dev/null 2>&1; then
+   echo "--range past the end : FAIL"
+   status=1
+else
+   echo "--range past the end : PASS"
+fi
+
+exit $status
@@ -0,0 +1,113 @@
+/*
+ * Copyright © 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+/* Writes a small KBL trace for aubinator-range-test.sh.  Every batch tells
+ * which one it is, and the second level batch they call into is changed
+ * half way through, so decoding a batch with the wrong memory contents
+ * shows in the output.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aub_write.h"
+#include "intel_aub.h"
+
+#define N_BATCHES 12
+
+#define BATCH_ADDR        0x10000000
+#define SECOND_LEVEL_ADDR 0x20000000
+#define DATA_ADDR         0x30000000
+
+#define MI_NOOP_ID(id)         ((1 << 22) | (id))
+#define MI_BATCH_BUFFER_START  0x18800101
+#define MI_SECOND_LEVEL        (1 << 22)
+#define MI_BATCH_BUFFER_END    0x05000000
+
+static void
+write_second_level(struct aub_file *aub, uint32_t id, uint64_t offset)
+{
+   uint32_t batch[] = {
+      MI_NOOP_ID(id),
+      MI_BATCH_BUFFER_END,
+   };
+   aub_write_trace_block(aub, AUB_TRACE_TYPE_BATCH, batch, sizeof(batch),
+                         SECOND_LEVEL_ADDR + offset);
+}
+
+int
+main(int argc, char **argv)
+{
+   if (argc != 2) {
+      fprintf(stderr, "usage: %s FILE\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   FILE *f = fopen(argv[1], "wb");
+   if (!f) {
+      perror(argv[1]);
+      return EXIT_FAILURE;
+   }
+
+   struct aub_file aub;
+   aub_file_init(&aub, f, NULL, 0x591b /* KBL GT2 */, "range test");
+   aub_write_default_setup(&aub);
+   uint32_t ctx = aub_write_context_create(&aub, NULL);
+
+   aub_map_ppgtt(&aub, BATCH_ADDR, 4096);
+   aub_map_ppgtt(&aub, SECOND_LEVEL_ADDR, 4096);
+   aub_map_ppgtt(&aub, DATA_ADDR, 16 * 4096);
+
+   /* Only written once, before the first batch */
+   write_second_level(&aub, 0x1000, 0);
+
+   static uint8_t data[16 * 4096];
+   for (uint32_t i = 0; i < N_BATCHES; i++) {
+      /* Some unrelated uploads between batches */
+      memset(data, i, sizeof(data));
+      aub_write_trace_block(&aub, AUB_TRACE_TYPE_NOTYPE, data,
+                            (i % 16 + 1) * 4096 - 100, DATA_ADDR + 36);
+
+      if (i == N_BATCHES / 2)
+         write_second_level(&aub, 0x2000, 0);
+
+      uint32_t batch[] = {
+         MI_NOOP_ID(i),
+         MI_BATCH_BUFFER_START | MI_SECOND_LEVEL,
+         SECOND_LEVEL_ADDR,
+         0,
+         MI_NOOP_ID(0x100 + i),
+         MI_BATCH_BUFFER_END,
+      };
+      aub_write_trace_block(&aub, AUB_TRACE_TYPE_BATCH, batch, sizeof(batch),
+                            BATCH_ADDR);
+      aub_write_exec(&aub, ctx, BATCH_ADDR, 0, I915_ENGINE_CLASS_RENDER);
+   }
+
+   /* Closes f */
+   aub_file_finish(&aub);
+
+   return EXIT_SUCCESS;
+}
@@ -97,6 +97,8 @@ anv_device_init_blorp(struct anv_device *device)
    device->blorp.compiler = device->instance->physicalDevice.compiler;
    device->blorp.lookup_shader = lookup_blorp_shader;
    device->blorp.upload_shader = upload_blorp_shader;
+   if (device->instance->pipeline_cache_enabled)
+      device->blorp.disk_cache = device->instance->physicalDevice.disk_cache;
    switch (device->info.gen) {
    case 7:
       if (device->info.is_haswell) {
@@ -283,6 +285,28 @@ get_blorp_surf_for_anv_shadow_image(const struct anv_device *device,
    return true;
 }
 
+/* Whether two regions of a vkCmdCopyImage copy between the same array
+ * layers, so that they can be passed to blorp_copy_rects() together.
+ */
+static bool
+copy_regions_share_subresources(const struct anv_image *src_image,
+                                const struct anv_image *dst_image,
+                                const VkImageCopy *a, const VkImageCopy *b)
+{
+   if (src_image->type == VK_IMAGE_TYPE_3D ||
+       dst_image->type == VK_IMAGE_TYPE_3D)
+      return false;
+
+   return a->srcSubresource.aspectMask == b->srcSubresource.aspectMask &&
+          a->srcSubresource.mipLevel == b->srcSubresource.mipLevel &&
+          a->srcSubresource.baseArrayLayer == b->srcSubresource.baseArrayLayer &&
+          a->srcSubresource.layerCount == b->srcSubresource.layerCount &&
+          a->dstSubresource.aspectMask == b->dstSubresource.aspectMask &&
+          a->dstSubresource.mipLevel == b->dstSubresource.mipLevel &&
+          a->dstSubresource.baseArrayLayer == b->dstSubresource.baseArrayLayer &&
+          a->dstSubresource.layerCount == b->dstSubresource.layerCount;
+}
+
 void anv_CmdCopyImage(
     VkCommandBuffer                             commandBuffer,
     VkImage                                     srcImage,
@@ -373,6 +397,37 @@ void anv_CmdCopyImage(
             }
          }
       } else {
+         /* The following regions which copy between the same layers are
+          * done along with this one, so that blorp can draw them with a
+          * single primitive.
+          */
+         struct blorp_copy_rect rects[16];
+         uint32_t num_rects = 0;
+         do {
+            rects[num_rects++] = (struct blorp_copy_rect) {
+               .src_x = srcOffset.x,
+               .src_y = srcOffset.y,
+               .dst_x = dstOffset.x,
+               .dst_y = dstOffset.y,
+               .width = extent.width,
+               .height = extent.height,
+            };
+
+            if (num_rects == ARRAY_SIZE(rects) || r + 1 == regionCount ||
+                !copy_regions_share_subresources(src_image, dst_image,
+                                                 &pRegions[r],
+                                                 &pRegions[r + 1]))
+               break;
+
+            r++;
+            srcOffset =
+               anv_sanitize_image_offset(src_image->type, pRegions[r].srcOffset);
+            dstOffset =
+               anv_sanitize_image_offset(dst_image->type, pRegions[r].dstOffset);
+            extent =
+               anv_sanitize_image_extent(src_image->type, pRegions[r].extent);
+         } while (true);
+
          struct blorp_surf src_surf, dst_surf;
          get_blorp_surf_for_anv_image(cmd_buffer->device, src_image, src_mask,
                                       srcImageLayout, ISL_AUX_USAGE_NONE,
@@ -385,11 +440,9 @@ void anv_CmdCopyImage(
                                            dst_base_layer, layer_count);
 
          for (unsigned i = 0; i < layer_count; i++) {
-            blorp_copy(&batch, &src_surf, src_level, src_base_layer + i,
-                       &dst_surf, dst_level, dst_base_layer + i,
-                       srcOffset.x, srcOffset.y,
-                       dstOffset.x, dstOffset.y,
-                       extent.width, extent.height);
+            blorp_copy_rects(&batch, &src_surf, src_level, src_base_layer + i,
+                             &dst_surf, dst_level, dst_base_layer + i,
+                             rects, num_rects);
          }
 
          struct blorp_surf dst_shadow_surf;
@@ -397,11 +450,11 @@ void anv_CmdCopyImage(
                                                  dst_image, dst_mask,
                                                  &dst_shadow_surf)) {
             for (unsigned i = 0; i < layer_count; i++) {
-               blorp_copy(&batch, &src_surf, src_level, src_base_layer + i,
-                          &dst_shadow_surf, dst_level, dst_base_layer + i,
-                          srcOffset.x, srcOffset.y,
-                          dstOffset.x, dstOffset.y,
-                          extent.width, extent.height);
+               blorp_copy_rects(&batch, &src_surf, src_level,
+                                src_base_layer + i,
+                                &dst_shadow_surf, dst_level,
+                                dst_base_layer + i,
+                                rects, num_rects);
             }
          }
       }
@@ -1098,6 +1151,60 @@ binding_table_for_surface_state(struct anv_cmd_buffer *cmd_buffer,
    return VK_SUCCESS;
 }
 
+/* Hands the rects over to blorp in groups, so that the ones which share
+ * their layers get cleared with a single primitive.
+ */
+static void
+clear_attachment_rects(struct blorp_batch *batch,
+                       const struct anv_subpass *subpass,
+                       uint32_t binding_table,
+                       enum isl_format depth_format, uint32_t samples,
+                       uint32_t rectCount, const VkClearRect *pRects,
+                       bool clear_color, union isl_color_value color_value,
+                       bool clear_depth, float depth_value,
+                       uint8_t stencil_mask, uint8_t stencil_value)
+{
+   struct blorp_layered_rect rects[32];
+
+   /* If multiview is enabled we ignore baseArrayLayer and layerCount */
+   uint32_t view_mask = subpass->view_mask ? subpass->view_mask : 1;
+   uint32_t view_idx;
+   for_each_bit(view_idx, view_mask) {
+      for (uint32_t r = 0; r < rectCount; r += ARRAY_SIZE(rects)) {
+         const uint32_t count = MIN2(rectCount - r, ARRAY_SIZE(rects));
+
+         for (uint32_t i = 0; i < count; i++) {
+            const VkClearRect *clear_rect = &pRects[r + i];
+            const VkOffset2D offset = clear_rect->rect.offset;
+            const VkExtent2D extent = clear_rect->rect.extent;
+
+            rects[i].rect = (struct blorp_rect) {
+               .x0 = offset.x,
+               .y0 = offset.y,
+               .x1 = offset.x + extent.width,
+               .y1 = offset.y + extent.height,
+            };
+
+            if (subpass->view_mask) {
+               rects[i].start_layer = view_idx;
+               rects[i].num_layers = 1;
+            } else {
+               assert(clear_rect->layerCount != VK_REMAINING_ARRAY_LAYERS);
+               rects[i].start_layer = clear_rect->baseArrayLayer;
+               rects[i].num_layers = clear_rect->layerCount;
+            }
+         }
+
+         blorp_clear_attachments_rects(batch, binding_table,
+                                       depth_format, samples,
+                                       rects, count,
+                                       clear_color, color_value,
+                                       clear_depth, depth_value,
+                                       stencil_mask, stencil_value);
+      }
+   }
+}
+
 static void
 clear_color_attachment(struct anv_cmd_buffer *cmd_buffer,
                        struct blorp_batch *batch,
@@ -1127,37 +1234,10 @@ clear_color_attachment(struct anv_cmd_buffer *cmd_buffer,
    union isl_color_value clear_color =
       vk_to_isl_color(attachment->clearValue.color);
 
-   /* If multiview is enabled we ignore baseArrayLayer and layerCount */
-   if (subpass->view_mask) {
-      uint32_t view_idx;
-      for_each_bit(view_idx, subpass->view_mask) {
-         for (uint32_t r = 0; r < rectCount; ++r) {
-            const VkOffset2D offset = pRects[r].rect.offset;
-            const VkExtent2D extent = pRects[r].rect.extent;
-            blorp_clear_attachments(batch, binding_table,
-                                    ISL_FORMAT_UNSUPPORTED, pass_att->samples,
-                                    view_idx, 1,
-                                    offset.x, offset.y,
-                                    offset.x + extent.width,
-                                    offset.y + extent.height,
-                                    true, clear_color, false, 0.0f, 0, 0);
-         }
-      }
-      return;
-   }
-
-   for (uint32_t r = 0; r < rectCount; ++r) {
-      const VkOffset2D offset = pRects[r].rect.offset;
-      const VkExtent2D extent = pRects[r].rect.extent;
-      assert(pRects[r].layerCount != VK_REMAINING_ARRAY_LAYERS);
-      blorp_clear_attachments(batch, binding_table,
-                              ISL_FORMAT_UNSUPPORTED, pass_att->samples,
-                              pRects[r].baseArrayLayer,
-                              pRects[r].layerCount,
-                              offset.x, offset.y,
-                              offset.x + extent.width, offset.y + extent.height,
-                              true, clear_color, false, 0.0f, 0, 0);
-   }
+   clear_attachment_rects(batch, subpass, binding_table,
+                          ISL_FORMAT_UNSUPPORTED, pass_att->samples,
+                          rectCount, pRects,
+                          true, clear_color, false, 0.0f, 0, 0);
 }
 
 static void
@@ -1195,43 +1275,13 @@ clear_depth_stencil_attachment(struct anv_cmd_buffer *cmd_buffer,
    if (result != VK_SUCCESS)
       return;
 
-   /* If multiview is enabled we ignore baseArrayLayer and layerCount */
-   if (subpass->view_mask) {
-      uint32_t view_idx;
-      for_each_bit(view_idx, subpass->view_mask) {
-         for (uint32_t r = 0; r < rectCount; ++r) {
-            const VkOffset2D offset = pRects[r].rect.offset;
-            const VkExtent2D extent = pRects[r].rect.extent;
-            VkClearDepthStencilValue value = attachment->clearValue.depthStencil;
-            blorp_clear_attachments(batch, binding_table,
-                                    depth_format, pass_att->samples,
-                                    view_idx, 1,
-                                    offset.x, offset.y,
-                                    offset.x + extent.width,
-                                    offset.y + extent.height,
-                                    false, color_value,
-                                    clear_depth, value.depth,
-                                    clear_stencil ? 0xff : 0, value.stencil);
-         }
-      }
-      return;
-   }
-
-   for (uint32_t r = 0; r < rectCount; ++r) {
-      const VkOffset2D offset = pRects[r].rect.offset;
-      const VkExtent2D extent = pRects[r].rect.extent;
-      VkClearDepthStencilValue value = attachment->clearValue.depthStencil;
-      assert(pRects[r].layerCount != VK_REMAINING_ARRAY_LAYERS);
-      blorp_clear_attachments(batch, binding_table,
-                              depth_format, pass_att->samples,
-                              pRects[r].baseArrayLayer,
-                              pRects[r].layerCount,
-                              offset.x, offset.y,
-                              offset.x + extent.width, offset.y + extent.height,
-                              false, color_value,
-                              clear_depth, value.depth,
-                              clear_stencil ? 0xff : 0, value.stencil);
-   }
+   VkClearDepthStencilValue value = attachment->clearValue.depthStencil;
+   clear_attachment_rects(batch, subpass, binding_table,
+                          depth_format, pass_att->samples,
+                          rectCount, pRects,
+                          false, color_value,
+                          clear_depth, value.depth,
+                          clear_stencil ? 0xff : 0, value.stencil);
 }
 
 void anv_CmdClearAttachments(
@@ -564,6 +564,8 @@ anv_physical_device_init(struct anv_physical_device *device,
    anv_physical_device_get_supported_extensions(device,
                                                 &device->supported_extensions);
 
+   /* Applications tend to create many images with the same description. */
+   device->isl_dev.surf_cache = isl_surf_cache_create();
 
    device->local_fd = fd;
 
@@ -581,6 +583,7 @@ anv_physical_device_finish(struct anv_physical_device *device)
 {
    anv_finish_wsi(device);
    anv_physical_device_free_disk_cache(device);
+   isl_surf_cache_destroy(device->isl_dev.surf_cache);
    ralloc_free(device->compiler);
    ralloc_free(device->perf);
    close(device->local_fd);
@@ -615,6 +618,22 @@ static const VkAllocationCallbacks default_alloc = {
    .pfnFree = default_free_func,
 };
 
+/**
+ * Returns whether allocations made for a command with the given allocator
+ * go to malloc().
+ *
+ * Application allocators may only be called from the thread the command was
+ * called on, so work may only be handed off to other threads when this is
+ * true.
+ */
+bool
+anv_device_alloc_is_default(const struct anv_device *device,
+                            const VkAllocationCallbacks *pAllocator)
+{
+   return pAllocator == NULL &&
+          device->alloc.pfnAllocation == default_alloc_func;
+}
+
 VkResult anv_EnumerateInstanceExtensionProperties(
     const char*                                 pLayerName,
     uint32_t*                                   pPropertyCount,
@@ -2886,6 +2905,10 @@ VkResult anv_CreateDevice(
 
    anv_pipeline_cache_init(&device->default_pipeline_cache, device, true);
 
+   pthread_mutex_init(&device->queue_mutex, NULL);
+   device->compile_queue_attempted = false;
+   device->pipeline_queue_attempted = false;
+
    anv_device_init_blorp(device);
 
    anv_device_init_border_colors(device);
@@ -2956,6 +2979,14 @@ void anv_DestroyDevice(
 
    anv_device_finish_blorp(device);
 
+   if (device->pipeline_queue_attempted &&
+       util_queue_is_initialized(&device->pipeline_queue))
+      util_queue_destroy(&device->pipeline_queue);
+   if (device->compile_queue_attempted &&
+       util_queue_is_initialized(&device->compile_queue))
+      util_queue_destroy(&device->compile_queue);
+   pthread_mutex_destroy(&device->queue_mutex);
+
    anv_pipeline_cache_finish(&device->default_pipeline_cache);
 
    anv_queue_finish(&device->queue);
@@ -29,6 +29,7 @@
 
 #include "util/mesa-sha1.h"
 #include "util/os_time.h"
+#include "util/u_cpu_detect.h"
 #include "common/gen_l3_config.h"
 #include "common/gen_disasm.h"
 #include "anv_private.h"
@@ -711,6 +712,25 @@ anv_pipeline_lower_nir(struct anv_pipeline *pipeline,
    stage->nir = nir;
 }
 
+/**
+ * Computes the output VUE map of a vertex or geometry shader.
+ *
+ * This happens before any backend compile starts so that the fragment
+ * shader, whose key depends on it, can be compiled at the same time.
+ */
+static void
+anv_pipeline_compute_vue_map(const struct brw_compiler *compiler,
+                             struct anv_pipeline_stage *stage)
+{
+   assert(stage->stage == MESA_SHADER_VERTEX ||
+          stage->stage == MESA_SHADER_GEOMETRY);
+
+   brw_compute_vue_map(compiler->devinfo,
+                       &stage->prog_data.vue.vue_map,
+                       stage->nir->info.outputs_written,
+                       stage->nir->info.separate_shader);
+}
+
 static void
 anv_pipeline_link_vs(const struct brw_compiler *compiler,
                      struct anv_pipeline_stage *vs_stage,
@@ -726,11 +746,7 @@ anv_pipeline_compile_vs(const struct brw_compiler *compiler,
                         struct anv_device *device,
                         struct anv_pipeline_stage *vs_stage)
 {
-   brw_compute_vue_map(compiler->devinfo,
-                       &vs_stage->prog_data.vs.base.vue_map,
-                       vs_stage->nir->info.outputs_written,
-                       vs_stage->nir->info.separate_shader);
-
+   /* The VUE map was computed by anv_pipeline_compute_vue_map(). */
    vs_stage->num_stats = 1;
    vs_stage->code = brw_compile_vs(compiler, device, mem_ctx,
                                    &vs_stage->key.vs,
@@ -872,11 +888,7 @@ anv_pipeline_compile_gs(const struct brw_compiler *compiler,
                         struct anv_pipeline_stage *gs_stage,
                         struct anv_pipeline_stage *prev_stage)
 {
-   brw_compute_vue_map(compiler->devinfo,
-                       &gs_stage->prog_data.gs.base.vue_map,
-                       gs_stage->nir->info.outputs_written,
-                       gs_stage->nir->info.separate_shader);
-
+   /* The VUE map was computed by anv_pipeline_compute_vue_map(). */
    gs_stage->num_stats = 1;
    gs_stage->code = brw_compile_gs(compiler, device, mem_ctx,
                                    &gs_stage->key.gs,
@@ -1104,6 +1116,133 @@ anv_pipeline_add_executables(struct anv_pipeline *pipeline,
    }
 }
 
+/**
+ * A unit of per-stage work run on the device's compile queue.
+ */
+struct anv_pipeline_stage_job {
+   struct util_queue_fence fence;
+
+   struct anv_pipeline *pipeline;
+   struct anv_pipeline_cache *cache;
+   struct anv_pipeline_stage *stage;
+   struct anv_pipeline_stage *prev_stage;
+
+   /* Only this job allocates out of mem_ctx while it runs, since ralloc
+    * contexts aren't thread-safe.
+    */
+   void *mem_ctx;
+};
+
+static void
+anv_pipeline_get_nir_job(void *data, int thread_index)
+{
+   struct anv_pipeline_stage_job *job = data;
+   struct anv_pipeline_stage *stage = job->stage;
+   int64_t stage_start = os_time_get_nano();
+
+   stage->nir = anv_pipeline_stage_get_nir(job->pipeline, job->cache,
+                                           job->mem_ctx, stage);
+
+   stage->feedback.duration += os_time_get_nano() - stage_start;
+}
+
+static void
+anv_pipeline_compile_stage_job(void *data, int thread_index)
+{
+   struct anv_pipeline_stage_job *job = data;
+   struct anv_device *device = job->pipeline->device;
+   const struct brw_compiler *compiler =
+      device->instance->physicalDevice.compiler;
+   struct anv_pipeline_stage *stage = job->stage;
+   int64_t stage_start = os_time_get_nano();
+
+   switch (stage->stage) {
+   case MESA_SHADER_VERTEX:
+      anv_pipeline_compile_vs(compiler, job->mem_ctx, device, stage);
+      break;
+   case MESA_SHADER_TESS_CTRL:
+      anv_pipeline_compile_tcs(compiler, job->mem_ctx, device,
+                               stage, job->prev_stage);
+      break;
+   case MESA_SHADER_TESS_EVAL:
+      anv_pipeline_compile_tes(compiler, job->mem_ctx, device,
+                               stage, job->prev_stage);
+      break;
+   case MESA_SHADER_GEOMETRY:
+      anv_pipeline_compile_gs(compiler, job->mem_ctx, device,
+                              stage, job->prev_stage);
+      break;
+   case MESA_SHADER_FRAGMENT:
+      anv_pipeline_compile_fs(compiler, job->mem_ctx, device,
+                              stage, job->prev_stage);
+      break;
+   default:
+      unreachable("Invalid graphics shader stage");
+   }
+
+   stage->feedback.duration += os_time_get_nano() - stage_start;
+}
+
+/**
+ * Creates the device's compile queue if it hasn't been yet.  Returns false if
+ * the queue couldn't be created, in which case stages are compiled one at a
+ * time.
+ */
+static bool
+anv_device_init_compile_queue(struct anv_device *device)
+{
+   pthread_mutex_lock(&device->queue_mutex);
+   if (!device->compile_queue_attempted) {
+      device->compile_queue_attempted = true;
+      util_cpu_detect();
+      util_queue_init(&device->compile_queue, "anv_sh", MESA_SHADER_STAGES,
+                      MIN2(util_cpu_caps.nr_cpus, MESA_SHADER_FRAGMENT + 1),
+                      UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+   }
+   pthread_mutex_unlock(&device->queue_mutex);
+
+   return util_queue_is_initialized(&device->compile_queue);
+}
+
+/**
+ * Runs execute on the job of every stage in stage_mask and waits for all of
+ * them to finish.
+ *
+ * The jobs go to the device's compile queue, unless there is only one of
+ * them or shader dumps are enabled for one of the stages, in which case they
+ * run on the calling thread to avoid the hand-off and interleaved output.
+ */
+static void
+anv_pipeline_run_stage_jobs(struct anv_device *device,
+                            struct anv_pipeline_stage_job *jobs,
+                            uint32_t stage_mask,
+                            util_queue_execute_func execute)
+{
+   uint64_t debug_flags = 0;
+   uint32_t s;
+
+   for_each_bit(s, stage_mask)
+      debug_flags |= intel_debug_flag_for_shader_stage(s);
+
+   if (util_bitcount(stage_mask) < 2 || (INTEL_DEBUG & debug_flags) ||
+       !anv_device_init_compile_queue(device)) {
+      for_each_bit(s, stage_mask)
+         execute(&jobs[s], 0);
+      return;
+   }
+
+   for_each_bit(s, stage_mask) {
+      util_queue_fence_init(&jobs[s].fence);
+      util_queue_add_job(&device->compile_queue, &jobs[s], &jobs[s].fence,
+                         execute, NULL, 0);
+   }
+
+   for_each_bit(s, stage_mask) {
+      util_queue_fence_wait(&jobs[s].fence);
+      util_queue_fence_destroy(&jobs[s].fence);
+   }
+}
+
 static VkResult
 anv_pipeline_compile_graphics(struct anv_pipeline *pipeline,
                               struct anv_pipeline_cache *cache,
@@ -1267,12 +1406,17 @@ anv_pipeline_compile_graphics(struct anv_pipeline *pipeline,
 
    void *pipeline_ctx = ralloc_context(NULL);
 
+   /* Each stage gets its own ralloc context so that the stages can be
+    * translated and compiled concurrently.  They hang off pipeline_ctx, so
+    * the failure path frees all of them.
+    */
+   struct anv_pipeline_stage_job jobs[MESA_SHADER_STAGES] = {};
+   uint32_t stage_mask = 0;
+
    for (unsigned s = 0; s < MESA_SHADER_STAGES; s++) {
       if (!stages[s].entrypoint)
          continue;
 
-      int64_t stage_start = os_time_get_nano();
-
       assert(stages[s].stage == s);
       assert(pipeline->shaders[s] == NULL);
 
@@ -1281,15 +1425,24 @@ anv_pipeline_compile_graphics(struct anv_pipeline *pipeline,
          .sampler_to_descriptor = stages[s].sampler_to_descriptor
       };
 
-      stages[s].nir = anv_pipeline_stage_get_nir(pipeline, cache,
-                                                 pipeline_ctx,
-                                                 &stages[s]);
-      if (stages[s].nir == NULL) {
+      jobs[s] = (struct anv_pipeline_stage_job) {
+         .pipeline = pipeline,
+         .cache = cache,
+         .stage = &stages[s],
+         .mem_ctx = ralloc_context(pipeline_ctx),
+      };
+      stage_mask |= 1 << s;
+   }
+
+   /* SPIR-V to NIR is independent for every stage. */
+   anv_pipeline_run_stage_jobs(pipeline->device, jobs, stage_mask,
+                               anv_pipeline_get_nir_job);
+
+   for (unsigned s = 0; s < MESA_SHADER_STAGES; s++) {
+      if (stages[s].entrypoint && stages[s].nir == NULL) {
          result = vk_error(VK_ERROR_OUT_OF_HOST_MEMORY);
          goto fail;
       }
-
-      stages[s].feedback.duration += os_time_get_nano() - stage_start;
    }
 
    /* Walk backwards to link */
@@ -1321,6 +1474,16 @@ anv_pipeline_compile_graphics(struct anv_pipeline *pipeline,
       next_stage = &stages[s];
    }
 
+   /* Lowering touches pipeline state, so it stays on this thread.  Only
+    * the backend compiles run in parallel.  The TES needs the output VUE map
+    * of the TCS, and a fragment shader after a TES needs the TES's.  Those
+    * only come out of the backend compile, so such stages go in a later
+    * wave than the stage before them.
+    */
+   nir_xfb_info *xfb_info[MESA_SHADER_STAGES] = {};
+   unsigned wave[MESA_SHADER_STAGES] = {};
+   uint32_t wave_stages[3] = {};
+
    struct anv_pipeline_stage *prev_stage = NULL;
    for (unsigned s = 0; s < MESA_SHADER_STAGES; s++) {
       if (!stages[s].entrypoint)
@@ -1328,42 +1491,47 @@ anv_pipeline_compile_graphics(struct anv_pipeline *pipeline,
 
       int64_t stage_start = os_time_get_nano();
 
-      void *stage_ctx = ralloc_context(NULL);
+      void *stage_ctx = ralloc_context(pipeline_ctx);
 
-      nir_xfb_info *xfb_info = NULL;
       if (s == MESA_SHADER_VERTEX ||
           s == MESA_SHADER_TESS_EVAL ||
           s == MESA_SHADER_GEOMETRY)
-         xfb_info = nir_gather_xfb_info(stages[s].nir, stage_ctx);
+         xfb_info[s] = nir_gather_xfb_info(stages[s].nir, stage_ctx);
 
       anv_pipeline_lower_nir(pipeline, stage_ctx, &stages[s], layout);
 
-      switch (s) {
-      case MESA_SHADER_VERTEX:
-         anv_pipeline_compile_vs(compiler, stage_ctx, pipeline->device,
-                                 &stages[s]);
-         break;
-      case MESA_SHADER_TESS_CTRL:
-         anv_pipeline_compile_tcs(compiler, stage_ctx, pipeline->device,
-                                  &stages[s], prev_stage);
-         break;
-      case MESA_SHADER_TESS_EVAL:
-         anv_pipeline_compile_tes(compiler, stage_ctx, pipeline->device,
-                                  &stages[s], prev_stage);
-         break;
-      case MESA_SHADER_GEOMETRY:
-         anv_pipeline_compile_gs(compiler, stage_ctx, pipeline->device,
-                                 &stages[s], prev_stage);
-         break;
-      case MESA_SHADER_FRAGMENT:
-         anv_pipeline_compile_fs(compiler, stage_ctx, pipeline->device,
-                                 &stages[s], prev_stage);
-         break;
-      default:
-         unreachable("Invalid graphics shader stage");
-      }
+      if (s == MESA_SHADER_VERTEX || s == MESA_SHADER_GEOMETRY)
+         anv_pipeline_compute_vue_map(compiler, &stages[s]);
+
+      if (s == MESA_SHADER_TESS_EVAL ||
+          (s == MESA_SHADER_FRAGMENT &&
+           prev_stage->stage == MESA_SHADER_TESS_EVAL))
+         wave[s] = wave[prev_stage->stage] + 1;
+      assert(wave[s] < ARRAY_SIZE(wave_stages));
+      wave_stages[wave[s]] |= 1 << s;
+
+      jobs[s].prev_stage = prev_stage;
+      jobs[s].mem_ctx = stage_ctx;
+
+      stages[s].feedback.duration += os_time_get_nano() - stage_start;
+
+      prev_stage = &stages[s];
+   }
+
+   for (unsigned w = 0; w < ARRAY_SIZE(wave_stages); w++) {
+      anv_pipeline_run_stage_jobs(pipeline->device, jobs, wave_stages[w],
+                                  anv_pipeline_compile_stage_job);
+   }
+
+   for (unsigned s = 0; s < MESA_SHADER_STAGES; s++) {
+      if (!stages[s].entrypoint)
+         continue;
+
+      int64_t stage_start = os_time_get_nano();
+
+      void *stage_ctx = jobs[s].mem_ctx;
+
       if (stages[s].code == NULL) {
-         ralloc_free(stage_ctx);
          result = vk_error(VK_ERROR_OUT_OF_HOST_MEMORY);
          goto fail;
       }
@@ -1382,9 +1550,8 @@ anv_pipeline_compile_graphics(struct anv_pipeline *pipeline,
                                   &stages[s].prog_data.base,
                                   brw_prog_data_size(s),
                                   stages[s].stats, stages[s].num_stats,
-                                  xfb_info, &stages[s].bind_map);
+                                  xfb_info[s], &stages[s].bind_map);
       if (!bin) {
-         ralloc_free(stage_ctx);
          result = vk_error(VK_ERROR_OUT_OF_HOST_MEMORY);
          goto fail;
       }
@@ -1395,8 +1562,6 @@ anv_pipeline_compile_graphics(struct anv_pipeline *pipeline,
       ralloc_free(stage_ctx);
 
       stages[s].feedback.duration += os_time_get_nano() - stage_start;
-
-      prev_stage = &stages[s];
    }
 
    ralloc_free(pipeline_ctx);
@@ -1831,6 +1996,95 @@ anv_pipeline_setup_l3_config(struct anv_pipeline *pipeline, bool needs_slm)
       gen_get_l3_config_urb_size(devinfo, pipeline->urb.l3_config);
 }
 
+/**
+ * Creates the device's pipeline queue if it hasn't been yet, so that devices
+ * which never create pipelines in batches don't start a thread per CPU.
+ * Returns false if the queue couldn't be created.
+ */
+static bool
+anv_device_init_pipeline_queue(struct anv_device *device)
+{
+   pthread_mutex_lock(&device->queue_mutex);
+   if (!device->pipeline_queue_attempted) {
+      device->pipeline_queue_attempted = true;
+      util_cpu_detect();
+      util_queue_init(&device->pipeline_queue, "anv_pipe", 64,
+                      util_cpu_caps.nr_cpus, UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+   }
+   pthread_mutex_unlock(&device->queue_mutex);
+
+   return util_queue_is_initialized(&device->pipeline_queue);
+}
+
+/**
+ * Creates count pipelines by running create on an anv_pipeline_create_job for
+ * each of them.
+ *
+ * As the spec allows, every pipeline is attempted even if some fail.  Failed
+ * entries are set to VK_NULL_HANDLE, and the error of the first one is
+ * returned.  The pipelines are spread over the device's pipeline queue unless
+ * the application provided its own allocator, which must only be called from
+ * this thread.
+ */
+VkResult
+anv_pipeline_create_batch(struct anv_device *device,
+                          struct anv_pipeline_cache *cache,
+                          uint32_t count, const void *create_infos,
+                          size_t create_info_size,
+                          const VkAllocationCallbacks *alloc,
+                          VkPipeline *pipelines,
+                          util_queue_execute_func create)
+{
+   const bool threaded = count > 1 &&
+      anv_device_alloc_is_default(device, alloc) &&
+      anv_device_init_pipeline_queue(device);
+
+   struct anv_pipeline_create_job *jobs =
+      vk_alloc2(&device->alloc, alloc, count * sizeof(*jobs), 8,
+                VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+   if (jobs == NULL) {
+      for (uint32_t i = 0; i < count; i++)
+         pipelines[i] = VK_NULL_HANDLE;
+      return vk_error(VK_ERROR_OUT_OF_HOST_MEMORY);
+   }
+
+   for (uint32_t i = 0; i < count; i++) {
+      jobs[i] = (struct anv_pipeline_create_job) {
+         .device = anv_device_to_handle(device),
+         .cache = cache,
+         .create_info = (const char *)create_infos + i * create_info_size,
+         .alloc = alloc,
+         .pipeline = &pipelines[i],
+      };
+
+      if (threaded) {
+         util_queue_fence_init(&jobs[i].fence);
+         util_queue_add_job(&device->pipeline_queue, &jobs[i], &jobs[i].fence,
+                            create, NULL, 0);
+      } else {
+         create(&jobs[i], 0);
+      }
+   }
+
+   VkResult result = VK_SUCCESS;
+   for (uint32_t i = 0; i < count; i++) {
+      if (threaded) {
+         util_queue_fence_wait(&jobs[i].fence);
+         util_queue_fence_destroy(&jobs[i].fence);
+      }
+
+      if (jobs[i].result != VK_SUCCESS) {
+         pipelines[i] = VK_NULL_HANDLE;
+         if (result == VK_SUCCESS)
+            result = jobs[i].result;
+      }
+   }
+
+   vk_free2(&device->alloc, alloc, jobs);
+
+   return result;
+}
+
 VkResult
 anv_pipeline_init(struct anv_pipeline *pipeline,
                   struct anv_device *device,
@@ -292,6 +292,9 @@ anv_pipeline_cache_init(struct anv_pipeline_cache *cache,
       cache->cache = NULL;
       cache->nir_cache = NULL;
    }
+
+   cache->data = NULL;
+   cache->lazy_cache = NULL;
 }
 
 void
@@ -316,6 +319,57 @@ anv_pipeline_cache_finish(struct anv_pipeline_cache *cache)
 
       _mesa_hash_table_destroy(cache->nir_cache, NULL);
    }
+
+   if (cache->lazy_cache)
+      _mesa_hash_table_destroy(cache->lazy_cache, NULL);
+   vk_free(&cache->device->alloc, cache->data);
+}
+
+/* The serialized form of a pipeline cache is the header required by the
+ * Vulkan spec, followed by a format version, the number of shaders, an index
+ * giving the location of each shader and finally the shaders themselves, as
+ * written by anv_shader_bin_write_to_blob().  Each shader starts with its
+ * key, at a 4 byte aligned offset, so keys can be used straight from the
+ * data without parsing the rest of the shader.
+ */
+#define ANV_PIPELINE_CACHE_FORMAT_VERSION 1
+
+struct cache_index_entry {
+   uint64_t offset;
+   uint64_t size;
+};
+
+static struct anv_shader_bin *
+anv_pipeline_cache_load_shader_locked(struct anv_pipeline_cache *cache,
+                                      const struct anv_shader_bin_key *key)
+{
+   struct hash_entry *entry = _mesa_hash_table_search(cache->lazy_cache, key);
+   if (entry == NULL)
+      return NULL;
+
+   const struct cache_index_entry *index = entry->data;
+   _mesa_hash_table_remove(cache->lazy_cache, entry);
+
+   struct blob_reader blob;
+   blob_reader_init(&blob, (uint8_t *)cache->data + index->offset,
+                    index->size);
+
+   struct anv_shader_bin *bin =
+      anv_shader_bin_create_from_blob(cache->device, &blob);
+   if (bin)
+      _mesa_hash_table_insert(cache->cache, bin->key, bin);
+
+   return bin;
+}
+
+static void
+anv_pipeline_cache_load_all_shaders_locked(struct anv_pipeline_cache *cache)
+{
+   if (cache->lazy_cache == NULL)
+      return;
+
+   hash_table_foreach(cache->lazy_cache, entry)
+      anv_pipeline_cache_load_shader_locked(cache, entry->key);
 }
 
 static struct anv_shader_bin *
@@ -330,6 +384,8 @@ anv_pipeline_cache_search_locked(struct anv_pipeline_cache *cache,
    struct hash_entry *entry = _mesa_hash_table_search(cache->cache, key);
    if (entry)
       return entry->data;
+   else if (cache->lazy_cache)
+      return anv_pipeline_cache_load_shader_locked(cache, key);
    else
       return NULL;
 }
@@ -475,7 +531,6 @@ anv_pipeline_cache_load(struct anv_pipeline_cache *cache,
 
    struct cache_header header;
    blob_copy_bytes(&blob, &header, sizeof(header));
-   uint32_t count = blob_read_uint32(&blob);
    if (blob.overrun)
       return;
 
@@ -490,12 +545,46 @@ anv_pipeline_cache_load(struct anv_pipeline_cache *cache,
    if (memcmp(header.uuid, pdevice->pipeline_cache_uuid, VK_UUID_SIZE) != 0)
       return;
 
+   uint32_t version = blob_read_uint32(&blob);
+   uint32_t count = blob_read_uint32(&blob);
+   if (blob.overrun || version != ANV_PIPELINE_CACHE_FORMAT_VERSION)
+      return;
+   if (count > (blob.end - blob.current) / sizeof(struct cache_index_entry))
+      return;
+
+   const size_t index_offset = blob.current - blob.data;
+
+   /* pInitialData only has to stay valid for the duration of
+    * vkCreatePipelineCache(), so keep one copy of it around and only create
+    * shaders out of it as they get looked up, rather than creating every
+    * shader in the cache up front.
+    */
+   cache->data = vk_alloc(&device->alloc, size, 8,
+                          VK_SYSTEM_ALLOCATION_SCOPE_CACHE);
+   if (cache->data == NULL)
+      return;
+   memcpy(cache->data, data, size);
+
+   cache->lazy_cache = _mesa_hash_table_create(NULL, shader_bin_key_hash_func,
+                                               shader_bin_key_compare_func);
+   if (cache->lazy_cache == NULL)
+      return;
+
+   const struct cache_index_entry *index =
+      (const void *)((uint8_t *)cache->data + index_offset);
    for (uint32_t i = 0; i < count; i++) {
-      struct anv_shader_bin *bin =
-         anv_shader_bin_create_from_blob(device, &blob);
-      if (!bin)
+      if (index[i].offset % sizeof(uint32_t) != 0 ||
+          index[i].offset > size ||
+          index[i].size > size - index[i].offset ||
+          index[i].size < sizeof(struct anv_shader_bin_key))
          break;
-      _mesa_hash_table_insert(cache->cache, bin->key, bin);
+
+      const struct anv_shader_bin_key *key =
+         (const void *)((uint8_t *)cache->data + index[i].offset);
+      if (key->size > index[i].size - sizeof(*key))
+         break;
+
+      _mesa_hash_table_insert(cache->lazy_cache, key, (void *)&index[i]);
    }
 }
 
@@ -546,6 +635,36 @@ void anv_DestroyPipelineCache(
    vk_free2(&device->alloc, pAllocator, cache);
 }
 
+/* Writes one shader, either from an anv_shader_bin or from its serialized
+ * form, and fills in its index entry.
+ */
+static bool
+anv_pipeline_cache_write_entry(struct blob *blob, intptr_t index_offset,
+                               uint32_t n, const struct anv_shader_bin *shader,
+                               const void *data, size_t size)
+{
+   static const uint8_t zeros[sizeof(uint32_t)] = { 0 };
+
+   if (!blob_write_bytes(blob, zeros,
+                         ALIGN_POT(blob->size, sizeof(uint32_t)) - blob->size))
+      return false;
+
+   struct cache_index_entry index = { .offset = blob->size };
+
+   if (shader) {
+      if (!anv_shader_bin_write_to_blob(shader, blob))
+         return false;
+   } else {
+      if (!blob_write_bytes(blob, data, size))
+         return false;
+   }
+
+   index.size = blob->size - index.offset;
+
+   return blob_overwrite_bytes(blob, index_offset + n * sizeof(index),
+                               &index, sizeof(index));
+}
+
 VkResult anv_GetPipelineCacheData(
     VkDevice                                    _device,
     VkPipelineCache                             _cache,
@@ -572,9 +691,21 @@ VkResult anv_GetPipelineCacheData(
    memcpy(header.uuid, pdevice->pipeline_cache_uuid, VK_UUID_SIZE);
    blob_write_bytes(&blob, &header, sizeof(header));
 
+   pthread_mutex_lock(&cache->mutex);
+
+   uint32_t max_count = 0;
+   if (cache->cache)
+      max_count += cache->cache->entries;
+   if (cache->lazy_cache)
+      max_count += cache->lazy_cache->entries;
+
    uint32_t count = 0;
+   blob_write_uint32(&blob, ANV_PIPELINE_CACHE_FORMAT_VERSION);
    intptr_t count_offset = blob_reserve_uint32(&blob);
-   if (count_offset < 0) {
+   intptr_t index_offset =
+      blob_reserve_bytes(&blob, max_count * sizeof(struct cache_index_entry));
+   if (count_offset < 0 || index_offset < 0) {
+      pthread_mutex_unlock(&cache->mutex);
       *pDataSize = 0;
       blob_finish(&blob);
       return VK_INCOMPLETE;
@@ -586,7 +717,8 @@ VkResult anv_GetPipelineCacheData(
          struct anv_shader_bin *shader = entry->data;
 
          size_t save_size = blob.size;
-         if (!anv_shader_bin_write_to_blob(shader, &blob)) {
+         if (!anv_pipeline_cache_write_entry(&blob, index_offset, count,
+                                             shader, NULL, 0)) {
             /* If it fails reset to the previous size and bail */
             blob.size = save_size;
             result = VK_INCOMPLETE;
@@ -597,6 +729,29 @@ VkResult anv_GetPipelineCacheData(
       }
    }
 
+   /* Shaders which were never looked up are still in their serialized form,
+    * which can be copied as is.
+    */
+   if (cache->lazy_cache && result == VK_SUCCESS) {
+      hash_table_foreach(cache->lazy_cache, entry) {
+         const struct cache_index_entry *index = entry->data;
+
+         size_t save_size = blob.size;
+         if (!anv_pipeline_cache_write_entry(&blob, index_offset, count, NULL,
+                                             (uint8_t *)cache->data +
+                                             index->offset,
+                                             index->size)) {
+            blob.size = save_size;
+            result = VK_INCOMPLETE;
+            break;
+         }
+
+         count++;
+      }
+   }
+
+   pthread_mutex_unlock(&cache->mutex);
+
    blob_overwrite_uint32(&blob, count_offset, count);
 
    *pDataSize = blob.size;
@@ -622,6 +777,13 @@ VkResult anv_MergePipelineCaches(
       if (!src->cache)
          continue;
 
+      /* The serialized shaders point into the source cache's data, so
+       * create them before handing them over.
+       */
+      pthread_mutex_lock(&src->mutex);
+      anv_pipeline_cache_load_all_shaders_locked(src);
+      pthread_mutex_unlock(&src->mutex);
+
       hash_table_foreach(src->cache, entry) {
          struct anv_shader_bin *bin = entry->data;
          assert(bin);
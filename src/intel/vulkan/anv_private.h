@@ -57,6 +57,7 @@
 #include "util/u_atomic.h"
 #include "util/u_vector.h"
 #include "util/u_math.h"
+#include "util/u_queue.h"
 #include "util/vma.h"
 #include "util/xmlconfig.h"
 #include "vk_alloc.h"
@@ -1141,6 +1142,13 @@ struct anv_pipeline_cache {
    struct hash_table *                          nir_cache;
 
    struct hash_table *                          cache;
+
+   /* Copy of the initial data and the serialized shaders in it which
+    * haven't been looked up yet, indexed by key.  They only get turned into
+    * anv_shader_bins on first use.
+    */
+   void *                                       data;
+   struct hash_table *                          lazy_cache;
 };
 
 struct nir_xfb_info;
@@ -1244,6 +1252,23 @@ struct anv_device {
     struct anv_pipeline_cache                   default_pipeline_cache;
     struct blorp_context                        blorp;
 
+    /** Protects creation of the two thread pools below */
+    pthread_mutex_t                             queue_mutex;
+
+    /**
+     * Thread pool the stages of a graphics pipeline are compiled on, created
+     * by the first pipeline with more than one stage to compile.
+     */
+    bool                                        compile_queue_attempted;
+    struct util_queue                           compile_queue;
+
+    /**
+     * Thread pool batches of vkCreate*Pipelines are spread over, created by
+     * the first batch which can use it.
+     */
+    bool                                        pipeline_queue_attempted;
+    struct util_queue                           pipeline_queue;
+
     struct anv_state                            border_colors;
 
     struct anv_state                            slice_hash;
@@ -1326,6 +1351,9 @@ anv_device_is_lost(struct anv_device *device)
 
 VkResult anv_device_query_status(struct anv_device *device);
 
+bool anv_device_alloc_is_default(const struct anv_device *device,
+                                 const VkAllocationCallbacks *pAllocator);
+
 
 enum anv_bo_alloc_flags {
    /** Specifies that the BO must have a 32-bit address
@@ -3185,6 +3213,30 @@ anv_pipeline_get_last_vue_prog_data(const struct anv_pipeline *pipeline)
       return &get_vs_prog_data(pipeline)->base;
 }
 
+/**
+ * Creation of one pipeline out of a vkCreate*Pipelines batch.
+ */
+struct anv_pipeline_create_job {
+   struct util_queue_fence fence;
+
+   VkDevice device;
+   struct anv_pipeline_cache *cache;
+   const void *create_info;
+   const VkAllocationCallbacks *alloc;
+   VkPipeline *pipeline;
+
+   VkResult result;
+};
+
+VkResult
+anv_pipeline_create_batch(struct anv_device *device,
+                          struct anv_pipeline_cache *cache,
+                          uint32_t count, const void *create_infos,
+                          size_t create_info_size,
+                          const VkAllocationCallbacks *alloc,
+                          VkPipeline *pipelines,
+                          util_queue_execute_func create);
+
 VkResult
 anv_pipeline_init(struct anv_pipeline *pipeline, struct anv_device *device,
                   struct anv_pipeline_cache *cache,
@@ -2347,6 +2347,26 @@ compute_pipeline_create(
    return pipeline->batch.status;
 }
 
+static void
+graphics_pipeline_create_job(void *data, int thread_index)
+{
+   struct anv_pipeline_create_job *job = data;
+
+   job->result = genX(graphics_pipeline_create)(job->device, job->cache,
+                                                job->create_info,
+                                                job->alloc, job->pipeline);
+}
+
+static void
+compute_pipeline_create_job(void *data, int thread_index)
+{
+   struct anv_pipeline_create_job *job = data;
+
+   job->result = compute_pipeline_create(job->device, job->cache,
+                                         job->create_info,
+                                         job->alloc, job->pipeline);
+}
+
 VkResult genX(CreateGraphicsPipelines)(
     VkDevice                                    _device,
     VkPipelineCache                             pipelineCache,
@@ -2355,27 +2375,13 @@ VkResult genX(CreateGraphicsPipelines)(
     const VkAllocationCallbacks*                pAllocator,
     VkPipeline*                                 pPipelines)
 {
+   ANV_FROM_HANDLE(anv_device, device, _device);
    ANV_FROM_HANDLE(anv_pipeline_cache, pipeline_cache, pipelineCache);
 
-   VkResult result = VK_SUCCESS;
-
-   unsigned i;
-   for (i = 0; i < count; i++) {
-      result = genX(graphics_pipeline_create)(_device,
-                                              pipeline_cache,
-                                              &pCreateInfos[i],
-                                              pAllocator, &pPipelines[i]);
-
-      /* Bail out on the first error as it is not obvious what error should be
-       * report upon 2 different failures. */
-      if (result != VK_SUCCESS)
-         break;
-   }
-
-   for (; i < count; i++)
-      pPipelines[i] = VK_NULL_HANDLE;
-
-   return result;
+   return anv_pipeline_create_batch(device, pipeline_cache,
+                                    count, pCreateInfos,
+                                    sizeof(*pCreateInfos), pAllocator,
+                                    pPipelines, graphics_pipeline_create_job);
 }
 
 VkResult genX(CreateComputePipelines)(
@@ -2386,24 +2392,11 @@ VkResult genX(CreateComputePipelines)(
     const VkAllocationCallbacks*                pAllocator,
     VkPipeline*                                 pPipelines)
 {
+   ANV_FROM_HANDLE(anv_device, device, _device);
    ANV_FROM_HANDLE(anv_pipeline_cache, pipeline_cache, pipelineCache);
 
-   VkResult result = VK_SUCCESS;
-
-   unsigned i;
-   for (i = 0; i < count; i++) {
-      result = compute_pipeline_create(_device, pipeline_cache,
-                                       &pCreateInfos[i],
-                                       pAllocator, &pPipelines[i]);
-
-      /* Bail out on the first error as it is not obvious what error should be
-       * report upon 2 different failures. */
-      if (result != VK_SUCCESS)
-         break;
-   }
-
-   for (; i < count; i++)
-      pPipelines[i] = VK_NULL_HANDLE;
-
-   return result;
+   return anv_pipeline_create_batch(device, pipeline_cache,
+                                    count, pCreateInfos,
+                                    sizeof(*pCreateInfos), pAllocator,
+                                    pPipelines, compute_pipeline_create_job);
 }
@@ -0,0 +1,291 @@
+/*
+ * Copyright © 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Round trips a pipeline cache full of fake shaders through
+ * vkGetPipelineCacheData() and vkCreatePipelineCache(), checking that
+ * shaders only get created when they are looked up and that they come back
+ * intact.
+ *
+ * Run with --bench to time loading a large cache and looking up a few of its
+ * shaders.
+ */
+
+#undef NDEBUG
+
+#include <stdio.h>
+
+#include "anv_private.h"
+#include "util/os_time.h"
+
+#define KEY_SIZE 20
+
+static void *
+test_alloc(void *user_data, size_t size, size_t align,
+           VkSystemAllocationScope scope)
+{
+   return malloc(size);
+}
+
+static void *
+test_realloc(void *user_data, void *mem, size_t size, size_t align,
+             VkSystemAllocationScope scope)
+{
+   return realloc(mem, size);
+}
+
+static void
+test_free(void *user_data, void *mem)
+{
+   free(mem);
+}
+
+static void
+make_key(uint8_t *key, uint32_t i)
+{
+   memset(key, 0, KEY_SIZE);
+   memcpy(key, &i, sizeof(i));
+}
+
+static void
+make_kernel(uint32_t *kernel, uint32_t kernel_size, uint32_t i)
+{
+   for (uint32_t j = 0; j < kernel_size / 4; j++)
+      kernel[j] = i * 0x9e3779b9 + j;
+}
+
+static void
+fill_cache(struct anv_pipeline_cache *cache, uint32_t n_shaders,
+           uint32_t kernel_size)
+{
+   const struct brw_stage_prog_data prog_data = { 0 };
+   const struct anv_pipeline_bind_map bind_map = { 0 };
+   uint32_t *kernel = malloc(kernel_size);
+   uint8_t key[KEY_SIZE];
+
+   for (uint32_t i = 0; i < n_shaders; i++) {
+      make_key(key, i);
+      make_kernel(kernel, kernel_size, i);
+
+      struct anv_shader_bin *bin =
+         anv_pipeline_cache_upload_kernel(cache, key, sizeof(key),
+                                          kernel, kernel_size, NULL, 0,
+                                          &prog_data, sizeof(prog_data),
+                                          NULL, 0, NULL, &bind_map);
+      assert(bin);
+      anv_shader_bin_unref(cache->device, bin);
+   }
+
+   free(kernel);
+}
+
+static void *
+get_cache_data(struct anv_device *device, struct anv_pipeline_cache *cache,
+               size_t *size)
+{
+   VkResult result =
+      anv_GetPipelineCacheData(anv_device_to_handle(device),
+                               anv_pipeline_cache_to_handle(cache),
+                               size, NULL);
+   assert(result == VK_SUCCESS);
+
+   void *data = malloc(*size);
+   result = anv_GetPipelineCacheData(anv_device_to_handle(device),
+                                     anv_pipeline_cache_to_handle(cache),
+                                     size, data);
+   assert(result == VK_SUCCESS);
+
+   return data;
+}
+
+static struct anv_pipeline_cache *
+create_cache(struct anv_device *device, const void *data, size_t size)
+{
+   const VkPipelineCacheCreateInfo info = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+      .initialDataSize = size,
+      .pInitialData = data,
+   };
+   VkPipelineCache handle;
+
+   VkResult result = anv_CreatePipelineCache(anv_device_to_handle(device),
+                                             &info, NULL, &handle);
+   assert(result == VK_SUCCESS);
+
+   return anv_pipeline_cache_from_handle(handle);
+}
+
+static void
+destroy_cache(struct anv_device *device, struct anv_pipeline_cache *cache)
+{
+   anv_DestroyPipelineCache(anv_device_to_handle(device),
+                            anv_pipeline_cache_to_handle(cache), NULL);
+}
+
+static void
+check_shader(struct anv_pipeline_cache *cache, uint32_t i,
+             uint32_t kernel_size)
+{
+   uint8_t key[KEY_SIZE];
+   make_key(key, i);
+
+   struct anv_shader_bin *bin =
+      anv_pipeline_cache_search(cache, key, sizeof(key));
+   assert(bin);
+   assert(bin->kernel_size == kernel_size);
+
+   uint32_t *kernel = malloc(kernel_size);
+   make_kernel(kernel, kernel_size, i);
+   assert(memcmp(bin->kernel.map, kernel, kernel_size) == 0);
+   free(kernel);
+
+   anv_shader_bin_unref(cache->device, bin);
+}
+
+static void
+test_round_trip(struct anv_device *device)
+{
+   const uint32_t n_shaders = 64, kernel_size = 256;
+
+   struct anv_pipeline_cache src;
+   anv_pipeline_cache_init(&src, device, true);
+   fill_cache(&src, n_shaders, kernel_size);
+
+   size_t size;
+   void *data = get_cache_data(device, &src, &size);
+   anv_pipeline_cache_finish(&src);
+
+   /* Nothing gets created until it is looked up. */
+   struct anv_pipeline_cache *cache = create_cache(device, data, size);
+   free(data);
+   assert(cache->cache->entries == 0);
+   assert(cache->lazy_cache->entries == n_shaders);
+
+   for (uint32_t i = 0; i < n_shaders; i += 4)
+      check_shader(cache, i, kernel_size);
+   assert(cache->cache->entries == n_shaders / 4);
+   assert(cache->lazy_cache->entries == n_shaders - n_shaders / 4);
+
+   /* A mix of created and serialized shaders is written back out whole. */
+   size_t size2;
+   void *data2 = get_cache_data(device, cache, &size2);
+   struct anv_pipeline_cache *cache2 = create_cache(device, data2, size2);
+   free(data2);
+   assert(cache2->lazy_cache->entries == n_shaders);
+   for (uint32_t i = 0; i < n_shaders; i++)
+      check_shader(cache2, i, kernel_size);
+   destroy_cache(device, cache2);
+
+   /* Merging has to keep the shaders alive after the source is gone. */
+   struct anv_pipeline_cache *dst = create_cache(device, NULL, 0);
+   VkPipelineCache src_handle = anv_pipeline_cache_to_handle(cache);
+   anv_MergePipelineCaches(anv_device_to_handle(device),
+                           anv_pipeline_cache_to_handle(dst), 1, &src_handle);
+   destroy_cache(device, cache);
+   assert(dst->cache->entries == n_shaders);
+   for (uint32_t i = 0; i < n_shaders; i++)
+      check_shader(dst, i, kernel_size);
+   destroy_cache(device, dst);
+}
+
+static void
+init_device(struct anv_device *device)
+{
+   pthread_mutex_init(&device->mutex, NULL);
+   anv_bo_cache_init(&device->bo_cache);
+   anv_state_pool_init(&device->dynamic_state_pool, device, 4096, 16384);
+   anv_state_pool_init(&device->instruction_state_pool, device, 4096, 16384);
+}
+
+static void
+finish_device(struct anv_device *device)
+{
+   anv_state_pool_finish(&device->instruction_state_pool);
+   anv_state_pool_finish(&device->dynamic_state_pool);
+   anv_bo_cache_finish(&device->bo_cache);
+   pthread_mutex_destroy(&device->mutex);
+}
+
+static void
+bench(struct anv_device *device)
+{
+   const uint32_t n_shaders = 8192, kernel_size = 16384, n_lookups = 64;
+
+   struct anv_pipeline_cache src;
+   anv_pipeline_cache_init(&src, device, true);
+   fill_cache(&src, n_shaders, kernel_size);
+
+   size_t size;
+   void *data = get_cache_data(device, &src, &size);
+   anv_pipeline_cache_finish(&src);
+
+   /* Start from empty state pools, like an application loading its cache
+    * at startup would.
+    */
+   finish_device(device);
+   init_device(device);
+
+   int64_t start = os_time_get_nano();
+   struct anv_pipeline_cache *cache = create_cache(device, data, size);
+   int64_t load_ns = os_time_get_nano() - start;
+
+   start = os_time_get_nano();
+   for (uint32_t i = 0; i < n_lookups; i++)
+      check_shader(cache, i * (n_shaders / n_lookups), kernel_size);
+   int64_t lookup_ns = os_time_get_nano() - start;
+
+   printf("load %zu MB, %u shaders: %.2f ms\n", size >> 20, n_shaders,
+          load_ns / 1000000.0);
+   printf("first lookup of %u shaders: %.2f us each\n", n_lookups,
+          lookup_ns / 1000.0 / n_lookups);
+
+   destroy_cache(device, cache);
+   free(data);
+}
+
+int main(int argc, char **argv)
+{
+   struct anv_instance instance = {
+      .pipeline_cache_enabled = true,
+   };
+   struct anv_device device = {
+      .alloc = {
+         .pfnAllocation = test_alloc,
+         .pfnReallocation = test_realloc,
+         .pfnFree = test_free,
+      },
+      .instance = &instance,
+      .chipset_id = 0x1234,
+   };
+
+   memset(instance.physicalDevice.pipeline_cache_uuid, 0x42, VK_UUID_SIZE);
+
+   init_device(&device);
+
+   if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+      bench(&device);
+   else
+      test_round_trip(&device);
+
+   finish_device(&device);
+}
@@ -116,6 +116,7 @@ brw_blorp_init(struct brw_context *brw)
 
    brw->blorp.lookup_shader = brw_blorp_lookup_shader;
    brw->blorp.upload_shader = brw_blorp_upload_shader;
+   brw->blorp.disk_cache = brw->screen->disk_cache;
 }
 
 static void
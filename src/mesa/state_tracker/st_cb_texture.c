@@ -1485,16 +1485,33 @@ st_TexSubImage(struct gl_context *ctx, GLuint dims,
    if (!dst)
       goto fallback;
 
-   /* Try texture_subdata, which should be the fastest memcpy path. */
-   if (pixels &&
-       !_mesa_is_bufferobj(unpack->BufferObj) &&
+   /* Try texture_subdata, which should be the fastest memcpy path.
+    *
+    * PBO sources are only taken through it if the driver doesn't prefer
+    * blit-based transfers, i.e. when mapping the PBO is cheap (software
+    * drivers).  The PBO contents are then copied straight into the
+    * texture instead of going through texstore.
+    */
+   if ((_mesa_is_bufferobj(unpack->BufferObj) ?
+        !st->prefer_blit_based_texture_transfer : pixels != NULL) &&
        _mesa_texstore_can_use_memcpy(ctx, texImage->_BaseFormat,
                                      texImage->TexFormat, format, type,
                                      unpack)) {
+      const bool is_pbo = _mesa_is_bufferobj(unpack->BufferObj);
       struct pipe_box box;
       unsigned stride, layer_stride;
       void *data;
 
+      if (is_pbo) {
+         pixels = _mesa_validate_pbo_teximage(ctx, dims, width, height,
+                                              depth, format, type, pixels,
+                                              unpack, "glTexSubImage");
+         if (!pixels) {
+            /* This is a GL error. */
+            return;
+         }
+      }
+
       stride = _mesa_image_row_stride(unpack, width, format, type);
       layer_stride = _mesa_image_image_stride(unpack, width, height, format,
                                               type);
@@ -1517,6 +1534,9 @@ st_TexSubImage(struct gl_context *ctx, GLuint dims,
       u_box_3d(xoffset, yoffset, zoffset + dstz, width, height, depth, &box);
       pipe->texture_subdata(pipe, dst, dst_level, 0,
                             &box, data, stride, layer_stride);
+
+      if (is_pbo)
+         _mesa_unmap_teximage_pbo(ctx, unpack);
       return;
    }
 
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include "util/bitset.h"
 #include "util/macros.h"
 #include "util/u_math.h"
 #include "lcra.h"
@@ -52,7 +53,7 @@ lcra_alloc_equations(
         l->bound = bound;
 
         l->alignment = calloc(sizeof(l->alignment[0]), node_count);
-        l->linear = calloc(sizeof(l->linear[0]), node_count * node_count);
+        l->linear = calloc(sizeof(l->linear[0]), node_count);
         l->modulus = calloc(sizeof(l->modulus[0]), node_count);
         l->class = calloc(sizeof(l->class[0]), node_count);
         l->class_start = calloc(sizeof(l->class_start[0]), class_count);
@@ -72,6 +73,9 @@ lcra_free(struct lcra_state *l)
         if (!l)
                 return;
 
+        for (unsigned i = 0; i < l->node_count; ++i)
+                free(l->linear[i].constraints);
+
         free(l->alignment);
         free(l->linear);
         free(l->modulus);
@@ -105,6 +109,36 @@ lcra_restrict_range(struct lcra_state *l, unsigned node, unsigned len)
                 l->modulus[node] = DIV_ROUND_UP(l->bound - len + 1, 1 << (l->alignment[node] - 1));
 }
 
+static void
+lcra_add_constraint(struct lcra_state *l, unsigned i, unsigned j, uint32_t constraint)
+{
+        struct lcra_row *row = &l->linear[i];
+
+        if (!constraint)
+                return;
+
+        /* Interference tends to be added for the same pair back-to-back, so
+         * fold those in place; other duplicates are merged by lcra_compact */
+
+        if (row->count && row->constraints[row->count - 1].node == j) {
+                row->constraints[row->count - 1].constraint |= constraint;
+                return;
+        }
+
+        if (row->count == row->size) {
+                row->size = MAX2(16, row->size * 2);
+                row->constraints = realloc(row->constraints,
+                                row->size * sizeof(row->constraints[0]));
+        }
+
+        row->constraints[row->count++] = (struct lcra_constraint) {
+                .node = j,
+                .constraint = constraint
+        };
+
+        l->compacted = false;
+}
+
 void
 lcra_add_node_interference(struct lcra_state *l, unsigned i, unsigned cmask_i, unsigned j, unsigned cmask_j)
 {
@@ -129,34 +163,96 @@ lcra_add_node_interference(struct lcra_state *l, unsigned i, unsigned cmask_i, u
                 }
         }
 
-        l->linear[j * l->node_count + i] |= constraint_fw;
-        l->linear[i * l->node_count + j] |= constraint_bw;
+        lcra_add_constraint(l, j, i, constraint_fw);
+        lcra_add_constraint(l, i, j, constraint_bw);
 }
 
-static bool
-lcra_test_linear(struct lcra_state *l, unsigned *solutions, unsigned i)
+static int
+lcra_compare_constraints(const void *a, const void *b)
 {
-        unsigned *row = &l->linear[i * l->node_count];
-        signed constant = solutions[i];
+        const struct lcra_constraint *ca = a;
+        const struct lcra_constraint *cb = b;
+
+        return (ca->node > cb->node) - (ca->node < cb->node);
+}
 
-        for (unsigned j = 0; j < l->node_count; ++j) {
-                if (solutions[j] == ~0) continue;
+/* Sort each row and merge duplicate entries, so each (i, j) pair appears at
+ * most once, as it would in a dense matrix. */
 
-                signed lhs = solutions[j] - constant;
+static void
+lcra_compact(struct lcra_state *l)
+{
+        if (l->compacted)
+                return;
 
-                if (lhs < -15 || lhs > 15)
+        for (unsigned i = 0; i < l->node_count; ++i) {
+                struct lcra_row *row = &l->linear[i];
+
+                if (row->count < 2)
                         continue;
 
-                if (row[j] & (1 << (lhs + 15)))
-                        return false;
+                qsort(row->constraints, row->count, sizeof(row->constraints[0]),
+                                lcra_compare_constraints);
+
+                unsigned count = 1;
+
+                for (unsigned k = 1; k < row->count; ++k) {
+                        struct lcra_constraint *last = &row->constraints[count - 1];
+
+                        if (row->constraints[k].node == last->node)
+                                last->constraint |= row->constraints[k].constraint;
+                        else
+                                row->constraints[count++] = row->constraints[k];
+                }
+
+                row->count = count;
         }
 
-        return true;
+        l->compacted = true;
+}
+
+/* Rather than testing each candidate solution against every other node, mark
+ * the solutions ruled out by the node's solved neighbours in a bitset up
+ * front, so testing a candidate is a single bit test */
+
+static void
+lcra_forbidden_solutions(struct lcra_state *l, unsigned i,
+                BITSET_WORD *forbidden, unsigned solution_count)
+{
+        struct lcra_row *row = &l->linear[i];
+
+        memset(forbidden, 0, BITSET_WORDS(solution_count) * sizeof(BITSET_WORD));
+
+        for (unsigned k = 0; k < row->count; ++k) {
+                unsigned j = row->constraints[k].node;
+                uint32_t constraint = row->constraints[k].constraint;
+
+                if (l->solutions[j] == ~0) continue;
+
+                /* Bit (lhs + 15) forbids solutions[j] - solutions[i] == lhs */
+
+                while (constraint) {
+                        signed bit = u_bit_scan(&constraint);
+                        signed solution = (signed) l->solutions[j] - (bit - 15);
+
+                        if (solution >= 0 && solution < solution_count)
+                                BITSET_SET(forbidden, solution);
+                }
+        }
 }
 
 bool
 lcra_solve(struct lcra_state *l)
 {
+        lcra_compact(l);
+
+        unsigned solution_count = 0;
+
+        for (unsigned c = 0; c < l->class_count; ++c)
+                solution_count = MAX2(solution_count, l->class_start[c] + l->class_size[c]);
+
+        BITSET_WORD *forbidden = calloc(BITSET_WORDS(solution_count), sizeof(BITSET_WORD));
+
         for (unsigned step = 0; step < l->node_count; ++step) {
                 if (l->solutions[step] != ~0) continue;
                 if (l->alignment[step] == 0) continue;
@@ -173,10 +269,12 @@ lcra_solve(struct lcra_state *l)
                 unsigned m_max = k_max / P;
                 bool succ = false;
 
+                lcra_forbidden_solutions(l, step, forbidden, solution_count);
+
                 for (unsigned m = 0; m < m_max; ++m) {
                         for (unsigned n = 0; n < Q; ++n) {
                                 l->solutions[step] = ((m * P + n) << shift) + class_start;
-                                succ = lcra_test_linear(l, l->solutions, step);
+                                succ = !BITSET_TEST(forbidden, l->solutions[step]);
 
                                 if (succ) break;
                         }
@@ -187,10 +285,12 @@ lcra_solve(struct lcra_state *l)
                 /* Out of registers - prepare to spill */
                 if (!succ) {
                         l->spill_class = l->class[step];
+                        free(forbidden);
                         return false;
                 }
         }
 
+        free(forbidden);
         return true;
 }
 
@@ -210,10 +310,12 @@ static unsigned
 lcra_count_constraints(struct lcra_state *l, unsigned i)
 {
         unsigned count = 0;
-        unsigned *constraints = &l->linear[i * l->node_count];
+        struct lcra_row *row = &l->linear[i];
 
-        for (unsigned j = 0; j < i; ++j)
-                count += util_bitcount(constraints[j]);
+        for (unsigned k = 0; k < row->count; ++k) {
+                if (row->constraints[k].node < i)
+                        count += util_bitcount(row->constraints[k].constraint);
+        }
 
         return count;
 }
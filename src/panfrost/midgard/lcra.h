@@ -30,6 +30,18 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/* One nonzero entry of a row of the constraint matrix */
+
+struct lcra_constraint {
+        unsigned node;
+        uint32_t constraint;
+};
+
+struct lcra_row {
+        struct lcra_constraint *constraints;
+        unsigned count, size;
+};
+
 struct lcra_state {
         unsigned node_count;
 
@@ -41,8 +53,10 @@ struct lcra_state {
          * integers. Zero is the sentinel for a missing node */
         unsigned *alignment;
 
-        /* Linear constraints imposed. Nested array sized upfront, organized as
-         * linear[node_left][node_right]. That is, calculate indices as:
+        /* Linear constraints imposed. The constraint matrix is sparse, so it
+         * is stored as one row per node_left, listing the node_right with a
+         * nonzero entry. Rows are unsorted and may contain duplicates until
+         * lcra_solve compacts them.
          *
          * Each element is itself a bit field denoting whether (c_j - c_i) bias
          * is present or not, including negative biases.
@@ -50,7 +64,8 @@ struct lcra_state {
          * Note for Midgard, there are 16 components so the bias is in range
          * [-15, 15] so encoded by 32-bit field. */
 
-        uint32_t *linear;
+        struct lcra_row *linear;
+        bool compacted;
 
         /* Per node max modulus constraints */
         uint8_t *modulus;
@@ -0,0 +1,187 @@
+/*
+ * Copyright © 2019 Broadcom
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#undef NDEBUG
+
+#include "util/macros.h"
+#include "util/u_tiling.h"
+#include "util/os_time.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IMAGE_W 256
+#define IMAGE_H 256
+
+struct test_layout {
+   const char *name;
+   struct util_tile_layout layout;
+};
+
+static const struct test_layout layouts[] = {
+   /* etnaviv 4x4 TILED */
+   { "etna_tiled_cpp1", { 4, 4, 1, IMAGE_W * 4 * 1 } },
+   { "etna_tiled_cpp2", { 4, 4, 2, IMAGE_W * 4 * 2 } },
+   { "etna_tiled_cpp4", { 4, 4, 4, IMAGE_W * 4 * 4 } },
+   { "etna_tiled_cpp8", { 4, 4, 8, IMAGE_W * 4 * 8 } },
+   /* vc4 LT utiles */
+   { "vc4_lt_cpp1", { 8, 8, 1, IMAGE_W * 8 * 1 } },
+   { "vc4_lt_cpp2", { 8, 4, 2, IMAGE_W * 4 * 2 } },
+   { "vc4_lt_cpp4", { 4, 4, 4, IMAGE_W * 4 * 4 } },
+   { "vc4_lt_cpp8", { 2, 4, 8, IMAGE_W * 4 * 8 } },
+};
+
+static uint8_t *
+ref_element(const struct util_tile_layout *l, uint8_t *tiled,
+            uint32_t x, uint32_t y)
+{
+   uint32_t tile_size = l->tile_w * l->tile_h * l->cpp;
+
+   return tiled + (y / l->tile_h) * l->tile_row_stride +
+          (x / l->tile_w) * tile_size +
+          ((y % l->tile_h) * l->tile_w + x % l->tile_w) * l->cpp;
+}
+
+static void
+fill_random(uint8_t *data, size_t size)
+{
+   for (size_t i = 0; i < size; i++)
+      data[i] = rand();
+}
+
+static void
+test_box(const struct util_tile_layout *l,
+         uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+{
+   const size_t tiled_size = (size_t)l->tile_row_stride *
+                             (IMAGE_H / l->tile_h);
+   const uint32_t linear_stride = w * l->cpp + 3;
+
+   uint8_t *tiled = malloc(tiled_size);
+   uint8_t *expected = malloc(tiled_size);
+   uint8_t *linear = malloc((size_t)linear_stride * h);
+   uint8_t *readback = calloc(1, (size_t)linear_stride * h);
+   assert(tiled && expected && linear && readback);
+
+   fill_random(tiled, tiled_size);
+   memcpy(expected, tiled, tiled_size);
+   fill_random(linear, (size_t)linear_stride * h);
+
+   for (uint32_t j = 0; j < h; j++) {
+      for (uint32_t i = 0; i < w; i++) {
+         memcpy(ref_element(l, expected, x + i, y + j),
+                linear + j * linear_stride + i * l->cpp, l->cpp);
+      }
+   }
+
+   /* Stores must touch exactly the elements inside the box. */
+   util_tile_store(l, tiled, linear, linear_stride, x, y, w, h);
+   assert(memcmp(tiled, expected, tiled_size) == 0);
+
+   util_tile_load(l, readback, linear_stride, tiled, x, y, w, h);
+   for (uint32_t j = 0; j < h; j++) {
+      assert(memcmp(readback + j * linear_stride,
+                    linear + j * linear_stride, w * l->cpp) == 0);
+   }
+
+   free(tiled);
+   free(expected);
+   free(linear);
+   free(readback);
+}
+
+static void
+bench_layout(const struct test_layout *t)
+{
+   const struct util_tile_layout *l = &t->layout;
+   const size_t size = (size_t)IMAGE_W * IMAGE_H * l->cpp;
+   const unsigned iterations = 200;
+
+   uint8_t *tiled = malloc(size);
+   uint8_t *linear = malloc(size);
+   assert(tiled && linear);
+   fill_random(linear, size);
+
+   int64_t start = os_time_get_nano();
+   for (unsigned i = 0; i < iterations; i++) {
+      util_tile_store(l, tiled, linear, IMAGE_W * l->cpp,
+                      0, 0, IMAGE_W, IMAGE_H);
+   }
+   int64_t store_ns = os_time_get_nano() - start;
+
+   start = os_time_get_nano();
+   for (unsigned i = 0; i < iterations; i++) {
+      util_tile_load(l, linear, IMAGE_W * l->cpp, tiled,
+                     0, 0, IMAGE_W, IMAGE_H);
+   }
+   int64_t load_ns = os_time_get_nano() - start;
+
+   double mb = (double)size * iterations / (1024 * 1024);
+   printf("%-16s store %8.1f MB/s  load %8.1f MB/s\n", t->name,
+          mb / (store_ns / 1e9), mb / (load_ns / 1e9));
+
+   free(tiled);
+   free(linear);
+}
+
+int
+main(int argc, char **argv)
+{
+   bool bench = argc > 1 && strcmp(argv[1], "--bench") == 0;
+
+   srand(0);
+
+   for (unsigned i = 0; i < ARRAY_SIZE(layouts); i++) {
+      const struct util_tile_layout *l = &layouts[i].layout;
+
+      /* Aligned, unaligned on either edge, inside a single tile, and the
+       * whole image.
+       */
+      test_box(l, 0, 0, IMAGE_W, IMAGE_H);
+      test_box(l, 0, 0, 1, 1);
+      test_box(l, 1, 1, 1, 1);
+      test_box(l, 3, 5, 2, 2);
+      test_box(l, 1, 2, 37, 19);
+      test_box(l, 16, 8, 64, 32);
+      test_box(l, 13, 29, 200, 100);
+      test_box(l, IMAGE_W - 7, IMAGE_H - 5, 7, 5);
+
+      for (unsigned r = 0; r < 64; r++) {
+         uint32_t x = rand() % IMAGE_W;
+         uint32_t y = rand() % IMAGE_H;
+         uint32_t w = 1 + rand() % (IMAGE_W - x);
+         uint32_t h = 1 + rand() % (IMAGE_H - y);
+         test_box(l, x, y, w, h);
+      }
+   }
+
+   if (bench) {
+      for (unsigned i = 0; i < ARRAY_SIZE(layouts); i++)
+         bench_layout(&layouts[i]);
+   }
+
+   return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright © 2019 Broadcom
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "u_tiling.h"
+#include "macros.h"
+#include "u_math.h"
+
+/* Each row of the rectangle is split into a partial tile row at the start, a
+ * run of whole tile rows, and a partial tile row at the end.  A whole tile
+ * row is tile_w * cpp contiguous bytes, and this is where nearly all of the
+ * time goes for any sizeable copy.
+ *
+ * The copy is specialized on the tile row size, so that the whole tile rows
+ * are moved with a fixed-size memcpy().  The compiler turns those into one or
+ * two vector loads and stores (SSE2 on x86-64, NEON on aarch64 and armv7
+ * builds with NEON), rather than a call or a per-element loop.
+ */
+static ALWAYS_INLINE void
+tile_copy_rows(const struct util_tile_layout *layout,
+               uint8_t *tiled, uint8_t *linear, uint32_t linear_stride,
+               uint32_t x, uint32_t y, uint32_t w, uint32_t h,
+               uint32_t span, bool store)
+{
+   const uint32_t tile_w = layout->tile_w;
+   const uint32_t tile_h = layout->tile_h;
+   const uint32_t cpp = layout->cpp;
+   const uint32_t tile_size = span * tile_h;
+
+   const uint32_t head = MIN2(w, (tile_w - x % tile_w) % tile_w);
+   const uint32_t body_tiles = (w - head) / tile_w;
+   const uint32_t tail = w - head - body_tiles * tile_w;
+   const uint32_t first_tile = DIV_ROUND_UP(x, tile_w);
+
+   for (uint32_t row = 0; row < h; row++) {
+      const uint32_t ty = y + row;
+      uint8_t *tiled_row = tiled + (ty / tile_h) * layout->tile_row_stride +
+                           (ty % tile_h) * span;
+      uint8_t *lin = linear + row * linear_stride;
+
+      if (head) {
+         uint8_t *t = tiled_row + (x / tile_w) * tile_size +
+                      (x % tile_w) * cpp;
+         if (store)
+            memcpy(t, lin, head * cpp);
+         else
+            memcpy(lin, t, head * cpp);
+         lin += head * cpp;
+      }
+
+      uint8_t *t = tiled_row + first_tile * tile_size;
+      for (uint32_t i = 0; i < body_tiles; i++) {
+         if (store)
+            memcpy(t, lin, span);
+         else
+            memcpy(lin, t, span);
+         t += tile_size;
+         lin += span;
+      }
+
+      if (tail) {
+         if (store)
+            memcpy(t, lin, tail * cpp);
+         else
+            memcpy(lin, t, tail * cpp);
+      }
+   }
+}
+
+static ALWAYS_INLINE void
+tile_copy(const struct util_tile_layout *layout,
+          uint8_t *tiled, uint8_t *linear, uint32_t linear_stride,
+          uint32_t x, uint32_t y, uint32_t w, uint32_t h, bool store)
+{
+   const uint32_t span = layout->tile_w * layout->cpp;
+
+   switch (span) {
+   case 4:
+      tile_copy_rows(layout, tiled, linear, linear_stride, x, y, w, h,
+                     4, store);
+      break;
+   case 8:
+      tile_copy_rows(layout, tiled, linear, linear_stride, x, y, w, h,
+                     8, store);
+      break;
+   case 16:
+      tile_copy_rows(layout, tiled, linear, linear_stride, x, y, w, h,
+                     16, store);
+      break;
+   case 32:
+      tile_copy_rows(layout, tiled, linear, linear_stride, x, y, w, h,
+                     32, store);
+      break;
+   case 64:
+      tile_copy_rows(layout, tiled, linear, linear_stride, x, y, w, h,
+                     64, store);
+      break;
+   default:
+      tile_copy_rows(layout, tiled, linear, linear_stride, x, y, w, h,
+                     span, store);
+      break;
+   }
+}
+
+void
+util_tile_store(const struct util_tile_layout *layout,
+                void *tiled, const void *linear, uint32_t linear_stride,
+                uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+{
+   tile_copy(layout, tiled, (uint8_t *)linear, linear_stride,
+             x, y, w, h, true);
+}
+
+void
+util_tile_load(const struct util_tile_layout *layout,
+               void *linear, uint32_t linear_stride, const void *tiled,
+               uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+{
+   tile_copy(layout, (uint8_t *)tiled, linear, linear_stride,
+             x, y, w, h, false);
+}
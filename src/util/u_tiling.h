@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2019 Broadcom
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * u_tiling copies rectangles between linear memory and images made of
+ * fixed-size tiles, where the elements of a tile are stored contiguously in
+ * row-major order and the tiles themselves are laid out row-major.
+ *
+ * This covers the simple tiled layouts of several embedded GPUs, such as the
+ * 4x4 TILED layout of Vivante and the LT (raster order microtile) layout of
+ * VideoCore IV.  Layouts that also permute elements within a tile aren't
+ * handled here.
+ */
+
+#ifndef U_TILING_H
+#define U_TILING_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct util_tile_layout {
+   /** Tile width in elements */
+   uint32_t tile_w;
+   /** Tile height in elements */
+   uint32_t tile_h;
+   /** Bytes per element */
+   uint32_t cpp;
+   /** Bytes from the start of one row of tiles to the start of the next */
+   uint32_t tile_row_stride;
+};
+
+/**
+ * Copies a w x h rectangle of elements from linear memory to position (x, y)
+ * of a tiled image.
+ */
+void
+util_tile_store(const struct util_tile_layout *layout,
+                void *tiled, const void *linear, uint32_t linear_stride,
+                uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+
+/**
+ * Copies a w x h rectangle of elements at position (x, y) of a tiled image
+ * to linear memory.
+ */
+void
+util_tile_load(const struct util_tile_layout *layout,
+               void *linear, uint32_t linear_stride, const void *tiled,
+               uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_TILING_H */
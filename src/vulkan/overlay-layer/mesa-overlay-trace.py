@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+'''
+Records and analyzes the binary trace of the MESA_overlay layer.
+
+The trace is either written by the layer itself with
+VK_LAYER_MESA_OVERLAY_CONFIG=trace_file=/path/to/trace.bin or streamed through
+the control socket with the 'record' command of this script.
+'''
+import argparse
+import socket
+import struct
+import sys
+import time
+
+DEFAULT_SERVER_ADDRESS = "\0mesa_overlay"
+
+TRACE_MAGIC = b'MESAOVTR'
+TRACE_VERSION = 1
+TRACE_ACK = b':TraceVersion='
+
+HEADER = struct.Struct('=8sIIII')
+RECORD_HEADER = struct.Struct('=IIQQ')
+
+RECORD_FRAME = 1
+RECORD_COMMAND_BUFFER = 2
+RECORD_DROPPED = 3
+
+# Values which are durations, and their unit
+TIME_UNITS = {
+    'frame_timing': 'us',
+    'acquire_timing': 'us',
+    'present_timing': 'us',
+    'gpu_timing': 'ns',
+}
+
+def record(args):
+    address = '\0' + args.socket if args.socket else DEFAULT_SERVER_ADDRESS
+
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    try:
+        sock.connect(address)
+    except socket.error as msg:
+        print(msg)
+        sys.exit(1)
+
+    sock.send(bytearray(':trace=1;', 'utf-8'))
+
+    # Skip the connection string up to the acknowledgement, everything after
+    # it is the binary trace.
+    data = bytes()
+    sock.settimeout(1.0)
+    while True:
+        try:
+            msg = sock.recv(4096)
+        except socket.timeout:
+            msg = None
+        if not msg:
+            print('ERROR: no answer to the trace request')
+            sys.exit(1)
+        data += msg
+        pos = data.find(TRACE_ACK)
+        if pos >= 0 and data.find(b';', pos) >= 0:
+            end = data.find(b';', pos)
+            if data[pos + len(TRACE_ACK):end] != bytes(str(TRACE_VERSION), 'utf-8'):
+                print('ERROR: trace not available')
+                sys.exit(1)
+            data = data[end + 1:]
+            break
+
+    sock.settimeout(None)
+    deadline = time.monotonic() + args.duration if args.duration else None
+    with open(args.output, 'wb') as f:
+        f.write(data)
+        try:
+            while deadline is None or time.monotonic() < deadline:
+                if deadline is not None:
+                    sock.settimeout(max(0.0, deadline - time.monotonic()))
+                try:
+                    msg = sock.recv(65536)
+                except socket.timeout:
+                    break
+                if not msg:
+                    break
+                f.write(msg)
+        except KeyboardInterrupt:
+            pass
+
+def read_trace(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    if len(data) < HEADER.size:
+        print('ERROR: truncated trace')
+        sys.exit(1)
+
+    magic, version, record_size, n_values, names_size = HEADER.unpack_from(data)
+    if magic != TRACE_MAGIC or version != TRACE_VERSION:
+        print('ERROR: not a MESA_overlay trace, or unsupported version')
+        sys.exit(1)
+
+    names = data[HEADER.size:HEADER.size + names_size].split(b'\0')
+    names = [n.decode('utf-8') for n in names[:n_values]]
+
+    values = struct.Struct('={}Q'.format(n_values))
+    records = []
+    offset = HEADER.size + names_size
+    while offset + record_size <= len(data):
+        rtype, swapchain, frame, timestamp = RECORD_HEADER.unpack_from(data, offset)
+        v = values.unpack_from(data, offset + RECORD_HEADER.size)
+        records.append((rtype, swapchain, frame, timestamp, v))
+        offset += record_size
+
+    return names, records
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return 0
+    k = (len(sorted_values) - 1) * p / 100.0
+    lo = int(k)
+    hi = min(lo + 1, len(sorted_values) - 1)
+    return sorted_values[lo] + (sorted_values[hi] - sorted_values[lo]) * (k - lo)
+
+def print_table(title, names, rows, percentiles):
+    print(title)
+    if not rows:
+        print('  no records\n')
+        return
+
+    columns = ['mean'] + ['p{:g}'.format(p) for p in percentiles] + ['max']
+    print('  {:<28}'.format('(%d records)' % len(rows)) +
+          ''.join('{:>14}'.format(c) for c in columns))
+
+    for i, name in enumerate(names):
+        column = sorted(r[i] for r in rows)
+        if column[-1] == 0:
+            continue
+        label = name
+        if name in TIME_UNITS:
+            label += ' (' + TIME_UNITS[name] + ')'
+        stats = [sum(column) / len(column)]
+        stats += [percentile(column, p) for p in percentiles]
+        stats += [column[-1]]
+        print('  {:<28}'.format(label) +
+              ''.join('{:>14.1f}'.format(s) for s in stats))
+    print('')
+
+def analyze(args):
+    names, records = read_trace(args.trace)
+    percentiles = [float(p) for p in args.percentiles.split(',')]
+
+    dropped = sum(r[4][0] for r in records if r[0] == RECORD_DROPPED)
+    swapchains = sorted(set(r[1] for r in records if r[0] == RECORD_FRAME))
+
+    for s in swapchains:
+        frames = [r[4] for r in records if r[0] == RECORD_FRAME and r[1] == s]
+        # The first frame has no previous present to time against.
+        print_table('Swapchain {} frames'.format(s), names, frames[1:],
+                    percentiles)
+
+        cmd_buffers = [r[4] for r in records
+                       if r[0] == RECORD_COMMAND_BUFFER and r[1] == s]
+        if cmd_buffers:
+            print_table('Swapchain {} command buffers'.format(s), names,
+                        cmd_buffers, percentiles)
+
+    if dropped:
+        print('{} records were dropped while tracing'.format(dropped))
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='MESA_overlay trace tool')
+
+    commands = parser.add_subparsers(help='commands to run', dest='cmd')
+
+    record_parser = commands.add_parser('record',
+                                        help='Stream the trace of a running application to a file')
+    record_parser.add_argument('--socket', '-s', type=str, help='Path to socket')
+    record_parser.add_argument('--duration', '-d', type=float,
+                               help='Seconds to record for, until interrupted by default')
+    record_parser.add_argument('output', type=str, help='Trace file to write')
+
+    analyze_parser = commands.add_parser('analyze',
+                                         help='Print percentiles of the statistics in a trace')
+    analyze_parser.add_argument('--percentiles', '-p', type=str,
+                                default='50,90,95,99',
+                                help='Comma separated list of percentiles')
+    analyze_parser.add_argument('trace', type=str, help='Trace file to read')
+
+    args = parser.parse_args()
+
+    if args.cmd == 'record':
+        record(args)
+    elif args.cmd == 'analyze':
+        analyze(args)
+    else:
+        parser.print_help()
@@ -33,6 +33,7 @@
 #include "imgui.h"
 
 #include "overlay_params.h"
+#include "overlay_trace.h"
 
 #include "util/debug.h"
 #include "util/hash_table.h"
@@ -41,6 +42,7 @@
 #include "util/os_time.h"
 #include "util/os_socket.h"
 #include "util/simple_mtx.h"
+#include "util/u_atomic.h"
 
 #include "vk_enum_to_str.h"
 #include "vk_util.h"
@@ -62,6 +64,15 @@ struct instance_data {
 
    /* Dumping of frame stats to a file has been enabled and started. */
    bool capture_started;
+
+   /* Binary per-frame trace, NULL until a trace_file is given or a control
+    * client asks for the trace.  Presents on other threads read it, so it is
+    * created under trace_mutex and read with get_trace().
+    */
+   simple_mtx_t trace_mutex;
+   struct overlay_trace *trace;
+
+   uint32_t n_swapchains;
 };
 
 struct frame_stat {
@@ -142,6 +153,7 @@ struct swapchain_data {
    struct device_data *device;
 
    VkSwapchainKHR swapchain;
+   uint32_t index; /* swapchain number within the instance */
    unsigned width, height;
    VkFormat format;
 
@@ -324,14 +336,24 @@ static struct instance_data *new_instance_data(VkInstance instance)
    struct instance_data *data = rzalloc(NULL, struct instance_data);
    data->instance = instance;
    data->control_client = -1;
+   simple_mtx_init(&data->trace_mutex, mtx_plain);
    map_object(HKEY(data->instance), data);
    return data;
 }
 
+static struct overlay_trace *get_trace(struct instance_data *data)
+{
+   return (struct overlay_trace *)p_atomic_read(&data->trace);
+}
+
 static void destroy_instance_data(struct instance_data *data)
 {
+   overlay_trace_destroy(data->trace);
+   simple_mtx_destroy(&data->trace_mutex);
    if (data->params.output_file)
       fclose(data->params.output_file);
+   if (data->params.trace_file)
+      fclose(data->params.trace_file);
    if (data->params.control >= 0)
       os_socket_close(data->params.control);
    unmap_object(HKEY(data->instance));
@@ -492,6 +514,7 @@ static struct swapchain_data *new_swapchain_data(VkSwapchainKHR swapchain,
    struct swapchain_data *data = rzalloc(NULL, struct swapchain_data);
    data->device = device_data;
    data->swapchain = swapchain;
+   data->index = p_atomic_inc_return(&instance_data->n_swapchains) - 1;
    data->window_size = ImVec2(instance_data->params.width, instance_data->params.height);
    list_inithead(&data->draws);
    map_object(HKEY(data->swapchain), data);
@@ -564,6 +587,8 @@ static const char *param_unit(enum overlay_param_enabled param)
    }
 }
 
+static void control_start_trace(struct instance_data *instance_data);
+
 static void parse_command(struct instance_data *instance_data,
                           const char *cmd, unsigned cmdlen,
                           const char *param, unsigned paramlen)
@@ -578,6 +603,9 @@ static void parse_command(struct instance_data *instance_data,
          instance_data->capture_enabled = false;
          instance_data->capture_started = false;
       }
+   } else if (!strncmp(cmd, "trace", cmdlen)) {
+      if (atoi(param) > 0)
+         control_start_trace(instance_data);
    }
 }
 
@@ -723,6 +751,40 @@ static void control_client_disconnected(struct instance_data *instance_data)
    instance_data->control_client = -1;
 }
 
+/**
+ * Turns the control connection into a trace stream.  Once the client has
+ * been acknowledged with :TraceVersion=1; the connection belongs to the
+ * trace writer, which sends the binary trace down it, and the control
+ * socket goes back to accepting a new client.
+ */
+static void control_start_trace(struct instance_data *instance_data)
+{
+   const int client = instance_data->control_client;
+   if (client < 0)
+      return;
+
+   simple_mtx_lock(&instance_data->trace_mutex);
+   struct overlay_trace *trace = instance_data->trace;
+   if (!trace) {
+      trace = overlay_trace_create(NULL);
+      p_atomic_set(&instance_data->trace, trace);
+   }
+   simple_mtx_unlock(&instance_data->trace_mutex);
+
+   const char *traceVersionCmd = "TraceVersion";
+   const char *traceVersionString = trace ? "1" : "0";
+
+   control_send(instance_data, traceVersionCmd, strlen(traceVersionCmd),
+                traceVersionString, strlen(traceVersionString));
+   if (!trace)
+      return;
+
+   /* Only one client can stream the trace at a time. */
+   if (!overlay_trace_attach_socket(trace, client))
+      os_socket_close(client);
+   instance_data->control_client = -1;
+}
+
 static void process_control_socket(struct instance_data *instance_data)
 {
    const int client = instance_data->control_client;
@@ -749,8 +811,15 @@ static void process_control_socket(struct instance_data *instance_data)
 
          for (ssize_t i = 0; i < n; i++) {
             process_char(instance_data, buf[i]);
+
+            /* The connection was handed over to the trace writer. */
+            if (instance_data->control_client != client)
+               break;
          }
 
+         if (instance_data->control_client != client)
+            break;
+
          /* If we try to read BUFSIZE and receive BUFSIZE bytes from the
           * socket, there's a good chance that there's still more data to be
           * read, so we will try again. Otherwise, simply be done for this
@@ -785,6 +854,18 @@ static void snapshot_swapchain_frame(struct swapchain_data *data)
       data->accumulated_stats.stats[s] += device_data->frame_stats.stats[s] + data->frame_stats.stats[s];
    }
 
+   struct overlay_trace *trace = get_trace(instance_data);
+   if (trace) {
+      struct overlay_trace_record record = {};
+      record.type = OVERLAY_TRACE_RECORD_FRAME;
+      record.swapchain = data->index;
+      record.frame = data->n_frames;
+      record.timestamp = now;
+      memcpy(record.values, data->frames_stats[f_idx].stats,
+             sizeof(record.values));
+      overlay_trace_push(trace, &record);
+   }
+
    /* If capture has been enabled but it hasn't started yet, it means we are on
     * the first snapshot after it has been enabled. At this point we want to
     * use the stats captured so far to update the display, but we don't want
@@ -1844,9 +1925,17 @@ static VkResult overlay_QueuePresentKHR(
                                                  1, &queue_data->queries_fence,
                                                  VK_FALSE, UINT64_MAX));
 
+      /* Command buffer results are traced as part of the frame about to be
+       * presented on the first swapchain.
+       */
+      struct swapchain_data *trace_swapchain =
+         FIND(struct swapchain_data, pPresentInfo->pSwapchains[0]);
+
       /* Now get the results. */
       list_for_each_entry_safe(struct command_buffer_data, cmd_buffer_data,
                                &queue_data->running_command_buffer, link) {
+         struct frame_stat query_stats = {};
+
          list_delinit(&cmd_buffer_data->link);
 
          if (cmd_buffer_data->pipeline_query_pool) {
@@ -1859,7 +1948,7 @@ static VkResult overlay_QueuePresentKHR(
 
             for (uint32_t i = OVERLAY_PARAM_ENABLED_vertices;
                  i <= OVERLAY_PARAM_ENABLED_compute_invocations; i++) {
-               device_data->frame_stats.stats[i] += query_results[i - OVERLAY_PARAM_ENABLED_vertices];
+               query_stats.stats[i] = query_results[i - OVERLAY_PARAM_ENABLED_vertices];
             }
          }
          if (cmd_buffer_data->timestamp_query_pool) {
@@ -1872,10 +1961,27 @@ static VkResult overlay_QueuePresentKHR(
 
             gpu_timestamps[0] &= queue_data->timestamp_mask;
             gpu_timestamps[1] &= queue_data->timestamp_mask;
-            device_data->frame_stats.stats[OVERLAY_PARAM_ENABLED_gpu_timing] +=
+            query_stats.stats[OVERLAY_PARAM_ENABLED_gpu_timing] =
                (gpu_timestamps[1] - gpu_timestamps[0]) *
                device_data->properties.limits.timestampPeriod;
          }
+
+         for (uint32_t s = 0; s < OVERLAY_PARAM_ENABLED_MAX; s++)
+            device_data->frame_stats.stats[s] += query_stats.stats[s];
+
+         struct overlay_trace *trace = get_trace(instance_data);
+         if (trace) {
+            struct overlay_trace_record record = {};
+            record.type = OVERLAY_TRACE_RECORD_COMMAND_BUFFER;
+            record.swapchain = trace_swapchain->index;
+            record.frame = trace_swapchain->n_frames;
+            record.timestamp = os_time_get();
+            for (uint32_t s = 0; s < OVERLAY_PARAM_ENABLED_MAX; s++) {
+               record.values[s] = cmd_buffer_data->stats.stats[s] +
+                                  query_stats.stats[s];
+            }
+            overlay_trace_push(trace, &record);
+         }
       }
    }
 
@@ -2486,6 +2592,9 @@ static VkResult overlay_CreateInstance(
       instance_data->params.output_file && instance_data->params.control < 0;
    instance_data->capture_started = instance_data->capture_enabled;
 
+   if (instance_data->params.trace_file)
+      instance_data->trace = overlay_trace_create(instance_data->params.trace_file);
+
    for (int i = OVERLAY_PARAM_ENABLED_vertices;
         i <= OVERLAY_PARAM_ENABLED_compute_invocations; i++) {
       if (instance_data->params.enabled[i]) {
@@ -51,6 +51,12 @@ parse_output_file(const char *str)
    return fopen(str, "w+");
 }
 
+static FILE *
+parse_trace_file(const char *str)
+{
+   return fopen(str, "wb");
+}
+
 static int
 parse_control(const char *str)
 {
@@ -101,6 +107,7 @@ parse_help(const char *str)
    fprintf(stderr, "\tfps_sampling_period=number-of-milliseconds\n");
    fprintf(stderr, "\tno_display=0|1\n");
    fprintf(stderr, "\toutput_file=/path/to/output.txt\n");
+   fprintf(stderr, "\ttrace_file=/path/to/trace.bin\n");
    fprintf(stderr, "\twidth=width-in-pixels\n");
    fprintf(stderr, "\theight=height-in-pixels\n");
 
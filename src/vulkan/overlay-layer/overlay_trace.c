@@ -0,0 +1,460 @@
+/*
+ * Copyright © 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include "overlay_trace.h"
+
+#include "util/macros.h"
+#include "util/os_socket.h"
+#include "util/os_time.h"
+#include "util/u_atomic.h"
+#include "util/u_thread.h"
+
+/* Must be a power of two so that the slot sequence numbers stay consistent
+ * when the counters wrap around.
+ */
+#define OVERLAY_TRACE_RING_SIZE 1024
+
+/* How long the writer sleeps when there is nothing to write (us) */
+#define OVERLAY_TRACE_POLL_PERIOD 2000
+
+/* How long overlay_trace_destroy() waits for a socket client to take the
+ * rest of the stream (ms)
+ */
+#define OVERLAY_TRACE_CLOSE_TIMEOUT 100
+
+/* The ring is a bounded multi-producer queue: a producer reserves a slot by
+ * bumping head, fills it in, and publishes it by setting the slot sequence
+ * number to its position + 1.  The writer consumes slots in order and hands
+ * them back by moving their sequence number one lap ahead.  A producer
+ * finding a slot that hasn't been handed back yet knows the ring is full and
+ * drops its record rather than waiting for the writer.
+ */
+struct overlay_trace_slot {
+   uint32_t seq;
+   struct overlay_trace_record record;
+};
+
+struct overlay_trace {
+   thrd_t thread;
+   bool quit;
+
+   FILE *file;
+
+   /* Socket the trace is streamed to, -1 if none.  Set by
+    * overlay_trace_attach_socket(), owned by the writer afterwards.
+    */
+   int socket;
+
+   uint32_t head;
+   uint32_t dropped;
+
+   /* Only accessed by the writer */
+   uint32_t tail;
+   uint32_t reported_dropped;
+
+   /* Header and names, sent first to every socket */
+   void *header;
+   size_t header_size;
+
+   /* Socket the header went out on, -1 once the client is detached */
+   int header_socket;
+
+   /* The socket is non-blocking and the stream to it only ever stops
+    * between whole units (the header or a record).  What is left of a unit
+    * the socket only took part of is kept here and sent before anything
+    * else.  Records that come while the socket is full are counted in
+    * socket_dropped instead, and reported to the client alone.
+    */
+   uint8_t *pending;
+   size_t pending_offset;
+   size_t pending_size;
+   uint32_t socket_dropped;
+
+   struct overlay_trace_slot slots[OVERLAY_TRACE_RING_SIZE];
+};
+
+bool
+overlay_trace_push(struct overlay_trace *trace,
+                   const struct overlay_trace_record *record)
+{
+   struct overlay_trace_slot *slot;
+   uint32_t pos = p_atomic_read(&trace->head);
+
+   while (true) {
+      slot = &trace->slots[pos % OVERLAY_TRACE_RING_SIZE];
+
+      int32_t diff = (int32_t)(p_atomic_read(&slot->seq) - pos);
+      if (diff == 0) {
+         uint32_t old = p_atomic_cmpxchg(&trace->head, pos, pos + 1);
+         if (old == pos)
+            break;
+         pos = old;
+      } else if (diff < 0) {
+         p_atomic_inc(&trace->dropped);
+         return false;
+      } else {
+         pos = p_atomic_read(&trace->head);
+      }
+   }
+
+   slot->record = *record;
+   p_atomic_set(&slot->seq, pos + 1);
+
+   return true;
+}
+
+static bool
+overlay_trace_pop(struct overlay_trace *trace,
+                  struct overlay_trace_record *record)
+{
+   struct overlay_trace_slot *slot =
+      &trace->slots[trace->tail % OVERLAY_TRACE_RING_SIZE];
+
+   if (p_atomic_read(&slot->seq) != trace->tail + 1)
+      return false;
+
+   *record = slot->record;
+   p_atomic_set(&slot->seq, trace->tail + OVERLAY_TRACE_RING_SIZE);
+   trace->tail++;
+
+   return true;
+}
+
+static void *
+build_header(size_t *size)
+{
+   struct overlay_trace_header header = {
+      .magic = OVERLAY_TRACE_MAGIC,
+      .version = OVERLAY_TRACE_VERSION,
+      .record_size = sizeof(struct overlay_trace_record),
+      .n_values = OVERLAY_PARAM_ENABLED_MAX,
+   };
+
+   for (int i = 0; i < OVERLAY_PARAM_ENABLED_MAX; i++)
+      header.names_size += strlen(overlay_param_names[i]) + 1;
+
+   *size = sizeof(header) + header.names_size;
+   char *data = malloc(*size);
+   if (!data)
+      return NULL;
+
+   memcpy(data, &header, sizeof(header));
+   char *names = data + sizeof(header);
+   for (int i = 0; i < OVERLAY_PARAM_ENABLED_MAX; i++) {
+      size_t len = strlen(overlay_param_names[i]) + 1;
+      memcpy(names, overlay_param_names[i], len);
+      names += len;
+   }
+
+   return data;
+}
+
+static void
+close_socket(struct overlay_trace *trace)
+{
+   os_socket_close(trace->socket);
+   trace->header_socket = -1;
+   trace->pending_size = 0;
+   p_atomic_set(&trace->socket, -1);
+}
+
+/* Sends as much of data as the socket takes without blocking.  Returns the
+ * number of bytes sent, or -1 if the client went away, in which case it is
+ * detached.
+ */
+static ssize_t
+send_some(struct overlay_trace *trace, const void *data, size_t size)
+{
+   const uint8_t *ptr = data;
+   size_t sent = 0;
+
+   while (sent < size) {
+      ssize_t n = os_socket_send(trace->header_socket, ptr + sent,
+                                 size - sent, MSG_NOSIGNAL);
+      if (n < 0) {
+         if (errno == EINTR)
+            continue;
+         if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+         close_socket(trace);
+         return -1;
+      }
+      sent += n;
+   }
+
+   return sent;
+}
+
+/* Sends what is left of the last unit, returns true once nothing is. */
+static bool
+send_pending(struct overlay_trace *trace)
+{
+   if (trace->pending_size == 0)
+      return true;
+
+   ssize_t n = send_some(trace, trace->pending + trace->pending_offset,
+                         trace->pending_size);
+   if (n < 0)
+      return false;
+
+   trace->pending_offset += n;
+   trace->pending_size -= n;
+
+   return trace->pending_size == 0;
+}
+
+/* Starts sending a whole unit of the stream.  Returns false if none of it
+ * could be sent, because the socket is full or the client went away.
+ */
+static bool
+send_unit(struct overlay_trace *trace, const void *data, size_t size)
+{
+   if (!send_pending(trace))
+      return false;
+
+   ssize_t n = send_some(trace, data, size);
+   if (n <= 0)
+      return false;
+
+   if ((size_t)n < size) {
+      memcpy(trace->pending, (const uint8_t *)data + n, size - n);
+      trace->pending_offset = 0;
+      trace->pending_size = size - n;
+   }
+
+   return true;
+}
+
+static bool
+send_socket_dropped(struct overlay_trace *trace)
+{
+   if (trace->socket_dropped == 0)
+      return true;
+
+   struct overlay_trace_record record = {
+      .type = OVERLAY_TRACE_RECORD_DROPPED,
+      .timestamp = os_time_get(),
+   };
+   record.values[0] = trace->socket_dropped;
+
+   if (!send_unit(trace, &record, sizeof(record)))
+      return false;
+
+   trace->socket_dropped = 0;
+   return true;
+}
+
+/* Streams records to the socket client.  When it doesn't keep up and the
+ * socket fills, the records are dropped whole rather than waited for, and
+ * the client stays attached.
+ */
+static void
+send_records(struct overlay_trace *trace,
+             const struct overlay_trace_record *records, unsigned count)
+{
+   for (unsigned i = 0; i < count; i++) {
+      if (send_socket_dropped(trace) &&
+          send_unit(trace, &records[i], sizeof(records[i])))
+         continue;
+
+      if (trace->header_socket < 0)
+         return;
+
+      for (; i < count; i++) {
+         if (records[i].type == OVERLAY_TRACE_RECORD_DROPPED)
+            trace->socket_dropped += records[i].values[0];
+         else
+            trace->socket_dropped++;
+      }
+   }
+}
+
+/* Writes out a batch of records, returns false if there was nothing to
+ * write.
+ */
+static bool
+overlay_trace_flush(struct overlay_trace *trace)
+{
+   struct overlay_trace_record batch[64];
+   unsigned n = 0;
+
+   const int socket = p_atomic_read(&trace->socket);
+   if (socket >= 0 && socket != trace->header_socket) {
+      trace->header_socket = socket;
+      trace->pending_size = 0;
+      trace->socket_dropped = 0;
+
+      /* A new socket's buffer holds the header, so this only fails if
+       * the client is already gone.
+       */
+      if (!send_unit(trace, trace->header, trace->header_size) &&
+          trace->header_socket >= 0)
+         close_socket(trace);
+   }
+
+   const uint32_t dropped = p_atomic_read(&trace->dropped);
+   if (dropped != trace->reported_dropped) {
+      memset(&batch[n], 0, sizeof(batch[n]));
+      batch[n].type = OVERLAY_TRACE_RECORD_DROPPED;
+      batch[n].timestamp = os_time_get();
+      batch[n].values[0] = dropped - trace->reported_dropped;
+      trace->reported_dropped = dropped;
+      n++;
+   }
+
+   while (n < ARRAY_SIZE(batch) && overlay_trace_pop(trace, &batch[n]))
+      n++;
+
+   if (n == 0)
+      return false;
+
+   if (trace->file) {
+      fwrite(batch, sizeof(batch[0]), n, trace->file);
+      fflush(trace->file);
+   }
+
+   if (trace->header_socket >= 0)
+      send_records(trace, batch, n);
+
+   return true;
+}
+
+/* Gives the socket client a last chance to take the rest of the stream, so
+ * that it ends on a whole record unless the client stopped reading.
+ */
+static void
+overlay_trace_finish_socket(struct overlay_trace *trace)
+{
+   int64_t end = os_time_get() + OVERLAY_TRACE_CLOSE_TIMEOUT * 1000;
+
+   while (trace->header_socket >= 0) {
+      if (send_pending(trace) && send_socket_dropped(trace) &&
+          trace->pending_size == 0)
+         break;
+
+      int64_t timeout = end - os_time_get();
+      if (timeout <= 0)
+         break;
+
+      struct pollfd pfd = {
+         .fd = trace->header_socket,
+         .events = POLLOUT,
+      };
+      int ret = poll(&pfd, 1, DIV_ROUND_UP(timeout, 1000));
+      if (ret == 0 || (ret < 0 && errno != EINTR))
+         break;
+   }
+}
+
+static int
+overlay_trace_thread(void *data)
+{
+   struct overlay_trace *trace = data;
+
+   u_thread_setname("overlay trace");
+
+   while (!p_atomic_read(&trace->quit)) {
+      if (!overlay_trace_flush(trace))
+         os_time_sleep(OVERLAY_TRACE_POLL_PERIOD);
+   }
+
+   while (overlay_trace_flush(trace))
+      ;
+
+   overlay_trace_finish_socket(trace);
+
+   return 0;
+}
+
+struct overlay_trace *
+overlay_trace_create(FILE *file)
+{
+   struct overlay_trace *trace = calloc(1, sizeof(*trace));
+   if (!trace)
+      return NULL;
+
+   trace->file = file;
+   trace->socket = -1;
+   trace->header_socket = -1;
+   for (uint32_t i = 0; i < OVERLAY_TRACE_RING_SIZE; i++)
+      trace->slots[i].seq = i;
+
+   trace->header = build_header(&trace->header_size);
+   trace->pending = malloc(MAX2(trace->header_size,
+                                sizeof(struct overlay_trace_record)));
+   if (!trace->header || !trace->pending)
+      goto fail;
+
+   if (file) {
+      fwrite(trace->header, trace->header_size, 1, file);
+      fflush(file);
+   }
+
+   trace->thread = u_thread_create(overlay_trace_thread, trace);
+   if (!trace->thread)
+      goto fail;
+
+   return trace;
+
+fail:
+   free(trace->pending);
+   free(trace->header);
+   free(trace);
+   return NULL;
+}
+
+void
+overlay_trace_destroy(struct overlay_trace *trace)
+{
+   if (!trace)
+      return;
+
+   p_atomic_set(&trace->quit, true);
+   thrd_join(trace->thread, NULL);
+
+   if (trace->socket >= 0)
+      os_socket_close(trace->socket);
+
+   free(trace->pending);
+   free(trace->header);
+   free(trace);
+}
+
+/* Streams the trace to an already connected socket.  Only one socket can be
+ * streamed to at a time, returns false if another one is in use.  Records
+ * are dropped, whole, while the client doesn't read fast enough to keep the
+ * socket from filling up, and the number lost is reported to it in an
+ * OVERLAY_TRACE_RECORD_DROPPED record once it catches up.
+ */
+bool
+overlay_trace_attach_socket(struct overlay_trace *trace, int socket)
+{
+   os_socket_block(socket, false);
+   return p_atomic_cmpxchg(&trace->socket, -1, socket) == -1;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef OVERLAY_TRACE_H
+#define OVERLAY_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "overlay_params.h"
+
+/*
+ * A trace is a stream of fixed-size binary records in host byte order.  It
+ * starts with a struct overlay_trace_header, followed by the names of the
+ * record values as NUL-terminated strings (names_size bytes in total), and
+ * then by records of header.record_size bytes each.
+ *
+ * Records are queued from the application threads without taking any lock
+ * and written out by a background thread.  When the writer can't keep up,
+ * records are dropped and an OVERLAY_TRACE_RECORD_DROPPED record carrying
+ * the number of lost records is emitted instead.  A socket client that
+ * doesn't read fast enough loses whole records the same way.
+ */
+
+#define OVERLAY_TRACE_MAGIC "MESAOVTR"
+#define OVERLAY_TRACE_VERSION 1
+
+struct overlay_trace_header {
+   char magic[8];
+   uint32_t version;
+   uint32_t record_size;
+   uint32_t n_values;
+   uint32_t names_size;
+};
+
+enum overlay_trace_record_type {
+   /* Statistics of one presented frame of a swapchain */
+   OVERLAY_TRACE_RECORD_FRAME = 1,
+   /* Statistics of one command buffer, read back at present time */
+   OVERLAY_TRACE_RECORD_COMMAND_BUFFER = 2,
+   /* values[0] records were lost because the writer fell behind */
+   OVERLAY_TRACE_RECORD_DROPPED = 3,
+};
+
+struct overlay_trace_record {
+   uint32_t type;
+   /* Index of the swapchain in the order they were created */
+   uint32_t swapchain;
+   /* Frame of the swapchain this record belongs to */
+   uint64_t frame;
+   /* CPU time at which the record was taken (us) */
+   uint64_t timestamp;
+   /* Indexed by enum overlay_param_enabled */
+   uint64_t values[OVERLAY_PARAM_ENABLED_MAX];
+};
+
+struct overlay_trace;
+
+struct overlay_trace *overlay_trace_create(FILE *file);
+
+void overlay_trace_destroy(struct overlay_trace *trace);
+
+bool overlay_trace_attach_socket(struct overlay_trace *trace, int socket);
+
+bool overlay_trace_push(struct overlay_trace *trace,
+                        const struct overlay_trace_record *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_TRACE_H */
@@ -0,0 +1,281 @@
+/*
+ * Copyright © 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "overlay_trace.h"
+
+#include "util/os_time.h"
+#include "util/u_thread.h"
+
+#define t_assert(cond) \
+   do { \
+      if (!(cond)) { \
+         fprintf(stderr, "%s:%d: assertion failed: %s\n", \
+                 __FILE__, __LINE__, #cond); \
+         abort(); \
+      } \
+   } while (0)
+
+struct stream {
+   uint8_t *data;
+   size_t size;
+};
+
+/* What a trace stream holds, once checked to be well formed */
+struct stream_summary {
+   uint64_t frames;
+   uint64_t dropped;
+   uint64_t last_frame;
+};
+
+static void
+stream_append(struct stream *stream, const void *data, size_t size)
+{
+   stream->data = realloc(stream->data, stream->size + size);
+   t_assert(stream->data);
+   memcpy(stream->data + stream->size, data, size);
+   stream->size += size;
+}
+
+static void
+stream_read_file(struct stream *stream, FILE *file)
+{
+   uint8_t buf[4096];
+   size_t n;
+
+   rewind(file);
+   while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+      stream_append(stream, buf, n);
+}
+
+/* Checks the header and that the stream ends on a whole record, and that
+ * frame records come in the order they were pushed in.
+ */
+static struct stream_summary
+check_stream(const struct stream *stream)
+{
+   struct stream_summary summary = { 0 };
+   struct overlay_trace_header header;
+
+   t_assert(stream->size >= sizeof(header));
+   memcpy(&header, stream->data, sizeof(header));
+   t_assert(memcmp(header.magic, OVERLAY_TRACE_MAGIC,
+                   sizeof(header.magic)) == 0);
+   t_assert(header.version == OVERLAY_TRACE_VERSION);
+   t_assert(header.record_size == sizeof(struct overlay_trace_record));
+   t_assert(header.n_values == OVERLAY_PARAM_ENABLED_MAX);
+
+   const char *name = (const char *)stream->data + sizeof(header);
+   for (int i = 0; i < OVERLAY_PARAM_ENABLED_MAX; i++) {
+      t_assert(strcmp(name, overlay_param_names[i]) == 0);
+      name += strlen(name) + 1;
+   }
+   t_assert(name == (const char *)stream->data + sizeof(header) +
+                    header.names_size);
+
+   size_t offset = sizeof(header) + header.names_size;
+   t_assert((stream->size - offset) % header.record_size == 0);
+
+   for (; offset < stream->size; offset += header.record_size) {
+      struct overlay_trace_record record;
+      memcpy(&record, stream->data + offset, sizeof(record));
+
+      switch (record.type) {
+      case OVERLAY_TRACE_RECORD_FRAME:
+         t_assert(summary.frames == 0 || record.frame > summary.last_frame);
+         t_assert(record.values[0] == record.frame * 3);
+         summary.last_frame = record.frame;
+         summary.frames++;
+         break;
+      case OVERLAY_TRACE_RECORD_DROPPED:
+         t_assert(record.values[0] > 0);
+         summary.dropped += record.values[0];
+         break;
+      default:
+         t_assert(!"unexpected record type");
+      }
+   }
+
+   return summary;
+}
+
+static bool
+push_frame(struct overlay_trace *trace, uint64_t frame)
+{
+   struct overlay_trace_record record = {
+      .type = OVERLAY_TRACE_RECORD_FRAME,
+      .frame = frame,
+      .timestamp = os_time_get(),
+   };
+   record.values[0] = frame * 3;
+
+   return overlay_trace_push(trace, &record);
+}
+
+static void
+test_file(void)
+{
+   FILE *file = tmpfile();
+   t_assert(file);
+
+   struct overlay_trace *trace = overlay_trace_create(file);
+   t_assert(trace);
+
+   /* Fewer records than the ring holds, so none can be lost */
+   for (uint64_t i = 0; i < 500; i++)
+      t_assert(push_frame(trace, i));
+
+   overlay_trace_destroy(trace);
+
+   struct stream stream = { 0 };
+   stream_read_file(&stream, file);
+   struct stream_summary summary = check_stream(&stream);
+
+   t_assert(summary.frames == 500);
+   t_assert(summary.dropped == 0);
+   t_assert(summary.last_frame == 499);
+
+   free(stream.data);
+   fclose(file);
+}
+
+static void
+test_ring_full(void)
+{
+   FILE *file = tmpfile();
+   t_assert(file);
+
+   struct overlay_trace *trace = overlay_trace_create(file);
+   t_assert(trace);
+
+   /* Push faster than the writer drains the ring, so that some records are
+    * turned away.  Every one of them must be accounted for.
+    */
+   const uint64_t count = 200000;
+   uint64_t pushed = 0;
+   for (uint64_t i = 0; i < count; i++)
+      pushed += push_frame(trace, i);
+
+   overlay_trace_destroy(trace);
+
+   struct stream stream = { 0 };
+   stream_read_file(&stream, file);
+   struct stream_summary summary = check_stream(&stream);
+
+   t_assert(summary.frames == pushed);
+   t_assert(summary.dropped == count - pushed);
+
+   free(stream.data);
+   fclose(file);
+}
+
+struct reader {
+   int socket;
+   struct stream stream;
+};
+
+/* Reads the stream a bit at a time, until the writer closes the socket */
+static int
+slow_reader(void *data)
+{
+   struct reader *reader = data;
+   uint8_t buf[512];
+
+   while (true) {
+      ssize_t n = recv(reader->socket, buf, sizeof(buf), 0);
+      t_assert(n >= 0);
+      if (n == 0)
+         break;
+
+      stream_append(&reader->stream, buf, n);
+      os_time_sleep(1000);
+   }
+
+   return 0;
+}
+
+static void
+test_slow_socket(void)
+{
+   int sv[2];
+   t_assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+
+   /* Small buffers, so that the socket fills up long before the end */
+   int size = 4096;
+   setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+   setsockopt(sv[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+   struct overlay_trace *trace = overlay_trace_create(NULL);
+   t_assert(trace);
+   t_assert(overlay_trace_attach_socket(trace, sv[0]));
+
+   /* Only one client at a time */
+   int other[2];
+   t_assert(socketpair(AF_UNIX, SOCK_STREAM, 0, other) == 0);
+   t_assert(!overlay_trace_attach_socket(trace, other[0]));
+   close(other[0]);
+   close(other[1]);
+
+   struct reader reader = { .socket = sv[1] };
+   thrd_t thread = u_thread_create(slow_reader, &reader);
+   t_assert(thread);
+
+   const uint64_t count = 20000;
+   for (uint64_t i = 0; i < count; i++) {
+      push_frame(trace, i);
+      if (i % 100 == 99)
+         os_time_sleep(1000);
+   }
+
+   /* Closes the socket, which ends the reader */
+   overlay_trace_destroy(trace);
+   thrd_join(thread, NULL);
+   close(sv[1]);
+
+   /* The client falls behind, but stays attached to the end: it gets whole
+    * records only, and every record pushed is either in the stream or
+    * counted as dropped.
+    */
+   struct stream_summary summary = check_stream(&reader.stream);
+
+   t_assert(summary.frames > 0);
+   t_assert(summary.dropped > 0);
+   t_assert(summary.frames + summary.dropped == count);
+
+   free(reader.stream.data);
+}
+
+int
+main(void)
+{
+   test_file();
+   test_ring_full();
+   test_slow_socket();
+
+   return 0;
+}
@@ -23,16 +23,23 @@
 
 #include "wsi_common_private.h"
 #include "drm-uapi/drm_fourcc.h"
+#include "util/debug.h"
 #include "util/macros.h"
 #include "util/xmlconfig.h"
 #include "vk_util.h"
 
+#include <inttypes.h>
 #include <time.h>
 #include <unistd.h>
 #include <xf86drm.h>
 #include <stdlib.h>
 #include <stdio.h>
 
+static const struct debug_control debug_control[] = {
+   { "stats",     WSI_DEBUG_STATS },
+   { NULL,        0 },
+};
+
 VkResult
 wsi_device_init(struct wsi_device *wsi,
                 VkPhysicalDevice pdevice,
@@ -128,11 +135,16 @@ wsi_device_init(struct wsi_device *wsi,
          wsi->override_present_mode = VK_PRESENT_MODE_MAILBOX_KHR;
       } else if (!strcmp(present_mode, "immediate")) {
          wsi->override_present_mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+      } else if (!strcmp(present_mode, "relaxed")) {
+         wsi->override_present_mode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
       } else {
          fprintf(stderr, "Invalid MESA_VK_WSI_PRESENT_MODE value!\n");
       }
    }
 
+   wsi->debug_flags = parse_debug_string(getenv("MESA_VK_WSI_DEBUG"),
+                                         debug_control);
+
    if (dri_options) {
       if (driCheckOption(dri_options, "adaptive_sync", DRI_BOOL))
          wsi->enable_adaptive_sync = driQueryOptionb(dri_options,
@@ -287,9 +299,55 @@ wsi_swapchain_get_present_mode(struct wsi_device *wsi,
    return wsi->override_present_mode;
 }
 
+/**
+ * Records that a present reached the screen at time_ns, on the clock the
+ * window system reports, with missed_refreshes refreshes since the previous
+ * one which didn't show anything new.
+ */
+void
+wsi_swapchain_stats_complete(struct wsi_swapchain *chain, uint64_t time_ns,
+                             uint64_t missed_refreshes)
+{
+   struct wsi_present_stats *stats = &chain->stats;
+
+   if (stats->completes > 0 && time_ns > stats->last_complete_ns) {
+      uint64_t interval = time_ns - stats->last_complete_ns;
+      stats->min_interval_ns = stats->completes > 1 ?
+         MIN2(stats->min_interval_ns, interval) : interval;
+      stats->max_interval_ns = MAX2(stats->max_interval_ns, interval);
+      stats->total_interval_ns += interval;
+   }
+
+   stats->completes++;
+   stats->missed_refreshes += missed_refreshes;
+   stats->last_complete_ns = time_ns;
+}
+
+static void
+wsi_swapchain_print_stats(const struct wsi_swapchain *chain)
+{
+   const struct wsi_present_stats *stats = &chain->stats;
+
+   fprintf(stderr, "WSI swapchain %p: %"PRIu64" presents, "
+           "%"PRIu64" shown, %"PRIu64" skipped, %"PRIu64" missed refreshes\n",
+           chain, stats->presents, stats->completes, stats->skipped,
+           stats->missed_refreshes);
+
+   if (stats->completes > 1) {
+      fprintf(stderr, "WSI swapchain %p: frame interval "
+              "min %.2f ms, avg %.2f ms, max %.2f ms\n", chain,
+              stats->min_interval_ns / 1000000.0,
+              stats->total_interval_ns / 1000000.0 / (stats->completes - 1),
+              stats->max_interval_ns / 1000000.0);
+   }
+}
+
 void
 wsi_swapchain_finish(struct wsi_swapchain *chain)
 {
+   if ((chain->wsi->debug_flags & WSI_DEBUG_STATS) && chain->stats.presents)
+      wsi_swapchain_print_stats(chain);
+
    if (chain->fences) {
       for (unsigned i = 0; i < chain->image_count; i++)
          chain->wsi->DestroyFence(chain->device, chain->fences[i], &chain->alloc);
@@ -1210,6 +1268,8 @@ wsi_common_queue_present(const struct wsi_device *wsi,
          region = &regions->pRegions[i];
 
       result = swapchain->queue_present(swapchain, image_index, region);
+      if (result >= 0)
+         swapchain->stats.presents++;
       if (result != VK_SUCCESS)
          goto fail_present;
 
@@ -96,6 +96,9 @@ struct wsi_device {
    VkPresentModeKHR override_present_mode;
    bool force_bgra8_unorm_first;
 
+   /* WSI_DEBUG_* flags from MESA_VK_WSI_DEBUG */
+   uint64_t debug_flags;
+
    /* Whether to enable adaptive sync for a swapchain if implemented and
     * available. Not all window systems might support this. */
    bool enable_adaptive_sync;
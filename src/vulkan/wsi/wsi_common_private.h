@@ -25,6 +25,8 @@
 
 #include "wsi_common.h"
 
+#define WSI_DEBUG_STATS (1ull << 0)
+
 struct wsi_image {
    VkImage image;
    VkDeviceMemory memory;
@@ -43,6 +45,26 @@ struct wsi_image {
    int fds[4];
 };
 
+/* Frame pacing statistics of a swapchain, as far as the window system
+ * tells us about them.
+ */
+struct wsi_present_stats {
+   /* Images handed to the window system */
+   uint64_t presents;
+   /* Presents which made it to the screen */
+   uint64_t completes;
+   /* Presents replaced by a newer one before they could be shown */
+   uint64_t skipped;
+   /* Refreshes which went by without showing a new image */
+   uint64_t missed_refreshes;
+
+   /* Time between consecutive completes (ns) */
+   uint64_t last_complete_ns;
+   uint64_t min_interval_ns;
+   uint64_t max_interval_ns;
+   uint64_t total_interval_ns;
+};
+
 struct wsi_swapchain {
    const struct wsi_device *wsi;
 
@@ -57,6 +79,8 @@ struct wsi_swapchain {
    /* Command pools, one per queue family */
    VkCommandPool *cmd_pools;
 
+   struct wsi_present_stats stats;
+
    VkResult (*destroy)(struct wsi_swapchain *swapchain,
                        const VkAllocationCallbacks *pAllocator);
    struct wsi_image *(*get_wsi_image)(struct wsi_swapchain *swapchain,
@@ -85,6 +109,10 @@ wsi_swapchain_get_present_mode(struct wsi_device *wsi,
 
 void wsi_swapchain_finish(struct wsi_swapchain *chain);
 
+void
+wsi_swapchain_stats_complete(struct wsi_swapchain *chain, uint64_t time_ns,
+                             uint64_t missed_refreshes);
+
 VkResult
 wsi_create_native_image(const struct wsi_swapchain *chain,
                         const VkSwapchainCreateInfoKHR *pCreateInfo,
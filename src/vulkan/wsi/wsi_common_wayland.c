@@ -85,6 +85,12 @@ struct wsi_wl_display {
    uint32_t                                     refcount;
 };
 
+/* Formats supported by the compositor on a given wl_display */
+struct wsi_wl_formats {
+   uint32_t                                     count;
+   VkFormat                                     formats[0];
+};
+
 struct wsi_wayland {
    struct wsi_interface                     base;
 
@@ -92,6 +98,12 @@ struct wsi_wayland {
 
    const VkAllocationCallbacks *alloc;
    VkPhysicalDevice physical_device;
+
+   /* Querying the formats takes two round trips to the compositor, so they
+    * are only queried once per wl_display.
+    */
+   pthread_mutex_t                          mutex;
+   struct hash_table *                      formats;
 };
 
 static void
@@ -505,6 +517,60 @@ wsi_wl_display_unref(struct wsi_wl_display *display)
    vk_free(wsi->alloc, display);
 }
 
+static struct wsi_wl_formats *
+wsi_wl_formats_create(struct wsi_wayland *wsi, struct wl_display *wl_display)
+{
+   struct wsi_wl_display display;
+   if (wsi_wl_display_init(wsi, &display, wl_display, true))
+      return NULL;
+
+   uint32_t count = u_vector_length(display.formats);
+   struct wsi_wl_formats *formats =
+      vk_alloc(wsi->alloc, sizeof(*formats) + count * sizeof(VkFormat), 8,
+               VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
+   if (formats) {
+      VkFormat *disp_fmt;
+      formats->count = 0;
+      u_vector_foreach(disp_fmt, display.formats)
+         formats->formats[formats->count++] = *disp_fmt;
+   }
+
+   wsi_wl_display_finish(&display);
+
+   return formats;
+}
+
+static const struct wsi_wl_formats *
+wsi_wl_get_formats(struct wsi_wayland *wsi, struct wl_display *wl_display)
+{
+   pthread_mutex_lock(&wsi->mutex);
+
+   struct hash_entry *entry = _mesa_hash_table_search(wsi->formats,
+                                                      wl_display);
+   if (!entry) {
+      /* Don't hold the mutex across the round trips. */
+      pthread_mutex_unlock(&wsi->mutex);
+
+      struct wsi_wl_formats *formats = wsi_wl_formats_create(wsi, wl_display);
+      if (!formats)
+         return NULL;
+
+      pthread_mutex_lock(&wsi->mutex);
+
+      entry = _mesa_hash_table_search(wsi->formats, wl_display);
+      if (entry) {
+         /* Someone raced us to it */
+         vk_free(wsi->alloc, formats);
+      } else {
+         entry = _mesa_hash_table_insert(wsi->formats, wl_display, formats);
+      }
+   }
+
+   pthread_mutex_unlock(&wsi->mutex);
+
+   return entry->data;
+}
+
 VkBool32
 wsi_wl_get_presentation_support(struct wsi_device *wsi_device,
 				struct wl_display *wl_display)
@@ -615,22 +681,20 @@ wsi_wl_surface_get_formats(VkIcdSurfaceBase *icd_surface,
    struct wsi_wayland *wsi =
       (struct wsi_wayland *)wsi_device->wsi[VK_ICD_WSI_PLATFORM_WAYLAND];
 
-   struct wsi_wl_display display;
-   if (wsi_wl_display_init(wsi, &display, surface->display, true))
+   const struct wsi_wl_formats *formats =
+      wsi_wl_get_formats(wsi, surface->display);
+   if (!formats)
       return VK_ERROR_SURFACE_LOST_KHR;
 
    VK_OUTARRAY_MAKE(out, pSurfaceFormats, pSurfaceFormatCount);
 
-   VkFormat *disp_fmt;
-   u_vector_foreach(disp_fmt, display.formats) {
+   for (uint32_t i = 0; i < formats->count; i++) {
       vk_outarray_append(&out, out_fmt) {
-         out_fmt->format = *disp_fmt;
+         out_fmt->format = formats->formats[i];
          out_fmt->colorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
       }
    }
 
-   wsi_wl_display_finish(&display);
-
    return vk_outarray_status(&out);
 }
 
@@ -645,22 +709,20 @@ wsi_wl_surface_get_formats2(VkIcdSurfaceBase *icd_surface,
    struct wsi_wayland *wsi =
       (struct wsi_wayland *)wsi_device->wsi[VK_ICD_WSI_PLATFORM_WAYLAND];
 
-   struct wsi_wl_display display;
-   if (wsi_wl_display_init(wsi, &display, surface->display, true))
+   const struct wsi_wl_formats *formats =
+      wsi_wl_get_formats(wsi, surface->display);
+   if (!formats)
       return VK_ERROR_SURFACE_LOST_KHR;
 
    VK_OUTARRAY_MAKE(out, pSurfaceFormats, pSurfaceFormatCount);
 
-   VkFormat *disp_fmt;
-   u_vector_foreach(disp_fmt, display.formats) {
+   for (uint32_t i = 0; i < formats->count; i++) {
       vk_outarray_append(&out, out_fmt) {
-         out_fmt->surfaceFormat.format = *disp_fmt;
+         out_fmt->surfaceFormat.format = formats->formats[i];
          out_fmt->surfaceFormat.colorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
       }
    }
 
-   wsi_wl_display_finish(&display);
-
    return vk_outarray_status(&out);
 }
 
@@ -841,13 +903,16 @@ wsi_wl_swapchain_acquire_next_image(struct wsi_swapchain *wsi_chain,
 }
 
 static void
-frame_handle_done(void *data, struct wl_callback *callback, uint32_t serial)
+frame_handle_done(void *data, struct wl_callback *callback, uint32_t time_ms)
 {
    struct wsi_wl_swapchain *chain = data;
 
    chain->frame = NULL;
    chain->fifo_ready = true;
 
+   /* The compositor doesn't tell us about the refreshes in between. */
+   wsi_swapchain_stats_complete(&chain->base, time_ms * 1000000ull, 0);
+
    wl_callback_destroy(callback);
 }
 
@@ -1176,6 +1241,18 @@ wsi_wl_init_wsi(struct wsi_device *wsi_device,
    wsi->alloc = alloc;
    wsi->wsi = wsi_device;
 
+   if (pthread_mutex_init(&wsi->mutex, NULL) != 0) {
+      result = VK_ERROR_OUT_OF_HOST_MEMORY;
+      goto fail_alloc;
+   }
+
+   wsi->formats = _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+                                          _mesa_key_pointer_equal);
+   if (!wsi->formats) {
+      result = VK_ERROR_OUT_OF_HOST_MEMORY;
+      goto fail_mutex;
+   }
+
    wsi->base.get_support = wsi_wl_surface_get_support;
    wsi->base.get_capabilities2 = wsi_wl_surface_get_capabilities2;
    wsi->base.get_formats = wsi_wl_surface_get_formats;
@@ -1188,6 +1265,10 @@ wsi_wl_init_wsi(struct wsi_device *wsi_device,
 
    return VK_SUCCESS;
 
+fail_mutex:
+   pthread_mutex_destroy(&wsi->mutex);
+fail_alloc:
+   vk_free(alloc, wsi);
 fail:
    wsi_device->wsi[VK_ICD_WSI_PLATFORM_WAYLAND] = NULL;
 
@@ -1203,5 +1284,11 @@ wsi_wl_finish_wsi(struct wsi_device *wsi_device,
    if (!wsi)
       return;
 
+   hash_table_foreach(wsi->formats, entry)
+      vk_free(alloc, entry->data);
+   _mesa_hash_table_destroy(wsi->formats, NULL);
+
+   pthread_mutex_destroy(&wsi->mutex);
+
    vk_free(alloc, wsi);
 }